@@ -0,0 +1,305 @@
+#include "AudioConvert.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if NDIRECV_X86
+#include <immintrin.h>
+#endif
+
+namespace
+{
+	using Taps = std::vector<std::vector<AudioFrameConverter::Tap>>;
+
+	// Largest float below 2^31; anything bigger doesn't convert to int32.
+	constexpr float int32Max = 2147483520.0f;
+
+	int sampleBytes(SampleFormat format)
+	{
+		switch (format)
+		{
+		case SampleFormat::UInt8: return 1;
+		case SampleFormat::Int16: return 2;
+		default: return 4;
+		}
+	}
+
+	Taps buildTaps(int inputs, int outputs)
+	{
+		Taps taps(outputs);
+		if (inputs == outputs)
+		{
+			for (int o = 0; o < outputs; ++o) { taps[o].push_back({ o, 1.0f }); }
+		}
+		else if (inputs == 1)
+		{
+			for (int o = 0; o < std::min(outputs, 2); ++o) { taps[o].push_back({ 0, 1.0f }); }
+		}
+		else if (outputs == 1)
+		{
+			for (int i = 0; i < inputs; ++i) { taps[0].push_back({ i, 1.0f / inputs }); }
+		}
+		else if (inputs == 6 && outputs == 2)
+		{
+			// ITU style 5.1 downmix, LFE dropped, scaled so a full scale signal on every channel can't clip.
+			constexpr float minus3dB = 0.70710678f;
+			constexpr float normalise = 1.0f / (1.0f + 2.0f * minus3dB);
+			taps[0] = { { 0, normalise }, { 2, minus3dB * normalise }, { 4, minus3dB * normalise } };
+			taps[1] = { { 1, normalise }, { 2, minus3dB * normalise }, { 5, minus3dB * normalise } };
+		}
+		else
+		{
+			for (int i = 0; i < inputs; ++i) { taps[i % outputs].push_back({ i, 1.0f }); }
+			for (auto& outputTaps : taps)
+			{
+				for (auto& tap : outputTaps) { tap.gain = 1.0f / outputTaps.size(); }
+			}
+		}
+		return taps;
+	}
+
+	// Conversion of a single mixed sample. The vector paths below must round and clamp identically:
+	//  scale, clamp, then round to nearest even (the default rounding mode, as cvtps uses).
+	void storeSample(float value, SampleFormat format, uint8_t* out)
+	{
+		switch (format)
+		{
+		case SampleFormat::UInt8:
+		{
+			float const scaled = std::clamp(value * 127.0f + 128.0f, 0.0f, 255.0f);
+			*out = static_cast<uint8_t>(std::nearbyint(scaled));
+			break;
+		}
+		case SampleFormat::Int16:
+		{
+			float const scaled = std::clamp(value * 32767.0f, -32768.0f, 32767.0f);
+			int16_t const sample = static_cast<int16_t>(std::nearbyint(scaled));
+			std::memcpy(out, &sample, sizeof(sample));
+			break;
+		}
+		case SampleFormat::Int32:
+		{
+			float const scaled = std::clamp(value * 2147483648.0f, -2147483648.0f, int32Max);
+			int32_t const sample = static_cast<int32_t>(std::nearbyint(scaled));
+			std::memcpy(out, &sample, sizeof(sample));
+			break;
+		}
+		case SampleFormat::Float:
+			std::memcpy(out, &value, sizeof(value));
+			break;
+		}
+	}
+
+	void convertScalar(Taps const& taps, SampleFormat format, float const* planar, size_t channelStride, size_t firstFrame, size_t frames, uint8_t* out)
+	{
+		int const bytes = sampleBytes(format);
+		for (size_t f = firstFrame; f < firstFrame + frames; ++f)
+		{
+			for (auto const& outputTaps : taps)
+			{
+				float mixed = 0.0f;
+				for (auto const& tap : outputTaps)
+				{
+					mixed += planar[tap.input * channelStride + f] * tap.gain;
+				}
+				storeSample(mixed, format, out);
+				out += bytes;
+			}
+		}
+	}
+
+#if NDIRECV_X86
+	// Both vector paths mix and convert a block of frames per output channel into lane storage, then
+	//  interleave from there. Mono and stereo, by far the common cases, get direct interleaving stores.
+	template <int Lanes>
+	struct Block
+	{
+		alignas(32) float floats[Lanes];
+		alignas(32) int32_t ints[Lanes];
+	};
+
+	NDIRECV_TARGET_SSE41 __m128 mixSse(std::vector<AudioFrameConverter::Tap> const& outputTaps, float const* planar, size_t channelStride, size_t f)
+	{
+		__m128 mixed = _mm_setzero_ps();
+		for (auto const& tap : outputTaps)
+		{
+			mixed = _mm_add_ps(mixed, _mm_mul_ps(_mm_loadu_ps(planar + tap.input * channelStride + f), _mm_set1_ps(tap.gain)));
+		}
+		return mixed;
+	}
+
+	NDIRECV_TARGET_SSE41 __m128i toIntsSse(__m128 mixed, SampleFormat format)
+	{
+		switch (format)
+		{
+		case SampleFormat::UInt8:
+			mixed = _mm_add_ps(_mm_mul_ps(mixed, _mm_set1_ps(127.0f)), _mm_set1_ps(128.0f));
+			mixed = _mm_min_ps(_mm_max_ps(mixed, _mm_set1_ps(0.0f)), _mm_set1_ps(255.0f));
+			break;
+		case SampleFormat::Int16:
+			mixed = _mm_mul_ps(mixed, _mm_set1_ps(32767.0f));
+			mixed = _mm_min_ps(_mm_max_ps(mixed, _mm_set1_ps(-32768.0f)), _mm_set1_ps(32767.0f));
+			break;
+		default:
+			mixed = _mm_mul_ps(mixed, _mm_set1_ps(2147483648.0f));
+			mixed = _mm_min_ps(_mm_max_ps(mixed, _mm_set1_ps(-2147483648.0f)), _mm_set1_ps(int32Max));
+			break;
+		}
+		return _mm_cvtps_epi32(mixed);
+	}
+
+	NDIRECV_TARGET_SSE41 void convertSse41(Taps const& taps, SampleFormat format, float const* planar, size_t channelStride, size_t frames, uint8_t* out)
+	{
+		int const outputs = static_cast<int>(taps.size());
+		int const bytes = sampleBytes(format);
+		size_t f = 0;
+		for (; f + 4 <= frames; f += 4)
+		{
+			if (format == SampleFormat::Float && outputs == 2)
+			{
+				__m128 const left = mixSse(taps[0], planar, channelStride, f);
+				__m128 const right = mixSse(taps[1], planar, channelStride, f);
+				_mm_storeu_ps(reinterpret_cast<float*>(out), _mm_unpacklo_ps(left, right));
+				_mm_storeu_ps(reinterpret_cast<float*>(out) + 4, _mm_unpackhi_ps(left, right));
+			}
+			else if (format == SampleFormat::Int16 && outputs == 2)
+			{
+				__m128i const left = toIntsSse(mixSse(taps[0], planar, channelStride, f), format);
+				__m128i const right = toIntsSse(mixSse(taps[1], planar, channelStride, f), format);
+				// Values are already clamped to int16 range, so the saturating pack is exact.
+				__m128i const packed = _mm_packs_epi32(_mm_unpacklo_epi32(left, right), _mm_unpackhi_epi32(left, right));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(out), packed);
+			}
+			else
+			{
+				Block<4> block;
+				for (int o = 0; o < outputs; ++o)
+				{
+					__m128 const mixed = mixSse(taps[o], planar, channelStride, f);
+					if (format == SampleFormat::Float) { _mm_store_ps(block.floats, mixed); }
+					else { _mm_store_si128(reinterpret_cast<__m128i*>(block.ints), toIntsSse(mixed, format)); }
+
+					for (int lane = 0; lane < 4; ++lane)
+					{
+						uint8_t* sample = out + (lane * outputs + o) * bytes;
+						switch (format)
+						{
+						case SampleFormat::Float: std::memcpy(sample, &block.floats[lane], 4); break;
+						case SampleFormat::Int32: std::memcpy(sample, &block.ints[lane], 4); break;
+						case SampleFormat::Int16: { int16_t const v = static_cast<int16_t>(block.ints[lane]); std::memcpy(sample, &v, 2); break; }
+						case SampleFormat::UInt8: *sample = static_cast<uint8_t>(block.ints[lane]); break;
+						}
+					}
+				}
+			}
+			out += 4 * outputs * bytes;
+		}
+		convertScalar(taps, format, planar, channelStride, f, frames - f, out);
+	}
+
+	NDIRECV_TARGET_AVX2 __m256 mixAvx2(std::vector<AudioFrameConverter::Tap> const& outputTaps, float const* planar, size_t channelStride, size_t f)
+	{
+		__m256 mixed = _mm256_setzero_ps();
+		for (auto const& tap : outputTaps)
+		{
+			mixed = _mm256_add_ps(mixed, _mm256_mul_ps(_mm256_loadu_ps(planar + tap.input * channelStride + f), _mm256_set1_ps(tap.gain)));
+		}
+		return mixed;
+	}
+
+	NDIRECV_TARGET_AVX2 __m256i toIntsAvx2(__m256 mixed, SampleFormat format)
+	{
+		switch (format)
+		{
+		case SampleFormat::UInt8:
+			mixed = _mm256_add_ps(_mm256_mul_ps(mixed, _mm256_set1_ps(127.0f)), _mm256_set1_ps(128.0f));
+			mixed = _mm256_min_ps(_mm256_max_ps(mixed, _mm256_set1_ps(0.0f)), _mm256_set1_ps(255.0f));
+			break;
+		case SampleFormat::Int16:
+			mixed = _mm256_mul_ps(mixed, _mm256_set1_ps(32767.0f));
+			mixed = _mm256_min_ps(_mm256_max_ps(mixed, _mm256_set1_ps(-32768.0f)), _mm256_set1_ps(32767.0f));
+			break;
+		default:
+			mixed = _mm256_mul_ps(mixed, _mm256_set1_ps(2147483648.0f));
+			mixed = _mm256_min_ps(_mm256_max_ps(mixed, _mm256_set1_ps(-2147483648.0f)), _mm256_set1_ps(int32Max));
+			break;
+		}
+		return _mm256_cvtps_epi32(mixed);
+	}
+
+	NDIRECV_TARGET_AVX2 void convertAvx2(Taps const& taps, SampleFormat format, float const* planar, size_t channelStride, size_t frames, uint8_t* out)
+	{
+		int const outputs = static_cast<int>(taps.size());
+		int const bytes = sampleBytes(format);
+		size_t f = 0;
+		for (; f + 8 <= frames; f += 8)
+		{
+			if (format == SampleFormat::Float && outputs == 2)
+			{
+				__m256 const left = mixAvx2(taps[0], planar, channelStride, f);
+				__m256 const right = mixAvx2(taps[1], planar, channelStride, f);
+				__m256 const low = _mm256_unpacklo_ps(left, right);   // Frames 0 1 | 4 5
+				__m256 const high = _mm256_unpackhi_ps(left, right);  // Frames 2 3 | 6 7
+				_mm256_storeu_ps(reinterpret_cast<float*>(out), _mm256_permute2f128_ps(low, high, 0x20));
+				_mm256_storeu_ps(reinterpret_cast<float*>(out) + 8, _mm256_permute2f128_ps(low, high, 0x31));
+			}
+			else if (format == SampleFormat::Float && outputs == 1)
+			{
+				_mm256_storeu_ps(reinterpret_cast<float*>(out), mixAvx2(taps[0], planar, channelStride, f));
+			}
+			else
+			{
+				Block<8> block;
+				for (int o = 0; o < outputs; ++o)
+				{
+					__m256 const mixed = mixAvx2(taps[o], planar, channelStride, f);
+					if (format == SampleFormat::Float) { _mm256_store_ps(block.floats, mixed); }
+					else { _mm256_store_si256(reinterpret_cast<__m256i*>(block.ints), toIntsAvx2(mixed, format)); }
+
+					for (int lane = 0; lane < 8; ++lane)
+					{
+						uint8_t* sample = out + (lane * outputs + o) * bytes;
+						switch (format)
+						{
+						case SampleFormat::Float: std::memcpy(sample, &block.floats[lane], 4); break;
+						case SampleFormat::Int32: std::memcpy(sample, &block.ints[lane], 4); break;
+						case SampleFormat::Int16: { int16_t const v = static_cast<int16_t>(block.ints[lane]); std::memcpy(sample, &v, 2); break; }
+						case SampleFormat::UInt8: *sample = static_cast<uint8_t>(block.ints[lane]); break;
+						}
+					}
+				}
+			}
+			out += 8 * outputs * bytes;
+		}
+		convertScalar(taps, format, planar, channelStride, f, frames - f, out);
+	}
+#endif
+}
+
+AudioFrameConverter::AudioFrameConverter(KernelPath path)
+	: m_path{ CpuFeatures::resolve(path) }
+{
+}
+
+void AudioFrameConverter::configure(int inputChannels, int outputChannels, SampleFormat format)
+{
+	m_inputChannels = inputChannels;
+	m_outputChannels = outputChannels;
+	m_format = format;
+	m_bytesPerFrame = outputChannels * sampleBytes(format);
+	m_taps = buildTaps(inputChannels, outputChannels);
+}
+
+void AudioFrameConverter::convert(float const* planar, size_t channelStride, size_t frames, uint8_t* out) const
+{
+	if (m_outputChannels <= 0 || m_inputChannels <= 0 || frames == 0)
+	{
+		return;
+	}
+#if NDIRECV_X86
+	if (m_path == KernelPath::AVX2) { convertAvx2(m_taps, m_format, planar, channelStride, frames, out); return; }
+	if (m_path == KernelPath::SSE41) { convertSse41(m_taps, m_format, planar, channelStride, frames, out); return; }
+#endif
+	convertScalar(m_taps, m_format, planar, channelStride, 0, frames, out);
+}
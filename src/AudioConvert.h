@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "CpuFeatures.h"
+
+// Sample formats an output device may ask for. Mirrors QAudioFormat::SampleFormat, kept separate so the
+//  kernels don't depend on Qt.
+enum class SampleFormat
+{
+    UInt8,
+    Int16,
+    Int32,
+    Float
+};
+
+// Turns planar float audio (as NDI delivers it) into interleaved samples in the output device's format and
+//  channel count, in a single pass. For each block of frames it mixes each output channel from its input
+//  channels, scales and converts to the sample format, and stores straight into the caller's buffer; no
+//  intermediate interleaved float copy is made.
+//
+// Channel counts that differ are mixed: mono is copied to the first two outputs, anything to mono is
+//  averaged, 5.1 (L R C LFE Ls Rs) to stereo uses the usual -3dB centre and surround downmix, and any
+//  other combination folds input channel i onto output i modulo the output count.
+class AudioFrameConverter
+{
+public:
+    explicit AudioFrameConverter(KernelPath path = KernelPath::Best);
+
+    void configure(int inputChannels, int outputChannels, SampleFormat format);
+
+    int inputChannels() const { return m_inputChannels; }
+    int outputChannels() const { return m_outputChannels; }
+    int bytesPerFrame() const { return m_bytesPerFrame; }
+    KernelPath path() const { return m_path; }
+
+    // planar points at the first sample of the first channel to convert; each channel's samples follow
+    //  the previous channel's at channelStride floats. Writes frames * bytesPerFrame() bytes to out.
+    void convert(float const* planar, size_t channelStride, size_t frames, uint8_t* out) const;
+
+    struct Tap
+    {
+        int input;
+        float gain;
+    };
+
+private:
+    KernelPath m_path;
+    int m_inputChannels{ 0 };
+    int m_outputChannels{ 0 };
+    int m_bytesPerFrame{ 0 };
+    SampleFormat m_format{ SampleFormat::Float };
+    std::vector<std::vector<Tap>> m_taps; // For each output channel, the inputs that feed it
+};
@@ -0,0 +1,430 @@
+#include "AudioMeter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if NDIRECV_X86
+#include <immintrin.h>
+#endif
+
+namespace
+{
+	using Measure = AudioMeter::Measure;
+	using ChannelState = AudioMeter::ChannelState;
+	using Filters = AudioMeter::Filters;
+
+	constexpr double pi = 3.14159265358979323846;
+	constexpr float peakFallDbPerSecond = 20.0f / 1.7f; // IEC 60268-18 peak meter return
+	constexpr double rmsSeconds = 0.3;                   // Time constant of the RMS meter
+	constexpr size_t historyLength = AudioMeter::truePeakTaps - 1;
+	// The vector paths read the first few samples of a run, whose filter taps reach back into the
+	//  history, from a copy with the history in front. A multiple of every vector width.
+	constexpr size_t edgeFrames = 16;
+
+	Filters design(int const sampleRate)
+	{
+		Filters filters{};
+
+		// K-weighting: BS.1770's high shelf then high pass, derived from their analogue prototypes so that
+		//  any rate gets the response the standard specifies at 48 kHz.
+		double K = std::tan(pi * 1681.974450955533 / sampleRate);
+		double Q = 0.7071752369554196;
+		double const Vh = std::pow(10.0, 3.999843853973347 / 20.0);
+		double const Vb = std::pow(Vh, 0.4996667741545416);
+		double a0 = 1.0 + K / Q + K * K;
+		filters.shelf = { (Vh + Vb * K / Q + K * K) / a0, 2.0 * (K * K - Vh) / a0, (Vh - Vb * K / Q + K * K) / a0,
+			              2.0 * (K * K - 1.0) / a0, (1.0 - K / Q + K * K) / a0 };
+
+		K = std::tan(pi * 38.13547087602444 / sampleRate);
+		Q = 0.5003270373238773;
+		a0 = 1.0 + K / Q + K * K;
+		filters.highPass = { 1.0, -2.0, 1.0, 2.0 * (K * K - 1.0) / a0, (1.0 - K / Q + K * K) / a0 };
+
+		// True peak: Hann windowed sinc, each phase normalised to unity gain at DC. Phase 0 lands on a sample,
+		//  so the true peak is never below the sample peak.
+		for (int p = 0; p < AudioMeter::truePeakPhases; ++p)
+		{
+			double sum = 0.0;
+			double taps[AudioMeter::truePeakTaps];
+			for (int j = 0; j < AudioMeter::truePeakTaps; ++j)
+			{
+				double const u = j - 6 + double(p) / AudioMeter::truePeakPhases;
+				double const sinc = u == 0.0 ? 1.0 : std::sin(pi * u) / (pi * u);
+				double const window = std::abs(u) < 6.0 ? 0.5 * (1.0 + std::cos(pi * u / 6.0)) : 0.0;
+				taps[j] = sinc * window;
+				sum += taps[j];
+			}
+			for (int j = 0; j < AudioMeter::truePeakTaps; ++j)
+			{
+				filters.truePeak[p][j] = static_cast<float>(taps[j] / sum);
+			}
+		}
+		return filters;
+	}
+
+	float amplitudeDb(double const amplitude)
+	{
+		return amplitude > 0.0 ? std::max(static_cast<float>(20.0 * std::log10(amplitude)), AudioLevels::floorDb) : AudioLevels::floorDb;
+	}
+
+	float powerDb(double const power)
+	{
+		return power > 0.0 ? std::max(static_cast<float>(10.0 * std::log10(power)), AudioLevels::floorDb) : AudioLevels::floorDb;
+	}
+
+	float loudness(double const weightedPower)
+	{
+		return weightedPower > 0.0 ? std::max(static_cast<float>(-0.691 + 10.0 * std::log10(weightedPower)), AudioLevels::floorDb) : AudioLevels::floorDb;
+	}
+
+	// One sample through both K-weighting filters
+	NDIRECV_FORCE_INLINE double kWeight(Filters const& filters, ChannelState& state, double const x)
+	{
+		AudioMeter::Biquad const& s{ filters.shelf };
+		double const shelved = s.b0 * x + state.shelf[0];
+		state.shelf[0] = s.b1 * x - s.a1 * shelved + state.shelf[1];
+		state.shelf[1] = s.b2 * x - s.a2 * shelved;
+
+		AudioMeter::Biquad const& h{ filters.highPass };
+		double const y = h.b0 * shelved + state.highPass[0];
+		state.highPass[0] = h.b1 * shelved - h.a1 * y + state.highPass[1];
+		state.highPass[1] = h.b2 * shelved - h.a2 * y;
+		return y;
+	}
+
+	// Samples first to last, with the true peak filter reaching back into the history before the run. The
+	//  whole of the scalar path, and the tails of the vector ones.
+	void measureRange(Filters const& filters, ChannelState& state, float const* samples, size_t first, size_t last, Measure& measure)
+	{
+		auto const at = [&](ptrdiff_t const index) { return index >= 0 ? samples[index] : state.history[historyLength + index]; };
+		for (size_t i = first; i < last; ++i)
+		{
+			float const sample = samples[i];
+			measure.peak = std::max(measure.peak, std::abs(sample));
+			measure.sumSquares += double(sample) * sample;
+			for (int p = 0; p < AudioMeter::truePeakPhases; ++p)
+			{
+				float interpolated = 0.0f;
+				for (int j = 0; j < AudioMeter::truePeakTaps; ++j)
+				{
+					interpolated += filters.truePeak[p][j] * at(static_cast<ptrdiff_t>(i) - j);
+				}
+				measure.truePeak = std::max(measure.truePeak, std::abs(interpolated));
+			}
+			double const weighted = kWeight(filters, state, sample);
+			measure.weightedSumSquares += weighted * weighted;
+		}
+	}
+
+	void finishRun(ChannelState& state, float const* samples, size_t const frames)
+	{
+		if (frames >= historyLength)
+		{
+			std::memcpy(state.history.data(), samples + frames - historyLength, historyLength * sizeof(float));
+		}
+		else
+		{
+			std::memmove(state.history.data(), state.history.data() + frames, (historyLength - frames) * sizeof(float));
+			std::memcpy(state.history.data() + historyLength - frames, samples, frames * sizeof(float));
+		}
+
+		// Silence would otherwise decay the filter state into denormals, which are very slow on x86
+		for (double* value : { &state.shelf[0], &state.shelf[1], &state.highPass[0], &state.highPass[1] })
+		{
+			if (std::abs(*value) < 1e-30) { *value = 0.0; }
+		}
+	}
+
+	// Copies the history, then as much of the run as the vector loop reads from the copy
+	template <size_t Length>
+	void fillEdge(ChannelState const& state, float const* samples, size_t const frames, float (&edge)[Length])
+	{
+		static_assert(Length == historyLength + edgeFrames);
+		std::memcpy(edge, state.history.data(), historyLength * sizeof(float));
+		std::memcpy(edge + historyLength, samples, std::min(frames, edgeFrames) * sizeof(float));
+	}
+
+	Measure measureScalar(Filters const& filters, ChannelState& state, float const* samples, size_t const frames)
+	{
+		Measure measure;
+		measureRange(filters, state, samples, 0, frames, measure);
+		finishRun(state, samples, frames);
+		return measure;
+	}
+
+#if NDIRECV_X86
+	NDIRECV_TARGET_SSE41 Measure measureSse41(Filters const& filters, ChannelState& state, float const* samples, size_t const frames)
+	{
+		alignas(16) float edge[historyLength + edgeFrames];
+		fillEdge(state, samples, frames, edge);
+
+		__m128 const signMask = _mm_set1_ps(-0.0f);
+		__m128 peak = _mm_setzero_ps();
+		__m128 truePeak = _mm_setzero_ps();
+		__m128 squares = _mm_setzero_ps();
+		double weightedSquares = 0.0;
+		size_t i = 0;
+		for (; i + 4 <= frames; i += 4)
+		{
+			float const* const at = i < edgeFrames ? edge + historyLength + i : samples + i;
+			__m128 const current = _mm_loadu_ps(at);
+			peak = _mm_max_ps(peak, _mm_andnot_ps(signMask, current));
+			squares = _mm_add_ps(squares, _mm_mul_ps(current, current));
+
+			__m128 interpolated[AudioMeter::truePeakPhases]{ _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps() };
+			for (int j = 0; j < AudioMeter::truePeakTaps; ++j)
+			{
+				__m128 const past = _mm_loadu_ps(at - j);
+				for (int p = 0; p < AudioMeter::truePeakPhases; ++p)
+				{
+					interpolated[p] = _mm_add_ps(interpolated[p], _mm_mul_ps(past, _mm_set1_ps(filters.truePeak[p][j])));
+				}
+			}
+			for (int p = 0; p < AudioMeter::truePeakPhases; ++p)
+			{
+				truePeak = _mm_max_ps(truePeak, _mm_andnot_ps(signMask, interpolated[p]));
+			}
+
+			alignas(16) float lanes[4];
+			_mm_store_ps(lanes, current);
+			for (float const sample : lanes)
+			{
+				double const weighted = kWeight(filters, state, sample);
+				weightedSquares += weighted * weighted;
+			}
+		}
+
+		alignas(16) float peaks[4], truePeaks[4], sums[4];
+		_mm_store_ps(peaks, peak);
+		_mm_store_ps(truePeaks, truePeak);
+		_mm_store_ps(sums, squares);
+		Measure measure;
+		measure.peak = std::max({ peaks[0], peaks[1], peaks[2], peaks[3] });
+		measure.truePeak = std::max({ truePeaks[0], truePeaks[1], truePeaks[2], truePeaks[3] });
+		measure.sumSquares = double(sums[0]) + sums[1] + sums[2] + sums[3];
+		measure.weightedSumSquares = weightedSquares;
+
+		measureRange(filters, state, samples, i, frames, measure);
+		finishRun(state, samples, frames);
+		return measure;
+	}
+
+	NDIRECV_TARGET_AVX2 Measure measureAvx2(Filters const& filters, ChannelState& state, float const* samples, size_t const frames)
+	{
+		alignas(32) float edge[historyLength + edgeFrames];
+		fillEdge(state, samples, frames, edge);
+
+		__m256 const signMask = _mm256_set1_ps(-0.0f);
+		__m256 peak = _mm256_setzero_ps();
+		__m256 truePeak = _mm256_setzero_ps();
+		__m256 squares = _mm256_setzero_ps();
+		double weightedSquares = 0.0;
+		size_t i = 0;
+		for (; i + 8 <= frames; i += 8)
+		{
+			float const* const at = i < edgeFrames ? edge + historyLength + i : samples + i;
+			__m256 const current = _mm256_loadu_ps(at);
+			peak = _mm256_max_ps(peak, _mm256_andnot_ps(signMask, current));
+			squares = _mm256_add_ps(squares, _mm256_mul_ps(current, current));
+
+			__m256 interpolated[AudioMeter::truePeakPhases]{ _mm256_setzero_ps(), _mm256_setzero_ps(), _mm256_setzero_ps(), _mm256_setzero_ps() };
+			for (int j = 0; j < AudioMeter::truePeakTaps; ++j)
+			{
+				__m256 const past = _mm256_loadu_ps(at - j);
+				for (int p = 0; p < AudioMeter::truePeakPhases; ++p)
+				{
+					interpolated[p] = _mm256_add_ps(interpolated[p], _mm256_mul_ps(past, _mm256_broadcast_ss(&filters.truePeak[p][j])));
+				}
+			}
+			for (int p = 0; p < AudioMeter::truePeakPhases; ++p)
+			{
+				truePeak = _mm256_max_ps(truePeak, _mm256_andnot_ps(signMask, interpolated[p]));
+			}
+
+			alignas(32) float lanes[8];
+			_mm256_store_ps(lanes, current);
+			for (float const sample : lanes)
+			{
+				double const weighted = kWeight(filters, state, sample);
+				weightedSquares += weighted * weighted;
+			}
+		}
+
+		alignas(32) float peaks[8], truePeaks[8], sums[8];
+		_mm256_store_ps(peaks, peak);
+		_mm256_store_ps(truePeaks, truePeak);
+		_mm256_store_ps(sums, squares);
+		Measure measure;
+		measure.peak = *std::max_element(std::begin(peaks), std::end(peaks));
+		measure.truePeak = *std::max_element(std::begin(truePeaks), std::end(truePeaks));
+		for (float const sum : sums) { measure.sumSquares += sum; }
+		measure.weightedSumSquares = weightedSquares;
+
+		measureRange(filters, state, samples, i, frames, measure);
+		finishRun(state, samples, frames);
+		return measure;
+	}
+#endif
+}
+
+AudioMeter::AudioMeter(AudioLevels& levels, KernelPath path)
+	: m_levels{ levels }
+	, m_path{ CpuFeatures::resolve(path) }
+	, m_measure{ measureScalar }
+{
+#if NDIRECV_X86
+	if (m_path == KernelPath::AVX2) { m_measure = measureAvx2; }
+	else if (m_path == KernelPath::SSE41) { m_measure = measureSse41; }
+#endif
+}
+
+void AudioMeter::configure(int const channels, int const sampleRate)
+{
+	m_channelCount = sampleRate > 0 ? std::max(channels, 0) : 0;
+	m_sampleRate = m_channelCount > 0 ? sampleRate : 0;
+	m_channels.assign(std::min(m_channelCount, AudioLevels::maxChannels), ChannelState{});
+	if (m_channels.size() == 6)
+	{
+		m_channels[3].weight = 0.0f;  // LFE
+		m_channels[4].weight = 1.41f; // Surrounds
+		m_channels[5].weight = 1.41f;
+	}
+	if (m_sampleRate > 0)
+	{
+		m_filters = design(m_sampleRate);
+	}
+	m_stepFrames = static_cast<size_t>(std::max(m_sampleRate / 10, 1));
+	m_stepFilled = 0;
+	m_stepPower.fill(0.0);
+	m_steps = 0;
+	m_gateCounts.assign(gateBins, 0);
+	m_gatePower.assign(gateBins, 0.0);
+
+	for (auto& channel : m_levels.channels)
+	{
+		channel.peak.store(AudioLevels::floorDb, std::memory_order_relaxed);
+		channel.truePeak.store(AudioLevels::floorDb, std::memory_order_relaxed);
+		channel.rms.store(AudioLevels::floorDb, std::memory_order_relaxed);
+	}
+	m_levels.momentaryLufs.store(AudioLevels::floorDb, std::memory_order_relaxed);
+	m_levels.shortTermLufs.store(AudioLevels::floorDb, std::memory_order_relaxed);
+	m_levels.integratedLufs.store(AudioLevels::floorDb, std::memory_order_relaxed);
+	m_levels.maxTruePeak.store(AudioLevels::floorDb, std::memory_order_relaxed);
+	m_levels.channelCount.store(static_cast<int>(m_channels.size()), std::memory_order_relaxed);
+}
+
+void AudioMeter::process(float const* planar, size_t const channelStride, size_t const frames)
+{
+	if (m_channels.empty() || !planar || frames == 0)
+	{
+		return;
+	}
+
+	// In runs that end where a 100 ms loudness step does
+	std::array<Measure, AudioLevels::maxChannels> measured{};
+	size_t done = 0;
+	while (done < frames)
+	{
+		size_t const run = std::min(frames - done, m_stepFrames - m_stepFilled);
+		for (size_t c = 0; c < m_channels.size(); ++c)
+		{
+			Measure const measure = m_measure(m_filters, m_channels[c], planar + c * channelStride + done, run);
+			measured[c].peak = std::max(measured[c].peak, measure.peak);
+			measured[c].truePeak = std::max(measured[c].truePeak, measure.truePeak);
+			measured[c].sumSquares += measure.sumSquares;
+			m_channels[c].blockWeightedSquares += measure.weightedSumSquares;
+		}
+		done += run;
+		m_stepFilled += run;
+		if (m_stepFilled == m_stepFrames)
+		{
+			closeLoudnessStep();
+		}
+	}
+	publish(measured, frames);
+}
+
+void AudioMeter::closeLoudnessStep()
+{
+	double power = 0.0;
+	for (auto& channel : m_channels)
+	{
+		power += channel.weight * channel.blockWeightedSquares / m_stepFrames;
+		channel.blockWeightedSquares = 0.0;
+	}
+	m_stepFilled = 0;
+	m_stepPower[m_steps % m_stepPower.size()] = power;
+	++m_steps;
+
+	auto const meanOfLast = [this](size_t const count) {
+		double sum = 0.0;
+		for (size_t step = m_steps - count; step < m_steps; ++step)
+		{
+			sum += m_stepPower[step % m_stepPower.size()];
+		}
+		return sum / count;
+	};
+	m_levels.shortTermLufs.store(loudness(meanOfLast(std::min(m_steps, m_stepPower.size()))), std::memory_order_relaxed);
+	if (m_steps < 4)
+	{
+		return;
+	}
+
+	// Every momentary block, overlapping the last by 75%, is a gating block for integrated loudness
+	double const momentary = meanOfLast(4);
+	float const momentaryLufs = loudness(momentary);
+	m_levels.momentaryLufs.store(momentaryLufs, std::memory_order_relaxed);
+	if (momentaryLufs > -70.0f)
+	{
+		int const bin = std::min(static_cast<int>((momentaryLufs + 70.0f) * 10.0f), gateBins - 1);
+		++m_gateCounts[bin];
+		m_gatePower[bin] += momentary;
+	}
+
+	uint64_t blocks = 0;
+	double total = 0.0;
+	for (int bin = 0; bin < gateBins; ++bin)
+	{
+		blocks += m_gateCounts[bin];
+		total += m_gatePower[bin];
+	}
+	if (blocks == 0)
+	{
+		return;
+	}
+	int const firstAboveRelativeGate = std::clamp(static_cast<int>((loudness(total / blocks) - 10.0f + 70.0f) * 10.0f), 0, gateBins - 1);
+	blocks = 0;
+	total = 0.0;
+	for (int bin = firstAboveRelativeGate; bin < gateBins; ++bin)
+	{
+		blocks += m_gateCounts[bin];
+		total += m_gatePower[bin];
+	}
+	m_levels.integratedLufs.store(blocks ? loudness(total / blocks) : AudioLevels::floorDb, std::memory_order_relaxed);
+}
+
+void AudioMeter::publish(std::array<Measure, AudioLevels::maxChannels> const& measured, size_t const frames)
+{
+	double const seconds = static_cast<double>(frames) / m_sampleRate;
+	float const fall = static_cast<float>(peakFallDbPerSecond * seconds);
+	double const smoothing = 1.0 - std::exp(-seconds / rmsSeconds);
+	float maxTruePeak = m_levels.maxTruePeak.load(std::memory_order_relaxed); // Only ever written here
+
+	for (size_t c = 0; c < m_channels.size(); ++c)
+	{
+		ChannelState& channel{ m_channels[c] };
+		Measure const& measure{ measured[c] };
+		channel.meanSquare += smoothing * (measure.sumSquares / frames - channel.meanSquare);
+		channel.peakDb = std::max(amplitudeDb(measure.peak), std::max(channel.peakDb - fall, AudioLevels::floorDb));
+		float const truePeakDb = amplitudeDb(measure.truePeak);
+		channel.truePeakDb = std::max(truePeakDb, std::max(channel.truePeakDb - fall, AudioLevels::floorDb));
+		maxTruePeak = std::max(maxTruePeak, truePeakDb);
+
+		AudioLevels::Channel& levels{ m_levels.channels[c] };
+		levels.peak.store(channel.peakDb, std::memory_order_relaxed);
+		levels.truePeak.store(channel.truePeakDb, std::memory_order_relaxed);
+		levels.rms.store(powerDb(channel.meanSquare), std::memory_order_relaxed);
+	}
+	m_levels.maxTruePeak.store(maxTruePeak, std::memory_order_relaxed);
+}
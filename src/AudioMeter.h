@@ -0,0 +1,100 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "CpuFeatures.h"
+#include "Stats.h"
+
+// Measures planar float audio (as NDI delivers it) for level meters and loudness, and publishes the
+//  results into an AudioLevels as it goes: sample peak, true peak and RMS per channel, and EBU R128
+//  momentary, short-term and integrated loudness (ITU-R BS.1770: K-weighted, 400 ms blocks gated at
+//  -70 LUFS absolute and -10 LU relative).
+//
+// Each channel's samples are read once. Peak, RMS and the 4x oversampling true peak filter run several
+//  samples to a vector; the K-weighting filters are recursive, so they run sample by sample in the same
+//  loop, on values already loaded. Integrated loudness keeps a histogram of block loudness rather than
+//  every block, so it costs the same after an hour as after a second, to within 0.1 LU.
+//
+// 5.1 is taken to be L R C LFE Ls Rs, as AudioFrameConverter does: the LFE doesn't count towards
+//  loudness and the surrounds are weighted +1.5 dB. Every other layout weights all channels equally.
+class AudioMeter
+{
+public:
+    explicit AudioMeter(AudioLevels& levels, KernelPath path = KernelPath::Best);
+
+    // Starts afresh, integrated loudness included, for audio in this format. 0 channels meters nothing.
+    void configure(int channels, int sampleRate);
+
+    int channels() const { return m_channelCount; } // As configured; only the first AudioLevels::maxChannels are metered
+    int sampleRate() const { return m_sampleRate; }
+    KernelPath path() const { return m_path; }
+
+    // planar points at the first sample of the first channel; each channel's samples follow the previous
+    //  channel's at channelStride floats.
+    void process(float const* planar, size_t channelStride, size_t frames);
+
+    // What a run of samples measured. Public for the kernels.
+    struct Measure
+    {
+        float peak{ 0.0f };
+        float truePeak{ 0.0f };
+        double sumSquares{ 0.0 };
+        double weightedSumSquares{ 0.0 }; // K-weighted
+    };
+
+    // The true peak filter: 4 phases of 12 taps, interpolating between the samples 6 and 5 back
+    static constexpr int truePeakPhases = 4;
+    static constexpr int truePeakTaps = 12;
+
+    struct Biquad
+    {
+        double b0, b1, b2, a1, a2;
+    };
+
+    struct ChannelState
+    {
+        std::array<float, truePeakTaps - 1> history{}; // The last samples seen, oldest first, for the true peak filter
+        double shelf[2]{};                             // K-weighting filter state, transposed direct form II
+        double highPass[2]{};
+        double blockWeightedSquares{ 0.0 };            // K-weighted, so far in the current 100 ms loudness step
+        double meanSquare{ 0.0 };                      // Smoothed, for the RMS meter
+        float peakDb{ AudioLevels::floorDb };          // As last shown, falling back
+        float truePeakDb{ AudioLevels::floorDb };
+        float weight{ 1.0f };                          // Towards loudness
+    };
+
+    struct Filters
+    {
+        Biquad shelf;
+        Biquad highPass;
+        alignas(32) float truePeak[truePeakPhases][truePeakTaps]; // truePeak[p][j] multiplies the sample j back
+    };
+
+private:
+    using MeasureFunction = Measure (*)(Filters const& filters, ChannelState& state, float const* samples, size_t frames);
+
+    void closeLoudnessStep();
+    void publish(std::array<Measure, AudioLevels::maxChannels> const& measured, size_t frames);
+
+    AudioLevels& m_levels;
+    KernelPath m_path;
+    MeasureFunction m_measure;
+    int m_channelCount{ 0 };
+    int m_sampleRate{ 0 };
+    Filters m_filters{};
+    std::vector<ChannelState> m_channels;
+
+    // Loudness, in 100 ms steps. Momentary is the mean power of the last 4, short-term of the last 30.
+    size_t m_stepFrames{ 0 };
+    size_t m_stepFilled{ 0 };
+    std::array<double, 30> m_stepPower{};
+    size_t m_steps{ 0 };
+
+    // Integrated: every 400 ms block above the absolute gate, binned by loudness in 0.1 LU steps from -70
+    static constexpr int gateBins = 800;
+    std::vector<uint64_t> m_gateCounts;
+    std::vector<double> m_gatePower;
+};
@@ -0,0 +1,105 @@
+#include "AudioMeterWidget.h"
+
+#include <QFontDatabase>
+#include <QFontMetrics>
+#include <QLinearGradient>
+#include <QPainter>
+#include <algorithm>
+
+namespace
+{
+	constexpr int refreshIntervalMs = 33;
+	constexpr float scaleBottomDb = -60.0f;
+	constexpr int minWidthForText = 70; // Narrower, as on a multiview tile, it's just the bars
+}
+
+AudioMeterWidget::AudioMeterWidget(QWidget* parent)
+	: QWidget(parent)
+{
+	setAttribute(Qt::WA_OpaquePaintEvent);
+	m_refresh.setInterval(refreshIntervalMs);
+	connect(&m_refresh, &QTimer::timeout, this, qOverload<>(&QWidget::update));
+}
+
+void AudioMeterWidget::setLevels(AudioLevels const* const levels)
+{
+	m_levels = levels;
+	update();
+}
+
+QSize AudioMeterWidget::sizeHint() const
+{
+	return QSize(90, 200);
+}
+
+void AudioMeterWidget::showEvent(QShowEvent* event)
+{
+	m_refresh.start();
+	QWidget::showEvent(event);
+}
+
+void AudioMeterWidget::hideEvent(QHideEvent* event)
+{
+	m_refresh.stop();
+	QWidget::hideEvent(event);
+}
+
+void AudioMeterWidget::paintEvent(QPaintEvent*)
+{
+	QPainter painter(this);
+	painter.fillRect(rect(), Qt::black);
+	int const channels{ m_levels ? m_levels->channelCount.load(std::memory_order_relaxed) : 0 };
+
+	bool const withText{ width() >= minWidthForText };
+	QFont const font{ QFontDatabase::systemFont(QFontDatabase::FixedFont) };
+	int const textHeight{ withText ? QFontMetrics(font).height() : 0 };
+	QRect const bars{ rect().adjusted(2, 2, -2, -2 - 2 * textHeight) };
+	if (withText)
+	{
+		painter.setFont(font);
+		painter.setPen(Qt::lightGray);
+	}
+	if (channels == 0 || bars.height() <= 0)
+	{
+		if (withText)
+		{
+			painter.drawText(rect(), Qt::AlignCenter, "No audio");
+		}
+		return;
+	}
+
+	auto const heightFor = [&bars](float const db) {
+		return static_cast<int>(std::clamp((db - scaleBottomDb) / -scaleBottomDb, 0.0f, 1.0f) * bars.height());
+	};
+	// Green up to the usual -18 dBFS alignment level, amber to -6, red above
+	QLinearGradient gradient(0, bars.bottom(), 0, bars.top());
+	gradient.setColorAt(0.0, QColor(0, 160, 0));
+	gradient.setColorAt(1.0f - 18.0f / -scaleBottomDb, QColor(0, 220, 0));
+	gradient.setColorAt(1.0f - 6.0f / -scaleBottomDb, QColor(255, 190, 0));
+	gradient.setColorAt(1.0, QColor(255, 40, 0));
+
+	int const gap{ channels > 1 ? 1 : 0 };
+	int const barWidth{ std::max(1, (bars.width() - gap * (channels - 1)) / channels) };
+	for (int channel = 0; channel < channels; ++channel)
+	{
+		AudioLevels::Channel const& levels{ m_levels->channels[channel] };
+		int const x{ bars.left() + channel * (barWidth + gap) };
+		if (x + barWidth > bars.right() + 1)
+		{
+			break; // Too many channels for the width; the rest are still in the stats
+		}
+		int const rmsHeight{ heightFor(levels.rms.load(std::memory_order_relaxed)) };
+		painter.fillRect(QRect(x, bars.bottom() + 1 - rmsHeight, barWidth, rmsHeight), gradient);
+		int const peakHeight{ heightFor(levels.peak.load(std::memory_order_relaxed)) };
+		bool const over{ levels.truePeak.load(std::memory_order_relaxed) > 0.0f };
+		painter.fillRect(QRect(x, bars.bottom() + 1 - std::max(peakHeight, 2), barWidth, 2), over ? Qt::red : Qt::white);
+	}
+
+	if (withText)
+	{
+		QRect const text{ rect().adjusted(2, 0, -2, -2) };
+		painter.drawText(text, Qt::AlignBottom | Qt::AlignLeft,
+			QString("M %1\nI %2").arg(m_levels->momentaryLufs.load(std::memory_order_relaxed), 0, 'f', 1)
+			                     .arg(m_levels->integratedLufs.load(std::memory_order_relaxed), 0, 'f', 1));
+	}
+}
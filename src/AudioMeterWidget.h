@@ -0,0 +1,32 @@
+#pragma once
+
+#include <QTimer>
+#include <QWidget>
+
+#include "Stats.h"
+
+// Level meters for one source. A bar per channel: RMS filled, sample peak as a line that falls back slowly,
+//  turning red while the true peak is over 0 dBTP. Scaled -60 to 0 dBFS. Given the room, momentary and
+//  integrated loudness are written underneath. The audio path never signals the widget; it reads the
+//  AudioLevels on a timer, as often as a meter needs redrawing, and only while shown.
+class AudioMeterWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit AudioMeterWidget(QWidget* parent = nullptr);
+
+    // GUI thread. Must outlive the widget, or be replaced with nullptr first.
+    void setLevels(AudioLevels const* levels);
+
+    QSize sizeHint() const override;
+
+protected:
+    void paintEvent(QPaintEvent* event) override;
+    void showEvent(QShowEvent* event) override;
+    void hideEvent(QHideEvent* event) override;
+
+private:
+    AudioLevels const* m_levels{ nullptr };
+    QTimer m_refresh;
+};
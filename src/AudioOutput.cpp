@@ -0,0 +1,296 @@
+#include "AudioOutput.h"
+
+#include "Log.h"
+
+#include <algorithm>
+#include <cstring>
+#include <optional>
+#include <thread>
+
+namespace
+{
+	constexpr size_t ringCapacityBytes = 4 * 1024 * 1024; // Over a second of 16 channel 48kHz float audio
+	constexpr double sinkBufferSeconds = 0.04;           // Kept small; the ring does the real buffering
+	constexpr double fillMarginSeconds = 0.02;           // Queued on top of one capture interval's worth
+	constexpr double overfullFactor = 4.0;               // Beyond this multiple of the target, drop instead of queueing
+	constexpr int clockSampleMilliseconds = 10;          // How often processedUSecs() is read for the presentation clock
+
+	int64_t steadyNanoseconds()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	std::optional<SampleFormat> sampleFormatFor(QAudioFormat::SampleFormat format)
+	{
+		switch (format)
+		{
+		case QAudioFormat::UInt8: return SampleFormat::UInt8;
+		case QAudioFormat::Int16: return SampleFormat::Int16;
+		case QAudioFormat::Int32: return SampleFormat::Int32;
+		case QAudioFormat::Float: return SampleFormat::Float;
+		default: return std::nullopt;
+		}
+	}
+}
+
+AudioPullDevice::AudioPullDevice(SpscRingBuffer<char>& ring, QObject* parent)
+	: QIODevice(parent)
+	, m_ring{ ring }
+{
+}
+
+void AudioPullDevice::configure(int bytesPerFrame, qsizetype primeBytes)
+{
+	m_bytesPerFrame = qMax(bytesPerFrame, 1);
+	m_primeBytes = primeBytes;
+	m_primed = false;
+	m_framesPulled.store(0, std::memory_order_relaxed);
+	m_detached.store(false);
+}
+
+void AudioPullDevice::detachAndClear()
+{
+	m_detached.store(true);
+	while (m_reading.load())
+	{
+		std::this_thread::yield();
+	}
+	m_ring.discard(m_ring.available());
+}
+
+qint64 AudioPullDevice::bytesAvailable() const
+{
+	return static_cast<qint64>(m_ring.available()) + QIODevice::bytesAvailable();
+}
+
+qint64 AudioPullDevice::readData(char* data, qint64 maxlen)
+{
+	qint64 const wholeFrames = maxlen - (maxlen % m_bytesPerFrame);
+	// With detachAndClear(), sequentially consistent both ways: either it sees this read under way and
+	//  waits for it, or this read sees the ring detached and leaves it alone
+	m_reading.store(true);
+	qint64 handedOver = wholeFrames;
+	if (m_detached.load())
+	{
+		std::memset(data, 0, static_cast<size_t>(wholeFrames));
+	}
+	else
+	{
+		handedOver = readFromRing(data, wholeFrames);
+	}
+	m_reading.store(false);
+	m_framesPulled.fetch_add(static_cast<uint64_t>(handedOver / m_bytesPerFrame), std::memory_order_relaxed);
+	return handedOver;
+}
+
+qint64 AudioPullDevice::readFromRing(char* data, qint64 const wholeFrames)
+{
+	if (!m_primed && static_cast<qsizetype>(m_ring.available()) >= m_primeBytes)
+	{
+		m_primed = true;
+	}
+
+	if (m_primed)
+	{
+		size_t const available = m_ring.available();
+		size_t const toRead = qMin(static_cast<size_t>(wholeFrames), available - (available % m_bytesPerFrame));
+		if (toRead > 0)
+		{
+			return static_cast<qint64>(m_ring.read(data, toRead));
+		}
+		m_underruns.fetch_add(1, std::memory_order_relaxed);
+		m_primed = false;
+	}
+
+	// Returning nothing would put the sink into its idle state; keep it running on silence while we refill.
+	std::memset(data, 0, static_cast<size_t>(wholeFrames));
+	return wholeFrames;
+}
+
+qint64 AudioPullDevice::writeData(const char*, qint64)
+{
+	return -1; // Read only; audio arrives through the ring
+}
+
+AudioOutput::AudioOutput(QObject* parent)
+	: QObject(parent)
+	, m_ring{ ringCapacityBytes }
+	, m_pullDevice{ m_ring }
+{
+	m_clockTimer.setInterval(clockSampleMilliseconds);
+	connect(&m_clockTimer, &QTimer::timeout, this, &AudioOutput::sampleProcessed);
+}
+
+AudioOutput::~AudioOutput()
+{
+	stopOnOwnThread();
+}
+
+int AudioOutput::start(int const sourceSampleRate, int const sourceChannels, std::chrono::microseconds const captureInterval)
+{
+	m_writtenUpTo.store(0, std::memory_order_relaxed); // No clock until audio in the new format is queued
+	// Anything left from a previous session is in the wrong place in time, and maybe the wrong format. Gone
+	//  before the first write of this one; the old sink plays silence until startOnOwnThread() replaces it.
+	m_pullDevice.detachAndClear();
+	QAudioFormat format;
+	format.setSampleRate(sourceSampleRate);
+	format.setChannelCount(sourceChannels);
+	format.setSampleFormat(QAudioFormat::Float);
+
+	if (!m_device.isFormatSupported(format))
+	{
+		LOG_WARNING(QString("Audio format not supported by device, cannot play audio. Sample rate: %1 , channel count: %2 , sample format: FLOAT")
+			       .arg(sourceSampleRate).arg(sourceChannels));
+
+		format = m_device.preferredFormat();
+		LOG_INFO(QString("Will attempt preferred format: Sample rate: %1 , channel count: %2 , sample format: %3")
+			.arg(format.sampleRate()).arg(format.channelCount()).arg(format.sampleFormat()));
+	}
+	else
+	{
+		LOG_DEBUG("Audio format supported by device.");
+	}
+
+	auto const sampleFormat = sampleFormatFor(format.sampleFormat());
+	if (!sampleFormat || sourceChannels <= 0)
+	{
+		LOG_WARNING(QString("Cannot produce audio in sample format %1; no audio will be played").arg(format.sampleFormat()));
+		m_bytesPerFrame.store(0, std::memory_order_relaxed);
+		return 0;
+	}
+
+	m_converter.configure(sourceChannels, format.channelCount(), *sampleFormat);
+	int const bytesPerFrame = m_converter.bytesPerFrame();
+	m_bytesPerFrame.store(bytesPerFrame, std::memory_order_relaxed);
+	m_wrappedFrame.resize(bytesPerFrame);
+	m_resampler.reset(sourceChannels);
+
+	double const targetFrames = format.sampleRate() * (captureInterval.count() / 1000000.0 + fillMarginSeconds);
+	m_controller.reset(targetFrames);
+	m_clockRate.store(format.sampleRate(), std::memory_order_relaxed);
+	qsizetype const primeBytes = static_cast<qsizetype>(targetFrames) * bytesPerFrame;
+
+	QMetaObject::invokeMethod(this, [this, device = m_device, format, bytesPerFrame, primeBytes]() {
+		startOnOwnThread(device, format, bytesPerFrame, primeBytes);
+	}, Qt::QueuedConnection);
+	return format.sampleRate();
+}
+
+void AudioOutput::stop()
+{
+	m_writtenUpTo.store(0, std::memory_order_relaxed);
+	QMetaObject::invokeMethod(this, &AudioOutput::stopOnOwnThread, Qt::QueuedConnection);
+}
+
+void AudioOutput::write(float const* planar, int channelStrideInBytes, size_t frames, std::chrono::system_clock::time_point const sentAt)
+{
+	int const bytesPerFrame = m_bytesPerFrame.load(std::memory_order_relaxed);
+	if (bytesPerFrame == 0 || !planar)
+	{
+		return;
+	}
+
+	double const ratio = m_controller.update(static_cast<double>(queuedFrames()));
+	auto const resampled = m_resampler.process(planar, channelStrideInBytes / sizeof(float), frames, ratio);
+	size_t const bytes = resampled.frames * bytesPerFrame;
+
+	// Only if the sound card has stopped pulling altogether; in normal running the controller keeps the queue near target.
+	if (queuedFrames() > m_controller.targetFill() * overfullFactor)
+	{
+		m_droppedBytes.fetch_add(bytes, std::memory_order_relaxed);
+		return;
+	}
+
+	// Convert straight into the ring. Its size is a power of two and a frame may not be, so one frame can
+	//  straddle the wrap point; that one is converted to the side and split.
+	auto const region = m_ring.prepareWrite(bytes - (bytes % bytesPerFrame));
+	size_t const framesToWrite = region.size() / bytesPerFrame;
+	size_t const firstFrames = region.firstCount / bytesPerFrame;
+	auto* const firstOut = reinterpret_cast<uint8_t*>(region.first);
+	auto* const secondOut = reinterpret_cast<uint8_t*>(region.second);
+
+	m_converter.convert(resampled.data, resampled.channelStride, firstFrames, firstOut);
+	if (firstFrames < framesToWrite)
+	{
+		size_t const straddleBytes = region.firstCount % bytesPerFrame;
+		size_t frame = firstFrames;
+		size_t secondOffset = 0;
+		if (straddleBytes > 0)
+		{
+			m_converter.convert(resampled.data + frame, resampled.channelStride, 1, m_wrappedFrame.data());
+			std::memcpy(firstOut + firstFrames * bytesPerFrame, m_wrappedFrame.data(), straddleBytes);
+			std::memcpy(secondOut, m_wrappedFrame.data() + straddleBytes, bytesPerFrame - straddleBytes);
+			secondOffset = bytesPerFrame - straddleBytes;
+			++frame;
+		}
+		m_converter.convert(resampled.data + frame, resampled.channelStride, framesToWrite - frame, secondOut + secondOffset);
+	}
+	m_ring.commitWrite(framesToWrite * bytesPerFrame);
+	m_droppedBytes.fetch_add(bytes - framesToWrite * bytesPerFrame, std::memory_order_relaxed);
+
+	// The block's timestamp is when its last sample was sent, so it is also the sent time of the end of the ring.
+	m_writtenUpTo.store(sentAt.time_since_epoch().count() > 0
+		? std::chrono::duration_cast<std::chrono::nanoseconds>(sentAt.time_since_epoch()).count()
+		: 0, std::memory_order_release);
+}
+
+std::optional<std::chrono::system_clock::time_point> AudioOutput::presentationClock() const
+{
+	int64_t const writtenUpTo = m_writtenUpTo.load(std::memory_order_acquire);
+	int const rate = m_clockRate.load(std::memory_order_relaxed);
+	int64_t const sampledAt = m_processedSampledAt.load(std::memory_order_acquire);
+	if (writtenUpTo == 0 || rate <= 0 || sampledAt == 0)
+	{
+		return std::nullopt;
+	}
+
+	// What the sink has been given but not yet played. Its processed time moves on in real time between
+	//  samples, but never past what it has been given.
+	double const playedSeconds = m_processedUSecs.load(std::memory_order_relaxed) / 1e6
+		+ (steadyNanoseconds() - sampledAt) / 1e9;
+	double const pulledSeconds = static_cast<double>(m_pullDevice.framesPulled()) / rate;
+	double const inSinkSeconds = std::max(0.0, pulledSeconds - playedSeconds);
+	double const inRingSeconds = static_cast<double>(queuedFrames()) / rate;
+
+	auto const behind = std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::duration<double>(inSinkSeconds + inRingSeconds));
+	return std::chrono::system_clock::time_point{ std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds{ writtenUpTo }) } - behind;
+}
+
+void AudioOutput::startOnOwnThread(QAudioDevice const& device, QAudioFormat const& format, int bytesPerFrame, qsizetype primeBytes)
+{
+	stopOnOwnThread();
+
+	m_pullDevice.configure(bytesPerFrame, primeBytes);
+	m_pullDevice.open(QIODevice::ReadOnly);
+
+	m_sink = std::make_unique<QAudioSink>(device, format);
+	m_sink->setBufferSize(static_cast<qsizetype>(format.sampleRate() * sinkBufferSeconds) * bytesPerFrame);
+	m_sink->start(&m_pullDevice);
+	m_processedUSecs.store(0, std::memory_order_relaxed);
+	m_processedSampledAt.store(steadyNanoseconds(), std::memory_order_release);
+	m_clockTimer.start();
+	LOG_INFO(QString("Audio output started in pull mode: %1 Hz, %2 channels, %3 bytes queued before playing")
+		.arg(format.sampleRate()).arg(format.channelCount()).arg(primeBytes));
+}
+
+void AudioOutput::stopOnOwnThread()
+{
+	m_clockTimer.stop();
+	m_processedSampledAt.store(0, std::memory_order_relaxed);
+	if (m_sink)
+	{
+		m_sink->stop();
+		m_sink.reset();
+		LOG_INFO(QString("Audio output stopped. Underruns: %1, bytes dropped: %2").arg(underruns()).arg(droppedBytes()));
+	}
+	m_pullDevice.close();
+}
+
+void AudioOutput::sampleProcessed()
+{
+	if (m_sink)
+	{
+		m_processedUSecs.store(m_sink->processedUSecs(), std::memory_order_relaxed);
+		m_processedSampledAt.store(steadyNanoseconds(), std::memory_order_release);
+	}
+}
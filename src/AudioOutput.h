@@ -0,0 +1,132 @@
+#pragma once
+
+#include <QObject>
+#include <QIODevice>
+#include <QAudioDevice>
+#include <QAudioFormat>
+#include <QAudioSink>
+#include <QTimer>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "AudioConvert.h"
+#include "AudioResampler.h"
+#include "MediaTargets.h"
+#include "SpscRingBuffer.h"
+
+// The QIODevice the QAudioSink pulls from. Hands over whatever the capture thread has queued in the ring.
+//  Until the ring holds the prime level (and again after it runs dry) it plays silence, so that playback
+//  starts with a consistent amount of audio queued rather than stuttering from empty.
+class AudioPullDevice : public QIODevice
+{
+    Q_OBJECT
+
+public:
+    explicit AudioPullDevice(SpscRingBuffer<char>& ring, QObject* parent = nullptr);
+
+    // Consumer thread, before the sink starts.
+    void configure(int bytesPerFrame, qsizetype primeBytes);
+
+    // Producer thread, as a new session starts. The sink gets silence from now until the next configure(),
+    //  and whatever is queued is thrown away, so the new session's audio goes into an empty ring and none of
+    //  it is lost. Waits out a read already under way, which is only ever a copy.
+    void detachAndClear();
+
+    bool isSequential() const override { return true; }
+    qint64 bytesAvailable() const override;
+
+    uint64_t underruns() const { return m_underruns.load(std::memory_order_relaxed); }
+
+    // Frames handed to the sink since configure(), silence included. Any thread.
+    uint64_t framesPulled() const { return m_framesPulled.load(std::memory_order_relaxed); }
+
+protected:
+    qint64 readData(char* data, qint64 maxlen) override;
+    qint64 writeData(const char* data, qint64 len) override;
+
+private:
+    qint64 readFromRing(char* data, qint64 wholeFrames);
+
+    SpscRingBuffer<char>& m_ring;
+    int m_bytesPerFrame{ 1 };
+    qsizetype m_primeBytes{ 0 };
+    bool m_primed{ false };
+    std::atomic<bool> m_detached{ false }; // While set, the producer owns the ring's read side
+    std::atomic<bool> m_reading{ false };
+    std::atomic<uint64_t> m_underruns{ 0 };
+    std::atomic<uint64_t> m_framesPulled{ 0 };
+};
+
+// Audio output in pull mode. The capture thread write()s audio as it arrives; it is resampled very slightly
+//  to keep the queue at a steady level (soaking up the drift between the NDI source's clock and the sound
+//  card's), then interleaved, mixed to the device's channel count and converted to its sample format
+//  straight into a lock-free ring. The QAudioSink pulls from that ring through AudioPullDevice when
+//  the sound card wants more. The sink is created and driven on this object's thread - the GUI thread -
+//  because in pull mode it needs an event loop, which the capture thread doesn't have.
+//
+// It also keeps the presentation clock: the sent time of the audio now playing, worked back from the sent
+//  time of the last block written, less what is still queued in the ring and in the sink. How much the sink
+//  has played comes from QAudioSink::processedUSecs(), which can only be read on this object's thread, so
+//  it is sampled on a short timer and extrapolated in between.
+class AudioOutput : public QObject, public AudioTarget
+{
+    Q_OBJECT
+
+public:
+    explicit AudioOutput(QObject* parent = nullptr);
+    ~AudioOutput() override;
+
+    // Set before playback starts; used by the next start().
+    void setDevice(QAudioDevice const& device) { m_device = device; }
+
+    // Capture thread. (Re)starts output on the device, fed with sourceChannels channels of audio. Float
+    //  at the source's rate and channel count if the device takes it, otherwise the device's preferred
+    //  format. Audio is written once per captureInterval, which sets how much needs to be kept queued to
+    //  ride out the gaps between writes. Returns the rate to write at, or 0 if the device's sample type
+    //  isn't one we can produce.
+    int start(int sourceSampleRate, int sourceChannels, std::chrono::microseconds captureInterval) override;
+    void stop() override;
+
+    // Capture thread. Planar float samples, as in an NDI audio frame, at the sample rate start() returned.
+    void write(float const* planar, int channelStrideInBytes, size_t frames, std::chrono::system_clock::time_point sentAt) override;
+
+    std::optional<std::chrono::system_clock::time_point> presentationClock() const override;
+
+    double currentRatio() const { return m_controller.ratio(); }
+    // Any thread.
+    size_t queuedFrames() const
+    {
+        int const bytesPerFrame = m_bytesPerFrame.load(std::memory_order_relaxed); // Once: start() may change it
+        return bytesPerFrame > 0 ? m_ring.available() / bytesPerFrame : 0;
+    }
+    uint64_t droppedBytes() const override { return m_droppedBytes.load(std::memory_order_relaxed); }
+    uint64_t underruns() const override { return m_pullDevice.underruns(); }
+
+private:
+    void startOnOwnThread(QAudioDevice const& device, QAudioFormat const& format, int bytesPerFrame, qsizetype primeBytes);
+    void stopOnOwnThread();
+    void sampleProcessed();
+
+    SpscRingBuffer<char> m_ring;
+    AudioPullDevice m_pullDevice;
+    std::unique_ptr<QAudioSink> m_sink; // Only touched on this object's thread
+    QAudioDevice m_device;
+    QTimer m_clockTimer;                // Samples the sink's processed time; this object's thread
+
+    // Capture thread state
+    AudioResampler m_resampler;
+    FillLevelController m_controller;
+    AudioFrameConverter m_converter;
+    std::vector<uint8_t> m_wrappedFrame; // Staging for the one frame that may straddle the end of the ring
+    std::atomic<int> m_bytesPerFrame{ 0 }; // Written by start(), but read for the presentation clock too
+    std::atomic<uint64_t> m_droppedBytes{ 0 };
+
+    // Presentation clock. Nanoseconds since the epoch, or 0 when unknown.
+    std::atomic<int> m_clockRate{ 0 };                 // Frames per second at the device
+    std::atomic<int64_t> m_writtenUpTo{ 0 };           // Sent time of the end of the last block queued
+    std::atomic<int64_t> m_processedUSecs{ 0 };        // The sink's processedUSecs() when last sampled...
+    std::atomic<int64_t> m_processedSampledAt{ 0 };    // ...and when that was, on the steady clock
+};
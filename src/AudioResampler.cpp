@@ -0,0 +1,87 @@
+#include "AudioResampler.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	// No real pair of clocks is further apart than this; anything beyond it is a glitch, not drift.
+	constexpr double maxRatioDeviation = 0.005;
+
+	constexpr double proportionalGain = 0.01;
+	constexpr double integralGain = 0.00003;
+	constexpr double smoothing = 0.05; // Weight of each new fill sample in the moving average
+}
+
+void AudioResampler::reset(int channels)
+{
+	m_channels = channels;
+	m_position = 0.0;
+	m_previousFrame.assign(channels, 0.0f);
+}
+
+AudioResampler::PlanarAudio AudioResampler::process(float const* input, size_t channelStride, size_t inFrames, double ratio)
+{
+	if (m_channels <= 0 || inFrames == 0 || ratio <= 0.0)
+	{
+		return { m_output.data(), m_outputStride, 0 };
+	}
+
+	size_t const maxOutFrames = static_cast<size_t>(std::ceil(inFrames * ratio)) + 2;
+	if (m_outputStride < maxOutFrames)
+	{
+		m_outputStride = maxOutFrames;
+		m_output.resize(m_outputStride * m_channels);
+	}
+
+	double const step = 1.0 / ratio;
+	double const lastIndex = static_cast<double>(inFrames - 1);
+
+	size_t outFrames = 0;
+	while (m_position < lastIndex && outFrames < maxOutFrames)
+	{
+		auto const index = static_cast<ptrdiff_t>(std::floor(m_position));
+		float const fraction = static_cast<float>(m_position - index);
+		for (int c = 0; c < m_channels; ++c)
+		{
+			float const* channel = input + c * channelStride;
+			float const a = index < 0 ? m_previousFrame[c] : channel[index];
+			float const b = channel[index + 1];
+			m_output[c * m_outputStride + outFrames] = a + (b - a) * fraction;
+		}
+		++outFrames;
+		m_position += step;
+	}
+
+	m_position -= static_cast<double>(inFrames);
+	for (int c = 0; c < m_channels; ++c)
+	{
+		m_previousFrame[c] = input[c * channelStride + inFrames - 1];
+	}
+	return { m_output.data(), m_outputStride, outFrames };
+}
+
+void FillLevelController::reset(double targetFill)
+{
+	m_targetFill = std::max(targetFill, 1.0);
+	m_smoothedFill = 0.0;
+	m_integral = 0.0;
+	m_ratio = 1.0;
+	m_primed = false;
+}
+
+double FillLevelController::update(double currentFill)
+{
+	if (!m_primed)
+	{
+		m_smoothedFill = currentFill;
+		m_primed = true;
+	}
+	m_smoothedFill += (currentFill - m_smoothedFill) * smoothing;
+
+	// Positive error: buffer too full, so produce fewer output frames per input frame.
+	double const error = (m_smoothedFill - m_targetFill) / m_targetFill;
+	m_integral = std::clamp(m_integral + error, -maxRatioDeviation / integralGain, maxRatioDeviation / integralGain);
+	m_ratio = std::clamp(1.0 - proportionalGain * error - integralGain * m_integral, 1.0 - maxRatioDeviation, 1.0 + maxRatioDeviation);
+	return m_ratio;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// Small streaming resampler for nudging the audio rate by fractions of a percent. The NDI framesync
+//  delivers audio on our capture clock, but the sound card consumes it on its own crystal, and the two
+//  never quite agree. Left alone the output buffer slowly fills up (latency grows) or drains (dropouts).
+//  Linear interpolation is plenty for ratios this close to 1; it carries the last input frame and the
+//  fractional read position across calls so consecutive blocks join up seamlessly.
+class AudioResampler
+{
+public:
+    // A block of planar float audio: channel c's samples start at data + c * channelStride.
+    struct PlanarAudio
+    {
+        float const* data;
+        size_t channelStride;
+        size_t frames;
+    };
+
+    // Resets history; call when the channel count changes or the stream restarts.
+    void reset(int channels);
+
+    // Resamples planar float input (as NDI delivers it). ratio is output frames per input frame. The
+    //  result is owned by the resampler and valid until the next call. Storage only grows, so steady
+    //  state calls don't allocate.
+    PlanarAudio process(float const* input, size_t channelStride, size_t inFrames, double ratio);
+
+private:
+    int m_channels{ 0 };
+    double m_position{ 0.0 };           // Read position in the current block; -1 is the carried over frame
+    std::vector<float> m_previousFrame; // Last input frame of the previous block, one sample per channel
+    std::vector<float> m_output;
+    size_t m_outputStride{ 0 };
+};
+
+// Decides the resampling ratio from how full the output buffer is, to hold it near a target level.
+//  A proportional-integral controller on a smoothed fill level: the proportional term reacts to
+//  sudden changes, the integral term settles on the steady clock difference between the two devices.
+class FillLevelController
+{
+public:
+    void reset(double targetFill);
+
+    // Feed the current fill level (any unit, as long as it matches the target); returns the ratio to use.
+    double update(double currentFill);
+
+    double targetFill() const { return m_targetFill; }
+    double ratio() const { return m_ratio; }
+
+private:
+    double m_targetFill{ 1.0 };
+    double m_smoothedFill{ 0.0 };
+    double m_integral{ 0.0 };
+    double m_ratio{ 1.0 };
+    bool m_primed{ false };
+};
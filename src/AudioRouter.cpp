@@ -0,0 +1,64 @@
+#include "AudioRouter.h"
+
+AudioRouter::AudioRouter(AudioTarget& output, size_t const inputs)
+	: m_output{ output }
+{
+	for (size_t i = 0; i < inputs; ++i)
+	{
+		m_inputs.push_back(std::make_unique<Input>(*this, static_cast<int>(i)));
+	}
+}
+
+int AudioRouter::Input::start(int const sourceSampleRate, int const sourceChannels, std::chrono::microseconds const captureInterval)
+{
+	if (!active())
+	{
+		// Deselected since the engine checked. Say the source's own rate is fine, so the engine doesn't
+		//  decide its audio is unplayable; it will stop on its next tick.
+		return sourceSampleRate;
+	}
+	std::lock_guard lock(m_router.m_mutex);
+	m_router.m_owner = m_index;
+	return m_router.m_output.start(sourceSampleRate, sourceChannels, captureInterval);
+}
+
+void AudioRouter::Input::stop()
+{
+	std::lock_guard lock(m_router.m_mutex);
+	if (m_router.m_owner == m_index)
+	{
+		m_router.m_output.stop();
+		m_router.m_owner = none;
+	}
+}
+
+void AudioRouter::Input::write(float const* const planar, int const channelStrideInBytes, size_t const frames, std::chrono::system_clock::time_point const sentAt)
+{
+	// Uncontended apart from the moment of a handover, so cheap next to the write itself
+	std::lock_guard lock(m_router.m_mutex);
+	if (m_router.m_owner == m_index)
+	{
+		m_router.m_output.write(planar, channelStrideInBytes, frames, sentAt);
+	}
+}
+
+std::optional<std::chrono::system_clock::time_point> AudioRouter::Input::presentationClock() const
+{
+	// Only the owner's; another engine's timestamps mean nothing to this one's video
+	std::lock_guard lock(m_router.m_mutex);
+	if (m_router.m_owner == m_index)
+	{
+		return m_router.m_output.presentationClock();
+	}
+	return std::nullopt;
+}
+
+uint64_t AudioRouter::Input::underruns() const
+{
+	return m_router.m_output.underruns();
+}
+
+uint64_t AudioRouter::Input::droppedBytes() const
+{
+	return m_router.m_output.droppedBytes();
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "MediaTargets.h"
+
+// Lets several engines share one audio output, only one of them audible at a time. Each engine gets its
+//  own input(); whichever input is selected owns the output, and the rest are quietly ignored. Engines
+//  run on different pool threads, so the handover is serialised here: when the selection changes, the
+//  newly selected engine's start() can arrive before the old one notices and stops, and the output must
+//  never see writes from both.
+class AudioRouter
+{
+public:
+    static constexpr int none = -1;
+
+    AudioRouter(AudioTarget& output, size_t inputs);
+
+    AudioRouter(AudioRouter const&) = delete;
+    AudioRouter& operator=(AudioRouter const&) = delete;
+
+    AudioTarget& input(size_t index) { return *m_inputs[index]; }
+
+    // Any thread. Unselected inputs report themselves inactive, so their engines stop capturing audio.
+    void select(int index) { m_selected.store(index, std::memory_order_relaxed); }
+    int selected() const { return m_selected.load(std::memory_order_relaxed); }
+
+private:
+    class Input : public AudioTarget
+    {
+    public:
+        Input(AudioRouter& router, int index) : m_router{ router }, m_index{ index } {}
+
+        int start(int sourceSampleRate, int sourceChannels, std::chrono::microseconds captureInterval) override;
+        void stop() override;
+        void write(float const* planar, int channelStrideInBytes, size_t frames, std::chrono::system_clock::time_point sentAt) override;
+        std::optional<std::chrono::system_clock::time_point> presentationClock() const override;
+        bool active() const override { return m_router.selected() == m_index; }
+        uint64_t underruns() const override;
+        uint64_t droppedBytes() const override;
+
+    private:
+        AudioRouter& m_router;
+        int const m_index;
+    };
+
+    AudioTarget& m_output;
+    std::vector<std::unique_ptr<Input>> m_inputs;
+    std::atomic<int> m_selected{ none };
+
+    std::mutex m_mutex;
+    int m_owner{ none }; // The input the output was last started for, under m_mutex
+};
@@ -0,0 +1,63 @@
+#include "BandwidthSelector.h"
+
+#include <algorithm>
+
+NDIlib_recv_bandwidth_e BandwidthSelector::reset(QSize const targetSize)
+{
+	m_proxySize = QSize(640, 360);
+	m_fullSize = QSize();
+	m_otherPreferredSince.reset();
+	// Nothing seen yet, so no hysteresis: whichever is right for the size now
+	m_current = displayedWidth(targetSize) > m_proxySize.width() ? NDIlib_recv_bandwidth_highest : NDIlib_recv_bandwidth_lowest;
+	return m_current;
+}
+
+void BandwidthSelector::observeFrame(NDIlib_recv_bandwidth_e const bandwidth, QSize const frameSize)
+{
+	if (frameSize.isEmpty())
+	{
+		return;
+	}
+	if (bandwidth == NDIlib_recv_bandwidth_lowest)
+	{
+		m_proxySize = frameSize;
+	}
+	else
+	{
+		m_fullSize = frameSize;
+	}
+}
+
+NDIlib_recv_bandwidth_e BandwidthSelector::update(QSize const targetSize, clock::time_point const now)
+{
+	if (preferred(targetSize) == m_current)
+	{
+		m_otherPreferredSince.reset();
+		return m_current;
+	}
+	if (!m_otherPreferredSince)
+	{
+		m_otherPreferredSince = now;
+	}
+	if (now - *m_otherPreferredSince < m_thresholds.dwell)
+	{
+		return m_current;
+	}
+	return m_current == NDIlib_recv_bandwidth_lowest ? NDIlib_recv_bandwidth_highest : NDIlib_recv_bandwidth_lowest;
+}
+
+int BandwidthSelector::displayedWidth(QSize const targetSize) const
+{
+	QSize const source{ m_fullSize.isEmpty() ? m_proxySize : m_fullSize };
+	return source.scaled(targetSize, Qt::KeepAspectRatio).width();
+}
+
+NDIlib_recv_bandwidth_e BandwidthSelector::preferred(QSize const targetSize) const
+{
+	int const width = displayedWidth(targetSize);
+	if (m_current == NDIlib_recv_bandwidth_lowest)
+	{
+		return width > m_proxySize.width() * m_thresholds.fullAbove ? NDIlib_recv_bandwidth_highest : NDIlib_recv_bandwidth_lowest;
+	}
+	return width <= m_proxySize.width() * m_thresholds.proxyAtOrBelow ? NDIlib_recv_bandwidth_lowest : NDIlib_recv_bandwidth_highest;
+}
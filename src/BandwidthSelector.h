@@ -0,0 +1,57 @@
+#pragma once
+
+#include <QSize>
+#include <chrono>
+#include <optional>
+
+#include "Processing.NDI.Lib.h"
+
+// Chooses between a source's full stream and its proxy from the size it is displayed at. Receiving and
+//  decoding 1080p only to scale it down to a 400 pixel wide tile is wasted CPU and network; the proxy
+//  (640 wide, by NDI convention) looks the same there.
+//
+// There is a band between the two thresholds where the current choice is kept, and the other stream must
+//  stay the better choice for a while before switching, so that dragging a window edge back and forth
+//  across the line doesn't flap between receivers.
+class BandwidthSelector
+{
+public:
+    using clock = std::chrono::steady_clock;
+
+    struct Thresholds
+    {
+        double fullAbove{ 1.25 };      // Switch to full once the picture is drawn this much wider than the proxy...
+        double proxyAtOrBelow{ 1.0 };  // ...and back to the proxy once the proxy is at least as wide as the picture
+        std::chrono::milliseconds dwell{ 1500 };
+    };
+
+    BandwidthSelector() = default;
+    explicit BandwidthSelector(Thresholds const& thresholds) : m_thresholds{ thresholds } {}
+
+    // Forgets what it has seen, for a new source. Returns the bandwidth to open it with.
+    NDIlib_recv_bandwidth_e reset(QSize targetSize);
+
+    // Every frame received, with the bandwidth it came at. Teaches us the real proxy and full sizes.
+    void observeFrame(NDIlib_recv_bandwidth_e bandwidth, QSize frameSize);
+
+    // Every tick. Returns the bandwidth that should be received now; differs from current() once a switch is due.
+    NDIlib_recv_bandwidth_e update(QSize targetSize, clock::time_point now);
+
+    // Once the receiver for a switch has delivered.
+    void switched(NDIlib_recv_bandwidth_e bandwidth) { m_current = bandwidth; m_otherPreferredSince.reset(); }
+
+    NDIlib_recv_bandwidth_e current() const { return m_current; }
+    QSize proxySize() const { return m_proxySize; }
+    QSize fullSize() const { return m_fullSize; } // Empty until a full frame has been seen
+
+private:
+    // The width the picture is drawn at within the target, going by the source's aspect ratio
+    int displayedWidth(QSize targetSize) const;
+    NDIlib_recv_bandwidth_e preferred(QSize targetSize) const;
+
+    Thresholds m_thresholds;
+    NDIlib_recv_bandwidth_e m_current{ NDIlib_recv_bandwidth_highest };
+    QSize m_proxySize{ 640, 360 };
+    QSize m_fullSize;
+    std::optional<clock::time_point> m_otherPreferredSince;
+};
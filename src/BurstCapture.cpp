@@ -0,0 +1,363 @@
+#include "BurstCapture.h"
+
+#include <QBuffer>
+#include <QDir>
+#include <QFile>
+#include <QImageWriter>
+#include <QThread>
+#include <QtConcurrent/QtConcurrentRun>
+#include <algorithm>
+#include <cstring>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "Log.h"
+#include "ReceiverEngine.h"
+#include "VideoConvert.h"
+
+namespace
+{
+	// Files written back to back before the writer looks for more; keeps one slow encode from holding up
+	//  the disk while there are finished frames behind it
+	constexpr size_t maxBatchFrames = 16;
+
+	int64_t sinceEpoch(BurstCapture::clock::time_point const time)
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+	}
+
+	void raiseTo(std::atomic<int64_t>& value, int64_t const candidate)
+	{
+		for (int64_t current = value.load(std::memory_order_relaxed); candidate > current && !value.compare_exchange_weak(current, candidate, std::memory_order_relaxed);)
+		{
+		}
+	}
+
+	void lowerTo(std::atomic<int64_t>& value, int64_t const candidate)
+	{
+		for (int64_t current = value.load(std::memory_order_relaxed); candidate < current && !value.compare_exchange_weak(current, candidate, std::memory_order_relaxed);)
+		{
+		}
+	}
+
+	QString rawExtension(NDIlib_FourCC_video_type_e const fourCC)
+	{
+		switch (fourCC)
+		{
+		case NDIlib_FourCC_video_type_UYVY: return "uyvy";
+		case NDIlib_FourCC_video_type_UYVA: return "uyva";
+		case NDIlib_FourCC_video_type_BGRA: return "bgra";
+		case NDIlib_FourCC_video_type_BGRX: return "bgrx";
+		case NDIlib_FourCC_video_type_RGBA: return "rgba";
+		case NDIlib_FourCC_video_type_RGBX: return "rgbx";
+		default: return QString("%1").arg(static_cast<uint>(fourCC), 8, 16, QChar('0'));
+		}
+	}
+
+	// UYVA's alpha plane, a byte a pixel, follows the colour
+	size_t frameBytes(NDIlib_video_frame_v2_t const& frame)
+	{
+		size_t const colour{ static_cast<size_t>(frame.line_stride_in_bytes) * frame.yres };
+		return frame.FourCC == NDIlib_FourCC_video_type_UYVA ? colour + static_cast<size_t>(frame.xres) * frame.yres : colour;
+	}
+}
+
+double BurstReport::encodedPerSecond() const
+{
+	return encodeSpan.count() > 0 ? encode.count / std::chrono::duration<double>(encodeSpan).count() : 0.0;
+}
+
+double BurstReport::capturedPerSecond() const
+{
+	return captureTime.count() > 0 && framesCaptured > 1 ? (framesCaptured - 1) / std::chrono::duration<double>(captureTime).count() : 0.0;
+}
+
+double BurstReport::writeMegabytesPerSecond() const
+{
+	return write.sumMicroseconds > 0 ? bytesWritten / (1024.0 * 1024.0) / (write.sumMicroseconds / 1e6) : 0.0;
+}
+
+QString BurstReport::summary() const
+{
+	return QString("%1 frames captured (%2 fps), %3 dropped, %4 written, %5 failed; %6 MB written at %7 MB/s. "
+		           "Encoding: %8 frames/s on %9 threads, mean %10 ms a frame. Capture to disk: mean %11 ms, p99 < %12 ms, max %13 ms")
+		.arg(framesCaptured).arg(capturedPerSecond(), 0, 'f', 2).arg(framesDropped).arg(framesWritten).arg(framesFailed)
+		.arg(bytesWritten / (1024.0 * 1024.0), 0, 'f', 1).arg(writeMegabytesPerSecond(), 0, 'f', 1)
+		.arg(encodedPerSecond(), 0, 'f', 1).arg(encoderThreads).arg(encode.meanMicroseconds() / 1000.0, 0, 'f', 1)
+		.arg(captureToDisk.meanMicroseconds() / 1000.0, 0, 'f', 1).arg(captureToDisk.percentileMicroseconds(0.99) / 1000.0, 0, 'f', 1)
+		.arg(captureToDisk.maxMicroseconds / 1000.0, 0, 'f', 1);
+}
+
+BurstCapture::BurstCapture(ReceiverCache& receivers)
+	: m_receivers{ receivers }
+{
+	// The capturing thread has a core of its own
+	m_encoders.setMaxThreadCount(std::max(1, QThread::idealThreadCount() - 1));
+}
+
+BurstCapture::~BurstCapture()
+{
+	m_encoders.waitForDone();
+}
+
+QString BurstCapture::extension(BurstFormat const format)
+{
+	switch (format)
+	{
+	case BurstFormat::Jpeg: return "jpg";
+	case BurstFormat::Raw: return "raw";
+	default: return "png";
+	}
+}
+
+void BurstCapture::Burst::fail(QString const& reason)
+{
+	std::lock_guard lock(mutex);
+	if (error.isEmpty())
+	{
+		error = reason;
+		LOG_WARNING(QString("Burst capture: %1").arg(reason));
+	}
+}
+
+BurstReport BurstCapture::run(BurstSettings const& settings, std::atomic<bool> const& stopRequested)
+{
+	BurstReport report;
+	report.encoderThreads = m_encoders.maxThreadCount();
+	if (settings.frames <= 0 && settings.duration.count() <= 0)
+	{
+		report.error = "A burst needs a number of frames or a duration";
+		return report;
+	}
+	if (!QDir().mkpath(settings.directory))
+	{
+		report.error = QString("Cannot create %1").arg(settings.directory);
+		return report;
+	}
+	ReceiverCache::Lease const receiver = m_receivers.acquire(settings.sourceName.toStdString(), NDIlib_recv_bandwidth_highest);
+	if (!receiver)
+	{
+		report.error = QString("Cannot connect to %1").arg(settings.sourceName);
+		return report;
+	}
+
+	Burst burst;
+	burst.settings = settings;
+	std::thread writer{ [&burst]() { writeAll(burst); } };
+	std::optional<clock::time_point> const firstFrame{ capture(receiver.get(), burst, m_encoders, stopRequested, report) };
+	{
+		std::lock_guard lock(burst.mutex);
+		burst.captureDone = true;
+	}
+	burst.wake.notify_one();
+	writer.join();
+
+	report.framesWritten = burst.written.load();
+	report.framesFailed = burst.failed.load();
+	report.bytesWritten = burst.bytesWritten.load();
+	report.queuedPeak = burst.queuedPeak.load();
+	report.encode = burst.encodeTime.snapshot();
+	report.write = burst.writeTime.snapshot();
+	report.captureToDisk = burst.captureToDisk.snapshot();
+	if (int64_t const firstEncode{ burst.firstEncodeStart.load() }; report.encode.count > 0)
+	{
+		report.encodeSpan = std::chrono::nanoseconds{ burst.lastEncodeEnd.load() - firstEncode };
+	}
+	if (firstFrame)
+	{
+		report.totalTime = clock::now() - *firstFrame;
+	}
+	report.error = burst.error;
+	return report;
+}
+
+std::optional<BurstCapture::clock::time_point> BurstCapture::capture(NDIlib_recv_instance_t const receiver, Burst& burst, QThreadPool& encoders,
+	                                                                 std::atomic<bool> const& stopRequested, BurstReport& report)
+{
+	BurstSettings const& settings{ burst.settings };
+	NDIlib_video_frame_v2_t video_frame;
+
+	// A warm receiver has frames queued from before; the burst starts from now
+	for (int discarded = 0; discarded < 100; ++discarded)
+	{
+		NDIlib_frame_type_e const frame_type = NDIlib_recv_capture_v2(receiver, &video_frame, nullptr, nullptr, 0);
+		if (frame_type == NDIlib_frame_type_video)
+		{
+			NDIlib_recv_free_video_v2(receiver, &video_frame);
+		}
+		else if (frame_type == NDIlib_frame_type_none || frame_type == NDIlib_frame_type_error)
+		{
+			break;
+		}
+	}
+
+	std::optional<clock::time_point> first;
+	clock::time_point last;
+	auto const firstDeadline = clock::now() + settings.firstFrameTimeout;
+	uint64_t received{ 0 };
+	while (!stopRequested.load() && (settings.frames <= 0 || received < static_cast<uint64_t>(settings.frames)))
+	{
+		auto const now = clock::now();
+		if (!first && now >= firstDeadline)
+		{
+			burst.fail(QString("No video from %1 within %2 ms").arg(settings.sourceName).arg(settings.firstFrameTimeout.count()));
+			break;
+		}
+		if (first && settings.duration.count() > 0 && now - *first >= settings.duration)
+		{
+			break;
+		}
+		if (NDIlib_recv_capture_v2(receiver, &video_frame, nullptr, nullptr, 100) != NDIlib_frame_type_video)
+		{
+			continue;
+		}
+		auto const capturedAt = clock::now();
+		bool const usable{ video_frame.p_data && video_frame.yres > 0 && (settings.format == BurstFormat::Raw || pixelLayoutFor(video_frame.FourCC)) };
+		if (!usable)
+		{
+			LOG_DEBUG(QString("Burst capture: skipped a frame of unsupported format %1").arg(static_cast<uint>(video_frame.FourCC), 8, 16, QChar('0')));
+			NDIlib_recv_free_video_v2(receiver, &video_frame);
+			continue;
+		}
+		first = first.value_or(capturedAt);
+		last = capturedAt;
+		uint64_t const index{ ++received }; // Dropped frames leave a gap in the file numbering
+
+		if (burst.queued.load() >= settings.maxQueuedFrames)
+		{
+			// Never wait for the encoders: the source won't
+			report.framesDropped++;
+			NDIlib_recv_free_video_v2(receiver, &video_frame);
+			continue;
+		}
+
+		size_t const bytes{ frameBytes(video_frame) };
+		Frame frame{ index, FramePool::shared().acquire(bytes), video_frame.xres, video_frame.yres, video_frame.line_stride_in_bytes, video_frame.FourCC, bytes, capturedAt };
+		std::memcpy(frame.pixels.data(), video_frame.p_data, bytes);
+		NDIlib_recv_free_video_v2(receiver, &video_frame);
+
+		uint64_t const queued{ burst.queued.fetch_add(1) + 1 };
+		for (uint64_t peak = burst.queuedPeak.load(); queued > peak && !burst.queuedPeak.compare_exchange_weak(peak, queued);)
+		{
+		}
+		report.framesCaptured++;
+
+		QFuture<Encoded> encoded{ QtConcurrent::run(&encoders, [&burst, frame = std::move(frame)]() mutable { return encode(std::move(frame), burst); }) };
+		{
+			std::lock_guard lock(burst.mutex);
+			burst.pending.push_back(std::move(encoded));
+		}
+		burst.wake.notify_one();
+	}
+	if (first)
+	{
+		report.captureTime = last - *first;
+	}
+	return first;
+}
+
+BurstCapture::Encoded BurstCapture::encode(Frame frame, Burst& burst)
+{
+	auto const started = clock::now();
+	lowerTo(burst.firstEncodeStart, sinceEpoch(started));
+
+	BurstSettings const& settings{ burst.settings };
+	QString const number{ QString("%1").arg(frame.index, 6, 10, QChar('0')) };
+	Encoded encoded{ frame.index, {}, {}, {}, 0, frame.capturedAt };
+	if (settings.format == BurstFormat::Raw)
+	{
+		// Nothing to do but name it: the writer writes the captured buffer
+		encoded.fileName = QString("frame-%1-%2x%3-%4bpl.%5").arg(number).arg(frame.width).arg(frame.height).arg(frame.strideBytes).arg(rawExtension(frame.fourCC));
+		encoded.raw = std::move(frame.pixels);
+		encoded.rawBytes = frame.bytes;
+	}
+	else
+	{
+		// Per encoder thread; stops allocating once it has seen the widest frame
+		thread_local FrameConverter converter;
+		QImage image{ FramePool::shared().image(QSize(frame.width, frame.height)) };
+		converter.convert({ frame.pixels.data(), frame.width, frame.height, frame.strideBytes, *pixelLayoutFor(frame.fourCC) },
+			              { image.bits(), image.width(), image.height(), static_cast<int>(image.bytesPerLine()) });
+		frame.pixels = {}; // Back to the pool before the slow part
+
+		encoded.fileName = QString("frame-%1.%2").arg(number, extension(settings.format));
+		QBuffer buffer{ &encoded.bytes };
+		buffer.open(QIODevice::WriteOnly);
+		QImageWriter writer{ &buffer, settings.format == BurstFormat::Jpeg ? "jpg" : "png" };
+		if (settings.format == BurstFormat::Jpeg)
+		{
+			writer.setQuality(settings.jpegQuality);
+		}
+		if (!writer.write(image))
+		{
+			burst.fail(QString("Cannot encode %1: %2").arg(encoded.fileName, writer.errorString()));
+			encoded.bytes.clear();
+		}
+	}
+
+	auto const finished = clock::now();
+	burst.encodeTime.record(finished - started);
+	raiseTo(burst.lastEncodeEnd, sinceEpoch(finished));
+	return encoded;
+}
+
+void BurstCapture::writeAll(Burst& burst)
+{
+	QDir const directory{ burst.settings.directory };
+	std::vector<QFuture<Encoded>> batch;
+	batch.reserve(maxBatchFrames);
+	for (;;)
+	{
+		{
+			std::unique_lock lock(burst.mutex);
+			burst.wake.wait(lock, [&burst]() { return !burst.pending.empty() || burst.captureDone; });
+			if (burst.pending.empty())
+			{
+				return; // Captured and all written
+			}
+			batch.push_back(std::move(burst.pending.front()));
+			burst.pending.pop_front();
+		}
+		// Files go in capture order: wait for the oldest, then take whatever behind it is ready too
+		batch.front().waitForFinished();
+		{
+			std::lock_guard lock(burst.mutex);
+			while (batch.size() < maxBatchFrames && !burst.pending.empty() && burst.pending.front().isFinished())
+			{
+				batch.push_back(std::move(burst.pending.front()));
+				burst.pending.pop_front();
+			}
+		}
+
+		ScopedStageTimer const timer{ burst.writeTime };
+		for (QFuture<Encoded>& future : batch)
+		{
+			Encoded const encoded{ future.result() };
+			char const* const data{ encoded.raw ? reinterpret_cast<char const*>(encoded.raw.data()) : encoded.bytes.constData() };
+			qint64 const bytes{ encoded.raw ? static_cast<qint64>(encoded.rawBytes) : encoded.bytes.size() };
+			bool written{ false };
+			if (bytes > 0)
+			{
+				QFile file{ directory.filePath(encoded.fileName) };
+				written = file.open(QIODevice::WriteOnly | QIODevice::Truncate) && file.write(data, bytes) == bytes;
+				if (!written)
+				{
+					burst.fail(QString("Cannot write %1: %2").arg(file.fileName(), file.errorString()));
+				}
+			}
+			if (written)
+			{
+				burst.written.fetch_add(1);
+				burst.bytesWritten.fetch_add(static_cast<uint64_t>(bytes));
+				burst.captureToDisk.record(clock::now() - encoded.capturedAt);
+			}
+			else
+			{
+				burst.failed.fetch_add(1);
+			}
+			burst.queued.fetch_sub(1);
+		}
+		batch.clear();
+	}
+}
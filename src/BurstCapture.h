@@ -0,0 +1,147 @@
+#pragma once
+
+#include <QByteArray>
+#include <QFuture>
+#include <QString>
+#include <QThreadPool>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <optional>
+
+#include "FramePool.h"
+#include "ReceiverCache.h"
+#include "Stats.h"
+
+enum class BurstFormat
+{
+    Png,
+    Jpeg,
+    Raw  // The frame exactly as received (UYVY, BGRA and so on), its size and layout in the file name
+};
+
+struct BurstSettings
+{
+    QString sourceName;
+    QString directory;                      // Created if need be. Files are named frame-000001.png and so on, in capture order
+    int frames{ 100 };                      // Stop after this many frames (dropped ones included)...
+    std::chrono::milliseconds duration{ 0 }; // ...or this long, whichever comes first. 0 for no limit, of either
+    BurstFormat format{ BurstFormat::Png };
+    int jpegQuality{ 90 };
+    // Frames captured but not yet on disk, at most. Past that the capture drops frames rather than wait for
+    //  the encoders; this and the largest frame's size bound the memory a burst can take.
+    size_t maxQueuedFrames{ 32 };
+    std::chrono::milliseconds firstFrameTimeout{ 5000 };
+};
+
+// How a burst went. The encode figures are what tells how long a burst a machine can sustain: as long
+//  as encodedPerSecond() stays above the source's frame rate, the queue never fills and nothing drops.
+struct BurstReport
+{
+    uint64_t framesCaptured{ 0 };
+    uint64_t framesDropped{ 0 };       // The queue was full: the encoders or the disk had fallen behind
+    uint64_t framesWritten{ 0 };
+    uint64_t framesFailed{ 0 };        // Couldn't be encoded or written; see error
+    uint64_t bytesWritten{ 0 };
+    uint64_t queuedPeak{ 0 };
+    int encoderThreads{ 0 };
+    std::chrono::nanoseconds captureTime{ 0 };   // First frame to last
+    std::chrono::nanoseconds encodeSpan{ 0 };    // First encode starting to last finishing
+    std::chrono::nanoseconds totalTime{ 0 };     // First frame to the last file closed
+    LatencyHistogram::Snapshot encode;           // Each frame's encode, on one core
+    LatencyHistogram::Snapshot write;            // Each batch of files written
+    LatencyHistogram::Snapshot captureToDisk;    // Each frame, from its capture to its file being closed
+    QString error;                               // The first thing that went wrong, if anything did
+
+    double encodedPerSecond() const;             // Across all the encoder threads
+    double capturedPerSecond() const;
+    double writeMegabytesPerSecond() const;
+    QString summary() const;                     // A line or two for the log
+};
+
+// Captures a burst of frames from one source to a directory of image files: "the next N frames" or "the
+//  next T seconds" of it, for looking at an incident frame by frame afterwards.
+//
+// Three stages, so that capturing never waits on encoding and encoding never waits on the disk. The
+//  calling thread receives, copying each frame into a pooled buffer and queueing it; encoding (colour
+//  conversion and PNG or JPEG compression, the expensive part) runs on a pool of threads of the burst's
+//  own, one per core less one, through QtConcurrent; and a single writer thread takes finished frames in
+//  capture order, as many as are ready at once, and writes their files one after another, so the disk
+//  sees one sequential stream of writes rather than a scatter from every encoder. Receivers come from the
+//  ReceiverCache, so a burst from a source being played or recently captured starts at once.
+class BurstCapture
+{
+public:
+    using clock = std::chrono::steady_clock;
+
+    explicit BurstCapture(ReceiverCache& receivers);
+    ~BurstCapture();
+
+    BurstCapture(BurstCapture const&) = delete;
+    BurstCapture& operator=(BurstCapture const&) = delete;
+
+    // Blocks until every frame captured is on disk, or stopRequested (which ends the capture early; what was
+    //  captured is still written). One burst at a time.
+    BurstReport run(BurstSettings const& settings, std::atomic<bool> const& stopRequested);
+
+    static QString extension(BurstFormat format);
+
+private:
+    struct Frame
+    {
+        uint64_t index;
+        FramePool::Buffer pixels;
+        int width;
+        int height;
+        int strideBytes;
+        NDIlib_FourCC_video_type_e fourCC;
+        size_t bytes;
+        clock::time_point capturedAt;
+    };
+
+    struct Encoded
+    {
+        uint64_t index;
+        QString fileName;
+        QByteArray bytes;          // Empty if it couldn't be encoded
+        FramePool::Buffer raw;     // BurstFormat::Raw writes the captured buffer itself, rather than a copy
+        size_t rawBytes{ 0 };
+        clock::time_point capturedAt;
+    };
+
+    // Everything one run() shares between its capture, encoders and writer
+    struct Burst
+    {
+        BurstSettings settings;
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::deque<QFuture<Encoded>> pending; // In capture order, for the writer
+        bool captureDone{ false };
+        QString error;
+
+        std::atomic<uint64_t> queued{ 0 };    // Captured and not yet written
+        std::atomic<uint64_t> queuedPeak{ 0 };
+        std::atomic<uint64_t> written{ 0 };
+        std::atomic<uint64_t> failed{ 0 };
+        std::atomic<uint64_t> bytesWritten{ 0 };
+        std::atomic<int64_t> firstEncodeStart{ INT64_MAX }; // steady_clock, nanoseconds since its epoch
+        std::atomic<int64_t> lastEncodeEnd{ 0 };
+        LatencyHistogram encodeTime;
+        LatencyHistogram writeTime;
+        LatencyHistogram captureToDisk;
+
+        void fail(QString const& reason);
+    };
+
+    static Encoded encode(Frame frame, Burst& burst);
+    static void writeAll(Burst& burst);
+    // Returns when the first frame arrived, if one did
+    static std::optional<clock::time_point> capture(NDIlib_recv_instance_t receiver, Burst& burst, QThreadPool& encoders,
+                                                    std::atomic<bool> const& stopRequested, BurstReport& report);
+
+    ReceiverCache& m_receivers;
+    QThreadPool m_encoders;
+};
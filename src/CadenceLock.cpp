@@ -0,0 +1,92 @@
+#include "CadenceLock.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <utility>
+
+namespace
+{
+	// Refresh rates are reported loosely: a 59.94 Hz display keeps up with a 60 fps source
+	constexpr double capTolerance = 0.01;
+}
+
+void CadenceLock::reset()
+{
+	*this = CadenceLock{};
+}
+
+std::optional<CadenceLock::Lock> CadenceLock::lockTo(int const frameRateN, int const frameRateD, int const frameFormat, double const maxTicksPerSecond)
+{
+	if (frameRateN <= 0 || frameRateD <= 0)
+	{
+		return std::nullopt; // Not a rate to lock to; keep ticking as we were
+	}
+	if (frameRateN == m_lock.frameRateN && frameRateD == m_lock.frameRateD && frameFormat == m_frameFormat && maxTicksPerSecond == m_maxTicksPerSecond)
+	{
+		return std::nullopt;
+	}
+
+	double const sourceRate{ static_cast<double>(frameRateN) / frameRateD };
+	int framesPerTick{ 1 };
+	if (maxTicksPerSecond > 0.0)
+	{
+		framesPerTick = std::max(1, static_cast<int>(std::ceil(sourceRate / maxTicksPerSecond * (1.0 - capTolerance))));
+	}
+
+	m_lock = { std::chrono::nanoseconds{ 1000000000LL * frameRateD * framesPerTick / frameRateN }, framesPerTick, frameRateN, frameRateD };
+	m_frameFormat = frameFormat;
+	m_maxTicksPerSecond = maxTicksPerSecond;
+	// The ticks move to the new grid; the step across the change means nothing
+	m_previousTimestamp = 0;
+	m_misses = 0;
+	m_cleanTicks = 0;
+	m_pendingShift = std::chrono::nanoseconds{ 0 };
+	return m_lock;
+}
+
+std::optional<CadenceLock::Step> CadenceLock::observe(int64_t const timestamp)
+{
+	if (!locked() || timestamp <= 0)
+	{
+		m_previousTimestamp = 0;
+		return std::nullopt;
+	}
+	int64_t const previous{ m_previousTimestamp };
+	m_previousTimestamp = timestamp;
+	++m_ticksSinceShift;
+	if (previous == 0)
+	{
+		return std::nullopt;
+	}
+
+	// In 100 ns units, like the timestamps
+	double const framePeriod{ 1e7 * m_lock.frameRateD / m_lock.frameRateN };
+	double const stepped{ static_cast<double>(timestamp - previous) };
+	Step step;
+	step.error = std::chrono::nanoseconds{ std::llround(std::abs(stepped - framePeriod * m_lock.framesPerTick) * 100.0) };
+	step.missed = std::llround(stepped / framePeriod) != m_lock.framesPerTick;
+
+	if (step.missed)
+	{
+		m_cleanTicks = 0;
+		if (++m_misses >= missesBeforeShift && m_ticksSinceShift >= minTicksBetweenShifts)
+		{
+			// Later rather than sooner, so no two ticks come closer together than an interval
+			m_pendingShift = m_lock.interval / 2;
+			m_misses = 0;
+			m_ticksSinceShift = 0;
+			m_previousTimestamp = 0; // The shifted tick steps further than usual
+		}
+	}
+	else if (++m_cleanTicks >= cleanTicksToForget)
+	{
+		m_misses = 0;
+	}
+	return step;
+}
+
+std::chrono::nanoseconds CadenceLock::takePhaseShift()
+{
+	return std::exchange(m_pendingShift, std::chrono::nanoseconds{ 0 });
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+
+// Locks the capture ticks to the source's own frame rate, instead of a rate picked by hand. Ticking 30
+//  times a second against a 29.97 fps source beats: every 33 s or so a frame is seen twice, and any
+//  other mismatch does the same more often. Locked, there is a tick per source frame; or, if the source
+//  runs faster than the display can show (a cap of its refresh rate), one per k source frames, the fewest
+//  that keeps under the cap. That subsamples evenly, where any other rate under the cap would skip frames
+//  unevenly.
+//
+// A tick should then step exactly k frames on through the source's timestamps. One that finds the frame
+//  it had last time, or has moved on k + 1, has the ticks sitting on the edge where frames arrive, with
+//  jitter on either side deciding which frame each sees. A couple of those and the ticks are moved half
+//  an interval, into the middle of the frame; that also follows the slow drift between the sender's clock
+//  and ours. How far each step was from k frames' worth is the cadence error.
+class CadenceLock
+{
+public:
+    struct Lock
+    {
+        std::chrono::nanoseconds interval{ 0 }; // Between ticks
+        int framesPerTick{ 1 };
+        int frameRateN{ 0 };
+        int frameRateD{ 0 };
+    };
+
+    struct Step
+    {
+        std::chrono::nanoseconds error{ 0 }; // From framesPerTick frames' worth, either way
+        bool missed{ false };                // Found the same frame again, or skipped one
+    };
+
+    // A couple of misses this close together means the ticks are on a frame edge, not that a frame was late
+    static constexpr int missesBeforeShift = 2;
+    static constexpr int cleanTicksToForget = 60;
+    // However many misses there are (a source sending fewer frames than it says it does misses all the
+    //  time), the ticks are moved at most once in this many
+    static constexpr int minTicksBetweenShifts = 30;
+
+    // Forgets the source, for a new one
+    void reset();
+
+    // With each frame captured: the rate the source says it runs at, and its frame format (progressive,
+    //  interleaved or a field). Returns the new lock when that differs from the current one (the first
+    //  frame, or the source changing format). maxTicksPerSecond of 0 is no cap.
+    std::optional<Lock> lockTo(int frameRateN, int frameRateD, int frameFormat, double maxTicksPerSecond);
+
+    // With each tick's frame, by its timestamp (100 ns units, as NDI stamps frames). Nothing for the first
+    //  tick after a lock or a shift, which has no step to measure, or if the source doesn't stamp its frames.
+    std::optional<Step> observe(int64_t timestamp);
+
+    // How far to move the next tick, once: half an interval later when the ticks are on an edge, else 0
+    std::chrono::nanoseconds takePhaseShift();
+
+    bool locked() const { return m_lock.frameRateN > 0; }
+    Lock const& lock() const { return m_lock; }
+
+private:
+    Lock m_lock;
+    int m_frameFormat{ -1 };
+    double m_maxTicksPerSecond{ 0.0 };
+    int64_t m_previousTimestamp{ 0 };    // Of the last tick's frame; 0 when there isn't one to step from
+    int m_misses{ 0 };
+    int m_cleanTicks{ 0 };
+    int m_ticksSinceShift{ minTicksBetweenShifts };
+    std::chrono::nanoseconds m_pendingShift{ 0 };
+};
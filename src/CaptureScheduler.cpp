@@ -0,0 +1,89 @@
+#include "CaptureScheduler.h"
+
+#include <algorithm>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <timeapi.h>
+#endif
+
+namespace
+{
+	// Longest single sleep; bounds how long a stop request can go unnoticed.
+	constexpr std::chrono::milliseconds maxSleepSlice{ 50 };
+}
+
+CaptureScheduler::CaptureScheduler(std::chrono::nanoseconds interval)
+	: m_interval{ std::max(interval, std::chrono::nanoseconds(std::chrono::microseconds(1))) }
+	, m_nextDeadline{ clock::now() + m_interval }
+	, m_lastDeadline{ m_nextDeadline - m_interval }
+	, m_lastTick{ clock::now() }
+{
+#ifdef _WIN32
+	// The default Windows timer granularity is ~15.6ms, which is coarser than a 60 captures per second
+	//  interval. Ask for 1ms for as long as this scheduler is alive.
+	timeBeginPeriod(1);
+#endif
+}
+
+CaptureScheduler::~CaptureScheduler()
+{
+#ifdef _WIN32
+	timeEndPeriod(1);
+#endif
+}
+
+std::optional<CaptureScheduler::Tick> CaptureScheduler::waitForNextTick(std::atomic<bool> const& stopRequested)
+{
+	using namespace std::chrono;
+
+	auto now = clock::now();
+	while (now < m_nextDeadline)
+	{
+		if (stopRequested.load())
+		{
+			return std::nullopt;
+		}
+		std::this_thread::sleep_until(std::min(m_nextDeadline, now + maxSleepSlice));
+		now = clock::now();
+	}
+	if (stopRequested.load())
+	{
+		return std::nullopt;
+	}
+
+	Tick tick{};
+	tick.jitter = duration_cast<microseconds>(now - m_nextDeadline);
+	tick.sinceLastTick = duration_cast<microseconds>(now - m_lastTick);
+
+	// Less than one interval late: fire now and keep the grid, so the next tick comes round a little
+	//  sooner and we catch up. A whole interval or more late: skip the missed deadlines instead of
+	//  firing a burst of back to back ticks.
+	auto const missed = static_cast<uint32_t>(tick.jitter / m_interval);
+	tick.skippedTicks = missed;
+	m_lastDeadline = m_nextDeadline + m_interval * missed;
+	m_nextDeadline = m_lastDeadline + m_interval;
+
+	m_lastTick = now;
+	m_ticksFired++;
+	m_ticksSkipped += missed;
+	m_totalJitter += tick.jitter;
+	m_maxJitter = std::max(m_maxJitter, tick.jitter);
+	return tick;
+}
+
+void CaptureScheduler::retime(std::chrono::nanoseconds const interval, std::chrono::nanoseconds const phaseShift)
+{
+	if (interval != m_interval && interval > std::chrono::nanoseconds{ 0 })
+	{
+		m_interval = std::max(interval, std::chrono::nanoseconds(std::chrono::microseconds(1)));
+		m_nextDeadline = m_lastDeadline + m_interval;
+	}
+	m_nextDeadline += phaseShift;
+}
+
+std::chrono::microseconds CaptureScheduler::meanJitter() const
+{
+	return m_ticksFired ? m_totalJitter / static_cast<int64_t>(m_ticksFired) : std::chrono::microseconds(0);
+}
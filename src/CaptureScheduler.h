@@ -0,0 +1,55 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+
+// Deadline-driven tick source for the playback loop. Rather than spinning on steady_clock::now() until
+//  enough time has passed, the calling thread sleeps until an absolute deadline. Deadlines sit on a fixed
+//  grid (start + n * interval) so small amounts of lateness do not accumulate into drift. If we fall a
+//  whole interval or more behind (debugger, overloaded machine), the missed deadlines are skipped rather
+//  than fired back to back.
+class CaptureScheduler
+{
+public:
+    using clock = std::chrono::steady_clock;
+
+    struct Tick
+    {
+        std::chrono::microseconds sinceLastTick; // Actual time since the previous tick (or since construction)
+        std::chrono::microseconds jitter;        // How late this tick fired relative to its deadline
+        uint32_t skippedTicks;                   // Deadlines abandoned since the previous tick
+    };
+
+    explicit CaptureScheduler(std::chrono::nanoseconds interval);
+    ~CaptureScheduler();
+
+    CaptureScheduler(CaptureScheduler const&) = delete;
+    CaptureScheduler& operator=(CaptureScheduler const&) = delete;
+
+    // Blocks until the next deadline. Returns nothing if stopRequested became true while waiting; the
+    //  wait is done in slices so that a stop is noticed promptly even at very low capture rates.
+    std::optional<Tick> waitForNextTick(std::atomic<bool> const& stopRequested);
+
+    // After a tick, for a capture locked to its source (see CadenceLock): a new interval puts the grid's next
+    //  deadline that far from the tick just fired, and a phase shift moves it, and every one after, that much later.
+    void retime(std::chrono::nanoseconds interval, std::chrono::nanoseconds phaseShift = std::chrono::nanoseconds{ 0 });
+    std::chrono::nanoseconds interval() const { return m_interval; }
+
+    uint64_t ticksFired() const { return m_ticksFired; }
+    uint64_t ticksSkipped() const { return m_ticksSkipped; }
+    std::chrono::microseconds maxJitter() const { return m_maxJitter; }
+    std::chrono::microseconds meanJitter() const;
+
+private:
+    std::chrono::nanoseconds m_interval;
+    clock::time_point m_nextDeadline;
+    clock::time_point m_lastDeadline;  // The one the last tick fired for
+    clock::time_point m_lastTick;
+
+    uint64_t m_ticksFired{ 0 };
+    uint64_t m_ticksSkipped{ 0 };
+    std::chrono::microseconds m_totalJitter{ 0 };
+    std::chrono::microseconds m_maxJitter{ 0 };
+};
@@ -0,0 +1,61 @@
+#include "CpuFeatures.h"
+
+#if NDIRECV_X86
+#if defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace
+{
+	CpuFeatures detect()
+	{
+		CpuFeatures features;
+#if NDIRECV_X86
+		unsigned int regs[4]{};
+#if defined(_MSC_VER)
+		auto cpuid = [&regs](unsigned int leaf) { int r[4]; __cpuidex(r, static_cast<int>(leaf), 0); for (int i = 0; i < 4; ++i) { regs[i] = static_cast<unsigned int>(r[i]); } };
+		auto xgetbv0 = []() { return static_cast<unsigned long long>(_xgetbv(0)); };
+#else
+		auto cpuid = [&regs](unsigned int leaf) { __cpuid_count(leaf, 0, regs[0], regs[1], regs[2], regs[3]); };
+		auto xgetbv0 = []() { unsigned int lo, hi; __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0)); return (static_cast<unsigned long long>(hi) << 32) | lo; };
+#endif
+		cpuid(0);
+		unsigned int const maxLeaf = regs[0];
+
+		cpuid(1);
+		features.sse41 = (regs[2] & (1u << 19)) != 0;
+		bool const osSavesYmm = (regs[2] & (1u << 27)) != 0 && (xgetbv0() & 0x6) == 0x6; // OSXSAVE, and XMM+YMM state enabled
+
+		if (maxLeaf >= 7 && osSavesYmm)
+		{
+			cpuid(7);
+			features.avx2 = (regs[1] & (1u << 5)) != 0;
+		}
+#endif
+		return features;
+	}
+}
+
+CpuFeatures const& CpuFeatures::get()
+{
+	static CpuFeatures const features{ detect() };
+	return features;
+}
+
+KernelPath CpuFeatures::resolve(KernelPath requested)
+{
+	CpuFeatures const& cpu{ get() };
+	if (requested == KernelPath::Best)
+	{
+		return cpu.avx2 ? KernelPath::AVX2 : cpu.sse41 ? KernelPath::SSE41 : KernelPath::Scalar;
+	}
+	if ((requested == KernelPath::AVX2 && !cpu.avx2) || (requested == KernelPath::SSE41 && !cpu.sse41))
+	{
+		return KernelPath::Scalar;
+	}
+	return requested;
+}
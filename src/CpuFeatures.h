@@ -0,0 +1,48 @@
+#pragma once
+
+// Which implementation of a vectorised kernel to run. Kernels take this so tests can pin each path and
+//  compare it against the scalar one.
+enum class KernelPath
+{
+    Scalar,
+    SSE41,
+    AVX2,
+    Best // Fastest path this CPU supports
+};
+
+// Runtime detection of the x86 SIMD extensions our kernels have hand-written paths for. Checked once
+//  and cached; kernels use this to pick a path so one binary runs on any x86-64 machine. On other
+//  architectures everything reports false and the scalar paths are used.
+struct CpuFeatures
+{
+    bool sse41{ false };
+    bool avx2{ false };
+
+    static CpuFeatures const& get();
+
+    // Best becomes the fastest supported path; anything this CPU can't run becomes Scalar.
+    static KernelPath resolve(KernelPath requested);
+};
+
+// Kernels compiled for an instruction set beyond the compiler's baseline need marking on GCC/Clang;
+//  MSVC lets intrinsics be used anywhere.
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define NDIRECV_X86 1
+#if defined(__GNUC__) || defined(__clang__)
+#define NDIRECV_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define NDIRECV_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define NDIRECV_TARGET_SSE41
+#define NDIRECV_TARGET_AVX2
+#endif
+#else
+#define NDIRECV_X86 0
+#endif
+
+// For scalar helpers called from inside a vector loop. Left as a call, one compiled for the baseline
+//  instruction set costs an AVX to SSE transition each time it is entered.
+#if defined(_MSC_VER)
+#define NDIRECV_FORCE_INLINE __forceinline
+#else
+#define NDIRECV_FORCE_INLINE inline __attribute__((always_inline))
+#endif
@@ -0,0 +1,244 @@
+#include "Deinterlace.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#if NDIRECV_X86
+#include <immintrin.h>
+#endif
+
+namespace
+{
+	// Rounds up, as pavgb does, so every path gives the same bytes.
+	NDIRECV_FORCE_INLINE uint8_t average(int a, int b)
+	{
+		return static_cast<uint8_t>((a + b + 1) >> 1);
+	}
+
+	void averageRowsScalar(uint8_t const* a, uint8_t const* b, uint8_t* out, int numBytes)
+	{
+		for (int i = 0; i < numBytes; ++i)
+		{
+			out[i] = average(a[i], b[i]);
+		}
+	}
+
+	void blendRowsScalar(uint8_t const* above, uint8_t const* row, uint8_t const* below, uint8_t* out, int numBytes)
+	{
+		for (int i = 0; i < numBytes; ++i)
+		{
+			out[i] = average(average(above[i], below[i]), row[i]);
+		}
+	}
+
+	// Works in groups of 4 bytes: a UYVY pixel pair or one RGB pixel, decided on together.
+	void adaptRowScalar(uint8_t const* above, uint8_t const* below, uint8_t const* woven, uint8_t const* previous, uint8_t* out, int numBytes, int threshold)
+	{
+		for (int i = 0; i + 4 <= numBytes; i += 4)
+		{
+			bool moving = false;
+			for (int j = i; j < i + 4; ++j)
+			{
+				moving = moving || std::abs(woven[j] - previous[j]) > threshold;
+			}
+			for (int j = i; j < i + 4; ++j)
+			{
+				out[j] = moving ? average(above[j], below[j]) : woven[j];
+			}
+		}
+	}
+
+#if NDIRECV_X86
+	NDIRECV_TARGET_SSE41 void averageRowsSse41(uint8_t const* a, uint8_t const* b, uint8_t* out, int numBytes)
+	{
+		int i = 0;
+		for (; i + 16 <= numBytes; i += 16)
+		{
+			__m128i const x = _mm_loadu_si128(reinterpret_cast<__m128i const*>(a + i));
+			__m128i const y = _mm_loadu_si128(reinterpret_cast<__m128i const*>(b + i));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_avg_epu8(x, y));
+		}
+		averageRowsScalar(a + i, b + i, out + i, numBytes - i);
+	}
+
+	NDIRECV_TARGET_SSE41 void blendRowsSse41(uint8_t const* above, uint8_t const* row, uint8_t const* below, uint8_t* out, int numBytes)
+	{
+		int i = 0;
+		for (; i + 16 <= numBytes; i += 16)
+		{
+			__m128i const up = _mm_loadu_si128(reinterpret_cast<__m128i const*>(above + i));
+			__m128i const here = _mm_loadu_si128(reinterpret_cast<__m128i const*>(row + i));
+			__m128i const down = _mm_loadu_si128(reinterpret_cast<__m128i const*>(below + i));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_avg_epu8(_mm_avg_epu8(up, down), here));
+		}
+		blendRowsScalar(above + i, row + i, below + i, out + i, numBytes - i);
+	}
+
+	NDIRECV_TARGET_SSE41 void adaptRowSse41(uint8_t const* above, uint8_t const* below, uint8_t const* woven, uint8_t const* previous, uint8_t* out, int numBytes, int threshold)
+	{
+		__m128i const limit = _mm_set1_epi8(static_cast<char>(threshold));
+		__m128i const zero = _mm_setzero_si128();
+		int i = 0;
+		for (; i + 16 <= numBytes; i += 16)
+		{
+			__m128i const up = _mm_loadu_si128(reinterpret_cast<__m128i const*>(above + i));
+			__m128i const down = _mm_loadu_si128(reinterpret_cast<__m128i const*>(below + i));
+			__m128i const now = _mm_loadu_si128(reinterpret_cast<__m128i const*>(woven + i));
+			__m128i const before = _mm_loadu_si128(reinterpret_cast<__m128i const*>(previous + i));
+			// |now - before| from two saturating subtracts; anything left after taking off the limit is
+			//  motion, and a group of 4 bytes is still only if all of it is zero
+			__m128i const difference = _mm_or_si128(_mm_subs_epu8(now, before), _mm_subs_epu8(before, now));
+			__m128i const still = _mm_cmpeq_epi32(_mm_subs_epu8(difference, limit), zero);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_blendv_epi8(_mm_avg_epu8(up, down), now, still));
+		}
+		adaptRowScalar(above + i, below + i, woven + i, previous + i, out + i, numBytes - i, threshold);
+	}
+
+	NDIRECV_TARGET_AVX2 void averageRowsAvx2(uint8_t const* a, uint8_t const* b, uint8_t* out, int numBytes)
+	{
+		int i = 0;
+		for (; i + 32 <= numBytes; i += 32)
+		{
+			__m256i const x = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(a + i));
+			__m256i const y = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(b + i));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_avg_epu8(x, y));
+		}
+		averageRowsScalar(a + i, b + i, out + i, numBytes - i);
+	}
+
+	NDIRECV_TARGET_AVX2 void blendRowsAvx2(uint8_t const* above, uint8_t const* row, uint8_t const* below, uint8_t* out, int numBytes)
+	{
+		int i = 0;
+		for (; i + 32 <= numBytes; i += 32)
+		{
+			__m256i const up = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(above + i));
+			__m256i const here = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(row + i));
+			__m256i const down = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(below + i));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_avg_epu8(_mm256_avg_epu8(up, down), here));
+		}
+		blendRowsScalar(above + i, row + i, below + i, out + i, numBytes - i);
+	}
+
+	NDIRECV_TARGET_AVX2 void adaptRowAvx2(uint8_t const* above, uint8_t const* below, uint8_t const* woven, uint8_t const* previous, uint8_t* out, int numBytes, int threshold)
+	{
+		__m256i const limit = _mm256_set1_epi8(static_cast<char>(threshold));
+		__m256i const zero = _mm256_setzero_si256();
+		int i = 0;
+		for (; i + 32 <= numBytes; i += 32)
+		{
+			__m256i const up = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(above + i));
+			__m256i const down = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(below + i));
+			__m256i const now = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(woven + i));
+			__m256i const before = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(previous + i));
+			__m256i const difference = _mm256_or_si256(_mm256_subs_epu8(now, before), _mm256_subs_epu8(before, now));
+			__m256i const still = _mm256_cmpeq_epi32(_mm256_subs_epu8(difference, limit), zero);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_blendv_epi8(_mm256_avg_epu8(up, down), now, still));
+		}
+		adaptRowScalar(above + i, below + i, woven + i, previous + i, out + i, numBytes - i, threshold);
+	}
+#endif
+}
+
+Deinterlacer::Deinterlacer(KernelPath path)
+	: m_path{ CpuFeatures::resolve(path) }
+{
+	m_averageRows = averageRowsScalar;
+	m_blendRows = blendRowsScalar;
+	m_adaptRow = adaptRowScalar;
+#if NDIRECV_X86
+	if (m_path == KernelPath::AVX2)
+	{
+		m_averageRows = averageRowsAvx2;
+		m_blendRows = blendRowsAvx2;
+		m_adaptRow = adaptRowAvx2;
+	}
+	if (m_path == KernelPath::SSE41)
+	{
+		m_averageRows = averageRowsSse41;
+		m_blendRows = blendRowsSse41;
+		m_adaptRow = adaptRowSse41;
+	}
+#endif
+}
+
+SourceFrame Deinterlacer::deinterlace(SourceFrame const& frame, DeinterlaceMode mode, int field, bool newFrame)
+{
+	if (mode == DeinterlaceMode::Off || !frame.data || frame.width <= 0 || frame.height < 2)
+	{
+		return frame;
+	}
+
+	// Whole pixel pairs only, as in FrameConverter; every row is then a whole number of 4 byte groups
+	int const width = frame.layout == PixelLayout::UYVY ? (frame.width & ~1) : frame.width;
+	int const rowBytes = width * (frame.layout == PixelLayout::UYVY ? 2 : 4);
+	int const height = frame.height;
+	if (m_output.size() < static_cast<size_t>(rowBytes) * height)
+	{
+		m_output.resize(static_cast<size_t>(rowBytes) * height);
+	}
+	auto const source = [&frame](int y) { return frame.data + static_cast<ptrdiff_t>(y) * frame.strideBytes; };
+	auto const output = [this, rowBytes](int y) { return m_output.data() + static_cast<ptrdiff_t>(y) * rowBytes; };
+
+	if (mode == DeinterlaceMode::LinearBlend)
+	{
+		for (int y = 0; y < height; ++y)
+		{
+			m_blendRows(source(std::max(y - 1, 0)), source(y), source(std::min(y + 1, height - 1)), output(y), rowBytes);
+		}
+		return { m_output.data(), width, height, rowBytes, frame.layout };
+	}
+
+	uint8_t const* previous{ nullptr };
+	if (mode == DeinterlaceMode::MotionAdaptive)
+	{
+		if (newFrame || m_historyFrames == 0 || m_historyRowBytes != rowBytes || m_historyHeight != height)
+		{
+			remember(frame, rowBytes);
+		}
+		if (m_historyFrames == 2)
+		{
+			previous = m_history[m_current ^ 1].data();
+		}
+	}
+
+	field &= 1;
+	for (int y = 0; y < height; ++y)
+	{
+		if ((y & 1) == field)
+		{
+			std::memcpy(output(y), source(y), rowBytes);
+			continue;
+		}
+		// The lines either side are the field being shown; at the top and bottom there is only one
+		int const up = y > 0 ? y - 1 : y + 1;
+		int const down = y + 1 < height ? y + 1 : y - 1;
+		if (previous)
+		{
+			m_adaptRow(source(up), source(down), source(y), previous + static_cast<ptrdiff_t>(y) * rowBytes, output(y), rowBytes, motionThreshold);
+		}
+		else
+		{
+			m_averageRows(source(up), source(down), output(y), rowBytes);
+		}
+	}
+	return { m_output.data(), width, height, rowBytes, frame.layout };
+}
+
+void Deinterlacer::remember(SourceFrame const& frame, int rowBytes)
+{
+	if (m_historyRowBytes != rowBytes || m_historyHeight != frame.height)
+	{
+		m_historyFrames = 0;
+		m_historyRowBytes = rowBytes;
+		m_historyHeight = frame.height;
+	}
+	m_current ^= 1;
+	std::vector<uint8_t>& copy = m_history[m_current];
+	copy.resize(static_cast<size_t>(rowBytes) * frame.height);
+	for (int y = 0; y < frame.height; ++y)
+	{
+		std::memcpy(copy.data() + static_cast<ptrdiff_t>(y) * rowBytes, frame.data + static_cast<ptrdiff_t>(y) * frame.strideBytes, rowBytes);
+	}
+	m_historyFrames = std::min(m_historyFrames + 1, 2);
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "CpuFeatures.h"
+#include "VideoConvert.h"
+
+enum class DeinterlaceMode
+{
+    Off,           // Frames are shown as they come; an interlaced source is left to the SDK to make progressive
+    Bob,           // Each field shown on its own, the missing lines interpolated from the ones either side
+    LinearBlend,   // Both fields mixed into one picture a frame: no combing, but moving edges go soft
+    MotionAdaptive // Bob where the picture moves, both fields woven together where it doesn't
+};
+
+// Bob and motion adaptive make a picture from each field, so show twice as many as there are frames.
+inline bool fieldRate(DeinterlaceMode mode)
+{
+    return mode == DeinterlaceMode::Bob || mode == DeinterlaceMode::MotionAdaptive;
+}
+
+// Turns interleaved frames - both fields woven into one, field 0 on the even lines and first in time -
+//  into progressive pictures, a whole line at a time (the vectorised part). Runs on the source frame
+//  before FrameConverter, so it sees every line and its output scales like any progressive frame.
+//
+// Motion adaptive decides per pixel (per pixel pair in UYVY, so luma and chroma agree): where the other
+//  field's lines differ from the same lines a frame earlier by more than motionThreshold the pixel is
+//  interpolated as in bob, otherwise that field's line is woven in, keeping full vertical detail in the
+//  still parts of the picture. It keeps a copy of the last two frames for this; the first frame after a
+//  reset, or after the format changes, is bobbed.
+//
+// The output lives in the deinterlacer and is reused, so a stream of frames doesn't allocate once it has
+//  seen the largest.
+class Deinterlacer
+{
+public:
+    static constexpr int motionThreshold{ 10 }; // Per 8 bit sample; above the noise of a clean camera feed
+
+    explicit Deinterlacer(KernelPath path = KernelPath::Best);
+
+    // A progressive picture of one field of an interleaved frame (0 or 1; linear blend ignores it). newFrame
+    //  says this is the first time this frame has been passed in, when motion adaptive moves its history
+    //  on. Returns the frame itself if mode is Off or it has fewer than two lines; otherwise the result
+    //  is valid until the next call.
+    SourceFrame deinterlace(SourceFrame const& frame, DeinterlaceMode mode, int field, bool newFrame);
+
+    // Forgets the frames motion adaptive compares against, e.g. on switching source.
+    void reset() { m_historyFrames = 0; }
+
+    // The path actually in use, after resolving Best and dropping anything the CPU can't run.
+    KernelPath path() const { return m_path; }
+
+private:
+    using AverageRowsFunction = void (*)(uint8_t const* a, uint8_t const* b, uint8_t* out, int numBytes);
+    using BlendRowsFunction = void (*)(uint8_t const* above, uint8_t const* row, uint8_t const* below, uint8_t* out, int numBytes);
+    using AdaptRowFunction = void (*)(uint8_t const* above, uint8_t const* below, uint8_t const* woven, uint8_t const* previous, uint8_t* out, int numBytes, int threshold);
+
+    void remember(SourceFrame const& frame, int rowBytes);
+
+    KernelPath m_path;
+    AverageRowsFunction m_averageRows;
+    BlendRowsFunction m_blendRows;
+    AdaptRowFunction m_adaptRow;
+    std::vector<uint8_t> m_output;
+    std::vector<uint8_t> m_history[2]; // The current frame and the one before, packed; m_current indexes the first
+    int m_current{ 0 };
+    int m_historyFrames{ 0 };
+    int m_historyRowBytes{ 0 };
+    int m_historyHeight{ 0 };
+};
@@ -0,0 +1,145 @@
+#include "FrameHash.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+#if NDIRECV_X86
+#include <immintrin.h>
+#endif
+
+namespace
+{
+	constexpr uint32_t prime1 = 2654435761u;
+	constexpr uint32_t prime2 = 2246822519u;
+	constexpr uint32_t prime3 = 3266489917u;
+	constexpr int numLanes = 32; // Four independent chains per AVX2 register's worth, to hide the multiply latency
+	constexpr int blockBytes = numLanes * 4;
+
+	uint32_t round(uint32_t const lane, uint32_t const word)
+	{
+		return std::rotl(lane + word * prime2, 13) * prime1;
+	}
+
+	// Whole blocks of 32 words, one to a lane, then any leftover words and bytes into the lanes in turn
+	void hashRowScalar(uint8_t const* row, int numBytes, uint32_t* lanes)
+	{
+		int i = 0;
+		for (; i + 4 <= numBytes; i += 4)
+		{
+			uint32_t word;
+			std::memcpy(&word, row + i, 4);
+			uint32_t& lane = lanes[(i / 4) % numLanes];
+			lane = round(lane, word);
+		}
+		if (i < numBytes)
+		{
+			uint32_t word = 0;
+			std::memcpy(&word, row + i, numBytes - i);
+			uint32_t& lane = lanes[(i / 4) % numLanes];
+			lane = round(lane, word ^ prime3); // So a short tail of zeros differs from no tail
+		}
+	}
+
+#if NDIRECV_X86
+	NDIRECV_TARGET_SSE41 __m128i roundSse41(__m128i lane, __m128i const words)
+	{
+		lane = _mm_add_epi32(lane, _mm_mullo_epi32(words, _mm_set1_epi32(static_cast<int>(prime2))));
+		lane = _mm_or_si128(_mm_slli_epi32(lane, 13), _mm_srli_epi32(lane, 32 - 13));
+		return _mm_mullo_epi32(lane, _mm_set1_epi32(static_cast<int>(prime1)));
+	}
+
+	NDIRECV_TARGET_SSE41 void hashRowSse41(uint8_t const* row, int numBytes, uint32_t* lanes)
+	{
+		__m128i lane[numLanes / 4];
+		for (int part = 0; part < numLanes / 4; ++part)
+		{
+			lane[part] = _mm_loadu_si128(reinterpret_cast<__m128i const*>(lanes + part * 4));
+		}
+		int i = 0;
+		for (; i + blockBytes <= numBytes; i += blockBytes)
+		{
+			for (int part = 0; part < numLanes / 4; ++part)
+			{
+				lane[part] = roundSse41(lane[part], _mm_loadu_si128(reinterpret_cast<__m128i const*>(row + i + part * 16)));
+			}
+		}
+		for (int part = 0; part < numLanes / 4; ++part)
+		{
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(lanes + part * 4), lane[part]);
+		}
+		hashRowScalar(row + i, numBytes - i, lanes);
+	}
+
+	NDIRECV_TARGET_AVX2 void hashRowAvx2(uint8_t const* row, int numBytes, uint32_t* lanes)
+	{
+		__m256i const multiplier2 = _mm256_set1_epi32(static_cast<int>(prime2));
+		__m256i const multiplier1 = _mm256_set1_epi32(static_cast<int>(prime1));
+		__m256i lane[numLanes / 8];
+		for (int part = 0; part < numLanes / 8; ++part)
+		{
+			lane[part] = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(lanes + part * 8));
+		}
+		int i = 0;
+		for (; i + blockBytes <= numBytes; i += blockBytes)
+		{
+			for (int part = 0; part < numLanes / 8; ++part)
+			{
+				__m256i const words = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(row + i + part * 32));
+				__m256i value = _mm256_add_epi32(lane[part], _mm256_mullo_epi32(words, multiplier2));
+				value = _mm256_or_si256(_mm256_slli_epi32(value, 13), _mm256_srli_epi32(value, 32 - 13));
+				lane[part] = _mm256_mullo_epi32(value, multiplier1);
+			}
+		}
+		for (int part = 0; part < numLanes / 8; ++part)
+		{
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes + part * 8), lane[part]);
+		}
+		hashRowScalar(row + i, numBytes - i, lanes);
+	}
+#endif
+}
+
+FrameHasher::FrameHasher(KernelPath path)
+	: m_path{ CpuFeatures::resolve(path) }
+{
+	m_hashRow = hashRowScalar;
+#if NDIRECV_X86
+	if (m_path == KernelPath::AVX2) { m_hashRow = hashRowAvx2; }
+	if (m_path == KernelPath::SSE41) { m_hashRow = hashRowSse41; }
+#endif
+}
+
+uint64_t FrameHasher::hash(uint8_t const* data, int const rowBytes, int const height, int const strideBytes, FrameHashMode const mode, uint64_t const seed) const
+{
+	uint32_t lanes[numLanes];
+	for (int lane = 0; lane < numLanes; ++lane)
+	{
+		lanes[lane] = static_cast<uint32_t>(seed) + static_cast<uint32_t>(seed >> 32) * prime3 + lane * prime1;
+	}
+	if (!data || rowBytes <= 0 || height <= 0 || mode == FrameHashMode::Off)
+	{
+		return seed;
+	}
+
+	// Sampling starts half way into the first band of rows, not on row 0, which is often a plain border
+	int const rowStep = mode == FrameHashMode::Sampled ? 8 : 1;
+	for (int y = mode == FrameHashMode::Sampled ? std::min(4, height - 1) : 0; y < height; y += rowStep)
+	{
+		m_hashRow(data + static_cast<ptrdiff_t>(y) * strideBytes, rowBytes, lanes);
+	}
+
+	// Fold the lanes together, each rotated differently so that swapping two lanes' contents changes
+	//  the answer, then mix the bits down (the xxHash64 avalanche)
+	uint64_t folded = static_cast<uint64_t>(rowBytes) * height;
+	for (int lane = 0; lane < numLanes; ++lane)
+	{
+		folded = std::rotl(folded ^ std::rotl(static_cast<uint64_t>(lanes[lane]), lane * 7 % 64), 27) * 0x9E3779B185EBCA87ull;
+	}
+	folded ^= folded >> 33;
+	folded *= 0xC2B2AE3D27D4EB4Full;
+	folded ^= folded >> 29;
+	folded *= 0x165667B19E3779F9ull;
+	folded ^= folded >> 32;
+	return folded;
+}
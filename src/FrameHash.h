@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+
+#include "CpuFeatures.h"
+
+// How much of a frame to look at when deciding whether it is the same as the last one.
+enum class FrameHashMode
+{
+    Off,     // Never skip on content; only framesync's own repeats (same timestamp) are skipped
+    Sampled, // Every eighth row. Several times cheaper, but can miss a change confined to a few rows.
+    Full     // Every byte
+};
+
+// A 64 bit hash of a frame's pixels, for spotting frames whose content hasn't changed (a slide, a test
+//  card, a paused source) so they needn't be converted, scaled and repainted again. Not cryptographic;
+//  only the chance of two different frames of the same source colliding matters.
+//
+// 32 lanes of 32 bits, each running the xxHash32 round over every 32nd word of a row, so the vector
+//  paths compute exactly what the scalar one does. Row padding beyond rowBytes is never read.
+class FrameHasher
+{
+public:
+    explicit FrameHasher(KernelPath path = KernelPath::Best);
+
+    // seed should distinguish frames whose bytes could match but mean different things (size, format).
+    uint64_t hash(uint8_t const* data, int rowBytes, int height, int strideBytes, FrameHashMode mode, uint64_t seed = 0) const;
+
+    KernelPath path() const { return m_path; }
+
+private:
+    using HashRowFunction = void (*)(uint8_t const* row, int numBytes, uint32_t* lanes);
+
+    KernelPath m_path;
+    HashRowFunction m_hashRow;
+};
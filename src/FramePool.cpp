@@ -0,0 +1,165 @@
+#include "FramePool.h"
+
+#include <algorithm>
+#include <bit>
+#include <new>
+
+FramePool::Buffer::Buffer(Block* const block)
+	: m_block{ block }
+{
+	m_block->references.fetch_add(1, std::memory_order_relaxed);
+}
+
+FramePool::Buffer::Buffer(Buffer const& other)
+	: m_block{ other.m_block }
+{
+	if (m_block)
+	{
+		m_block->references.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+FramePool::Buffer::Buffer(Buffer&& other) noexcept
+	: m_block{ other.m_block }
+{
+	other.m_block = nullptr;
+}
+
+FramePool::Buffer& FramePool::Buffer::operator=(Buffer other) noexcept
+{
+	std::swap(m_block, other.m_block);
+	return *this;
+}
+
+FramePool::Buffer::~Buffer()
+{
+	// The last reference hands the block back. acq_rel, so everything written through other
+	//  references happens before it can be handed out again.
+	if (m_block && m_block->references.fetch_sub(1, std::memory_order_acq_rel) == 1)
+	{
+		m_block->pool->release(m_block);
+	}
+}
+
+FramePool::FramePool(size_t const maxIdleBytes)
+	: m_maxIdleBytes{ maxIdleBytes }
+{
+}
+
+FramePool::~FramePool()
+{
+	trim();
+}
+
+FramePool& FramePool::shared()
+{
+	static FramePool* const pool = new FramePool;
+	return *pool;
+}
+
+int FramePool::sizeClassOf(size_t const bytes)
+{
+	// Class 4k + q covers up to (4 + q) / 4 * 2^k bytes, for q in 0..3
+	size_t const rounded = std::max<size_t>(bytes, alignment);
+	int const log2 = static_cast<int>(std::bit_width(rounded - 1)) - 1; // 2^log2 < rounded <= 2^(log2 + 1)
+	size_t const base = size_t{ 1 } << log2;
+	int const quarter = static_cast<int>((rounded - base + base / 4 - 1) / (base / 4)); // 1..4
+	return 4 * log2 + quarter - 1;
+}
+
+size_t FramePool::capacityOf(int const sizeClass)
+{
+	int const log2 = sizeClass / 4;
+	int const quarter = sizeClass % 4 + 1;
+	return (size_t{ 1 } << log2) + quarter * ((size_t{ 1 } << log2) / 4);
+}
+
+size_t FramePool::roundUp(size_t const bytes)
+{
+	return capacityOf(sizeClassOf(bytes));
+}
+
+FramePool::Buffer FramePool::acquire(size_t const bytes)
+{
+	int const sizeClass = sizeClassOf(bytes);
+	{
+		std::lock_guard lock(m_mutex);
+		if (auto& idle = m_idle[sizeClass]; !idle.empty())
+		{
+			Block* const block = idle.back();
+			idle.pop_back();
+			m_counters.idleBytes -= block->capacity;
+			++m_counters.hits;
+			return Buffer(block);
+		}
+		++m_counters.misses;
+	}
+
+	// Allocate outside the lock; a frame's worth of memory can take a while to come back
+	size_t const capacity = capacityOf(sizeClass);
+	auto* const block = new Block{ this, static_cast<uint8_t*>(::operator new(capacity, std::align_val_t{ alignment })), capacity, sizeClass };
+	{
+		std::lock_guard lock(m_mutex);
+		m_counters.residentBytes += capacity;
+		m_counters.peakResidentBytes = std::max(m_counters.peakResidentBytes, m_counters.residentBytes);
+		// Room for every block of the class to be idle at once, so returning one never allocates
+		m_idle[sizeClass].reserve(++m_blocks[sizeClass]);
+	}
+	return Buffer(block);
+}
+
+QImage FramePool::image(QSize const size, QImage::Format const format)
+{
+	if (size.isEmpty())
+	{
+		return {};
+	}
+	int const bitsPerPixel = QImage::toPixelFormat(format).bitsPerPixel();
+	qsizetype const rowBytes = (static_cast<qsizetype>(size.width()) * bitsPerPixel + 7) / 8;
+	qsizetype const stride = (rowBytes + alignment - 1) / alignment * alignment;
+
+	// The image holds one reference, in a Buffer of its own that its cleanup function deletes
+	auto* const held = new Buffer(acquire(static_cast<size_t>(stride) * size.height()));
+	return QImage(held->data(), size.width(), size.height(), stride, format,
+		          [](void* info) { delete static_cast<Buffer*>(info); }, held);
+}
+
+void FramePool::release(Block* const block)
+{
+	std::lock_guard lock(m_mutex);
+	if (m_counters.idleBytes + block->capacity > m_maxIdleBytes)
+	{
+		destroy(block);
+		return;
+	}
+	m_idle[block->sizeClass].push_back(block);
+	m_counters.idleBytes += block->capacity;
+}
+
+void FramePool::destroy(Block* const block)
+{
+	m_counters.residentBytes -= block->capacity;
+	--m_blocks[block->sizeClass];
+	::operator delete(block->data, std::align_val_t{ alignment });
+	delete block;
+}
+
+FramePool::Counters FramePool::counters() const
+{
+	std::lock_guard lock(m_mutex);
+	return m_counters;
+}
+
+void FramePool::trim()
+{
+	std::lock_guard lock(m_mutex);
+	for (auto& idle : m_idle)
+	{
+		for (Block* const block : idle)
+		{
+			destroy(block);
+		}
+		idle.clear();
+	}
+	m_counters.idleBytes = 0;
+}
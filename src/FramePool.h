@@ -0,0 +1,103 @@
+#pragma once
+
+#include <QImage>
+#include <QSize>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// Recycles the pixel memory of video frames. Every stage that needs a frame buffer (the display back
+//  buffers, a captured still, a multiview tile) draws one from here, and it comes back when the last
+//  reference to it goes, rather than being freed. Requests are rounded up to a size class (quarter powers
+//  of two, so at most a quarter is wasted), so a window being resized, or a receiver switching between
+//  its proxy and full streams, keeps reusing the same few buffers instead of churning the heap.
+//
+// Storage is aligned for SIMD, and images have their rows padded to that alignment too. Idle buffers are
+//  kept up to a limit; beyond that, returned buffers are freed.
+class FramePool
+{
+public:
+    static constexpr size_t alignment = 64;
+
+    struct Counters
+    {
+        uint64_t hits{ 0 };          // Requests served from an idle buffer
+        uint64_t misses{ 0 };        // Requests that had to allocate
+        size_t residentBytes{ 0 };   // In use and idle
+        size_t peakResidentBytes{ 0 };
+        size_t idleBytes{ 0 };
+    };
+
+private:
+    struct Block
+    {
+        FramePool* pool;
+        uint8_t* data;
+        size_t capacity;
+        int sizeClass;
+        std::atomic<int> references{ 0 };
+    };
+
+public:
+    // A counted reference to a pooled buffer, like a shared_ptr. Copying it doesn't allocate.
+    class Buffer
+    {
+    public:
+        Buffer() = default;
+        Buffer(Buffer const& other);
+        Buffer(Buffer&& other) noexcept;
+        Buffer& operator=(Buffer other) noexcept;
+        ~Buffer();
+
+        uint8_t* data() const { return m_block ? m_block->data : nullptr; }
+        size_t capacity() const { return m_block ? m_block->capacity : 0; }
+        explicit operator bool() const { return m_block != nullptr; }
+
+    private:
+        friend class FramePool;
+        explicit Buffer(Block* block);
+
+        Block* m_block{ nullptr };
+    };
+
+    explicit FramePool(size_t maxIdleBytes = 256 * 1024 * 1024);
+    // Every buffer must have been returned by now.
+    ~FramePool();
+
+    FramePool(FramePool const&) = delete;
+    FramePool& operator=(FramePool const&) = delete;
+
+    // The one the video path uses. Never destroyed, so it outlives every image, whatever order the
+    //  application is torn down in.
+    static FramePool& shared();
+
+    // Any thread.
+    Buffer acquire(size_t bytes);
+    // An image whose pixels are a pooled buffer, returned to the pool when the image (and every copy
+    //  of it) is gone. Rows are padded to the alignment.
+    QImage image(QSize size, QImage::Format format = QImage::Format_RGB32);
+
+    Counters counters() const;
+    // Frees every idle buffer.
+    void trim();
+
+    // The capacity a request for this many bytes gets
+    static size_t roundUp(size_t bytes);
+
+private:
+    static constexpr int numSizeClasses = 4 * 40; // Four per power of two, up to a terabyte
+
+    static int sizeClassOf(size_t bytes);
+    static size_t capacityOf(int sizeClass);
+    void release(Block* block);
+    void destroy(Block* block); // Caller holds the lock
+
+    size_t const m_maxIdleBytes;
+    mutable std::mutex m_mutex;
+    std::array<std::vector<Block*>, numSizeClasses> m_idle;
+    std::array<size_t, numSizeClasses> m_blocks{};  // Blocks of each class in existence, idle or not
+    Counters m_counters;
+};
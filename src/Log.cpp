@@ -0,0 +1,101 @@
+#include "Log.h"
+
+#include <QDateTime>
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "SpscRingBuffer.h"
+
+namespace
+{
+	constexpr size_t recordsPerThread = 512;
+
+	struct ThreadLog
+	{
+		SpscRingBuffer<Log::Record> records{ recordsPerThread };
+		std::atomic<uint64_t> dropped{ 0 };
+		std::atomic<bool> threadFinished{ false };
+	};
+
+	// Rings are only registered and retired under the lock - once per thread, not per message.
+	std::mutex registryMutex;
+	std::vector<std::shared_ptr<ThreadLog>> registry;
+
+	// Marks the thread's ring finished when the thread exits; the drainer removes it once it is empty.
+	struct ThreadLogHandle
+	{
+		std::shared_ptr<ThreadLog> log{ std::make_shared<ThreadLog>() };
+
+		ThreadLogHandle()
+		{
+			std::lock_guard lock(registryMutex);
+			registry.push_back(log);
+		}
+		~ThreadLogHandle()
+		{
+			log->threadFinished.store(true, std::memory_order_release);
+		}
+	};
+
+	ThreadLog& threadLog()
+	{
+		thread_local ThreadLogHandle handle;
+		return *handle.log;
+	}
+}
+
+void Log::write(LogLevel level, QString const& message)
+{
+	ThreadLog& log{ threadLog() };
+	auto const region = log.records.prepareWrite(1);
+	if (region.size() == 0)
+	{
+		log.dropped.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	Record& record{ *region.first };
+	record.msSinceEpoch = QDateTime::currentMSecsSinceEpoch();
+	record.level = level;
+	record.length = static_cast<uint16_t>(std::min<qsizetype>(message.size(), Record::maxChars));
+	std::copy_n(reinterpret_cast<char16_t const*>(message.utf16()), record.length, record.text);
+	log.records.commitWrite(1);
+}
+
+size_t Log::drain(Record* out, size_t maxRecords)
+{
+	std::lock_guard lock(registryMutex);
+	size_t drained = 0;
+	for (auto& log : registry)
+	{
+		drained += log->records.read(out + drained, maxRecords - drained);
+	}
+
+	registry.erase(std::remove_if(registry.begin(), registry.end(), [](auto const& log) {
+		return log->threadFinished.load(std::memory_order_acquire) && log->records.available() == 0;
+	}), registry.end());
+	return drained;
+}
+
+uint64_t Log::takeDroppedCount()
+{
+	std::lock_guard lock(registryMutex);
+	uint64_t dropped = 0;
+	for (auto& log : registry)
+	{
+		dropped += log->dropped.exchange(0, std::memory_order_relaxed);
+	}
+	return dropped;
+}
+
+QString Log::levelName(LogLevel level)
+{
+	switch (level)
+	{
+	case LogLevel::Debug: return "DEBUG";
+	case LogLevel::Info: return "INFO";
+	default: return "WARNING";
+	}
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <QString>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+enum class LogLevel : uint8_t
+{
+    Debug,
+    Info,
+    Warning
+};
+
+// Levels below this are compiled out entirely: the message expression is never evaluated. Define it
+//  to 1 (Info) for builds that should carry no debug logging cost at all.
+#ifndef NDIRECV_LOG_MIN_LEVEL
+#define NDIRECV_LOG_MIN_LEVEL 0
+#endif
+
+// Logging that is cheap enough for the capture loop. The level check happens in the macro, before the
+//  message is built, so a disabled QString(...).arg(...) costs a relaxed atomic load and nothing else.
+//  An enabled message is copied into a fixed-size record in a lock-free ring owned by the calling thread;
+//  no locks, no signals, no allocation. Whoever displays the log drains all threads' rings in batches.
+namespace Log
+{
+    struct Record
+    {
+        static constexpr size_t maxChars = 250; // Longer messages are truncated; keeps a record at 512 bytes
+
+        int64_t msSinceEpoch;
+        LogLevel level;
+        uint16_t length;
+        char16_t text[maxChars];
+
+        QString message() const { return QString::fromUtf16(text, length); }
+    };
+
+    inline std::atomic<LogLevel> runtimeLevel{ LogLevel::Info };
+
+    inline bool enabled(LogLevel level)
+    {
+        return static_cast<int>(level) >= NDIRECV_LOG_MIN_LEVEL && level >= runtimeLevel.load(std::memory_order_relaxed);
+    }
+
+    inline void setLevel(LogLevel level) { runtimeLevel.store(level, std::memory_order_relaxed); }
+
+    // Use the macros below rather than calling this directly, so disabled messages aren't formatted.
+    void write(LogLevel level, QString const& message);
+
+    // Copies up to maxRecords waiting records, from all threads, into out; returns how many. Only one
+    //  thread may drain. Records are in order per thread, not across threads.
+    size_t drain(Record* out, size_t maxRecords);
+
+    // Records lost because a thread logged faster than they were drained, since the last call.
+    uint64_t takeDroppedCount();
+
+    QString levelName(LogLevel level);
+}
+
+#define NDIRECV_LOG(level, message) \
+    do { if (Log::enabled(level)) { Log::write(level, message); } } while (false)
+
+#define LOG_DEBUG(message) NDIRECV_LOG(LogLevel::Debug, message)
+#define LOG_INFO(message) NDIRECV_LOG(LogLevel::Info, message)
+#define LOG_WARNING(message) NDIRECV_LOG(LogLevel::Warning, message)
@@ -0,0 +1,66 @@
+#include "LogView.h"
+
+#include <QDateTime>
+#include <QScrollBar>
+#include <QTextCursor>
+#include <QTextDocument>
+#include <QTextEdit>
+
+namespace
+{
+	constexpr int flushIntervalMs = 100;
+	constexpr size_t maxRecordsPerFlush = 1000; // Any more wait for the next flush
+}
+
+LogView::LogView(QTextEdit* target, int maxLines, QObject* parent)
+	: QObject(parent)
+	, m_target{ target }
+	, m_batch(maxRecordsPerFlush)
+{
+	m_target->document()->setMaximumBlockCount(maxLines);
+	connect(&m_timer, &QTimer::timeout, this, &LogView::flush);
+	m_timer.start(flushIntervalMs);
+}
+
+void LogView::flush()
+{
+	size_t const count = Log::drain(m_batch.data(), m_batch.size());
+	uint64_t const dropped = Log::takeDroppedCount();
+	if (count == 0 && dropped == 0)
+	{
+		return;
+	}
+
+	QString text;
+	text.reserve(static_cast<qsizetype>(count) * 100);
+	for (size_t i = 0; i < count; ++i)
+	{
+		Log::Record const& record{ m_batch[i] };
+		if (!m_target->document()->isEmpty() || !text.isEmpty())
+		{
+			text += '\n';
+		}
+		text += QDateTime::fromMSecsSinceEpoch(record.msSinceEpoch).toString(Qt::ISODateWithMs);
+		text += " - ";
+		if (record.level != LogLevel::Info)
+		{
+			text += Log::levelName(record.level) + ": ";
+		}
+		text += record.message();
+	}
+	if (dropped > 0)
+	{
+		text += QString("\n%1 log lines dropped; logging faster than they can be displayed").arg(dropped);
+	}
+
+	// One insertion for the whole batch, as plain text. Only follow the end if the user hasn't scrolled up.
+	QScrollBar* scrollBar{ m_target->verticalScrollBar() };
+	bool const atBottom = scrollBar->value() == scrollBar->maximum();
+	QTextCursor cursor{ m_target->document() };
+	cursor.movePosition(QTextCursor::End);
+	cursor.insertText(text);
+	if (atBottom)
+	{
+		scrollBar->setValue(scrollBar->maximum());
+	}
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <QObject>
+#include <QTimer>
+#include <vector>
+
+#include "Log.h"
+
+class QTextEdit;
+
+// Moves log records from the per-thread rings into a text widget. Runs on the GUI thread on a timer, so
+//  however fast threads log the widget is appended to at most a few times a second, one batch at a time,
+//  and the document is capped so it doesn't grow (and re-layout) without bound over a long session.
+class LogView : public QObject
+{
+    Q_OBJECT
+
+public:
+    LogView(QTextEdit* target, int maxLines, QObject* parent = nullptr);
+
+    void flush();
+
+private:
+    QTextEdit* m_target;
+    QTimer m_timer;
+    std::vector<Log::Record> m_batch; // Reused every flush
+};
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <QImage>
+#include <QSize>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+// Where the engine puts converted video. VideoPlaybackWidget is one; the benchmark has a headless one.
+//  All of these are called on the capture thread.
+class VideoTarget
+{
+public:
+    virtual ~VideoTarget() = default;
+
+    virtual QSize targetSize() const = 0;  // Frames are scaled to fit within this
+    virtual QImage& backBuffer() = 0;      // Render here...
+    // ...then hand it over. sentAt is when the source sent the frame, or the epoch if it didn't say.
+    virtual void publishFrame(std::chrono::system_clock::time_point sentAt) = 0;
+};
+
+// Where the engine sends audio. AudioOutput plays it; the benchmark just accounts for it.
+//  All of these are called on the capture thread.
+class AudioTarget
+{
+public:
+    virtual ~AudioTarget() = default;
+
+    // Called once the source's audio format is known. Returns the sample rate audio should be delivered
+    //  at, or 0 if it can't be played at all.
+    virtual int start(int sourceSampleRate, int sourceChannels, std::chrono::microseconds captureInterval) = 0;
+    virtual void stop() = 0;
+
+    // Planar float samples, as in an NDI audio frame, at the rate start() returned. sentAt is the block's
+    //  NDI timestamp: when the source sent it, which is as its last sample was captured. The epoch if unknown.
+    virtual void write(float const* planar, int channelStrideInBytes, size_t frames, std::chrono::system_clock::time_point sentAt) = 0;
+
+    // Any thread. Where playback has got to, as the sent time (see write()) of the sample being heard right
+    //  now; nothing if that isn't known. Video is presented against this, so audio is the master clock.
+    virtual std::optional<std::chrono::system_clock::time_point> presentationClock() const { return std::nullopt; }
+
+    // Whether audio is wanted right now. While it isn't, the engine stops the target and captures no
+    //  audio at all, so that a muted source costs nothing.
+    virtual bool active() const { return true; }
+
+    virtual uint64_t underruns() const { return 0; }
+    virtual uint64_t droppedBytes() const { return 0; }
+};
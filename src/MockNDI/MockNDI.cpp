@@ -0,0 +1,745 @@
+#include "MockNDI.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+	// How far behind an unread video or audio queue is allowed to fall before its oldest frames are dropped
+	constexpr int64_t videoQueueFrames = 4;
+	constexpr int64_t audioQueueChunks = 8;
+
+	std::mutex configMutex;
+	std::optional<MockNDI::Config> currentConfig;
+
+	struct Rgb
+	{
+		uint8_t r, g, b;
+	};
+
+	// 75% colour bars, left to right
+	constexpr std::array<Rgb, 8> bars{ { { 191, 191, 191 }, { 191, 191, 0 }, { 0, 191, 191 }, { 0, 191, 0 },
+	                                     { 191, 0, 191 }, { 191, 0, 0 }, { 0, 0, 191 }, { 0, 0, 0 } } };
+	constexpr Rgb white{ 255, 255, 255 };
+	constexpr Rgb black{ 0, 0, 0 };
+	constexpr int frameNumberBits = 32;
+
+	int bytesPerPixel(NDIlib_FourCC_video_type_e const fourCC)
+	{
+		return fourCC == NDIlib_FourCC_video_type_UYVY ? 2 : 4;
+	}
+
+	int frameNumberBandHeight(int const height)
+	{
+		return std::max(2, height / 16);
+	}
+
+	// Fills pixels [x0, x1) of one row. For UYVY both ends must be even.
+	void fillSpan(uint8_t* row, NDIlib_FourCC_video_type_e const fourCC, int const x0, int const x1, Rgb const colour)
+	{
+		switch (fourCC)
+		{
+		case NDIlib_FourCC_video_type_UYVY:
+		{
+			// BT.709, studio range, as NDI sources send it
+			double const luma = 0.2126 * colour.r + 0.7152 * colour.g + 0.0722 * colour.b;
+			auto const y = static_cast<uint8_t>(std::lround(16.0 + luma * 219.0 / 255.0));
+			auto const cb = static_cast<uint8_t>(std::lround(128.0 + (colour.b - luma) / 1.8556 * 224.0 / 255.0));
+			auto const cr = static_cast<uint8_t>(std::lround(128.0 + (colour.r - luma) / 1.5748 * 224.0 / 255.0));
+			for (int x = x0; x < x1; x += 2)
+			{
+				uint8_t* const pair = row + x * 2;
+				pair[0] = cb;
+				pair[1] = y;
+				pair[2] = cr;
+				pair[3] = y;
+			}
+			break;
+		}
+		case NDIlib_FourCC_video_type_BGRA:
+		case NDIlib_FourCC_video_type_BGRX:
+			for (int x = x0; x < x1; ++x)
+			{
+				uint8_t* const pixel = row + x * 4;
+				pixel[0] = colour.b;
+				pixel[1] = colour.g;
+				pixel[2] = colour.r;
+				pixel[3] = 255;
+			}
+			break;
+		default: // RGBA, RGBX
+			for (int x = x0; x < x1; ++x)
+			{
+				uint8_t* const pixel = row + x * 4;
+				pixel[0] = colour.r;
+				pixel[1] = colour.g;
+				pixel[2] = colour.b;
+				pixel[3] = 255;
+			}
+			break;
+		}
+	}
+
+	// Renders the synthetic picture. The bars are drawn once; each frame copies them and draws the moving
+	//  box and frame number on top, so the mock costs little next to the pipeline it is feeding.
+	class SyntheticVideo
+	{
+	public:
+		SyntheticVideo(int const width, int const height, NDIlib_FourCC_video_type_e const fourCC)
+			: m_width{ width }
+			, m_height{ height }
+			, m_fourCC{ fourCC }
+			, m_stride{ width * bytesPerPixel(fourCC) }
+			, m_bars(static_cast<size_t>(m_stride) * height)
+		{
+			for (int y = 0; y < height; ++y)
+			{
+				uint8_t* const row = m_bars.data() + static_cast<size_t>(y) * m_stride;
+				for (size_t bar = 0; bar < bars.size(); ++bar)
+				{
+					fillSpan(row, fourCC, evenBelow(width * bar / bars.size()), evenBelow(width * (bar + 1) / bars.size()), bars[bar]);
+				}
+			}
+		}
+
+		int width() const { return m_width; }
+		int height() const { return m_height; }
+		int stride() const { return m_stride; }
+		NDIlib_FourCC_video_type_e fourCC() const { return m_fourCC; }
+		size_t frameBytes() const { return m_bars.size(); }
+
+		// Interlaced, the box on the odd lines is where it has got to half a frame later
+		void render(int64_t const frameIndex, uint8_t* out, bool const interlaced = false) const
+		{
+			std::memcpy(out, m_bars.data(), m_bars.size());
+
+			int const boxWidth = std::max(2, evenBelow(m_width / 60));
+			if (m_width > boxWidth)
+			{
+				int const boxX = evenBelow(static_cast<int>((frameIndex * 16) % (m_width - boxWidth)));
+				int const laterX = evenBelow(static_cast<int>((frameIndex * 16 + 8) % (m_width - boxWidth)));
+				for (int y = m_height / 3; y < m_height * 2 / 3; ++y)
+				{
+					int const x = interlaced && (y & 1) ? laterX : boxX;
+					fillSpan(out + static_cast<size_t>(y) * m_stride, m_fourCC, x, x + boxWidth, white);
+				}
+			}
+
+			int const blockWidth = evenBelow(m_width / frameNumberBits);
+			if (blockWidth > 0)
+			{
+				for (int y = m_height - frameNumberBandHeight(m_height); y < m_height; ++y)
+				{
+					uint8_t* const row = out + static_cast<size_t>(y) * m_stride;
+					for (int bit = 0; bit < frameNumberBits; ++bit)
+					{
+						bool const set = (static_cast<uint64_t>(frameIndex) >> (frameNumberBits - 1 - bit)) & 1;
+						fillSpan(row, m_fourCC, bit * blockWidth, (bit + 1) * blockWidth, set ? white : black);
+					}
+				}
+			}
+		}
+
+	private:
+		static int evenBelow(size_t const value) { return static_cast<int>(value & ~size_t{ 1 }); }
+
+		int m_width;
+		int m_height;
+		NDIlib_FourCC_video_type_e m_fourCC;
+		int m_stride;
+		std::vector<uint8_t> m_bars;
+	};
+
+	// What the receiver would be sent, given what it asked for. A real receiver converts RGB to the colour
+	//  format requested and gets a small proxy stream at the lowest bandwidth; so does this one.
+	NDIlib_FourCC_video_type_e deliveredFourCC(NDIlib_FourCC_video_type_e const native, NDIlib_recv_color_format_e const requested)
+	{
+		bool const nativeIsYuv = native == NDIlib_FourCC_video_type_UYVY;
+		switch (requested)
+		{
+		case NDIlib_recv_color_format_BGRX_BGRA:
+			return NDIlib_FourCC_video_type_BGRA;
+		case NDIlib_recv_color_format_RGBX_RGBA:
+			return NDIlib_FourCC_video_type_RGBA;
+		case NDIlib_recv_color_format_UYVY_BGRA:
+			return nativeIsYuv ? native : NDIlib_FourCC_video_type_BGRA;
+		case NDIlib_recv_color_format_UYVY_RGBA:
+			return nativeIsYuv ? native : NDIlib_FourCC_video_type_RGBA;
+		default:
+			return native;
+		}
+	}
+
+	int64_t toHundredsOfNanoseconds(double const seconds)
+	{
+		return static_cast<int64_t>(std::llround(seconds * 10000000.0));
+	}
+
+	struct Finder
+	{
+		std::vector<std::string> names;
+		std::vector<std::string> urls;
+		std::vector<NDIlib_source_t> sources;
+		bool reported{ false };
+	};
+
+	struct Receiver
+	{
+		MockNDI::Config config;
+		Clock::time_point start{ Clock::now() };
+		bool video{ false };
+		bool audio{ false };
+		SyntheticVideo picture;
+		bool fields{ false };  // Interlaced, and allowed to send it that way
+		int audioChunk{ 1 };
+		int64_t nextVideoFrame{ 0 };
+		int64_t nextAudioChunk{ 0 };
+		std::chrono::system_clock::time_point startWall{};  // The moment start was taken, on the wall clock
+
+		// Seconds elapsed on the source's clock, which runs fast or slow by the configured drift
+		double sourceSeconds(Clock::time_point const now) const
+		{
+			return std::chrono::duration<double>(now - start).count() * (1.0 + config.clockDriftPpm * 1e-6);
+		}
+
+		Clock::time_point localTime(double const sourceSeconds) const
+		{
+			return start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(sourceSeconds / (1.0 + config.clockDriftPpm * 1e-6)));
+		}
+
+		double framePeriod() const { return static_cast<double>(config.frameRateD) / config.frameRateN; }
+
+		// What a real sender stamps on a frame: its UTC clock, in 100 ns units since 1970, as it sends. The
+		//  source sends each frame as soon as it is complete and the network is instant, so this is when
+		//  it becomes due here.
+		int64_t timestampAt(double const sourceSeconds) const
+		{
+			auto const sent = startWall + std::chrono::duration_cast<std::chrono::system_clock::duration>(localTime(sourceSeconds) - start);
+			return std::chrono::duration_cast<std::chrono::duration<int64_t, std::ratio<1, 10000000>>>(sent.time_since_epoch()).count();
+		}
+
+		// The timecode counts from the start of the source's timeline; the timestamp is when it was sent.
+		//  Woven frames carry both of an interlaced frame's fields, as sent.
+		NDIlib_video_frame_v2_t videoHeader(int64_t const frameIndex, uint8_t* data, bool const woven = false) const
+		{
+			double const seconds = frameIndex * framePeriod();
+			return NDIlib_video_frame_v2_t(picture.width(), picture.height(), picture.fourCC(), config.frameRateN, config.frameRateD,
+			                               static_cast<float>(picture.width()) / picture.height(),
+			                               woven ? NDIlib_frame_format_type_interleaved : NDIlib_frame_format_type_progressive,
+			                               toHundredsOfNanoseconds(seconds), data, picture.stride(), nullptr, timestampAt(seconds + framePeriod()));
+		}
+
+		void fillVideo(NDIlib_video_frame_v2_t& frame, int64_t const frameIndex, uint8_t* data, bool const woven = false) const
+		{
+			frame = videoHeader(frameIndex, data, woven);
+			picture.render(frameIndex, data, woven);
+		}
+
+		// Both layouts of the same chunk; v2 callers take the second, v3 callers the first
+		std::pair<NDIlib_audio_frame_v3_t, NDIlib_audio_frame_v2_t> audioHeader(int64_t const chunk, uint8_t* data) const
+		{
+			int const samples = audioChunk;
+			double const seconds = chunk * double(samples) / config.sampleRate;
+			int64_t const timestamp = timestampAt((chunk + 1) * double(samples) / config.sampleRate);
+			int const stride = samples * static_cast<int>(sizeof(float));
+			return { NDIlib_audio_frame_v3_t(config.sampleRate, config.channels, samples, toHundredsOfNanoseconds(seconds), NDIlib_FourCC_audio_type_FLTP,
+			                                 data, stride, nullptr, timestamp),
+			         NDIlib_audio_frame_v2_t(config.sampleRate, config.channels, samples, toHundredsOfNanoseconds(seconds), reinterpret_cast<float*>(data),
+			                                 stride, nullptr, timestamp) };
+		}
+
+		// Waits for the next frame of whichever kind asked for is due first, and returns its index. Like the
+		//  real receiver, video and audio are queued separately, so each can be captured on a thread of its
+		//  own (one thread per kind; the two touch nothing in common). The queues are short: a kind left
+		//  unread for a while skips ahead to its most recent few frames.
+		NDIlib_frame_type_e captureNext(bool const wantVideo, bool const wantAudio, uint32_t const timeoutMs, int64_t& index)
+		{
+			Clock::time_point const deadline = Clock::now() + std::chrono::milliseconds(timeoutMs);
+			double const audioPeriod = double(audioChunk) / config.sampleRate;
+			bool const videoAsked = wantVideo && video;
+			bool const audioAsked = wantAudio && audio;
+			if (videoAsked)
+			{
+				nextVideoFrame = std::max(nextVideoFrame, static_cast<int64_t>(sourceSeconds(Clock::now()) / framePeriod()) - videoQueueFrames);
+			}
+			if (audioAsked)
+			{
+				nextAudioChunk = std::max(nextAudioChunk, static_cast<int64_t>(sourceSeconds(Clock::now()) / audioPeriod) - audioQueueChunks);
+			}
+			if (!videoAsked && !audioAsked)
+			{
+				std::this_thread::sleep_until(deadline);
+				return NDIlib_frame_type_none;
+			}
+
+			// Frames are sent when the source's clock says they are complete
+			double const videoDue = videoAsked ? (nextVideoFrame + 1) * framePeriod() : HUGE_VAL;
+			double const audioDue = audioAsked ? (nextAudioChunk + 1) * audioPeriod : HUGE_VAL;
+			bool const videoNext = videoDue <= audioDue;
+			Clock::time_point const due = localTime(videoNext ? videoDue : audioDue);
+			if (due > deadline)
+			{
+				std::this_thread::sleep_until(deadline);
+				return NDIlib_frame_type_none;
+			}
+			std::this_thread::sleep_until(due);
+			index = videoNext ? nextVideoFrame++ : nextAudioChunk++;
+			return videoNext ? NDIlib_frame_type_video : NDIlib_frame_type_audio;
+		}
+
+		void fillAudio(float* out, int const channelStride, int64_t const firstSample, int const samples, double const sampleRate, int const channels) const
+		{
+			for (int channel = 0; channel < channels; ++channel)
+			{
+				float* const plane = out + static_cast<size_t>(channel) * channelStride;
+				for (int sample = 0; sample < samples; ++sample)
+				{
+					plane[sample] = audio ? MockNDI::audioSample(config, channel, firstSample + sample, sampleRate) : 0.0f;
+				}
+			}
+		}
+	};
+
+	Receiver* createReceiver(NDIlib_recv_create_v3_t const& settings)
+	{
+		MockNDI::Config const config{ MockNDI::config() };
+		int width = config.width;
+		int height = config.height;
+		if (settings.bandwidth == NDIlib_recv_bandwidth_lowest && width > 640)
+		{
+			height = std::max(2, (height * 640 / width) & ~1);
+			width = 640;
+		}
+		auto* receiver = new Receiver{ config, Clock::now(), false, false,
+		                               SyntheticVideo(width, height, deliveredFourCC(config.fourCC, settings.color_format)) };
+		receiver->video = config.videoEnabled && settings.bandwidth != NDIlib_recv_bandwidth_audio_only && settings.bandwidth != NDIlib_recv_bandwidth_metadata_only;
+		receiver->audio = config.audioEnabled && settings.bandwidth != NDIlib_recv_bandwidth_metadata_only;
+		receiver->fields = config.interlaced && settings.allow_video_fields;
+		receiver->audioChunk = std::max(1, config.sampleRate / 50);
+		// Drawing the bars took a while; the wall clock reading has to be of the same moment as start
+		receiver->startWall = std::chrono::system_clock::now() - std::chrono::duration_cast<std::chrono::system_clock::duration>(Clock::now() - receiver->start);
+		return receiver;
+	}
+
+	struct FrameSync
+	{
+		Receiver* receiver;
+		std::vector<uint8_t> video{};
+		int64_t renderedFrame{ -1 };
+		bool renderedWoven{ false };
+		std::vector<float> audio{};
+		int64_t audioPosition{ 0 };   // Samples handed out so far, at audioRate
+		int audioRate{ 0 };
+	};
+
+	uint64_t splitMix64(uint64_t x)
+	{
+		x += 0x9E3779B97F4A7C15ull;
+		x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+		x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+		return x ^ (x >> 31);
+	}
+
+	std::vector<std::string> split(std::string const& text, char const separator)
+	{
+		std::vector<std::string> parts;
+		size_t begin = 0;
+		for (size_t end; (end = text.find(separator, begin)) != std::string::npos; begin = end + 1)
+		{
+			parts.push_back(text.substr(begin, end - begin));
+		}
+		parts.push_back(text.substr(begin));
+		return parts;
+	}
+
+	std::optional<NDIlib_FourCC_video_type_e> fourCCNamed(std::string const& name)
+	{
+		for (auto const fourCC : { NDIlib_FourCC_video_type_UYVY, NDIlib_FourCC_video_type_BGRA, NDIlib_FourCC_video_type_BGRX,
+		                           NDIlib_FourCC_video_type_RGBA, NDIlib_FourCC_video_type_RGBX })
+		{
+			char const code[5] = { char(fourCC & 0xFF), char((fourCC >> 8) & 0xFF), char((fourCC >> 16) & 0xFF), char(fourCC >> 24), 0 };
+			if (name == code)
+			{
+				return fourCC;
+			}
+		}
+		return std::nullopt;
+	}
+
+	void applyVideoSetting(MockNDI::Config& config, std::string const& value)
+	{
+		if (value == "off")
+		{
+			config.videoEnabled = false;
+			return;
+		}
+		auto const parts = split(value, ':');
+		int width = 0, height = 0, rateN = 0, rateD = 1;
+		int const fields = std::sscanf(parts[0].c_str(), "%dx%d@%d/%d", &width, &height, &rateN, &rateD);
+		if (fields < 2 || width < 2 || height < 2 || (fields >= 3 && rateN <= 0) || rateD <= 0)
+		{
+			return;
+		}
+		config.width = width & ~1;
+		config.height = height;
+		config.interlaced = fields >= 3 && parts[0].back() == 'i';
+		if (fields >= 3)
+		{
+			config.frameRateN = rateN;
+			config.frameRateD = fields == 4 ? rateD : 1;
+		}
+		if (parts.size() > 1)
+		{
+			if (auto const fourCC = fourCCNamed(parts[1]))
+			{
+				config.fourCC = *fourCC;
+			}
+		}
+	}
+
+	void applyAudioSetting(MockNDI::Config& config, std::string const& value)
+	{
+		if (value == "off")
+		{
+			config.audioEnabled = false;
+			return;
+		}
+		auto const parts = split(value, ':');
+		int const rate = std::atoi(parts[0].c_str());
+		if (rate <= 0)
+		{
+			return;
+		}
+		config.sampleRate = rate;
+		if (parts.size() > 1 && std::atoi(parts[1].c_str()) > 0)
+		{
+			config.channels = std::atoi(parts[1].c_str());
+		}
+		if (parts.size() > 2)
+		{
+			config.signal = parts[2] == "noise" ? MockNDI::AudioSignal::Noise : MockNDI::AudioSignal::Tone;
+		}
+		if (parts.size() > 3 && std::atof(parts[3].c_str()) > 0.0)
+		{
+			config.toneHz = std::atof(parts[3].c_str());
+		}
+	}
+}
+
+MockNDI::Config MockNDI::configFromEnvironment()
+{
+	Config config;
+	if (char const* sources = std::getenv("NDIRECV_MOCK_SOURCES"); sources && std::atoi(sources) >= 0)
+	{
+		config.sourceCount = std::atoi(sources);
+	}
+	if (char const* video = std::getenv("NDIRECV_MOCK_VIDEO"))
+	{
+		applyVideoSetting(config, video);
+	}
+	if (char const* audio = std::getenv("NDIRECV_MOCK_AUDIO"))
+	{
+		applyAudioSetting(config, audio);
+	}
+	if (char const* drift = std::getenv("NDIRECV_MOCK_DRIFT_PPM"))
+	{
+		config.clockDriftPpm = std::atof(drift);
+	}
+	if (char const* seed = std::getenv("NDIRECV_MOCK_SEED"))
+	{
+		config.seed = static_cast<uint32_t>(std::strtoul(seed, nullptr, 10));
+	}
+	return config;
+}
+
+void MockNDI::setConfig(Config const& config)
+{
+	std::lock_guard lock(configMutex);
+	currentConfig = config;
+}
+
+MockNDI::Config MockNDI::config()
+{
+	std::lock_guard lock(configMutex);
+	if (!currentConfig)
+	{
+		currentConfig = configFromEnvironment();
+	}
+	return *currentConfig;
+}
+
+float MockNDI::audioSample(Config const& config, int const channel, int64_t const sampleIndex, double const sampleRate)
+{
+	if (config.signal == AudioSignal::Noise)
+	{
+		uint64_t const bits = splitMix64((uint64_t{ config.seed } << 40) ^ (uint64_t(channel) << 56) ^ static_cast<uint64_t>(sampleIndex));
+		return static_cast<float>((bits >> 40) / double(1 << 24) - 0.5) * 0.5f;
+	}
+	double const cycles = std::fmod(config.toneHz * (channel + 1) * static_cast<double>(sampleIndex) / sampleRate, 1.0);
+	return static_cast<float>(0.25 * std::sin(2.0 * 3.14159265358979323846 * cycles));
+}
+
+int64_t MockNDI::readFrameNumber(NDIlib_video_frame_v2_t const& frame)
+{
+	int const blockWidth = (frame.xres / frameNumberBits) & ~1;
+	if (!frame.p_data || blockWidth <= 0 || frame.yres < 2)
+	{
+		return -1;
+	}
+	uint8_t const* const row = frame.p_data + static_cast<size_t>(frame.yres - 1 - frameNumberBandHeight(frame.yres) / 2) * frame.line_stride_in_bytes;
+	int64_t number = 0;
+	for (int bit = 0; bit < frameNumberBits; ++bit)
+	{
+		int const x = bit * blockWidth + blockWidth / 2;
+		// Green, or luma for UYVY; either way bright means a set bit
+		uint8_t const level = frame.FourCC == NDIlib_FourCC_video_type_UYVY ? row[x * 2 + 1] : row[x * 4 + 1];
+		number = (number << 1) | (level > 128 ? 1 : 0);
+	}
+	return number;
+}
+
+bool NDIlib_initialize(void)
+{
+	return true;
+}
+
+void NDIlib_destroy(void)
+{
+}
+
+const char* NDIlib_version(void)
+{
+	return "Mock NDI SDK (synthetic sources)";
+}
+
+NDIlib_find_instance_t NDIlib_find_create_v2(const NDIlib_find_create_t*)
+{
+	auto* finder = new Finder;
+	int const sourceCount = MockNDI::config().sourceCount;
+	for (int i = 0; i < sourceCount; ++i)
+	{
+		finder->names.push_back("MOCK (Synthetic " + std::to_string(i + 1) + ")");
+		finder->urls.push_back("127.0.0.1:" + std::to_string(5961 + i));
+	}
+	// Only take pointers once the strings have stopped moving
+	for (int i = 0; i < sourceCount; ++i)
+	{
+		finder->sources.emplace_back(finder->names[i].c_str(), finder->urls[i].c_str());
+	}
+	return finder;
+}
+
+void NDIlib_find_destroy(NDIlib_find_instance_t p_instance)
+{
+	delete static_cast<Finder*>(p_instance);
+}
+
+const NDIlib_source_t* NDIlib_find_get_current_sources(NDIlib_find_instance_t p_instance, uint32_t* p_no_sources)
+{
+	auto* finder = static_cast<Finder*>(p_instance);
+	finder->reported = true;
+	*p_no_sources = static_cast<uint32_t>(finder->sources.size());
+	return finder->sources.empty() ? nullptr : finder->sources.data();
+}
+
+bool NDIlib_find_wait_for_sources(NDIlib_find_instance_t p_instance, uint32_t timeout_in_ms)
+{
+	// The sources are all there from the start, so the first wait sees a change and later ones time out
+	auto* finder = static_cast<Finder*>(p_instance);
+	if (!finder->reported && !finder->sources.empty())
+	{
+		return true;
+	}
+	std::this_thread::sleep_for(std::chrono::milliseconds(timeout_in_ms));
+	return false;
+}
+
+NDIlib_recv_instance_t NDIlib_recv_create_v3(const NDIlib_recv_create_v3_t* p_create_settings)
+{
+	return createReceiver(p_create_settings ? *p_create_settings : NDIlib_recv_create_v3_t());
+}
+
+void NDIlib_recv_destroy(NDIlib_recv_instance_t p_instance)
+{
+	delete static_cast<Receiver*>(p_instance);
+}
+
+NDIlib_frame_type_e NDIlib_recv_capture_v2(NDIlib_recv_instance_t p_instance, NDIlib_video_frame_v2_t* p_video_data,
+                                           NDIlib_audio_frame_v2_t* p_audio_data, NDIlib_metadata_frame_t*, uint32_t timeout_in_ms)
+{
+	auto* receiver = static_cast<Receiver*>(p_instance);
+	int64_t index = 0;
+	NDIlib_frame_type_e const type = receiver->captureNext(p_video_data != nullptr, p_audio_data != nullptr, timeout_in_ms, index);
+	if (type == NDIlib_frame_type_video)
+	{
+		receiver->fillVideo(*p_video_data, index, new uint8_t[receiver->picture.frameBytes()], receiver->fields);
+	}
+	else if (type == NDIlib_frame_type_audio)
+	{
+		int const samples = receiver->audioChunk;
+		auto* data = new float[static_cast<size_t>(samples) * receiver->config.channels];
+		*p_audio_data = receiver->audioHeader(index, reinterpret_cast<uint8_t*>(data)).second;
+		receiver->fillAudio(data, samples, index * samples, samples, receiver->config.sampleRate, receiver->config.channels);
+	}
+	return type;
+}
+
+NDIlib_frame_type_e NDIlib_recv_capture_v3(NDIlib_recv_instance_t p_instance, NDIlib_video_frame_v2_t* p_video_data,
+                                           NDIlib_audio_frame_v3_t* p_audio_data, NDIlib_metadata_frame_t*, uint32_t timeout_in_ms)
+{
+	auto* receiver = static_cast<Receiver*>(p_instance);
+	int64_t index = 0;
+	NDIlib_frame_type_e const type = receiver->captureNext(p_video_data != nullptr, p_audio_data != nullptr, timeout_in_ms, index);
+	if (type == NDIlib_frame_type_video)
+	{
+		receiver->fillVideo(*p_video_data, index, new uint8_t[receiver->picture.frameBytes()], receiver->fields);
+	}
+	else if (type == NDIlib_frame_type_audio)
+	{
+		int const samples = receiver->audioChunk;
+		auto* data = new float[static_cast<size_t>(samples) * receiver->config.channels];
+		*p_audio_data = receiver->audioHeader(index, reinterpret_cast<uint8_t*>(data)).first;
+		receiver->fillAudio(data, samples, index * samples, samples, receiver->config.sampleRate, receiver->config.channels);
+	}
+	return type;
+}
+
+void NDIlib_recv_free_video_v2(NDIlib_recv_instance_t, const NDIlib_video_frame_v2_t* p_video_data)
+{
+	delete[] p_video_data->p_data;
+}
+
+void NDIlib_recv_free_audio_v2(NDIlib_recv_instance_t, const NDIlib_audio_frame_v2_t* p_audio_data)
+{
+	delete[] p_audio_data->p_data;
+}
+
+void NDIlib_recv_free_audio_v3(NDIlib_recv_instance_t, const NDIlib_audio_frame_v3_t* p_audio_data)
+{
+	delete[] reinterpret_cast<float*>(p_audio_data->p_data);
+}
+
+void NDIlib_recv_free_metadata(NDIlib_recv_instance_t, const NDIlib_metadata_frame_t*)
+{
+	// No metadata is ever sent
+}
+
+NDIlib_framesync_instance_t NDIlib_framesync_create(NDIlib_recv_instance_t p_receiver)
+{
+	if (!p_receiver)
+	{
+		return nullptr;
+	}
+	return new FrameSync{ static_cast<Receiver*>(p_receiver) };
+}
+
+void NDIlib_framesync_destroy(NDIlib_framesync_instance_t p_instance)
+{
+	delete static_cast<FrameSync*>(p_instance);
+}
+
+void NDIlib_framesync_capture_video(NDIlib_framesync_instance_t p_instance, NDIlib_video_frame_v2_t* p_video_data, NDIlib_frame_format_type_e field_type)
+{
+	auto* frameSync = static_cast<FrameSync*>(p_instance);
+	Receiver const& receiver = *frameSync->receiver;
+	// Asked for anything but progressive, an interlaced source comes woven; single fields aren't mocked
+	bool const woven = receiver.fields && field_type != NDIlib_frame_format_type_progressive;
+
+	// The most recent frame to have arrived, handed back again until a newer one does. Nothing until the first.
+	int64_t const frameIndex = static_cast<int64_t>(std::floor(receiver.sourceSeconds(Clock::now()) / receiver.framePeriod())) - 1;
+	if (!receiver.video || frameIndex < 0)
+	{
+		*p_video_data = NDIlib_video_frame_v2_t();
+		return;
+	}
+	if (frameSync->video.size() != receiver.picture.frameBytes())
+	{
+		frameSync->video.resize(receiver.picture.frameBytes());
+		frameSync->renderedFrame = -1;
+	}
+	if (frameIndex != frameSync->renderedFrame || woven != frameSync->renderedWoven)
+	{
+		receiver.fillVideo(*p_video_data, frameIndex, frameSync->video.data(), woven);
+		frameSync->renderedFrame = frameIndex;
+		frameSync->renderedWoven = woven;
+	}
+	else
+	{
+		// Same frame as last time; only the header needs filling in again
+		*p_video_data = receiver.videoHeader(frameIndex, frameSync->video.data(), woven);
+	}
+}
+
+void NDIlib_framesync_free_video(NDIlib_framesync_instance_t, NDIlib_video_frame_v2_t*)
+{
+	// The frame sync owns the buffer
+}
+
+void NDIlib_framesync_capture_audio(NDIlib_framesync_instance_t p_instance, NDIlib_audio_frame_v2_t* p_audio_data,
+                                    int sample_rate, int no_channels, int no_samples)
+{
+	auto* frameSync = static_cast<FrameSync*>(p_instance);
+	Receiver const& receiver = *frameSync->receiver;
+
+	if (no_samples <= 0)
+	{
+		// Asking for nothing tells you the source's format
+		*p_audio_data = NDIlib_audio_frame_v2_t(receiver.audio ? receiver.config.sampleRate : 0, receiver.audio ? receiver.config.channels : 0, 0);
+		return;
+	}
+	sample_rate = sample_rate > 0 ? sample_rate : receiver.config.sampleRate;
+	no_channels = no_channels > 0 ? no_channels : receiver.config.channels;
+
+	// The real frame sync resamples to whatever rate is asked for, against our clock: a source whose clock
+	//  runs fast sends more than a second of audio each second, so every sample handed out covers more of
+	//  its timeline. Synthesising at the requested rate, slowed by the drift, is the same as resampling
+	//  perfectly.
+	if (sample_rate != frameSync->audioRate)
+	{
+		frameSync->audioPosition = frameSync->audioRate ? frameSync->audioPosition * sample_rate / frameSync->audioRate : 0;
+		frameSync->audioRate = sample_rate;
+	}
+	frameSync->audio.resize(static_cast<size_t>(no_samples) * no_channels);
+	double const sourceRate = sample_rate / (1.0 + receiver.config.clockDriftPpm * 1e-6);
+	receiver.fillAudio(frameSync->audio.data(), no_samples, frameSync->audioPosition, no_samples, sourceRate, no_channels);
+
+	double const seconds = static_cast<double>(frameSync->audioPosition) / sourceRate;
+	*p_audio_data = NDIlib_audio_frame_v2_t(sample_rate, no_channels, no_samples, toHundredsOfNanoseconds(seconds), frameSync->audio.data(),
+	                                        no_samples * static_cast<int>(sizeof(float)), nullptr,
+	                                        receiver.timestampAt(static_cast<double>(frameSync->audioPosition + no_samples) / sourceRate));
+	frameSync->audioPosition += no_samples;
+}
+
+void NDIlib_framesync_free_audio(NDIlib_framesync_instance_t, NDIlib_audio_frame_v2_t*)
+{
+	// The frame sync owns the buffer
+}
+
+void NDIlib_util_audio_to_interleaved_32f_v2(const NDIlib_audio_frame_v2_t* p_src, NDIlib_audio_frame_interleaved_32f_t* p_dst)
+{
+	p_dst->sample_rate = p_src->sample_rate;
+	p_dst->no_channels = p_src->no_channels;
+	p_dst->no_samples = p_src->no_samples;
+	p_dst->timecode = p_src->timecode;
+	for (int channel = 0; channel < p_src->no_channels; ++channel)
+	{
+		auto const* plane = reinterpret_cast<float const*>(reinterpret_cast<uint8_t const*>(p_src->p_data) + static_cast<size_t>(channel) * p_src->channel_stride_in_bytes);
+		for (int sample = 0; sample < p_src->no_samples; ++sample)
+		{
+			p_dst->p_data[static_cast<size_t>(sample) * p_src->no_channels + channel] = plane[sample];
+		}
+	}
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "Processing.NDI.Lib.h"
+
+// Configuration of the synthetic sources behind the mock NDI SDK. Every source produces the same
+//  deterministic content for the same settings: colour bars, a box that moves a fixed step per frame,
+//  and the frame number written as 32 black/white blocks along the bottom so tests can read it back.
+//
+// Read from the environment when the first instance is created, so the unmodified application can be
+//  pointed at whatever the test needs:
+//   NDIRECV_MOCK_SOURCES=2                   Number of sources found (default 1)
+//   NDIRECV_MOCK_VIDEO=1280x720@50/1:BGRA    Size, rate and native format (UYVY, BGRA, BGRX, RGBA, RGBX), or "off"
+//   NDIRECV_MOCK_VIDEO=1920x1080@25/1i       An i after the frame rate makes it interlaced: 1080i50
+//   NDIRECV_MOCK_AUDIO=48000:2:tone:440      Rate, channels, tone or noise (tone frequency optional), or "off"
+//   NDIRECV_MOCK_DRIFT_PPM=100               How fast the sources' clocks run against ours
+//   NDIRECV_MOCK_SEED=7                      Noise seed
+namespace MockNDI
+{
+    enum class AudioSignal
+    {
+        Tone,  // Channel n carries a sine at (n + 1) times the tone frequency
+        Noise
+    };
+
+    struct Config
+    {
+        int sourceCount{ 1 };
+
+        bool videoEnabled{ true };
+        int width{ 1920 };
+        int height{ 1080 };
+        int frameRateN{ 30000 };
+        int frameRateD{ 1001 };
+        NDIlib_FourCC_video_type_e fourCC{ NDIlib_FourCC_video_type_UYVY };
+        // Each frame's odd lines (field 1) caught half a frame after its even ones, so the moving box is
+        //  combed. Receivers that allow fields are sent frames as they are, marked interleaved; the rest
+        //  get them made progressive, as the SDK would.
+        bool interlaced{ false };
+
+        bool audioEnabled{ true };
+        int sampleRate{ 48000 };
+        int channels{ 2 };
+        AudioSignal signal{ AudioSignal::Tone };
+        double toneHz{ 1000.0 };
+
+        double clockDriftPpm{ 0.0 };
+        uint32_t seed{ 1 };
+    };
+
+    // Defaults overridden by whichever NDIRECV_MOCK_ variables are set. Malformed values are ignored.
+    Config configFromEnvironment();
+
+    // Applies to instances created afterwards. Tests call this instead of setting the environment.
+    void setConfig(Config const& config);
+    Config config();
+
+    // The value a synthetic source puts in the given channel for the given sample, for tests to compare against.
+    float audioSample(Config const& config, int channel, int64_t sampleIndex, double sampleRate);
+
+    // The frame number encoded along the bottom of a synthetic frame, or -1 if it can't be read.
+    int64_t readFrameNumber(NDIlib_video_frame_v2_t const& frame);
+}
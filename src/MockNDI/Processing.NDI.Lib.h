@@ -0,0 +1,234 @@
+#pragma once
+
+// Stand-in for the NDI SDK's Processing.NDI.Lib.h, built when NDIRECV_MOCK_NDI is on. It declares the
+//  subset of the SDK this application uses, with the same names, layouts and defaults, and is backed by
+//  synthetic sources (see MockNDI.h) rather than the network. Anything not declared here isn't used by
+//  the application; if you start using it, add it here too or the mock build will tell you.
+
+#include <cstdint>
+
+#define NDI_LIB_FOURCC(ch0, ch1, ch2, ch3) \
+    ((uint32_t)(uint8_t)(ch0) | ((uint32_t)(uint8_t)(ch1) << 8) | ((uint32_t)(uint8_t)(ch2) << 16) | ((uint32_t)(uint8_t)(ch3) << 24))
+
+static const int64_t NDIlib_send_timecode_synthesize = INT64_MAX;
+static const int64_t NDIlib_recv_timestamp_undefined = INT64_MAX;
+
+typedef void* NDIlib_find_instance_t;
+typedef void* NDIlib_recv_instance_t;
+typedef void* NDIlib_framesync_instance_t;
+
+typedef enum NDIlib_frame_type_e
+{
+    NDIlib_frame_type_none = 0,
+    NDIlib_frame_type_video = 1,
+    NDIlib_frame_type_audio = 2,
+    NDIlib_frame_type_metadata = 3,
+    NDIlib_frame_type_error = 4,
+    NDIlib_frame_type_status_change = 100,
+} NDIlib_frame_type_e;
+
+typedef enum NDIlib_FourCC_video_type_e
+{
+    NDIlib_FourCC_video_type_UYVY = NDI_LIB_FOURCC('U', 'Y', 'V', 'Y'),
+    NDIlib_FourCC_video_type_UYVA = NDI_LIB_FOURCC('U', 'Y', 'V', 'A'),
+    NDIlib_FourCC_video_type_P216 = NDI_LIB_FOURCC('P', '2', '1', '6'),
+    NDIlib_FourCC_video_type_PA16 = NDI_LIB_FOURCC('P', 'A', '1', '6'),
+    NDIlib_FourCC_video_type_YV12 = NDI_LIB_FOURCC('Y', 'V', '1', '2'),
+    NDIlib_FourCC_video_type_I420 = NDI_LIB_FOURCC('I', '4', '2', '0'),
+    NDIlib_FourCC_video_type_NV12 = NDI_LIB_FOURCC('N', 'V', '1', '2'),
+    NDIlib_FourCC_video_type_BGRA = NDI_LIB_FOURCC('B', 'G', 'R', 'A'),
+    NDIlib_FourCC_video_type_BGRX = NDI_LIB_FOURCC('B', 'G', 'R', 'X'),
+    NDIlib_FourCC_video_type_RGBA = NDI_LIB_FOURCC('R', 'G', 'B', 'A'),
+    NDIlib_FourCC_video_type_RGBX = NDI_LIB_FOURCC('R', 'G', 'B', 'X'),
+} NDIlib_FourCC_video_type_e;
+
+typedef enum NDIlib_FourCC_audio_type_e
+{
+    NDIlib_FourCC_audio_type_FLTP = NDI_LIB_FOURCC('F', 'L', 'T', 'p'),
+} NDIlib_FourCC_audio_type_e;
+
+typedef enum NDIlib_frame_format_type_e
+{
+    NDIlib_frame_format_type_progressive = 1,
+    NDIlib_frame_format_type_interleaved = 0,
+    NDIlib_frame_format_type_field_0 = 2,
+    NDIlib_frame_format_type_field_1 = 3,
+} NDIlib_frame_format_type_e;
+
+typedef enum NDIlib_recv_bandwidth_e
+{
+    NDIlib_recv_bandwidth_metadata_only = -10,
+    NDIlib_recv_bandwidth_audio_only = 10,
+    NDIlib_recv_bandwidth_lowest = 0,
+    NDIlib_recv_bandwidth_highest = 100,
+} NDIlib_recv_bandwidth_e;
+
+typedef enum NDIlib_recv_color_format_e
+{
+    NDIlib_recv_color_format_BGRX_BGRA = 0,
+    NDIlib_recv_color_format_UYVY_BGRA = 1,
+    NDIlib_recv_color_format_RGBX_RGBA = 2,
+    NDIlib_recv_color_format_UYVY_RGBA = 3,
+    NDIlib_recv_color_format_fastest = 100,
+    NDIlib_recv_color_format_best = 101,
+} NDIlib_recv_color_format_e;
+
+typedef struct NDIlib_source_t
+{
+    const char* p_ndi_name;
+    const char* p_url_address;
+
+    NDIlib_source_t(const char* p_ndi_name_ = nullptr, const char* p_url_address_ = nullptr)
+        : p_ndi_name(p_ndi_name_), p_url_address(p_url_address_) {}
+} NDIlib_source_t;
+
+typedef struct NDIlib_video_frame_v2_t
+{
+    int xres, yres;
+    NDIlib_FourCC_video_type_e FourCC;
+    int frame_rate_N, frame_rate_D;
+    float picture_aspect_ratio;
+    NDIlib_frame_format_type_e frame_format_type;
+    int64_t timecode;
+    uint8_t* p_data;
+    union
+    {
+        int line_stride_in_bytes;
+        int data_size_in_bytes;
+    };
+    const char* p_metadata;
+    int64_t timestamp;
+
+    NDIlib_video_frame_v2_t(int xres_ = 0, int yres_ = 0, NDIlib_FourCC_video_type_e FourCC_ = NDIlib_FourCC_video_type_UYVY,
+                            int frame_rate_N_ = 30000, int frame_rate_D_ = 1001, float picture_aspect_ratio_ = 0.0f,
+                            NDIlib_frame_format_type_e frame_format_type_ = NDIlib_frame_format_type_progressive,
+                            int64_t timecode_ = NDIlib_send_timecode_synthesize, uint8_t* p_data_ = nullptr,
+                            int line_stride_in_bytes_ = 0, const char* p_metadata_ = nullptr, int64_t timestamp_ = 0)
+        : xres(xres_), yres(yres_), FourCC(FourCC_), frame_rate_N(frame_rate_N_), frame_rate_D(frame_rate_D_),
+          picture_aspect_ratio(picture_aspect_ratio_), frame_format_type(frame_format_type_), timecode(timecode_),
+          p_data(p_data_), line_stride_in_bytes(line_stride_in_bytes_), p_metadata(p_metadata_), timestamp(timestamp_) {}
+} NDIlib_video_frame_v2_t;
+
+typedef struct NDIlib_audio_frame_v2_t
+{
+    int sample_rate;
+    int no_channels;
+    int no_samples;
+    int64_t timecode;
+    float* p_data;
+    int channel_stride_in_bytes;
+    const char* p_metadata;
+    int64_t timestamp;
+
+    NDIlib_audio_frame_v2_t(int sample_rate_ = 48000, int no_channels_ = 2, int no_samples_ = 0,
+                            int64_t timecode_ = NDIlib_send_timecode_synthesize, float* p_data_ = nullptr,
+                            int channel_stride_in_bytes_ = 0, const char* p_metadata_ = nullptr, int64_t timestamp_ = 0)
+        : sample_rate(sample_rate_), no_channels(no_channels_), no_samples(no_samples_), timecode(timecode_), p_data(p_data_),
+          channel_stride_in_bytes(channel_stride_in_bytes_), p_metadata(p_metadata_), timestamp(timestamp_) {}
+} NDIlib_audio_frame_v2_t;
+
+typedef struct NDIlib_audio_frame_v3_t
+{
+    int sample_rate;
+    int no_channels;
+    int no_samples;
+    int64_t timecode;
+    NDIlib_FourCC_audio_type_e FourCC;
+    uint8_t* p_data;
+    union
+    {
+        int channel_stride_in_bytes;
+        int data_size_in_bytes;
+    };
+    const char* p_metadata;
+    int64_t timestamp;
+
+    NDIlib_audio_frame_v3_t(int sample_rate_ = 48000, int no_channels_ = 2, int no_samples_ = 0,
+                            int64_t timecode_ = NDIlib_send_timecode_synthesize,
+                            NDIlib_FourCC_audio_type_e FourCC_ = NDIlib_FourCC_audio_type_FLTP, uint8_t* p_data_ = nullptr,
+                            int channel_stride_in_bytes_ = 0, const char* p_metadata_ = nullptr, int64_t timestamp_ = 0)
+        : sample_rate(sample_rate_), no_channels(no_channels_), no_samples(no_samples_), timecode(timecode_), FourCC(FourCC_),
+          p_data(p_data_), channel_stride_in_bytes(channel_stride_in_bytes_), p_metadata(p_metadata_), timestamp(timestamp_) {}
+} NDIlib_audio_frame_v3_t;
+
+typedef struct NDIlib_audio_frame_interleaved_32f_t
+{
+    int sample_rate;
+    int no_channels;
+    int no_samples;
+    int64_t timecode;
+    float* p_data;
+
+    NDIlib_audio_frame_interleaved_32f_t(int sample_rate_ = 48000, int no_channels_ = 2, int no_samples_ = 0,
+                                         int64_t timecode_ = NDIlib_send_timecode_synthesize, float* p_data_ = nullptr)
+        : sample_rate(sample_rate_), no_channels(no_channels_), no_samples(no_samples_), timecode(timecode_), p_data(p_data_) {}
+} NDIlib_audio_frame_interleaved_32f_t;
+
+typedef struct NDIlib_metadata_frame_t
+{
+    int length;
+    int64_t timecode;
+    char* p_data;
+
+    NDIlib_metadata_frame_t(int length_ = 0, int64_t timecode_ = NDIlib_send_timecode_synthesize, char* p_data_ = nullptr)
+        : length(length_), timecode(timecode_), p_data(p_data_) {}
+} NDIlib_metadata_frame_t;
+
+typedef struct NDIlib_find_create_t
+{
+    bool show_local_sources;
+    const char* p_groups;
+    const char* p_extra_ips;
+
+    NDIlib_find_create_t(bool show_local_sources_ = true, const char* p_groups_ = nullptr, const char* p_extra_ips_ = nullptr)
+        : show_local_sources(show_local_sources_), p_groups(p_groups_), p_extra_ips(p_extra_ips_) {}
+} NDIlib_find_create_t;
+
+typedef struct NDIlib_recv_create_v3_t
+{
+    NDIlib_source_t source_to_connect_to;
+    NDIlib_recv_color_format_e color_format;
+    NDIlib_recv_bandwidth_e bandwidth;
+    bool allow_video_fields;
+    const char* p_ndi_recv_name;
+
+    NDIlib_recv_create_v3_t(const NDIlib_source_t source_to_connect_to_ = NDIlib_source_t(),
+                            NDIlib_recv_color_format_e color_format_ = NDIlib_recv_color_format_UYVY_BGRA,
+                            NDIlib_recv_bandwidth_e bandwidth_ = NDIlib_recv_bandwidth_highest,
+                            bool allow_video_fields_ = true, const char* p_ndi_name_ = nullptr)
+        : source_to_connect_to(source_to_connect_to_), color_format(color_format_), bandwidth(bandwidth_),
+          allow_video_fields(allow_video_fields_), p_ndi_recv_name(p_ndi_name_) {}
+} NDIlib_recv_create_v3_t;
+
+bool NDIlib_initialize(void);
+void NDIlib_destroy(void);
+const char* NDIlib_version(void);
+
+NDIlib_find_instance_t NDIlib_find_create_v2(const NDIlib_find_create_t* p_create_settings = nullptr);
+void NDIlib_find_destroy(NDIlib_find_instance_t p_instance);
+const NDIlib_source_t* NDIlib_find_get_current_sources(NDIlib_find_instance_t p_instance, uint32_t* p_no_sources);
+bool NDIlib_find_wait_for_sources(NDIlib_find_instance_t p_instance, uint32_t timeout_in_ms);
+
+NDIlib_recv_instance_t NDIlib_recv_create_v3(const NDIlib_recv_create_v3_t* p_create_settings = nullptr);
+void NDIlib_recv_destroy(NDIlib_recv_instance_t p_instance);
+NDIlib_frame_type_e NDIlib_recv_capture_v2(NDIlib_recv_instance_t p_instance, NDIlib_video_frame_v2_t* p_video_data,
+                                           NDIlib_audio_frame_v2_t* p_audio_data, NDIlib_metadata_frame_t* p_metadata,
+                                           uint32_t timeout_in_ms);
+NDIlib_frame_type_e NDIlib_recv_capture_v3(NDIlib_recv_instance_t p_instance, NDIlib_video_frame_v2_t* p_video_data,
+                                           NDIlib_audio_frame_v3_t* p_audio_data, NDIlib_metadata_frame_t* p_metadata,
+                                           uint32_t timeout_in_ms);
+void NDIlib_recv_free_video_v2(NDIlib_recv_instance_t p_instance, const NDIlib_video_frame_v2_t* p_video_data);
+void NDIlib_recv_free_audio_v2(NDIlib_recv_instance_t p_instance, const NDIlib_audio_frame_v2_t* p_audio_data);
+void NDIlib_recv_free_audio_v3(NDIlib_recv_instance_t p_instance, const NDIlib_audio_frame_v3_t* p_audio_data);
+void NDIlib_recv_free_metadata(NDIlib_recv_instance_t p_instance, const NDIlib_metadata_frame_t* p_metadata);
+
+NDIlib_framesync_instance_t NDIlib_framesync_create(NDIlib_recv_instance_t p_receiver);
+void NDIlib_framesync_destroy(NDIlib_framesync_instance_t p_instance);
+void NDIlib_framesync_capture_video(NDIlib_framesync_instance_t p_instance, NDIlib_video_frame_v2_t* p_video_data,
+                                    NDIlib_frame_format_type_e field_type = NDIlib_frame_format_type_progressive);
+void NDIlib_framesync_free_video(NDIlib_framesync_instance_t p_instance, NDIlib_video_frame_v2_t* p_video_data);
+void NDIlib_framesync_capture_audio(NDIlib_framesync_instance_t p_instance, NDIlib_audio_frame_v2_t* p_audio_data,
+                                    int sample_rate, int no_channels, int no_samples);
+void NDIlib_framesync_free_audio(NDIlib_framesync_instance_t p_instance, NDIlib_audio_frame_v2_t* p_audio_data);
+
+void NDIlib_util_audio_to_interleaved_32f_v2(const NDIlib_audio_frame_v2_t* p_src, NDIlib_audio_frame_interleaved_32f_t* p_dst);
@@ -0,0 +1,161 @@
+#include "MultiviewWidget.h"
+
+#include <QGridLayout>
+#include <QHBoxLayout>
+#include <cmath>
+
+#include "Log.h"
+
+MultiviewWidget::MultiviewWidget(ReceiverCache& receivers, QWidget* parent)
+	: QWidget(parent)
+	, m_receivers{ receivers }
+{
+	auto* const grid = new QGridLayout(this);
+	grid->setContentsMargins(0, 0, 0, 0);
+	grid->setSpacing(2);
+}
+
+MultiviewWidget::~MultiviewWidget()
+{
+	// The pool's threads write into the tiles and the audio output; they must be gone first
+	stop();
+}
+
+void MultiviewWidget::start(QStringList const& sources, ReceiverSettings const& settings, QAudioDevice const& audioDevice)
+{
+	stop();
+	if (sources.isEmpty())
+	{
+		return;
+	}
+
+	m_audioOutput->setDevice(audioDevice);
+	m_audioRouter = std::make_unique<AudioRouter>(*m_audioOutput, sources.size());
+	m_pool = std::make_unique<ReceiverPool>();
+	m_selected = 0;
+
+	// As square as possible, filled row by row
+	int const columns = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(sources.size()))));
+	auto* const grid = static_cast<QGridLayout*>(layout());
+
+	for (int i = 0; i < sources.size(); ++i)
+	{
+		auto* const cell = new QWidget(this);
+		cell->setSizePolicy(QSizePolicy::Ignored, QSizePolicy::Ignored);
+		auto* const cellLayout = new QHBoxLayout(cell);
+		cellLayout->setContentsMargins(0, 0, 0, 0);
+		cellLayout->setSpacing(0);
+		auto* const view = new VideoPlaybackWidget(cell);
+		view->setSizePolicy(QSizePolicy::Ignored, QSizePolicy::Ignored);
+		view->setPlaceholderText(sources[i]);
+		cellLayout->addWidget(view);
+		auto* const meter = new AudioMeterWidget(cell);
+		meter->setFixedWidth(12); // Just the bars
+		meter->setVisible(m_audioMetersVisible);
+		cellLayout->addWidget(meter);
+		grid->addWidget(cell, i / columns, i % columns);
+		connect(view, &VideoPlaybackWidget::clicked, this, [this, i]() { select(i); });
+
+		auto engine = std::make_unique<ReceiverEngine>(*view, m_audioRouter->input(i), m_receivers);
+		view->setStats(&engine->stats());
+		view->setStatsOverlayVisible(m_statsOverlayVisible);
+		meter->setLevels(&engine->stats().audioLevels);
+
+		ReceiverSettings tileSettings{ settings };
+		tileSettings.sourceName = sources[i];
+		tileSettings.audio = true; // The audio router decides which tile is heard
+		tileSettings.meterAudio = m_audioMetersVisible; // Metered whether heard or not
+		m_pool->add(*engine, tileSettings);
+
+		m_tiles.push_back({ sources[i], cell, view, meter, std::move(engine) });
+	}
+	for (int row = 0; row < grid->rowCount(); ++row)
+	{
+		grid->setRowStretch(row, 1);
+	}
+	for (int column = 0; column < grid->columnCount(); ++column)
+	{
+		grid->setColumnStretch(column, 1);
+	}
+
+	select(0);
+	m_pool->start();
+	LOG_INFO(QString("Multiview started with %1 sources").arg(sources.size()));
+}
+
+void MultiviewWidget::stop()
+{
+	if (!m_pool)
+	{
+		return;
+	}
+	m_pool->stop(); // Joins the workers and closes the engines
+	m_pool.reset();
+	for (auto& tile : m_tiles)
+	{
+		delete tile.cell;
+	}
+	m_tiles.clear();
+	m_audioRouter.reset();
+
+	// The grid keeps its rows and columns; don't let empty ones take space from a smaller grid next time
+	auto* const grid = static_cast<QGridLayout*>(layout());
+	for (int row = 0; row < grid->rowCount(); ++row)
+	{
+		grid->setRowStretch(row, 0);
+	}
+	for (int column = 0; column < grid->columnCount(); ++column)
+	{
+		grid->setColumnStretch(column, 0);
+	}
+	LOG_INFO("Multiview stopped");
+}
+
+void MultiviewWidget::setAudioFollowsSelection(bool const follows)
+{
+	m_audioFollowsSelection = follows;
+	updateAudio();
+}
+
+void MultiviewWidget::setStatsOverlayVisible(bool const visible)
+{
+	m_statsOverlayVisible = visible;
+	for (auto& tile : m_tiles)
+	{
+		tile.view->setStatsOverlayVisible(visible);
+	}
+}
+
+void MultiviewWidget::setAudioMetersVisible(bool const visible)
+{
+	m_audioMetersVisible = visible;
+	for (auto& tile : m_tiles)
+	{
+		tile.meter->setVisible(visible);
+		tile.engine->setAudioMetering(visible);
+	}
+}
+
+void MultiviewWidget::select(int const tile)
+{
+	m_selected = tile;
+	for (int i = 0; i < static_cast<int>(m_tiles.size()); ++i)
+	{
+		m_tiles[i].view->setHighlighted(i == tile);
+	}
+	updateAudio();
+}
+
+void MultiviewWidget::updateAudio()
+{
+	if (!m_audioRouter)
+	{
+		return;
+	}
+	int const audible = m_audioFollowsSelection ? m_selected : AudioRouter::none;
+	m_audioRouter->select(audible);
+	if (audible != AudioRouter::none)
+	{
+		LOG_INFO(QString("Multiview audio from %1").arg(m_tiles[audible].source));
+	}
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <QAudioDevice>
+#include <QStringList>
+#include <QWidget>
+#include <memory>
+#include <vector>
+
+#include "AudioMeterWidget.h"
+#include "AudioOutput.h"
+#include "AudioRouter.h"
+#include "ReceiverCache.h"
+#include "ReceiverEngine.h"
+#include "ReceiverPool.h"
+#include "VideoPlaybackWidget.h"
+
+// A grid of tiles, one per source, all received at once. Each tile is its own engine and playback
+//  widget, but they share a small ReceiverPool of capture threads rather than each having one, and one
+//  audio output: clicking a tile selects it, and if audio follows selection it is the one heard (if not,
+//  none are). Every tile has a narrow level meter beside it, whether or not it is the one heard.
+class MultiviewWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    MultiviewWidget(ReceiverCache& receivers, QWidget* parent = nullptr);
+    ~MultiviewWidget() override;
+
+    // GUI thread. Replaces whatever is showing. Every source is received with the given settings, bar the name.
+    void start(QStringList const& sources, ReceiverSettings const& settings, QAudioDevice const& audioDevice);
+    void stop();
+    bool running() const { return m_pool != nullptr; }
+
+    void setAudioFollowsSelection(bool follows);
+    void setStatsOverlayVisible(bool visible);
+    // Also stops or starts measuring, so hidden meters cost nothing.
+    void setAudioMetersVisible(bool visible);
+
+private:
+    struct Tile
+    {
+        QString source;
+        QWidget* cell;                 // Holds the view and the meter
+        VideoPlaybackWidget* view;
+        AudioMeterWidget* meter;
+        std::unique_ptr<ReceiverEngine> engine;
+    };
+
+    void select(int tile);
+    void updateAudio();
+
+    ReceiverCache& m_receivers;
+    AudioOutput* m_audioOutput{ new AudioOutput(this) };
+    std::unique_ptr<AudioRouter> m_audioRouter;
+    std::unique_ptr<ReceiverPool> m_pool;
+    std::vector<Tile> m_tiles;
+    int m_selected{ 0 };
+    bool m_audioFollowsSelection{ true };
+    bool m_statsOverlayVisible{ false };
+    bool m_audioMetersVisible{ true };
+};
@@ -1,35 +1,154 @@
 #pragma once
 
+#include <atomic>
+#include <cstdint>
 #include <type_traits>
-#include <functional>
+#include <utility>
 
-// Concept to check if T is a pointer
-template <typename T>
-concept IsPointer = std::is_pointer_v<T>;
+#include "Processing.NDI.Lib.h"
 
-// Concept to check if F is a callable (function, lambda, or functor)
-template <typename F>
-concept IsCallable = std::is_invocable_v<F> || std::is_function_v<std::remove_pointer_t<F>>;
+// Debug builds count the NDI objects alive, for the stats: a count that climbs with every play and stop
+//  is a leak. Release builds don't pay for the atomics.
+#if !defined(NDEBUG) && !defined(NDIRECV_COUNT_HANDLES)
+#define NDIRECV_COUNT_HANDLES 1
+#endif
 
-// Simple template class accepting a function to call upon destruction, and a pointer on which to call
-//  that function. Many NDISDK objects have a C style free function that must be called on them to release
-//  them properly. This guard object gives us an RAII style object to do that for us.
-template <IsCallable F, IsPointer P>
-struct deleteGuard
+#ifdef NDIRECV_COUNT_HANDLES
+inline constexpr bool ndiHandlesCounted = true;
+#else
+inline constexpr bool ndiHandlesCounted = false;
+#endif
+
+// Sole owner of one NDI SDK object, released with its C style destroy function when the owner goes.
+//  The destroy function is part of the type, so a frame sync can only ever be destroyed as a frame sync:
+//  NDI's handles are all void* underneath, and a guard that took its deleter as a constructor argument
+//  would happily destroy a receiver twice and its frame sync never. Move-only, and the size of the pointer
+//  it wraps.
+//
+// The create function is part of the type too, and create() is the only way in: there is no taking over
+//  a raw pointer, which could be any kind of object, so a frame sync handle can only hold a frame sync.
+//
+// Objects that depend on another (a frame sync on its receiver) must go first; declare the dependent
+//  handle after the one it depends on, so it is destroyed before it.
+template <typename P, auto Create, auto Destroy>
+    requires std::is_pointer_v<P> && std::is_invocable_v<decltype(Destroy), P>
+class NDIHandle
 {
-	F funcToCall;  // Store the callable
-	P ptr;   // Store the pointer
-
-	deleteGuard(F deleterFunction, P toDelete)
-	{
-		funcToCall = deleterFunction;
-		ptr = toDelete;
-	}
-	~deleteGuard()
-	{
-		if (ptr) { funcToCall(ptr); }
-	}
+public:
+    NDIHandle() = default;
+    NDIHandle(NDIHandle&& other) noexcept : m_handle{ std::exchange(other.m_handle, nullptr) } {}
+    NDIHandle& operator=(NDIHandle&& other) noexcept
+    {
+        if (this != &other)
+        {
+            replace(other.release());
+        }
+        return *this;
+    }
+    ~NDIHandle() { reset(); }
+
+    // A new object of this kind, from whatever its create function takes; empty if the SDK couldn't make one
+    template <typename... Args>
+        requires std::is_invocable_r_v<P, decltype(Create), Args...>
+    [[nodiscard]] static NDIHandle create(Args&&... args)
+    {
+        return NDIHandle{ Create(std::forward<Args>(args)...) };
+    }
+
+    NDIHandle(NDIHandle const&) = delete;
+    NDIHandle& operator=(NDIHandle const&) = delete;
+
+    P get() const noexcept { return m_handle; }
+    explicit operator bool() const noexcept { return m_handle != nullptr; }
+
+    // Destroys what is held, if anything
+    void reset() noexcept { replace(nullptr); }
+
+    // Gives up ownership without destroying; the caller destroys it
+    P release() noexcept
+    {
+        if (m_handle)
+        {
+            forgotten();
+        }
+        return std::exchange(m_handle, nullptr);
+    }
+
+    // How many objects of this kind handles own right now, across the process; 0 if not counted
+    static int64_t live() noexcept
+    {
+#ifdef NDIRECV_COUNT_HANDLES
+        return s_live.load(std::memory_order_relaxed);
+#else
+        return 0;
+#endif
+    }
+
+private:
+    explicit NDIHandle(P handle) noexcept : m_handle{ handle } { adopted(handle); }
+
+    void replace(P handle) noexcept
+    {
+        if (handle == m_handle)
+        {
+            return;
+        }
+        adopted(handle);
+        if (P const old = std::exchange(m_handle, handle))
+        {
+            Destroy(old);
+            forgotten();
+        }
+    }
+
+    static void adopted([[maybe_unused]] P handle) noexcept
+    {
+#ifdef NDIRECV_COUNT_HANDLES
+        if (handle)
+        {
+            s_live.fetch_add(1, std::memory_order_relaxed);
+        }
+#endif
+    }
+
+    static void forgotten() noexcept
+    {
+#ifdef NDIRECV_COUNT_HANDLES
+        s_live.fetch_sub(1, std::memory_order_relaxed);
+#endif
+    }
+
+    P m_handle{ nullptr };
+#ifdef NDIRECV_COUNT_HANDLES
+    static inline std::atomic<int64_t> s_live{ 0 };
+#endif
 };
 
+// What each kind is made with, taking its settings by reference rather than as an optional pointer. Use
+//  the handles' create() instead: these return objects nobody owns yet.
+namespace NDICreate
+{
+    inline NDIlib_find_instance_t finder(NDIlib_find_create_t const& settings)
+    {
+        return NDIlib_find_create_v2(&settings);
+    }
+
+    inline NDIlib_recv_instance_t receiver(NDIlib_recv_create_v3_t const& settings)
+    {
+        return NDIlib_recv_create_v3(&settings);
+    }
+}
 
+using FindHandle = NDIHandle<NDIlib_find_instance_t, NDICreate::finder, NDIlib_find_destroy>;
+using ReceiverHandle = NDIHandle<NDIlib_recv_instance_t, NDICreate::receiver, NDIlib_recv_destroy>;
+
+namespace NDICreate
+{
+    // Only from a receiver handle, so nothing else can be passed off as one
+    inline NDIlib_framesync_instance_t frameSync(ReceiverHandle const& receiver)
+    {
+        return receiver ? NDIlib_framesync_create(receiver.get()) : nullptr;
+    }
+}
 
+using FrameSyncHandle = NDIHandle<NDIlib_framesync_instance_t, NDICreate::frameSync, NDIlib_framesync_destroy>;
@@ -0,0 +1,63 @@
+#include "PresentationQueue.h"
+
+#include "FramePool.h"
+
+PresentationQueue::PresentationQueue(size_t const capacity)
+	: m_frames(capacity > 0 ? capacity : 1)
+{
+}
+
+QImage& PresentationQueue::prepare(QSize const size)
+{
+	QImage& image{ m_frames[(m_head + m_count) % m_frames.size()].image };
+	if (image.size() != size)
+	{
+		image = FramePool::shared().image(size);
+	}
+	return image;
+}
+
+void PresentationQueue::push(std::chrono::system_clock::time_point const sentAt)
+{
+	if (full())
+	{
+		return;
+	}
+	m_frames[(m_head + m_count) % m_frames.size()].sentAt = sentAt;
+	++m_count;
+}
+
+PresentationQueue::Frame* PresentationQueue::takeDue(std::chrono::system_clock::time_point const clock, uint64_t& overtaken)
+{
+	Frame* due{ nullptr };
+	while (m_count > 0 && m_frames[m_head].sentAt <= clock)
+	{
+		if (due)
+		{
+			++overtaken;
+		}
+		due = takeOldest();
+	}
+	return due;
+}
+
+PresentationQueue::Frame* PresentationQueue::takeOldest()
+{
+	if (m_count == 0)
+	{
+		return nullptr;
+	}
+	Frame* const oldest{ &m_frames[m_head] };
+	m_head = (m_head + 1) % m_frames.size();
+	--m_count;
+	return oldest;
+}
+
+std::optional<std::chrono::system_clock::time_point> PresentationQueue::nextDue() const
+{
+	if (m_count == 0)
+	{
+		return std::nullopt;
+	}
+	return m_frames[m_head].sentAt;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <QImage>
+#include <QSize>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+// Video frames converted ahead of time, waiting for the audio to catch up with them. The engine converts
+//  into prepare() and queues with push(); then, as the audio clock moves on, takeDue() hands back the frame
+//  that belongs on screen. Images come from the FramePool and are meant to be swapped, not copied, with the
+//  video target's back buffer, so the queue recycles the target's old buffers as it goes.
+class PresentationQueue
+{
+public:
+    struct Frame
+    {
+        QImage image;
+        std::chrono::system_clock::time_point sentAt;
+    };
+
+    explicit PresentationQueue(size_t capacity = 8);
+
+    // The image to convert the next frame into, sized to size. Only when !full().
+    QImage& prepare(QSize size);
+    // Queues the frame prepare() gave, sent by the source at sentAt. Frames must be pushed in sent order.
+    void push(std::chrono::system_clock::time_point sentAt);
+
+    // Takes every frame due by clock, and returns the newest of them, or null if none is due. The older
+    //  ones are counted in overtaken: they never got their turn on screen. Frames returned by these stay
+    //  valid until the next prepare().
+    Frame* takeDue(std::chrono::system_clock::time_point clock, uint64_t& overtaken);
+    // Takes the oldest frame whether due or not, or null if empty.
+    Frame* takeOldest();
+
+    std::optional<std::chrono::system_clock::time_point> nextDue() const;
+    size_t size() const { return m_count; }
+    bool empty() const { return m_count == 0; }
+    bool full() const { return m_count == m_frames.size(); }
+    void clear() { m_count = 0; }
+
+private:
+    std::vector<Frame> m_frames;
+    size_t m_head{ 0 };  // Oldest queued frame
+    size_t m_count{ 0 };
+};
@@ -0,0 +1,553 @@
+// ndirecv-bench: runs the receive pipeline against a source for a while, with no widgets or sound card,
+//  and reports how it coped. For headless boxes, and for catching throughput regressions.
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <new>
+#include <random>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#include "AudioConvert.h"
+#include "BurstCapture.h"
+#include "CaptureScheduler.h"
+#include "Deinterlace.h"
+#include "Log.h"
+#include "NDIDeleters.h"
+#include "ReceiverCache.h"
+#include "ReceiverEngine.h"
+#include "RecordingReader.h"
+#include "StatsReport.h"
+
+namespace
+{
+	// Counts operator new calls made by the thread running the pipeline. Other threads (the NDI SDK's own)
+	//  are not ours to count. Frame buffers come from the FramePool, whose hits and misses are in the report.
+	thread_local uint64_t allocationsOnThisThread = 0;
+}
+
+void* operator new(std::size_t size)
+{
+	++allocationsOnThisThread;
+	if (void* p = std::malloc(size ? size : 1))
+	{
+		return p;
+	}
+	throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+	std::free(p);
+}
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+	std::chrono::nanoseconds threadCpuTime()
+	{
+#ifdef _WIN32
+		FILETIME creation, exit, kernel, user;
+		GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user);
+		auto const hundredsOfNanoseconds = [](FILETIME const& time) { return (uint64_t{ time.dwHighDateTime } << 32) | time.dwLowDateTime; };
+		return std::chrono::nanoseconds((hundredsOfNanoseconds(kernel) + hundredsOfNanoseconds(user)) * 100);
+#else
+		timespec now;
+		clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+		return std::chrono::seconds(now.tv_sec) + std::chrono::nanoseconds(now.tv_nsec);
+#endif
+	}
+
+	// Stands in for the playback widget. Nothing consumes the frames; the conversion into the back buffer
+	//  is the work being measured. With no screen, publishing is as near the glass as a frame gets.
+	class HeadlessVideo : public VideoTarget
+	{
+	public:
+		explicit HeadlessVideo(QSize size) : m_size{ size } {}
+
+		void setStats(PipelineStats* stats) { m_stats = stats; }
+
+		QSize targetSize() const override { return m_size; }
+		QImage& backBuffer() override { return m_image; }
+		void publishFrame(std::chrono::system_clock::time_point const sentAt) override
+		{
+			++m_published;
+			if (m_stats && sentAt != std::chrono::system_clock::time_point{})
+			{
+				m_stats->glassToGlass.record(std::max<std::chrono::nanoseconds>(std::chrono::system_clock::now() - sentAt, std::chrono::nanoseconds{ 0 }));
+			}
+		}
+
+		uint64_t published() const { return m_published; }
+
+	private:
+		QSize m_size;
+		PipelineStats* m_stats{ nullptr };
+		QImage m_image;
+		uint64_t m_published{ 0 };
+	};
+
+	// Stands in for the sound card. Converts to 16 bit stereo as a typical device would want, so the cost is
+	//  realistic, and keeps track of whether audio arrives as fast as it plays out. Its presentation clock
+	//  plays the first block as it arrives and runs on in real time from there.
+	class AccountingAudio : public AudioTarget
+	{
+	public:
+		int start(int sourceSampleRate, int sourceChannels, std::chrono::microseconds) override
+		{
+			m_sampleRate = sourceSampleRate;
+			m_converter.configure(sourceChannels, 2, SampleFormat::Int16);
+			LOG_INFO(QString("Audio: %1 channels at %2 Hz").arg(sourceChannels).arg(sourceSampleRate));
+			return sourceSampleRate;
+		}
+
+		void stop() override {}
+
+		void write(float const* planar, int channelStrideInBytes, size_t frames, std::chrono::system_clock::time_point sentAt) override
+		{
+			++m_writes;
+			if (frames == 0 || !planar)
+			{
+				++m_emptyWrites;
+				return;
+			}
+			m_converted.resize(frames * m_converter.bytesPerFrame());
+			m_converter.convert(planar, channelStrideInBytes / sizeof(float), frames, m_converted.data());
+
+			// Treat the first write as covering the time just before it, then see how far the audio
+			//  delivered drifts from the time that has passed
+			auto const now = Clock::now();
+			if (m_frames == 0)
+			{
+				m_reference = now - std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(double(frames) / m_sampleRate));
+				if (sentAt.time_since_epoch().count() > 0)
+				{
+					m_firstWrite.store(now.time_since_epoch().count(), std::memory_order_relaxed);
+					m_firstSentAt.store(sentAt.time_since_epoch().count(), std::memory_order_release);
+				}
+			}
+			m_frames += frames;
+			double const elapsed = std::chrono::duration<double>(now - m_reference).count();
+			m_worstDeviation = std::max(m_worstDeviation, std::abs(elapsed - double(m_frames) / m_sampleRate));
+		}
+
+		std::optional<std::chrono::system_clock::time_point> presentationClock() const override
+		{
+			auto const firstSentAt = m_firstSentAt.load(std::memory_order_acquire);
+			if (firstSentAt == 0)
+			{
+				return std::nullopt;
+			}
+			auto const playing = Clock::now() - Clock::time_point{ Clock::duration{ m_firstWrite.load(std::memory_order_relaxed) } };
+			return std::chrono::system_clock::time_point{ std::chrono::system_clock::duration{ firstSentAt } }
+				+ std::chrono::duration_cast<std::chrono::system_clock::duration>(playing);
+		}
+
+		int sampleRate() const { return m_sampleRate; }
+		uint64_t frames() const { return m_frames; }
+		uint64_t writes() const { return m_writes; }
+		uint64_t emptyWrites() const { return m_emptyWrites; }
+		double worstDeviationSeconds() const { return m_worstDeviation; }
+
+	private:
+		AudioFrameConverter m_converter;
+		std::vector<uint8_t> m_converted;
+		int m_sampleRate{ 0 };
+		uint64_t m_frames{ 0 };
+		uint64_t m_writes{ 0 };
+		uint64_t m_emptyWrites{ 0 };
+		Clock::time_point m_reference;
+		double m_worstDeviation{ 0.0 };
+		std::atomic<Clock::rep> m_firstWrite{ 0 };
+		std::atomic<std::chrono::system_clock::rep> m_firstSentAt{ 0 };
+	};
+
+	void printLog()
+	{
+		static Log::Record records[64];
+		while (size_t const count = Log::drain(records, std::size(records)))
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				std::fprintf(stderr, "%s: %s\n", qPrintable(Log::levelName(records[i].level)), qPrintable(records[i].message()));
+			}
+		}
+	}
+
+	// Shuts the NDI library down when it goes out of scope. Made right after NDIlib_initialize(), so
+	//  everything else that holds NDI objects is destroyed before it, however main() returns.
+	struct NDILibraryScope
+	{
+		NDILibraryScope() = default;
+		NDILibraryScope(NDILibraryScope const&) = delete;
+		NDILibraryScope& operator=(NDILibraryScope const&) = delete;
+		~NDILibraryScope() { NDIlib_destroy(); }
+	};
+
+	// Pictures a second out of 1080i frames through one deinterlacer, as a measure against field rate
+	double picturesPerSecond(KernelPath const path, DeinterlaceMode const mode)
+	{
+		int const stride = 1920 * 2;
+		std::mt19937 rng(1);
+		std::vector<uint8_t> frames[2];
+		for (auto& frame : frames)
+		{
+			frame.resize(static_cast<size_t>(stride) * 1080);
+			for (auto& byte : frame) { byte = static_cast<uint8_t>(rng()); }
+		}
+		Deinterlacer deinterlacer(path);
+		int const pictures = 200;
+		auto const start = Clock::now();
+		for (int i = 0; i < pictures; ++i)
+		{
+			SourceFrame const frame{ frames[(i / 2) % 2].data(), 1920, 1080, stride, PixelLayout::UYVY };
+			deinterlacer.deinterlace(frame, mode, i % 2, i % 2 == 0);
+		}
+		return pictures / std::chrono::duration<double>(Clock::now() - start).count();
+	}
+
+	QString firstSource()
+	{
+		FindHandle const finder{ FindHandle::create(NDIlib_find_create_t{}) };
+		if (!finder)
+		{
+			return {};
+		}
+		NDIlib_find_wait_for_sources(finder.get(), 5000);
+		uint32_t count = 0;
+		NDIlib_source_t const* sources = NDIlib_find_get_current_sources(finder.get(), &count);
+		return count > 0 ? QString(sources[0].p_ndi_name) : QString();
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	QCoreApplication app(argc, argv);
+	QCommandLineParser parser;
+	parser.setApplicationDescription("Receives an NDI source for a while with no display or sound card, and reports how the pipeline coped.");
+	parser.addHelpOption();
+	parser.addPositionalArgument("source", "NDI source name. The first one found if left out.");
+	parser.addOption({ "seconds", "How long to run for.", "seconds", "10" });
+	parser.addOption({ "fps", "Captures per second.", "fps", "30" });
+	parser.addOption({ "size", "Size frames are scaled to fit, as WIDTHxHEIGHT.", "size", "1920x1080" });
+	parser.addOption({ "lowest", "Ask for the lowest bandwidth stream." });
+	parser.addOption({ "auto-bandwidth", "Pick the proxy or full stream to suit --size." });
+	parser.addOption({ "no-audio", "Don't capture audio." });
+	parser.addOption({ "direct", "Receive each frame as it arrives, without a frame sync; --fps is ignored." });
+	parser.addOption({ "lock-to-source", "Capture once per source frame, at the source's own rate; --fps only until the first frame." });
+	parser.addOption({ "max-rate", "With --lock-to-source, capture no more often than this (a display's refresh rate); 0 for no limit.", "hz", "0" });
+	parser.addOption({ "no-meter", "Don't meter audio levels and loudness." });
+	parser.addOption({ "no-av-sync", "Deliver video as soon as it is converted, rather than when the audio reaches it." });
+	parser.addOption({ "deinterlace", "Ask for interlaced frames as sent and deinterlace them here: off (the SDK makes them progressive), bob, blend or adaptive.", "mode", "off" });
+	parser.addOption({ "unchanged-check", "How to spot new frames with the same picture: off, sampled or full.", "mode", "full" });
+	parser.addOption({ "record", "Also record what is received to this file.", "file" });
+	parser.addOption({ "stats", "Also write the pipeline stats to this file (.json, or .prom for Prometheus).", "file" });
+	parser.addOption({ "burst", "Instead of running the pipeline, capture this many frames (or --seconds' worth, if fewer; 0 for no limit but that) to image files.", "frames" });
+	parser.addOption({ "burst-format", "Burst file format: png, jpeg or raw.", "format", "png" });
+	parser.addOption({ "burst-dir", "Directory for the burst's files.", "directory", "ndirecv-burst" });
+	parser.addOption({ "deinterlace-kernels", "Instead of receiving, time each deinterlace mode on 1080 UYVY, the scalar kernels against the best this CPU has." });
+	parser.process(app);
+
+	QStringList const sizeParts = parser.value("size").split('x');
+	QSize const targetSize = sizeParts.size() == 2 ? QSize(sizeParts[0].toInt(), sizeParts[1].toInt()) : QSize();
+	double const seconds = parser.value("seconds").toDouble();
+	int const fps = parser.value("fps").toInt();
+	double const maxRate = parser.value("max-rate").toDouble();
+	QString const unchangedCheck = parser.value("unchanged-check");
+	int const burstFormat = QStringList({ "png", "jpeg", "raw" }).indexOf(parser.value("burst-format"));
+	int const deinterlace = QStringList({ "off", "bob", "blend", "adaptive" }).indexOf(parser.value("deinterlace"));
+	if (targetSize.isEmpty() || seconds <= 0.0 || fps <= 0 || maxRate < 0.0 || !QStringList({ "off", "sampled", "full" }).contains(unchangedCheck)
+		|| burstFormat < 0 || parser.value("burst").toInt() < 0 || deinterlace < 0)
+	{
+		std::fprintf(stderr, "Bad --size, --seconds, --fps, --max-rate, --unchanged-check, --burst, --burst-format or --deinterlace\n");
+		return 2;
+	}
+
+	if (parser.isSet("deinterlace-kernels"))
+	{
+		// 1080i59.94 needs 59.94 a second from one core, with room left for everything else
+		struct { DeinterlaceMode mode; char const* name; } const modes[]{
+			{ DeinterlaceMode::Bob, "bob" }, { DeinterlaceMode::LinearBlend, "blend" }, { DeinterlaceMode::MotionAdaptive, "adaptive" } };
+		Deinterlacer const best;
+		for (auto const& [mode, name] : modes)
+		{
+			std::printf("1080 UYVY %s: %.0f pictures/s scalar, %.0f best\n", name, picturesPerSecond(KernelPath::Scalar, mode), picturesPerSecond(best.path(), mode));
+		}
+		return 0;
+	}
+
+	if (!NDIlib_initialize())
+	{
+		std::fprintf(stderr, "NDIlib_initialize failed; this CPU isn't supported by the NDI SDK\n");
+		return 1;
+	}
+	NDILibraryScope const ndiLibrary;
+
+	ReceiverSettings settings;
+	settings.sourceName = parser.positionalArguments().value(0);
+	settings.capturesPerSecond = fps;
+	settings.bandwidth = parser.isSet("lowest") ? NDIlib_recv_bandwidth_lowest : NDIlib_recv_bandwidth_highest;
+	settings.adaptiveBandwidth = parser.isSet("auto-bandwidth");
+	settings.receiveMode = parser.isSet("direct") ? ReceiveMode::Direct : ReceiveMode::FrameSync;
+	settings.lockToSource = parser.isSet("lock-to-source");
+	settings.maxCapturesPerSecond = maxRate;
+	settings.deinterlace = static_cast<DeinterlaceMode>(deinterlace);
+	settings.audio = !parser.isSet("no-audio");
+	settings.avSync = !parser.isSet("no-av-sync");
+	settings.meterAudio = !parser.isSet("no-meter");
+	settings.unchangedCheck = unchangedCheck == "off" ? FrameHashMode::Off : unchangedCheck == "sampled" ? FrameHashMode::Sampled : FrameHashMode::Full;
+	if (settings.sourceName.isEmpty())
+	{
+		settings.sourceName = firstSource();
+		if (settings.sourceName.isEmpty())
+		{
+			std::fprintf(stderr, "No NDI sources found\n");
+			return 1;
+		}
+	}
+
+	if (parser.isSet("burst"))
+	{
+		BurstSettings burst;
+		burst.sourceName = settings.sourceName;
+		burst.directory = parser.value("burst-dir");
+		burst.frames = parser.value("burst").toInt();
+		burst.duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::duration<double>(seconds));
+		burst.format = static_cast<BurstFormat>(burstFormat);
+		std::printf("Source: %s, burst of %d frames at most, %.1f s at most, as %s into %s\n", qPrintable(settings.sourceName), burst.frames,
+			seconds, qPrintable(BurstCapture::extension(burst.format)), qPrintable(burst.directory));
+
+		ReceiverCache receivers{ 1 };
+		BurstCapture capture{ receivers };
+		std::atomic<bool> const stop{ false };
+		BurstReport const report{ capture.run(burst, stop) };
+		printLog();
+		std::printf("Burst: %s\n", qPrintable(report.summary()));
+		std::printf("Encode per frame: mean %.1f ms, p99 < %.1f ms; write per batch: mean %.1f ms, max %.1f ms; at most %llu frames queued\n",
+			report.encode.meanMicroseconds() / 1000.0, report.encode.percentileMicroseconds(0.99) / 1000.0,
+			report.write.meanMicroseconds() / 1000.0, report.write.maxMicroseconds / 1000.0, static_cast<unsigned long long>(report.queuedPeak));
+		if (!report.error.isEmpty())
+		{
+			std::printf("Burst failed: %s\n", qPrintable(report.error));
+		}
+		return report.error.isEmpty() && report.framesWritten > 0 ? 0 : 1;
+	}
+
+	HeadlessVideo video{ targetSize };
+	AccountingAudio audio;
+	ReceiverCache receivers{ 1 };
+	ReceiverEngine engine{ video, audio, receivers };
+	video.setStats(&engine.stats());
+	if (!engine.open(settings))
+	{
+		printLog();
+		return 1;
+	}
+	if (parser.isSet("record") && !engine.recorder().start(std::filesystem::path(parser.value("record").toStdU16String()), settings.sourceName.toStdString()))
+	{
+		std::fprintf(stderr, "%s\n", engine.recorder().error().c_str());
+		engine.close();
+		return 1;
+	}
+	bool const direct = settings.receiveMode == ReceiveMode::Direct;
+	std::printf("Source: %s, %.1f s %s, frames scaled to fit %dx%d\n", qPrintable(settings.sourceName), seconds,
+		direct ? "received directly" : qPrintable(QString(settings.lockToSource ? "locked to the source's rate (%1 captures/s until known)" : "at %1 captures/s").arg(fps)),
+		targetSize.width(), targetSize.height());
+
+	// The first second is reported separately: buffers get sized, the source connects, caches warm up.
+	//  After that a well behaved pipeline allocates nothing.
+	constexpr auto warmUp = std::chrono::seconds(1);
+	LatencyHistogram cpuPerTick;
+	uint64_t warmUpAllocations = 0;
+	uint64_t steadyAllocations = 0;
+	uint64_t steadyTicks = 0;
+	std::chrono::nanoseconds totalCpu{ 0 };
+
+	std::atomic<bool> stop{ false };
+	CaptureScheduler scheduler{ engine.captureInterval() };
+	auto const start = Clock::now();
+	auto const end = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+	if (direct)
+	{
+		// No ticks to time: the engine's threads wait in the SDK for each frame. The video thread is the one measured.
+		std::thread receiving{ [&]() {
+			auto const cpuBefore = threadCpuTime();
+			engine.receiveDirect(stop);
+			totalCpu = threadCpuTime() - cpuBefore;
+			steadyAllocations = allocationsOnThisThread;
+		} };
+		while (Clock::now() < end)
+		{
+			printLog();
+			std::this_thread::sleep_for(std::chrono::milliseconds(50));
+		}
+		stop.store(true);
+		receiving.join();
+	}
+	while (auto const tick = direct ? std::nullopt : scheduler.waitForNextTick(stop))
+	{
+		auto const cpuBefore = threadCpuTime();
+		uint64_t const allocationsBefore = allocationsOnThisThread;
+		engine.tick(*tick);
+		scheduler.retime(engine.captureInterval(), engine.takePhaseShift());
+		uint64_t const allocations = allocationsOnThisThread - allocationsBefore;
+		auto const cpu = threadCpuTime() - cpuBefore;
+
+		totalCpu += cpu;
+		auto const now = Clock::now();
+		if (now - start < warmUp)
+		{
+			warmUpAllocations += allocations;
+		}
+		else
+		{
+			cpuPerTick.record(cpu);
+			steadyAllocations += allocations;
+			++steadyTicks;
+		}
+
+		printLog();
+		if (now >= end)
+		{
+			stop.store(true);
+		}
+	}
+	double const elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+	engine.close();
+	bool const recorded{ !engine.recorder().recording() || engine.recorder().stop() };
+	printLog();
+
+	PipelineStats const& stats = engine.stats();
+	auto const cpu = cpuPerTick.snapshot();
+	if (!direct)
+	{
+		std::printf("Ticks: %llu (%llu skipped), %.1f per second\n",
+			static_cast<unsigned long long>(scheduler.ticksFired()), static_cast<unsigned long long>(scheduler.ticksSkipped()), scheduler.ticksFired() / elapsed);
+	}
+	if (int const lockedN = stats.cadenceFrameRateN.load(); lockedN > 0)
+	{
+		auto const error = stats.cadenceError.snapshot();
+		std::printf("Cadence: locked to %.3f fps, every %d frame(s); error mean %.0f us, p99 < %llu us; %llu misses, %llu phase shifts, %llu locks\n",
+			double(lockedN) / stats.cadenceFrameRateD.load(), stats.cadenceFramesPerCapture.load(), error.meanMicroseconds(),
+			static_cast<unsigned long long>(error.percentileMicroseconds(0.99)), static_cast<unsigned long long>(stats.cadenceMisses.load()),
+			static_cast<unsigned long long>(stats.cadencePhaseShifts.load()), static_cast<unsigned long long>(stats.cadenceLocks.load()));
+	}
+	std::printf("Video: %llu new source frames (%.2f fps, %llu unchanged), %llu repeats, %llu frames delivered (%.2f fps)\n",
+		static_cast<unsigned long long>(stats.videoFramesCaptured.load()), stats.videoFramesCaptured.load() / elapsed,
+		static_cast<unsigned long long>(stats.videoFramesUnchanged.load()), static_cast<unsigned long long>(stats.videoFramesDuplicated.load()),
+		static_cast<unsigned long long>(video.published()), video.published() / elapsed);
+	// Deinterlacing here against the SDK's progressive conversion: run once with --deinterlace off and once
+	//  with a mode. The SDK's share shows in capture; ours in deinterlace.
+	auto const capture = stats.videoCapture.snapshot();
+	auto const convert = stats.videoConvert.snapshot();
+	std::printf("Per picture: capture mean %.3f ms, convert mean %.3f ms", capture.meanMicroseconds() / 1000.0, convert.meanMicroseconds() / 1000.0);
+	if (auto const deinterlaced = stats.videoDeinterlace.snapshot(); deinterlaced.count > 0)
+	{
+		std::printf(", deinterlace mean %.3f ms, p99 < %.3f ms (%llu pictures; %.0f a second would fit on one core)",
+			deinterlaced.meanMicroseconds() / 1000.0, deinterlaced.percentileMicroseconds(0.99) / 1000.0, static_cast<unsigned long long>(deinterlaced.count),
+			deinterlaced.meanMicroseconds() > 0.0 ? 1e6 / deinterlaced.meanMicroseconds() : 0.0);
+	}
+	std::printf("\n");
+	auto const sourceToCapture = stats.videoSourceToCapture.snapshot();
+	auto const glassToGlass = stats.glassToGlass.snapshot();
+	std::printf("Latency from the source's timestamp: to capture mean %.1f ms, p99 < %.1f ms; to delivery mean %.1f ms, p99 < %.1f ms\n",
+		sourceToCapture.meanMicroseconds() / 1000.0, sourceToCapture.percentileMicroseconds(0.99) / 1000.0,
+		glassToGlass.meanMicroseconds() / 1000.0, glassToGlass.percentileMicroseconds(0.99) / 1000.0);
+	if (direct)
+	{
+		std::printf("CPU on the video thread: %.1f%% of one core; %llu allocations (operator new) on it in all\n",
+			100.0 * std::chrono::duration<double>(totalCpu).count() / elapsed, static_cast<unsigned long long>(steadyAllocations));
+	}
+	else
+	{
+		std::printf("CPU per tick after warm-up: mean %.3f ms, p99 < %.3f ms, max %.3f ms; %.1f%% of one core overall\n",
+			cpu.meanMicroseconds() / 1000.0, cpu.percentileMicroseconds(0.99) / 1000.0, cpu.maxMicroseconds / 1000.0,
+			100.0 * std::chrono::duration<double>(totalCpu).count() / elapsed);
+		std::printf("Allocations (operator new, pipeline thread): %llu in the first second, %.2f per tick after\n",
+			static_cast<unsigned long long>(warmUpAllocations), steadyTicks ? double(steadyAllocations) / steadyTicks : 0.0);
+	}
+	if (audio.sampleRate() > 0)
+	{
+		std::printf("Audio: %llu frames at %d Hz in %llu writes (%llu empty), %.1f%% of real time, never more than %.1f ms from it\n",
+			static_cast<unsigned long long>(audio.frames()), audio.sampleRate(), static_cast<unsigned long long>(audio.writes()),
+			static_cast<unsigned long long>(audio.emptyWrites()), 100.0 * audio.frames() / (audio.sampleRate() * elapsed),
+			audio.worstDeviationSeconds() * 1000.0);
+	}
+	else if (settings.audio)
+	{
+		std::printf("Audio: none received\n");
+	}
+	if (parser.isSet("record"))
+	{
+		RecordingStats const& recording{ stats.recording };
+		double const written{ recording.bytesWritten.load() / (1024.0 * 1024.0) };
+		double const writing{ recording.writeNanoseconds.load() / 1e9 };
+		std::printf("Recording: %llu video frames and %llu audio blocks, %.1f MB at %.1f MB/s (%.1f MB/s while writing, %s); %llu frames and %llu audio blocks dropped\n",
+			static_cast<unsigned long long>(recording.videoFramesRecorded.load()), static_cast<unsigned long long>(recording.audioBlocksRecorded.load()),
+			written, written / elapsed, writing > 0.0 ? written / writing : 0.0, recording.directIo.load() ? "direct I/O" : "through the page cache",
+			static_cast<unsigned long long>(recording.videoFramesDropped.load()), static_cast<unsigned long long>(recording.audioBlocksDropped.load()));
+		if (!recorded)
+		{
+			std::printf("Recording failed: %s\n", engine.recorder().error().c_str());
+		}
+		else if (RecordingReader reader; reader.open(std::filesystem::path(parser.value("record").toStdU16String())))
+		{
+			// Read back through the index, every byte touched, to check it and to see how fast it maps in
+			auto const readStart = Clock::now();
+			uint64_t bytes{ 0 };
+			uint64_t checksum{ 0 };
+			for (auto const type : { RecordingFormat::RecordType::Video, RecordingFormat::RecordType::Audio })
+			{
+				for (auto const& entry : reader.entries(type))
+				{
+					auto const record = reader.read(entry);
+					for (size_t i = 0; i + sizeof(uint64_t) <= record.header->payloadBytes; i += sizeof(uint64_t))
+					{
+						uint64_t word;
+						std::memcpy(&word, record.payload + i, sizeof(word));
+						checksum += word;
+					}
+					bytes += record.header->payloadBytes;
+				}
+			}
+			double const readSeconds{ std::chrono::duration<double>(Clock::now() - readStart).count() };
+			std::printf("Read back: %zu video frames and %zu audio blocks, %.1f MB/s mapped (checksum %016llx)\n",
+				reader.entries(RecordingFormat::RecordType::Video).size(), reader.entries(RecordingFormat::RecordType::Audio).size(),
+				readSeconds > 0.0 ? bytes / (1024.0 * 1024.0) / readSeconds : 0.0, static_cast<unsigned long long>(checksum));
+		}
+		else
+		{
+			std::printf("Cannot read the recording back: %s\n", reader.error().c_str());
+		}
+	}
+	std::printf("%s\n", qPrintable(StatsReport::overlayText(stats)));
+
+	if (parser.isSet("stats"))
+	{
+		StatsExporter exporter{ stats };
+		exporter.setPath(parser.value("stats"));
+		exporter.exportNow();
+	}
+	return recorded ? 0 : 1;
+}
@@ -0,0 +1,227 @@
+#include "ReceiverCache.h"
+
+#include <algorithm>
+
+ReceiverCache::Lease::Lease(Lease&& other) noexcept
+	: m_cache{ other.m_cache }
+	, m_receiver{ other.m_receiver }
+	, m_reused{ other.m_reused }
+	, m_connected{ other.m_connected }
+{
+	other.m_cache = nullptr;
+	other.m_receiver = nullptr;
+	other.m_reused = false;
+	other.m_connected = {};
+}
+
+ReceiverCache::Lease& ReceiverCache::Lease::operator=(Lease&& other) noexcept
+{
+	if (this != &other)
+	{
+		reset();
+		m_cache = other.m_cache;
+		m_receiver = other.m_receiver;
+		m_reused = other.m_reused;
+		m_connected = other.m_connected;
+		other.m_cache = nullptr;
+		other.m_receiver = nullptr;
+		other.m_reused = false;
+		other.m_connected = {};
+	}
+	return *this;
+}
+
+ReceiverCache::Lease::~Lease()
+{
+	reset();
+}
+
+void ReceiverCache::Lease::reset()
+{
+	if (m_cache && m_receiver)
+	{
+		m_cache->release(m_receiver);
+	}
+	m_cache = nullptr;
+	m_receiver = nullptr;
+	m_reused = false;
+	m_connected = {};
+}
+
+void ReceiverCache::Lease::close()
+{
+	if (m_cache && m_receiver)
+	{
+		m_cache->discard(m_receiver);
+		m_cache = nullptr;
+		m_receiver = nullptr;
+	}
+	reset();
+}
+
+ReceiverCache::ReceiverCache(size_t maxConnections, std::chrono::milliseconds idleTimeout)
+	: m_maxConnections{ maxConnections }
+	, m_idleTimeout{ idleTimeout }
+{
+}
+
+ReceiverCache::~ReceiverCache()
+{
+	// Leases must not outlive the cache; whatever is left is idle, and its handle closes it
+}
+
+ReceiverCache::Lease ReceiverCache::acquire(std::string const& sourceName, NDIlib_recv_bandwidth_e const bandwidth, bool const allowFields)
+{
+	std::vector<ReceiverHandle> victims; // Destroyed once the lock is released: disconnecting takes a while too
+	{
+		std::lock_guard lock(m_mutex);
+		auto const idle = std::find_if(m_entries.begin(), m_entries.end(), [&](Entry const& entry) {
+			return !entry.leased && entry.bandwidth == bandwidth && entry.allowFields == allowFields && entry.sourceName == sourceName;
+		});
+		if (idle != m_entries.end())
+		{
+			++m_hits;
+			idle->leased = true;
+			idle->lastUsed = clock::now();
+			return Lease(this, &idle->receiver, true, idle->connected);
+		}
+		++m_misses;
+
+		// Make room before connecting, so the count only goes over the cap if everything is in use
+		if (m_maxConnections > 0)
+		{
+			trimTo(m_maxConnections - 1, victims);
+		}
+	}
+	victims.clear();
+
+	// Connecting takes a while; don't hold everyone else up meanwhile
+	NDIlib_source_t const source{ sourceName.c_str() };
+	NDIlib_recv_create_v3_t const recvSettings{ source,
+		                                        NDIlib_recv_color_format_UYVY_BGRA, // Native formats; we convert and scale in one pass ourselves
+		                                        bandwidth,
+		                                        allowFields };
+	ReceiverHandle receiver{ ReceiverHandle::create(recvSettings) };
+	if (!receiver)
+	{
+		return {};
+	}
+
+	auto const now = clock::now();
+	std::lock_guard lock(m_mutex);
+	m_entries.push_back({ sourceName, bandwidth, allowFields, std::move(receiver), true, now, now });
+	return Lease(this, &m_entries.back().receiver, false, now);
+}
+
+void ReceiverCache::release(ReceiverHandle const* const receiver)
+{
+	std::vector<ReceiverHandle> victims;
+	{
+		std::lock_guard lock(m_mutex);
+		auto const entry = std::find_if(m_entries.begin(), m_entries.end(), [&](Entry const& e) { return &e.receiver == receiver; });
+		if (entry == m_entries.end())
+		{
+			return;
+		}
+		entry->leased = false;
+		entry->lastUsed = clock::now();
+		trimTo(m_maxConnections, victims);
+	}
+}
+
+void ReceiverCache::discard(ReceiverHandle const* const receiver)
+{
+	ReceiverHandle victim; // Closed once the lock is released
+	{
+		std::lock_guard lock(m_mutex);
+		auto const entry = std::find_if(m_entries.begin(), m_entries.end(), [&](Entry const& e) { return &e.receiver == receiver; });
+		if (entry == m_entries.end())
+		{
+			return;
+		}
+		victim = std::move(entry->receiver);
+		m_entries.erase(entry);
+	}
+}
+
+void ReceiverCache::setLimits(size_t const maxConnections, std::chrono::milliseconds const idleTimeout)
+{
+	std::vector<ReceiverHandle> victims;
+	{
+		std::lock_guard lock(m_mutex);
+		m_maxConnections = maxConnections;
+		m_idleTimeout = idleTimeout;
+		trimTo(m_maxConnections, victims);
+	}
+}
+
+size_t ReceiverCache::evictIdle(clock::time_point const now)
+{
+	std::vector<ReceiverHandle> victims;
+	{
+		std::lock_guard lock(m_mutex);
+		std::erase_if(m_entries, [&](Entry& entry) {
+			bool const expired = !entry.leased && now - entry.lastUsed >= m_idleTimeout;
+			if (expired)
+			{
+				victims.push_back(std::move(entry.receiver));
+			}
+			return expired;
+		});
+	}
+	return victims.size();
+}
+
+void ReceiverCache::clear()
+{
+	std::vector<ReceiverHandle> victims;
+	{
+		std::lock_guard lock(m_mutex);
+		std::erase_if(m_entries, [&](Entry& entry) {
+			if (!entry.leased)
+			{
+				victims.push_back(std::move(entry.receiver));
+			}
+			return !entry.leased;
+		});
+	}
+}
+
+size_t ReceiverCache::openConnections() const
+{
+	std::lock_guard lock(m_mutex);
+	return m_entries.size();
+}
+
+uint64_t ReceiverCache::hits() const
+{
+	std::lock_guard lock(m_mutex);
+	return m_hits;
+}
+
+uint64_t ReceiverCache::misses() const
+{
+	std::lock_guard lock(m_mutex);
+	return m_misses;
+}
+
+void ReceiverCache::trimTo(size_t const limit, std::vector<ReceiverHandle>& victims)
+{
+	while (m_entries.size() > limit)
+	{
+		auto oldestIdle = m_entries.end();
+		for (auto entry = m_entries.begin(); entry != m_entries.end(); ++entry)
+		{
+			if (!entry->leased && (oldestIdle == m_entries.end() || entry->lastUsed < oldestIdle->lastUsed))
+			{
+				oldestIdle = entry;
+			}
+		}
+		if (oldestIdle == m_entries.end())
+		{
+			return; // Everything left is in use
+		}
+		victims.push_back(std::move(oldestIdle->receiver));
+		m_entries.erase(oldestIdle);
+	}
+}
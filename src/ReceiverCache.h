@@ -0,0 +1,119 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "NDIDeleters.h"
+
+// Keeps NDI receivers connected after use, so grabbing another frame from a source, or starting playback of
+//  one just grabbed from, doesn't pay for a new connection each time. Receivers are keyed by source name,
+//  bandwidth and whether they deliver fields, and handed out as exclusive leases; a receiver with a frame
+//  sync attached can't also be captured from directly, so two users of the same source get two connections.
+//
+// Idle receivers are closed least recently used first when a new one would take the count over the cap,
+//  and once they have been idle longer than the timeout (see evictIdle()). Leased receivers are never
+//  closed under their users, so while everything is in use the count can go over the cap. A cap of zero
+//  turns caching off: receivers are closed as soon as their lease ends.
+//
+// Safe to use from any thread.
+class ReceiverCache
+{
+public:
+    using clock = std::chrono::steady_clock;
+
+    // Exclusive use of one connected receiver, returned to the cache on destruction.
+    class Lease
+    {
+    public:
+        Lease() = default;
+        Lease(Lease&& other) noexcept;
+        Lease& operator=(Lease&& other) noexcept;
+        ~Lease();
+
+        Lease(Lease const&) = delete;
+        Lease& operator=(Lease const&) = delete;
+
+        NDIlib_recv_instance_t get() const { return m_receiver ? m_receiver->get() : nullptr; }
+        explicit operator bool() const { return m_receiver != nullptr; }
+        // The cache's handle on the receiver, to make a frame sync from; an empty handle if the lease is.
+        ReceiverHandle const& receiver() const
+        {
+            static ReceiverHandle const none;
+            return m_receiver ? *m_receiver : none;
+        }
+
+        // True if the receiver was already connected; it may have frames queued from before.
+        bool reused() const { return m_reused; }
+        // When the receiver was first connected.
+        clock::time_point connected() const { return m_connected; }
+
+        void reset();
+        // Gives the receiver back to be closed at once, rather than kept connected for reuse: for one that
+        //  won't be wanted again soon, since an idle receiver still takes its whole stream off the network.
+        void close();
+
+    private:
+        friend class ReceiverCache;
+        Lease(ReceiverCache* cache, ReceiverHandle const* receiver, bool reused, clock::time_point connected)
+            : m_cache{ cache }, m_receiver{ receiver }, m_reused{ reused }, m_connected{ connected } {}
+
+        ReceiverCache* m_cache{ nullptr };
+        ReceiverHandle const* m_receiver{ nullptr }; // Owned by the cache's entry, which stays put while leased
+        bool m_reused{ false };
+        clock::time_point m_connected;
+    };
+
+    explicit ReceiverCache(size_t maxConnections = 4, std::chrono::milliseconds idleTimeout = std::chrono::minutes(2));
+    ~ReceiverCache();
+
+    ReceiverCache(ReceiverCache const&) = delete;
+    ReceiverCache& operator=(ReceiverCache const&) = delete;
+
+    // An idle receiver for the source if there is one, otherwise a newly connected one. An empty lease if
+    //  the receiver couldn't be created. With allowFields, an interlaced source's frames can be asked for
+    //  with both fields woven together, rather than only as the SDK's progressive conversion.
+    Lease acquire(std::string const& sourceName, NDIlib_recv_bandwidth_e bandwidth, bool allowFields = false);
+
+    // Takes effect immediately; idle receivers over the new cap are closed.
+    void setLimits(size_t maxConnections, std::chrono::milliseconds idleTimeout);
+
+    // Closes receivers idle for longer than the timeout. Call now and again; returns how many were closed.
+    size_t evictIdle(clock::time_point now = clock::now());
+
+    // Closes every idle receiver.
+    void clear();
+
+    size_t openConnections() const;
+    uint64_t hits() const;
+    uint64_t misses() const;
+
+private:
+    struct Entry
+    {
+        std::string sourceName;
+        NDIlib_recv_bandwidth_e bandwidth;
+        bool allowFields;
+        ReceiverHandle receiver;
+        bool leased;
+        clock::time_point connected;
+        clock::time_point lastUsed;
+    };
+
+    void release(ReceiverHandle const* receiver);
+    void discard(ReceiverHandle const* receiver);
+    // Moves idle receivers beyond limit, least recently used first, into victims, to be destroyed once the
+    //  lock is released. Caller holds the lock.
+    void trimTo(size_t limit, std::vector<ReceiverHandle>& victims);
+
+    mutable std::mutex m_mutex;
+    std::list<Entry> m_entries; // A handful at most, so linear scans; a list so leases can point into it
+    size_t m_maxConnections;
+    std::chrono::milliseconds m_idleTimeout;
+    uint64_t m_hits{ 0 };
+    uint64_t m_misses{ 0 };
+};
@@ -0,0 +1,807 @@
+#include "ReceiverEngine.h"
+
+#include "FramePool.h"
+#include "Log.h"
+
+#include <algorithm>
+#include <thread>
+
+namespace
+{
+	// NDI timestamps are the sender's UTC clock as it sent the frame, in 100 ns units since 1970. Left at the
+	//  epoch (which the video target takes as unknown) if the sender didn't fill it in.
+	std::chrono::system_clock::time_point sentTime(int64_t const timestamp)
+	{
+		if (timestamp == NDIlib_recv_timestamp_undefined || timestamp <= 0)
+		{
+			return {};
+		}
+		return std::chrono::system_clock::time_point(std::chrono::duration_cast<std::chrono::system_clock::duration>(
+			std::chrono::duration<int64_t, std::ratio<1, 10000000>>(timestamp)));
+	}
+
+	// Video further than this from the audio clock, either way, can't be on the same timeline as it (a sender
+	//  stamping its audio and video from different clocks, say). Waiting for it, or dropping it, would only
+	//  freeze the picture, so it is shown as it comes.
+	constexpr std::chrono::seconds maxAvOffset{ 1 };
+	// The recorder and the cadence lock take 0 to mean the source didn't stamp it
+	int64_t knownTimestamp(int64_t const timestamp)
+	{
+		return timestamp == NDIlib_recv_timestamp_undefined ? 0 : timestamp;
+	}
+
+	// What to ask the frame sync for. Deinterlacing ourselves, interlaced frames come as sent, both fields
+	//  woven together; progressive sources are sent progressive whatever is asked for.
+	NDIlib_frame_format_type_e requestedFormat(DeinterlaceMode const mode)
+	{
+		return mode == DeinterlaceMode::Off ? NDIlib_frame_format_type_progressive : NDIlib_frame_format_type_interleaved;
+	}
+
+	// When the picture shown was caught: the frame's timestamp, or for its second field half a frame later
+	int64_t pictureTimestamp(NDIlib_video_frame_v2_t const& frame, bool const secondField)
+	{
+		if (!secondField || frame.timestamp == NDIlib_recv_timestamp_undefined || frame.timestamp <= 0 || frame.frame_rate_N <= 0)
+		{
+			return frame.timestamp;
+		}
+		return frame.timestamp + 5000000LL * frame.frame_rate_D / frame.frame_rate_N;
+	}
+
+	// If video is always late - it can't be converted as fast as the audio plays - show one frame in this
+	//  many rather than none at all
+	constexpr size_t maxLateRun = 4;
+}
+
+std::optional<PixelLayout> pixelLayoutFor(NDIlib_FourCC_video_type_e const fourCC)
+{
+	switch (fourCC)
+	{
+	case NDIlib_FourCC_video_type_UYVY:
+	case NDIlib_FourCC_video_type_UYVA:
+		return PixelLayout::UYVY;
+	case NDIlib_FourCC_video_type_BGRA:
+	case NDIlib_FourCC_video_type_BGRX:
+		return PixelLayout::BGRA;
+	case NDIlib_FourCC_video_type_RGBA:
+	case NDIlib_FourCC_video_type_RGBX:
+		return PixelLayout::RGBA;
+	default:
+		return std::nullopt;
+	}
+}
+
+ReceiverEngine::ReceiverEngine(VideoTarget& video, AudioTarget& audio, ReceiverCache& receivers)
+	: m_video{ video }
+	, m_audio{ audio }
+	, m_receivers{ receivers }
+{
+}
+
+ReceiverEngine::~ReceiverEngine()
+{
+	close();
+}
+
+bool ReceiverEngine::open(ReceiverSettings const& settings)
+{
+	close();
+
+	m_opened = std::chrono::steady_clock::now();
+	m_haveFirstFrame = false;
+	m_sourceName = settings.sourceName.toStdString();
+	m_receiveMode = settings.receiveMode;
+	// Direct mode takes frames however the receiver sends them, so can't ask for fields only when wanted
+	m_deinterlace = m_receiveMode == ReceiveMode::FrameSync ? settings.deinterlace : DeinterlaceMode::Off;
+	// Switching streams relies on a frame sync to run the new one alongside the old; direct mode keeps its first choice
+	m_adaptiveBandwidth = settings.adaptiveBandwidth && m_receiveMode == ReceiveMode::FrameSync;
+	m_bandwidth = settings.adaptiveBandwidth ? m_bandwidthSelector.reset(m_video.targetSize()) : settings.bandwidth;
+	m_receiver = m_receivers.acquire(m_sourceName, m_bandwidth, m_deinterlace != DeinterlaceMode::Off);
+	if (!m_receiver)
+	{
+		LOG_WARNING("NDIlib_recv_create_v3 failed");
+		return false;
+	}
+	LOG_INFO(QString("%1 %2 receiver for %3").arg(m_receiver.reused() ? "Reusing the connected" : "Connected a new")
+		.arg(m_bandwidth == NDIlib_recv_bandwidth_lowest ? "proxy" : "full").arg(settings.sourceName));
+
+	if (m_receiveMode == ReceiveMode::FrameSync)
+	{
+		m_frameSync = FrameSyncHandle::create(m_receiver.receiver());
+		if (!m_frameSync)
+		{
+			LOG_WARNING("NDIlib_framesync_create failed");
+			close();
+			return false;
+		}
+	}
+
+	m_captureInterval = std::chrono::nanoseconds(1000000000 / std::max(settings.capturesPerSecond, 1));
+	m_lockToSource = settings.lockToSource && m_receiveMode == ReceiveMode::FrameSync;
+	m_maxCapturesPerSecond = settings.maxCapturesPerSecond;
+	m_cadence.reset();
+	m_stats.captureIntervalNanoseconds.store(m_captureInterval.count(), std::memory_order_relaxed);
+	m_stats.cadenceFrameRateN.store(0, std::memory_order_relaxed);
+	m_audioEnabled.store(settings.audio, std::memory_order_relaxed);
+	m_audioSamplesCarried = 0.0;
+	m_lastVideoTimestamp = 0;
+	m_field = 0;
+	m_deinterlacer.reset();
+	m_unchangedCheck = settings.unchangedCheck;
+	m_lastPublishedSize = QSize();
+	m_avSync = settings.avSync;
+	m_meterAudio.store(settings.meterAudio, std::memory_order_relaxed);
+	m_meter.configure(0, 0); // Loudness is integrated from here
+	m_presentation.clear();
+	m_lateRun = 0;
+	m_audioIdentified = false;
+	m_audioPlayable = false;
+	return true;
+}
+
+void ReceiverEngine::close()
+{
+	if (m_audioIdentified)
+	{
+		m_audio.stop();
+		m_audioIdentified = false;
+	}
+	abandonBandwidthSwitch();
+	m_presentation.clear();
+	// The frame sync belongs to the receiver, so it goes first
+	m_frameSync.reset();
+	m_receiver.reset(); // Back to the cache, still connected
+}
+
+bool ReceiverEngine::run(ReceiverSettings const& settings, std::atomic<bool> const& stopRequested)
+{
+	if (!open(settings))
+	{
+		return false;
+	}
+
+	if (m_receiveMode == ReceiveMode::Direct)
+	{
+		receiveDirect(stopRequested);
+		close();
+		return true;
+	}
+
+	CaptureScheduler scheduler{ m_captureInterval }; // Sleeps between captures rather than spinning
+	while (auto const next = scheduler.waitForNextTick(stopRequested))       //  loop until someone external orders a stop
+	{
+		tick(*next);
+		scheduler.retime(m_captureInterval, takePhaseShift());
+	}
+	LOG_INFO(QString("Playback scheduler: %1 captures, %2 skipped, mean jitter %3 us, max jitter %4 us")
+		.arg(scheduler.ticksFired()).arg(scheduler.ticksSkipped()).arg(scheduler.meanJitter().count()).arg(scheduler.maxJitter().count()));
+	close();
+	return true;
+}
+
+void ReceiverEngine::tick(CaptureScheduler::Tick const& tick)
+{
+	m_stats.ticks.fetch_add(1, std::memory_order_relaxed);
+	m_stats.tickJitter.record(tick.jitter);
+
+	if (m_adaptiveBandwidth)
+	{
+		adaptBandwidth();
+	}
+	captureVideo();
+
+	if (m_audioEnabled.load(std::memory_order_relaxed) && m_audio.active())
+	{
+		captureAudio(tick.sinceLastTick);
+	}
+	else
+	{
+		if (m_audioIdentified)
+		{
+			// Audio was switched off (or, in multiview, another tile was selected). Let go of the audio target, so
+			//  that switching back on identifies the source's audio again rather than writing into a stopped sink.
+			m_audio.stop();
+			m_audioIdentified = false;
+		}
+		if (m_meterAudio.load(std::memory_order_relaxed) || m_recorder.recording())
+		{
+			captureUnplayedAudio(tick.sinceLastTick);
+		}
+	}
+
+	LOG_DEBUG(QString("Captured video, and audio if appropriate. Microseconds since previous capture = %1, jitter = %2 us, skipped ticks = %3")
+		.arg(tick.sinceLastTick.count()).arg(tick.jitter.count()).arg(tick.skippedTicks));
+}
+
+void ReceiverEngine::captureVideo()
+{
+	NDIlib_video_frame_v2_t video_frame;
+
+	{
+		ScopedStageTimer const timer{ m_stats.videoCapture };
+		NDIlib_framesync_capture_video(
+			m_frameSync.get(),
+			&video_frame, // Write data into here
+			requestedFormat(m_deinterlace));
+	}
+	// Deinterlaced at the field rate, each frame is shown twice, a field at a time: field 0 the first time a
+	//  capture finds it, field 1 the next
+	bool secondField{ false };
+	if (video_frame.yres > 0)
+	{
+		if (video_frame.timestamp != m_lastVideoTimestamp)
+		{
+			m_field = 0;
+		}
+		else if (m_field == 0 && fieldRate(m_deinterlace) && video_frame.frame_format_type == NDIlib_frame_format_type_interleaved)
+		{
+			m_field = 1;
+			secondField = true;
+		}
+	}
+	if (m_lockToSource && video_frame.yres > 0)
+	{
+		lockCadence(video_frame);
+	}
+	presentVideo(video_frame, secondField);
+	NDIlib_framesync_free_video(m_frameSync.get(), &video_frame);
+	presentDue();
+}
+
+void ReceiverEngine::lockCadence(NDIlib_video_frame_v2_t const& video_frame)
+{
+	// Showing each field, lock to those: twice the frame rate, the second of each pair half a frame on
+	bool const fields{ fieldRate(m_deinterlace) && video_frame.frame_format_type == NDIlib_frame_format_type_interleaved };
+	if (auto const lock = m_cadence.lockTo(fields ? video_frame.frame_rate_N * 2 : video_frame.frame_rate_N, video_frame.frame_rate_D, video_frame.frame_format_type, m_maxCapturesPerSecond))
+	{
+		m_captureInterval = lock->interval;
+		m_stats.cadenceLocks.fetch_add(1, std::memory_order_relaxed);
+		m_stats.captureIntervalNanoseconds.store(lock->interval.count(), std::memory_order_relaxed);
+		m_stats.cadenceFrameRateN.store(lock->frameRateN, std::memory_order_relaxed);
+		m_stats.cadenceFrameRateD.store(lock->frameRateD, std::memory_order_relaxed);
+		m_stats.cadenceFramesPerCapture.store(lock->framesPerTick, std::memory_order_relaxed);
+		LOG_INFO(QString("Capture locked to the source's %1 fps: every %2 frame(s), %3 us apart")
+			.arg(double(lock->frameRateN) / lock->frameRateD, 0, 'f', 3).arg(lock->framesPerTick).arg(lock->interval.count() / 1000.0, 0, 'f', 1));
+
+		// The audio target keeps enough queued to last one interval; if that got longer, start it again to suit
+		if (m_audioIdentified && m_captureInterval > m_audioInterval)
+		{
+			m_audio.stop();
+			m_audioIdentified = false;
+		}
+	}
+
+	if (auto const step = m_cadence.observe(knownTimestamp(pictureTimestamp(video_frame, fields && m_field == 1))))
+	{
+		m_stats.cadenceError.record(step->error);
+		if (step->missed)
+		{
+			m_stats.cadenceMisses.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+}
+
+std::chrono::nanoseconds ReceiverEngine::takePhaseShift()
+{
+	auto const shift = m_cadence.takePhaseShift();
+	if (shift.count() != 0)
+	{
+		m_stats.cadencePhaseShifts.fetch_add(1, std::memory_order_relaxed);
+		LOG_DEBUG(QString("Captures landing on the source's frame edges; moving them %1 us later").arg(shift.count() / 1000));
+	}
+	return shift;
+}
+
+void ReceiverEngine::receiveDirect(std::atomic<bool> const& stopRequested)
+{
+	// Audio on a thread of its own, so that neither waits on the other; the SDK queues the two separately.
+	//  Both block in the SDK until a frame arrives, with a timeout only so that a stop is noticed.
+	LOG_INFO("Receiving directly, without a frame sync");
+	std::thread audioThread{ [this, &stopRequested]() { receiveDirectAudio(stopRequested); } };
+	while (!stopRequested.load())
+	{
+		// Wake for the next queued frame's turn, if that comes before another frame arrives
+		int64_t timeoutMs{ 100 };
+		if (auto const due = m_presentation.nextDue())
+		{
+			if (auto const clock = m_audio.presentationClock())
+			{
+				timeoutMs = std::clamp<int64_t>(std::chrono::ceil<std::chrono::milliseconds>(*due - *clock).count(), 0, timeoutMs);
+			}
+		}
+
+		NDIlib_video_frame_v2_t video_frame;
+		if (NDIlib_recv_capture_v3(m_receiver.get(), &video_frame, nullptr, nullptr, static_cast<uint32_t>(timeoutMs)) == NDIlib_frame_type_video)
+		{
+			presentVideo(video_frame);
+			NDIlib_recv_free_video_v2(m_receiver.get(), &video_frame);
+		}
+		presentDue();
+	}
+	audioThread.join();
+}
+
+void ReceiverEngine::presentVideo(NDIlib_video_frame_v2_t const& video_frame, bool const secondField)
+{
+	bool newFrame{ false };
+	if (video_frame.yres > 0) // Used as proxy for knowing an actual frame of video data was captured
+	{
+		LOG_DEBUG(QString("Captured video frame, size %1x%2").arg(video_frame.yres).arg(video_frame.xres));
+
+		if (!m_haveFirstFrame)
+		{
+			auto const waited = std::chrono::steady_clock::now() - m_opened;
+			m_stats.timeToFirstFrame.record(waited);
+			m_haveFirstFrame = true;
+			LOG_INFO(QString("First video frame after %1 ms").arg(std::chrono::duration_cast<std::chrono::milliseconds>(waited).count()));
+		}
+
+		// Framesync hands back the last frame again when the source hasn't sent a new one since we asked. At
+		//  the field rate, the first time it does is for the frame's other field, so is no repeat.
+		if (video_frame.timestamp == m_lastVideoTimestamp)
+		{
+			if (!secondField)
+			{
+				m_stats.videoFramesDuplicated.fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+		else
+		{
+			m_stats.videoFramesCaptured.fetch_add(1, std::memory_order_relaxed);
+			m_lastVideoTimestamp = video_frame.timestamp;
+			newFrame = true;
+			if (m_recorder.recording())
+			{
+				recordVideo(video_frame);
+			}
+
+			// How long it took to reach us from the sender; a frame sync adds up to a tick to this, on top of its own buffering
+			if (auto const sent = sentTime(video_frame.timestamp); sent != std::chrono::system_clock::time_point{})
+			{
+				m_stats.videoSourceToCapture.record(std::max<std::chrono::nanoseconds>(std::chrono::system_clock::now() - sent, std::chrono::nanoseconds{ 0 }));
+			}
+
+			if (m_adaptiveBandwidth)
+			{
+				m_bandwidthSelector.observeFrame(m_bandwidth, QSize(video_frame.xres, video_frame.yres));
+				if (m_bandwidth == NDIlib_recv_bandwidth_lowest)
+				{
+					// What the full stream would have cost, if we have seen it
+					QSize const full{ m_bandwidthSelector.fullSize() };
+					int64_t const avoided = static_cast<int64_t>(full.width()) * full.height() - static_cast<int64_t>(video_frame.xres) * video_frame.yres;
+					m_stats.videoFramesProxy.fetch_add(1, std::memory_order_relaxed);
+					m_stats.videoPixelsAvoided.fetch_add(static_cast<uint64_t>(std::max<int64_t>(avoided, 0)), std::memory_order_relaxed);
+				}
+			}
+		}
+	}
+
+	if (auto const layout = pixelLayoutFor(video_frame.FourCC);
+		video_frame.p_data && video_frame.yres > 0 && layout)
+	{
+		// A repeat from framesync is the picture the target already has. So can a new frame be: slides, a paused
+		//  clip, a test card. Hashing costs a fraction of converting, and the seed folds in the size and format
+		//  so a change of either never matches. Sampled only reads every eighth row, so can miss a change
+		//  confined to the others; and UYVA's alpha plane isn't hashed at all.
+		bool unchanged{ !newFrame && !secondField };
+		if (newFrame && m_unchangedCheck != FrameHashMode::Off)
+		{
+			uint64_t hash;
+			{
+				ScopedStageTimer const timer{ m_stats.videoHash };
+				int const rowBytes{ video_frame.xres * (*layout == PixelLayout::UYVY ? 2 : 4) };
+				uint64_t const seed{ (static_cast<uint64_t>(video_frame.xres) << 48) ^ (static_cast<uint64_t>(video_frame.yres) << 32) ^ video_frame.FourCC };
+				hash = m_frameHasher.hash(video_frame.p_data, rowBytes, video_frame.yres, video_frame.line_stride_in_bytes, m_unchangedCheck, seed);
+			}
+			unchanged = hash == m_lastVideoHash;
+			m_lastVideoHash = hash;
+		}
+
+		QSize const fittedSize{ QSize(video_frame.xres, video_frame.yres).scaled(m_video.targetSize(), Qt::KeepAspectRatio) };
+		if (unchanged && !m_lastPublishedSize.isEmpty() && fittedSize == m_lastPublishedSize)
+		{
+			if (newFrame)
+			{
+				m_stats.videoFramesUnchanged.fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+		else if (fittedSize.isEmpty())
+		{
+			m_lastPublishedSize = QSize(); // The target no longer shows the last frame we hashed
+		}
+		else
+		{
+			// With an audio clock to go by, the frame waits in the presentation queue for its turn; without one
+			//  it is shown straight away, and anything still queued is older than it.
+			auto const sent = sentTime(pictureTimestamp(video_frame, secondField));
+			auto const clock = m_audio.presentationClock();
+			bool const hold{ m_avSync && clock && sent != std::chrono::system_clock::time_point{} };
+			if (hold)
+			{
+				// A frame can be shown up to one source frame late; with a frame sync it may also wait up to a tick to be looked at
+				std::chrono::nanoseconds const framePeriod{ video_frame.frame_rate_N > 0
+					? std::chrono::nanoseconds{ 1000000000LL * video_frame.frame_rate_D / video_frame.frame_rate_N } : std::chrono::nanoseconds{ 0 } };
+				m_lateTolerance = framePeriod + (m_receiveMode == ReceiveMode::FrameSync ? m_captureInterval : std::chrono::nanoseconds{ 0 });
+				if (m_presentation.full())
+				{
+					// The audio is further behind than the queue holds; show the oldest early rather than wait longer
+					showQueued(*m_presentation.takeOldest(), clock);
+				}
+			}
+			else
+			{
+				m_presentation.clear();
+			}
+
+			// An interlaced frame is made progressive at full size, before any scaling mixes its fields together
+			SourceFrame source{ video_frame.p_data, video_frame.xres, video_frame.yres, video_frame.line_stride_in_bytes, *layout };
+			if (m_deinterlace != DeinterlaceMode::Off && video_frame.frame_format_type == NDIlib_frame_format_type_interleaved)
+			{
+				ScopedStageTimer const timer{ m_stats.videoDeinterlace };
+				source = m_deinterlacer.deinterlace(source, m_deinterlace, m_field, newFrame);
+				m_stats.videoPicturesDeinterlaced.fetch_add(1, std::memory_order_relaxed);
+			}
+
+			// Convert and scale straight into the target's back buffer, or a queued image that will be swapped
+			//  with it. Either is only replaced when the fitted size changes, and then from the frame pool, which
+			//  gets back the buffer it replaces; so neither steady playback nor resizing churns the heap.
+			{
+				ScopedStageTimer const timer{ m_stats.videoConvert };
+				QImage& displayImage{ hold ? m_presentation.prepare(fittedSize) : m_video.backBuffer() };
+				if (displayImage.size() != fittedSize)
+				{
+					displayImage = FramePool::shared().image(fittedSize);
+				}
+				m_frameConverter.convert(source,
+					                     { displayImage.bits(), displayImage.width(), displayImage.height(), static_cast<int>(displayImage.bytesPerLine()) });
+			}
+
+			if (hold)
+			{
+				m_presentation.push(sent);
+			}
+			else
+			{
+				publishVideo(sent, clock);
+			}
+			m_lastPublishedSize = fittedSize;
+		}
+	}
+	else if (video_frame.p_data && !layout)
+	{
+		LOG_DEBUG(QString("Unsupported video format received, FourCC %1").arg(static_cast<uint>(video_frame.FourCC), 8, 16, QChar('0')));
+	}
+}
+
+void ReceiverEngine::presentDue()
+{
+	if (m_presentation.empty())
+	{
+		return;
+	}
+
+	auto const clock = m_audio.presentationClock();
+	if (!clock)
+	{
+		// The audio stopped while frames waited for it. Show the newest; the rest are out of date.
+		PresentationQueue::Frame* newest{ nullptr };
+		while (auto* const frame = m_presentation.takeOldest())
+		{
+			newest = frame;
+		}
+		showQueued(*newest, clock);
+		return;
+	}
+	if (*m_presentation.nextDue() - *clock > maxAvOffset)
+	{
+		showQueued(*m_presentation.takeOldest(), clock);
+		return;
+	}
+
+	uint64_t overtaken{ 0 };
+	PresentationQueue::Frame* const due{ m_presentation.takeDue(*clock, overtaken) };
+	m_stats.videoFramesLate.fetch_add(overtaken, std::memory_order_relaxed);
+	if (!due)
+	{
+		return;
+	}
+	auto const lateness = *clock - due->sentAt;
+	if (lateness > m_lateTolerance && lateness < maxAvOffset && m_lateRun < maxLateRun)
+	{
+		// Showing it now would put the picture behind the sound; the next frame will be along shortly
+		m_stats.videoFramesLate.fetch_add(1, std::memory_order_relaxed);
+		++m_lateRun;
+		return;
+	}
+	m_lateRun = 0;
+	showQueued(*due, clock);
+}
+
+void ReceiverEngine::showQueued(PresentationQueue::Frame& frame, std::optional<std::chrono::system_clock::time_point> const audioClock)
+{
+	// The target's old back buffer goes back to the queue, to be converted into again
+	std::swap(frame.image, m_video.backBuffer());
+	publishVideo(frame.sentAt, audioClock);
+}
+
+void ReceiverEngine::publishVideo(std::chrono::system_clock::time_point const sentAt, std::optional<std::chrono::system_clock::time_point> const audioClock)
+{
+	m_video.publishFrame(sentAt);
+	if (audioClock && sentAt != std::chrono::system_clock::time_point{})
+	{
+		auto const offset = std::chrono::duration_cast<std::chrono::microseconds>(sentAt - *audioClock);
+		m_stats.avOffset.record(offset < std::chrono::microseconds{ 0 } ? -offset : offset);
+		m_stats.avOffsetMicroseconds.store(offset.count(), std::memory_order_relaxed);
+		m_stats.avOffsetKnown.store(true, std::memory_order_relaxed);
+	}
+}
+
+void ReceiverEngine::adaptBandwidth()
+{
+	if (!m_pendingFrameSync)
+	{
+		NDIlib_recv_bandwidth_e const wanted = m_bandwidthSelector.update(m_video.targetSize(), std::chrono::steady_clock::now());
+		if (wanted == m_bandwidth)
+		{
+			return;
+		}
+		m_pendingReceiver = m_receivers.acquire(m_sourceName, wanted, m_deinterlace != DeinterlaceMode::Off);
+		m_pendingFrameSync = FrameSyncHandle::create(m_pendingReceiver.receiver()); // Empty if the receiver is
+		if (!m_pendingFrameSync)
+		{
+			LOG_WARNING("Could not connect the other stream to switch bandwidth; staying as we are");
+			abandonBandwidthSwitch();
+			m_bandwidthSelector.switched(m_bandwidth); // Restarts the dwell, rather than retrying every tick
+			return;
+		}
+		m_pendingBandwidth = wanted;
+		m_switchStarted = std::chrono::steady_clock::now();
+		LOG_INFO(QString("Switching to the %1 stream for a %2x%3 display")
+			.arg(wanted == NDIlib_recv_bandwidth_lowest ? "proxy" : "full").arg(m_video.targetSize().width()).arg(m_video.targetSize().height()));
+	}
+
+	// Keep showing the current stream until the new one has a frame
+	NDIlib_video_frame_v2_t video_frame;
+	NDIlib_framesync_capture_video(m_pendingFrameSync.get(), &video_frame, requestedFormat(m_deinterlace));
+	bool const delivered = video_frame.p_data && video_frame.yres > 0;
+	NDIlib_framesync_free_video(m_pendingFrameSync.get(), &video_frame);
+
+	auto const waited = std::chrono::steady_clock::now() - m_switchStarted;
+	if (delivered)
+	{
+		m_frameSync = std::move(m_pendingFrameSync);
+		// The old stream is closed, not kept idle in the cache: switching back waits out the selector's dwell,
+		//  and meanwhile an idle receiver would still be taking the whole stream off the network
+		m_receiver.close();
+		m_receiver = std::move(m_pendingReceiver);
+		m_bandwidth = m_pendingBandwidth;
+		m_bandwidthSelector.switched(m_bandwidth);
+		m_lastVideoTimestamp = 0;
+		m_lastPublishedSize = QSize();
+		m_stats.bandwidthSwitches.fetch_add(1, std::memory_order_relaxed);
+		LOG_INFO(QString("Switched bandwidth after %1 ms").arg(std::chrono::duration_cast<std::chrono::milliseconds>(waited).count()));
+	}
+	else if (waited > std::chrono::seconds(5))
+	{
+		LOG_WARNING("The other stream sent nothing within 5 s; staying as we are");
+		abandonBandwidthSwitch();
+		m_bandwidthSelector.switched(m_bandwidth);
+	}
+}
+
+void ReceiverEngine::abandonBandwidthSwitch()
+{
+	m_pendingFrameSync.reset();
+	m_pendingReceiver.reset();
+}
+
+void ReceiverEngine::captureAudio(std::chrono::microseconds const sinceLastCapture)
+{
+	NDIlib_audio_frame_v2_t audio_frame;
+
+	if (!m_audioIdentified) 
+	{
+		{
+			ScopedStageTimer const timer{ m_stats.audioCapture };
+			NDIlib_framesync_capture_audio(m_frameSync.get(), &audio_frame, 0, 0, 0);
+		}
+		identifyAudioParameters(audio_frame.sample_rate, audio_frame.no_channels, audio_frame.p_metadata, std::chrono::ceil<std::chrono::microseconds>(m_captureInterval));
+		m_audioInterval = m_captureInterval;
+	}
+	else if (m_audioPlayable)
+	{
+		int const numSamplesToFetchPerChannel = audioSamplesDue(sinceLastCapture, m_audioSampleRate);
+
+		{
+			ScopedStageTimer const timer{ m_stats.audioCapture };
+			NDIlib_framesync_capture_audio(
+				m_frameSync.get(), // The frame sync instance. NDILib object
+				&audio_frame, // The destination audio buffer. NDILib object 
+				m_audioSampleRate,
+				m_sourceAudioChannels, // The source's own channel layout; the audio target mixes to its own
+				numSamplesToFetchPerChannel);
+		}
+
+		// Metered as the source sent it, before the target mixes it to the device's channels
+		meterAudio(audio_frame.p_data, audio_frame.channel_stride_in_bytes, audio_frame.no_channels, audio_frame.no_samples, m_audioSampleRate);
+		recordAudio(audio_frame.p_data, audio_frame.channel_stride_in_bytes, audio_frame.no_channels, audio_frame.no_samples, m_audioSampleRate,
+		            audio_frame.timestamp, audio_frame.timecode);
+		{
+			// NDI audio is planar; the audio target interleaves, mixes and converts in one pass as it queues it.
+			ScopedStageTimer const timer{ m_stats.audioWrite };
+			m_audio.write(audio_frame.p_data, audio_frame.channel_stride_in_bytes, audio_frame.no_samples, sentTime(audio_frame.timestamp));
+		}
+		m_stats.audioUnderruns.store(m_audio.underruns(), std::memory_order_relaxed);
+		m_stats.audioBytesDropped.store(m_audio.droppedBytes(), std::memory_order_relaxed);
+		LOG_DEBUG(QString("Queued %1 audio frames. Underruns so far %2, bytes dropped so far %3")
+			.arg(audio_frame.no_samples).arg(m_audio.underruns()).arg(m_audio.droppedBytes()));
+	}
+	NDIlib_framesync_free_audio(m_frameSync.get(), &audio_frame);
+}
+
+void ReceiverEngine::captureUnplayedAudio(std::chrono::microseconds const sinceLastCapture)
+{
+	// For the meter and the recorder. Nothing is played, so any rate will do: the one the meter already has,
+	//  so that loudness carries on from when the audio was last heard, or else the source's own.
+	NDIlib_audio_frame_v2_t audio_frame;
+	int const sampleRate{ m_meter.sampleRate() };
+	if (sampleRate == 0)
+	{
+		NDIlib_framesync_capture_audio(m_frameSync.get(), &audio_frame, 0, 0, 0);
+		if (audio_frame.sample_rate > 0 && audio_frame.no_channels > 0)
+		{
+			m_meter.configure(audio_frame.no_channels, audio_frame.sample_rate);
+			m_audioSamplesCarried = 0.0;
+		}
+	}
+	else
+	{
+		int const numSamples = audioSamplesDue(sinceLastCapture, sampleRate);
+		{
+			ScopedStageTimer const timer{ m_stats.audioCapture };
+			NDIlib_framesync_capture_audio(m_frameSync.get(), &audio_frame, sampleRate, 0, numSamples); // 0: the source's channels
+		}
+		meterAudio(audio_frame.p_data, audio_frame.channel_stride_in_bytes, audio_frame.no_channels, audio_frame.no_samples, sampleRate);
+		recordAudio(audio_frame.p_data, audio_frame.channel_stride_in_bytes, audio_frame.no_channels, audio_frame.no_samples, sampleRate,
+		            audio_frame.timestamp, audio_frame.timecode);
+	}
+	NDIlib_framesync_free_audio(m_frameSync.get(), &audio_frame);
+}
+
+int ReceiverEngine::audioSamplesDue(std::chrono::microseconds const sinceLastCapture, int const sampleRate)
+{
+	// Exactly the audio that has played out since the last capture. The fraction of a sample left over is
+	//  carried to the next capture; truncating it every time would lose a steady trickle of audio.
+	double const samplesDue = sampleRate * (sinceLastCapture.count() / 1000000.0) + m_audioSamplesCarried;
+	int const samples = static_cast<int>(samplesDue);
+	m_audioSamplesCarried = samplesDue - samples;
+	return samples;
+}
+
+void ReceiverEngine::meterAudio(float const* const planar, int const channelStrideInBytes, int const channels, size_t const frames, int const sampleRate)
+{
+	if (!m_meterAudio.load(std::memory_order_relaxed) || !planar || frames == 0)
+	{
+		return;
+	}
+	ScopedStageTimer const timer{ m_stats.audioMeter };
+	if (channels != m_meter.channels() || sampleRate != m_meter.sampleRate())
+	{
+		m_meter.configure(channels, sampleRate); // A new format; its loudness starts afresh
+	}
+	m_meter.process(planar, channelStrideInBytes / sizeof(float), frames);
+}
+
+void ReceiverEngine::recordVideo(NDIlib_video_frame_v2_t const& video_frame)
+{
+	// Only the layouts asked of the SDK are recorded, as their size is known: rows at the line stride, and
+	//  for UYVA an alpha plane of xres to a row after them
+	if (!video_frame.p_data || !pixelLayoutFor(video_frame.FourCC))
+	{
+		return;
+	}
+	size_t bytes{ static_cast<size_t>(video_frame.line_stride_in_bytes) * video_frame.yres };
+	if (video_frame.FourCC == NDIlib_FourCC_video_type_UYVA)
+	{
+		bytes += static_cast<size_t>(video_frame.xres) * video_frame.yres;
+	}
+	RecordingFormat::VideoFormat const format{ static_cast<uint32_t>(video_frame.FourCC), video_frame.xres, video_frame.yres, video_frame.line_stride_in_bytes,
+		video_frame.frame_rate_N, video_frame.frame_rate_D, static_cast<uint32_t>(video_frame.frame_format_type), video_frame.picture_aspect_ratio };
+	m_recorder.recordVideo(format, knownTimestamp(video_frame.timestamp), video_frame.timecode, video_frame.p_data, bytes);
+}
+
+void ReceiverEngine::recordAudio(float const* const planar, int const channelStrideInBytes, int const channels, size_t const frames, int const sampleRate,
+                                 int64_t const timestamp, int64_t const timecode)
+{
+	if (m_recorder.recording())
+	{
+		m_recorder.recordAudio(sampleRate, channels, knownTimestamp(timestamp), timecode, planar, channelStrideInBytes / sizeof(float), frames);
+	}
+}
+
+void ReceiverEngine::receiveDirectAudio(std::atomic<bool> const& stopRequested)
+{
+	while (!stopRequested.load())
+	{
+		NDIlib_audio_frame_v3_t audio_frame;
+		if (NDIlib_recv_capture_v3(m_receiver.get(), nullptr, &audio_frame, nullptr, 100) != NDIlib_frame_type_audio)
+		{
+			continue;
+		}
+
+		if (audio_frame.FourCC == NDIlib_FourCC_audio_type_FLTP)
+		{
+			// Whether or not it is played, and at the source's rate, before any resampling for the target
+			meterAudio(reinterpret_cast<float const*>(audio_frame.p_data), audio_frame.channel_stride_in_bytes,
+			           audio_frame.no_channels, audio_frame.no_samples, audio_frame.sample_rate);
+			recordAudio(reinterpret_cast<float const*>(audio_frame.p_data), audio_frame.channel_stride_in_bytes,
+			            audio_frame.no_channels, audio_frame.no_samples, audio_frame.sample_rate, audio_frame.timestamp, audio_frame.timecode);
+		}
+
+		if (!m_audioEnabled.load(std::memory_order_relaxed) || !m_audio.active())
+		{
+			// Still taken off the SDK's queue, so turning audio back on starts from now rather than from a backlog
+			if (m_audioIdentified)
+			{
+				m_audio.stop();
+				m_audioIdentified = false;
+			}
+		}
+		else
+		{
+			// Nothing retimes the audio for us here, so a change of format has to restart the target
+			if (m_audioIdentified && (audio_frame.sample_rate != m_sourceAudioRate || audio_frame.no_channels != m_sourceAudioChannels))
+			{
+				m_audio.stop();
+				m_audioIdentified = false;
+			}
+			if (!m_audioIdentified && audio_frame.sample_rate > 0)
+			{
+				// Audio is written a frame at a time, as it comes
+				identifyAudioParameters(audio_frame.sample_rate, audio_frame.no_channels, audio_frame.p_metadata,
+					std::chrono::microseconds(1000000LL * audio_frame.no_samples / audio_frame.sample_rate));
+			}
+			if (m_audioPlayable && audio_frame.FourCC == NDIlib_FourCC_audio_type_FLTP)
+			{
+				ScopedStageTimer const timer{ m_stats.audioWrite };
+				auto const* planar = reinterpret_cast<float const*>(audio_frame.p_data);
+				if (m_audioSampleRate == audio_frame.sample_rate)
+				{
+					m_audio.write(planar, audio_frame.channel_stride_in_bytes, audio_frame.no_samples, sentTime(audio_frame.timestamp));
+				}
+				else
+				{
+					// The frame sync would have resampled this to the target's rate for us
+					auto const resampled = m_directResampler.process(planar, audio_frame.channel_stride_in_bytes / sizeof(float), audio_frame.no_samples,
+					                                                 double(m_audioSampleRate) / audio_frame.sample_rate);
+					m_audio.write(resampled.data, static_cast<int>(resampled.channelStride * sizeof(float)), resampled.frames, sentTime(audio_frame.timestamp));
+				}
+				m_stats.audioUnderruns.store(m_audio.underruns(), std::memory_order_relaxed);
+				m_stats.audioBytesDropped.store(m_audio.droppedBytes(), std::memory_order_relaxed);
+			}
+		}
+		NDIlib_recv_free_audio_v3(m_receiver.get(), &audio_frame);
+	}
+}
+
+void ReceiverEngine::identifyAudioParameters(int const sampleRate, int const channels, char const* const metadata, std::chrono::microseconds const writeInterval)
+{
+	if (channels != 0) // Used as a proxy for having real data - assume any real audio data must have at least one channel
+	{
+		LOG_INFO(QString("Audio data detected. Num channels = %1, sample rate = %2 Hz, metadata: %3")
+			.arg(channels)
+			.arg(sampleRate)
+			.arg(metadata));
+
+		m_sourceAudioChannels = channels;
+		m_sourceAudioRate = sampleRate;
+		m_audioSampleRate = m_audio.start(sampleRate, m_sourceAudioChannels, writeInterval);
+		m_audioPlayable = m_audioSampleRate > 0;
+		m_directResampler.reset(channels);
+		m_audioSamplesCarried = 0.0;
+		m_audioIdentified = true;
+	}
+	else
+	{
+		LOG_INFO("No audio captured");
+	}
+}
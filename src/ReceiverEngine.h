@@ -0,0 +1,178 @@
+#pragma once
+
+#include <QImage>
+#include <QSize>
+#include <QString>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+#include "Processing.NDI.Lib.h"
+#include "AudioMeter.h"
+#include "AudioResampler.h"
+#include "BandwidthSelector.h"
+#include "CadenceLock.h"
+#include "CaptureScheduler.h"
+#include "Deinterlace.h"
+#include "FrameHash.h"
+#include "MediaTargets.h"
+#include "NDIDeleters.h"
+#include "PresentationQueue.h"
+#include "ReceiverCache.h"
+#include "Recorder.h"
+#include "Stats.h"
+#include "VideoConvert.h"
+
+enum class ReceiveMode
+{
+    FrameSync, // Polled once per capture tick through NDI's frame sync, which retimes the source to our clock. Smooth.
+    Direct     // Each video and audio frame handled the moment it arrives, on threads that block waiting for them. Lowest latency.
+};
+
+// Everything the engine needs to know to receive a source, gathered up front on whichever thread owns
+//  the settings (the GUI thread, or the benchmark's command line) so the capture thread never asks.
+struct ReceiverSettings
+{
+    QString sourceName;
+    int capturesPerSecond{ 30 };
+    // Capture once per source frame, at the rate the source's frames say it runs at, rather than
+    //  capturesPerSecond (which holds until the first frame arrives). See CadenceLock. Frame sync mode only.
+    bool lockToSource{ false };
+    double maxCapturesPerSecond{ 0.0 }; // With lockToSource: capture every so many source frames as keeps under this (the display's refresh rate). 0 for no limit
+    // Ask an interlaced source for its frames as sent, both fields woven together, and make them progressive
+    //  here before scaling rather than leave it to the SDK. Bob and motion adaptive show each field in turn,
+    //  so want captures at the field rate: lockToSource does that. Frame sync mode only.
+    DeinterlaceMode deinterlace{ DeinterlaceMode::Off };
+    NDIlib_recv_bandwidth_e bandwidth{ NDIlib_recv_bandwidth_highest };
+    bool adaptiveBandwidth{ false }; // Ignore bandwidth; switch between proxy and full to suit the target's size
+    bool audio{ true };
+    FrameHashMode unchangedCheck{ FrameHashMode::Full }; // How new frames are compared with the last one shown, to skip converting identical ones
+    ReceiveMode receiveMode{ ReceiveMode::FrameSync };  // Direct ignores capturesPerSecond, and adaptiveBandwidth beyond the first choice
+    bool avSync{ true }; // Hold each video frame until the audio playing reaches its timestamp, if the audio target keeps a clock
+    // Measure levels and loudness into stats().audioLevels. Audio that isn't being played (switched off, or an
+    //  unselected multiview tile) is then still captured, for the meters.
+    bool meterAudio{ true };
+};
+
+// The layouts NDI can hand us when asked for NDIlib_recv_color_format_UYVY_BGRA (or the RGB variants)
+std::optional<PixelLayout> pixelLayoutFor(NDIlib_FourCC_video_type_e fourCC);
+
+// The receive pipeline: pulls video and audio from an NDI frame sync once per capture tick (or, in direct
+//  mode, takes each frame from the receiver as it arrives), converts and scales video into a VideoTarget and
+//  hands audio to an AudioTarget. Audio is the master clock: with avSync, converted video waits in a
+//  PresentationQueue until the audio target's presentation clock reaches its timestamp, and frames whose
+//  moment has passed are dropped rather than shown late. Audio is metered on its way to the target, into
+//  stats().audioLevels, and with ReceiverSettings::meterAudio even when it isn't played. While recorder() is
+//  recording, each new video frame and all the audio received are written to it as they arrive, before any
+//  conversion. Knows nothing about widgets, so it runs the same under the GUI as it does headless. Receivers
+//  come from a ReceiverCache, so playing a source that was recently captured from (or played) reuses its
+//  connection. Everything but setAudioEnabled(), setAudioMetering(), stats() and recorder() is for the
+//  capture thread only.
+class ReceiverEngine
+{
+public:
+    ReceiverEngine(VideoTarget& video, AudioTarget& audio, ReceiverCache& receivers);
+    ~ReceiverEngine();
+
+    ReceiverEngine(ReceiverEngine const&) = delete;
+    ReceiverEngine& operator=(ReceiverEngine const&) = delete;
+
+    // Connects to the source. Returns false if the NDI receiver or frame sync can't be created.
+    bool open(ReceiverSettings const& settings);
+    // One capture: the latest video frame, and the audio that has played out since the previous tick.
+    void tick(CaptureScheduler::Tick const& tick);
+    void close();
+
+    // In ReceiveMode::Direct, instead of tick(): receives until stopRequested, video on this thread and audio
+    //  on one of its own, each frame handled as soon as it arrives.
+    void receiveDirect(std::atomic<bool> const& stopRequested);
+
+    // open(), then tick() on a CaptureScheduler (or receiveDirect()) until stopRequested, then close().
+    bool run(ReceiverSettings const& settings, std::atomic<bool> const& stopRequested);
+
+    // Whoever ticks the engine retimes its ticks to these after each one (CaptureScheduler::retime()). They
+    //  only change with ReceiverSettings::lockToSource: the interval when the source's rate is first known
+    //  or changes, and a phase shift when the ticks are landing on the edge where its frames arrive.
+    std::chrono::nanoseconds captureInterval() const { return m_captureInterval; }
+    std::chrono::nanoseconds takePhaseShift();
+
+    // Any thread. Takes effect from the next tick.
+    void setAudioEnabled(bool enabled) { m_audioEnabled.store(enabled, std::memory_order_relaxed); }
+    void setAudioMetering(bool enabled) { m_meterAudio.store(enabled, std::memory_order_relaxed); }
+
+    // Any thread.
+    PipelineStats& stats() { return m_stats; }
+    Recorder& recorder() { return m_recorder; } // Started and stopped by whoever wants a recording; independent of open() and close()
+
+private:
+    void captureVideo();
+    void lockCadence(NDIlib_video_frame_v2_t const& videoFrame);
+    void presentVideo(NDIlib_video_frame_v2_t const& videoFrame, bool secondField = false);
+    void presentDue();
+    void showQueued(PresentationQueue::Frame& frame, std::optional<std::chrono::system_clock::time_point> audioClock);
+    void publishVideo(std::chrono::system_clock::time_point sentAt, std::optional<std::chrono::system_clock::time_point> audioClock);
+    void receiveDirectAudio(std::atomic<bool> const& stopRequested);
+    void adaptBandwidth();
+    void abandonBandwidthSwitch();
+    void captureAudio(std::chrono::microseconds sinceLastCapture);
+    void captureUnplayedAudio(std::chrono::microseconds sinceLastCapture);
+    int audioSamplesDue(std::chrono::microseconds sinceLastCapture, int sampleRate);
+    void meterAudio(float const* planar, int channelStrideInBytes, int channels, size_t frames, int sampleRate);
+    void recordVideo(NDIlib_video_frame_v2_t const& videoFrame);
+    void recordAudio(float const* planar, int channelStrideInBytes, int channels, size_t frames, int sampleRate, int64_t timestamp, int64_t timecode);
+    void identifyAudioParameters(int sampleRate, int channels, char const* metadata, std::chrono::microseconds writeInterval);
+
+    VideoTarget& m_video;
+    AudioTarget& m_audio;
+    ReceiverCache& m_receivers;
+    PipelineStats m_stats;
+    FrameConverter m_frameConverter;  // Colour conversion and downscale to the target, in one pass
+    FrameHasher m_frameHasher;
+    Deinterlacer m_deinterlacer;      // Interlaced frames to progressive, ahead of the converter
+
+    ReceiverCache::Lease m_receiver;
+    FrameSyncHandle m_frameSync;   // Declared after its receiver, so destroyed before it
+    std::string m_sourceName;
+    NDIlib_recv_bandwidth_e m_bandwidth{ NDIlib_recv_bandwidth_highest };
+
+    // Adaptive bandwidth. A switch connects the other stream alongside the current one, and only swaps
+    //  over once it has delivered a frame, so the picture never goes blank while it connects.
+    ReceiveMode m_receiveMode{ ReceiveMode::FrameSync };
+    bool m_adaptiveBandwidth{ false };
+    BandwidthSelector m_bandwidthSelector;
+    ReceiverCache::Lease m_pendingReceiver;
+    FrameSyncHandle m_pendingFrameSync;
+    NDIlib_recv_bandwidth_e m_pendingBandwidth{ NDIlib_recv_bandwidth_highest };
+    std::chrono::steady_clock::time_point m_switchStarted;
+    std::chrono::steady_clock::time_point m_opened;
+    bool m_haveFirstFrame{ false };
+    std::chrono::nanoseconds m_captureInterval{ 0 };
+    bool m_lockToSource{ false };
+    double m_maxCapturesPerSecond{ 0.0 };
+    CadenceLock m_cadence;
+    DeinterlaceMode m_deinterlace{ DeinterlaceMode::Off };
+    int m_field{ 0 };                      // Of the frame last captured, the field shown last
+    std::atomic<bool> m_audioEnabled{ true };
+
+    int64_t m_lastVideoTimestamp{ 0 };     // Spots framesync handing back the same frame
+    FrameHashMode m_unchangedCheck{ FrameHashMode::Full };
+    uint64_t m_lastVideoHash{ 0 };         // Of the last new frame, to spot a source sending the same picture again
+    QSize m_lastPublishedSize;             // Empty unless the target is showing (or has queued) the last frame captured
+    bool m_avSync{ true };
+    PresentationQueue m_presentation;
+    std::chrono::nanoseconds m_lateTolerance{ 0 }; // How far past its time a frame may still be shown
+    size_t m_lateRun{ 0 };                 // Frames dropped as late in a row
+    bool m_audioIdentified{ false };
+    std::chrono::nanoseconds m_audioInterval{ 0 }; // The capture interval the audio target was started for
+    bool m_audioPlayable{ false };
+    int m_audioSampleRate{ 0 };            // What the audio target asked for
+    int m_sourceAudioChannels{ 0 };
+    int m_sourceAudioRate{ 0 };
+    AudioResampler m_directResampler;      // Direct mode gets audio at the source's rate, which the target may not take
+    std::atomic<bool> m_meterAudio{ true };
+    AudioMeter m_meter{ m_stats.audioLevels }; // On the capture thread, or in direct mode the audio thread
+    Recorder m_recorder{ m_stats };
+    double m_audioSamplesCarried{ 0.0 };   // Fraction of a sample owed to the next audio capture
+};
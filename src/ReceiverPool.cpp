@@ -0,0 +1,147 @@
+#include "ReceiverPool.h"
+
+#include <algorithm>
+
+#include "Log.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <timeapi.h>
+#endif
+
+namespace
+{
+	constexpr std::chrono::seconds reopenInterval{ 5 }; // How long to wait before trying a source that failed to open again
+}
+
+ReceiverPool::ReceiverPool(size_t const threads)
+	: m_threadCount{ threads > 0 ? threads : std::max(2u, std::thread::hardware_concurrency()) - 1 }
+{
+}
+
+ReceiverPool::~ReceiverPool()
+{
+	stop();
+}
+
+void ReceiverPool::add(ReceiverEngine& engine, ReceiverSettings const& settings)
+{
+	auto const interval = std::chrono::nanoseconds(1000000000 / std::max(settings.capturesPerSecond, 1));
+	m_slots.push_back({ &engine, settings, interval });
+}
+
+void ReceiverPool::start()
+{
+	stop();
+	m_stopping = false;
+
+#ifdef _WIN32
+	// As for CaptureScheduler: the default timer granularity is coarser than the capture intervals
+	timeBeginPeriod(1);
+#endif
+
+	// Stagger the first ticks across one interval, so a wall of sources at the same rate doesn't have
+	//  every receiver due at the same instant
+	auto const now = clock::now();
+	for (size_t i = 0; i < m_slots.size(); ++i)
+	{
+		m_slots[i].opened = false;
+		m_due.push({ now + m_slots[i].interval * i / std::max<size_t>(m_slots.size(), 1), i });
+	}
+
+	size_t const threads = std::min(m_threadCount, std::max<size_t>(m_slots.size(), 1));
+	for (size_t i = 0; i < threads; ++i)
+	{
+		m_threads.emplace_back(&ReceiverPool::work, this);
+	}
+	LOG_INFO(QString("Receiver pool started: %1 sources on %2 threads").arg(m_slots.size()).arg(threads));
+}
+
+void ReceiverPool::stop()
+{
+	if (m_threads.empty())
+	{
+		return;
+	}
+	{
+		std::lock_guard lock(m_mutex);
+		m_stopping = true;
+	}
+	m_wake.notify_all();
+	for (auto& thread : m_threads)
+	{
+		thread.join();
+	}
+	m_threads.clear();
+	m_due = {};
+
+	for (auto& slot : m_slots)
+	{
+		slot.engine->close();
+	}
+#ifdef _WIN32
+	timeEndPeriod(1);
+#endif
+	LOG_INFO(QString("Receiver pool stopped: %1 ticks, %2 skipped").arg(ticksFired()).arg(ticksSkipped()));
+}
+
+void ReceiverPool::work()
+{
+	std::unique_lock lock(m_mutex);
+	while (!m_stopping)
+	{
+		if (m_due.empty())
+		{
+			m_wake.wait(lock);
+			continue;
+		}
+		Due const due = m_due.top();
+		if (clock::now() < due.deadline)
+		{
+			// Woken early if a stop comes in, or another worker pushes an earlier deadline
+			m_wake.wait_until(lock, due.deadline);
+			continue;
+		}
+		m_due.pop();
+
+		lock.unlock();
+		clock::time_point const next = runSlot(m_slots[due.slot], due.deadline);
+		lock.lock();
+
+		m_due.push({ next, due.slot });
+		m_wake.notify_one(); // The new deadline may be earlier than the one another worker is waiting for
+	}
+}
+
+ReceiverPool::clock::time_point ReceiverPool::runSlot(Slot& slot, clock::time_point const deadline)
+{
+	auto const now = clock::now();
+	if (!slot.opened)
+	{
+		slot.opened = slot.engine->open(slot.settings);
+		if (!slot.opened)
+		{
+			LOG_WARNING(QString("Could not open %1; trying again in %2 s").arg(slot.settings.sourceName).arg(reopenInterval.count()));
+			return clock::now() + reopenInterval;
+		}
+		slot.lastTick = clock::now();
+		slot.interval = slot.engine->captureInterval();
+		return slot.lastTick + slot.interval;
+	}
+
+	// Deadlines stay on the slot's grid. If we are a whole interval or more behind, skip the missed ones
+	//  rather than firing them back to back.
+	auto const late = std::chrono::duration_cast<std::chrono::microseconds>(now - deadline);
+	auto const skipped = static_cast<uint32_t>(late / slot.interval);
+	CaptureScheduler::Tick const tick{ std::chrono::duration_cast<std::chrono::microseconds>(now - slot.lastTick), late, skipped };
+	slot.lastTick = now;
+
+	slot.engine->tick(tick);
+
+	m_ticksFired.fetch_add(1, std::memory_order_relaxed);
+	m_ticksSkipped.fetch_add(skipped, std::memory_order_relaxed);
+	// A capture locked to its source retimes itself, as for CaptureScheduler::retime()
+	slot.interval = slot.engine->captureInterval();
+	return deadline + slot.interval * (skipped + 1) + slot.engine->takePhaseShift();
+}
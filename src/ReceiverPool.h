@@ -0,0 +1,78 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+#include "ReceiverEngine.h"
+
+// Runs the capture ticks of many receivers on a fixed number of threads, rather than a thread per
+//  receiver. Every receiver has its own deadline grid, like CaptureScheduler's; the deadlines of all of
+//  them sit in one min-heap, and whichever worker is free takes the earliest that is due. A receiver is
+//  only ever in the heap once, so its ticks never overlap and it needs no locking of its own.
+//
+// Opening a receiver (which can take a while) happens on a worker too, so starting a wall of sources
+//  doesn't block whoever starts it. A receiver that fails to open is tried again every few seconds.
+class ReceiverPool
+{
+public:
+    using clock = std::chrono::steady_clock;
+
+    // threads == 0 means one per core, less one for the GUI.
+    explicit ReceiverPool(size_t threads = 0);
+    ~ReceiverPool();
+
+    ReceiverPool(ReceiverPool const&) = delete;
+    ReceiverPool& operator=(ReceiverPool const&) = delete;
+
+    // Before start(). The engine must outlive the pool's use of it.
+    void add(ReceiverEngine& engine, ReceiverSettings const& settings);
+
+    void start();
+    // Blocks until the workers have finished their current ticks, then closes every engine.
+    void stop();
+
+    size_t threadCount() const { return m_threadCount; }
+    uint64_t ticksFired() const { return m_ticksFired.load(std::memory_order_relaxed); }
+    uint64_t ticksSkipped() const { return m_ticksSkipped.load(std::memory_order_relaxed); }
+
+private:
+    struct Slot
+    {
+        ReceiverEngine* engine;
+        ReceiverSettings settings;
+        std::chrono::nanoseconds interval;   // The engine's, which a capture locked to its source changes
+        bool opened{ false };
+        clock::time_point lastTick{};
+    };
+
+    struct Due
+    {
+        clock::time_point deadline;
+        size_t slot;
+
+        bool operator>(Due const& other) const { return deadline > other.deadline; }
+    };
+
+    void work();
+    // Returns the slot's next deadline.
+    clock::time_point runSlot(Slot& slot, clock::time_point deadline);
+
+    std::vector<Slot> m_slots;
+    size_t m_threadCount;
+    std::vector<std::thread> m_threads;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::priority_queue<Due, std::vector<Due>, std::greater<Due>> m_due;
+    bool m_stopping{ false };
+
+    std::atomic<uint64_t> m_ticksFired{ 0 };
+    std::atomic<uint64_t> m_ticksSkipped{ 0 };
+};
@@ -0,0 +1,531 @@
+#include "Recorder.h"
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace RecordingFormat;
+
+namespace
+{
+	constexpr size_t pendingIndexEntries = 16384; // Index entries the writer hasn't collected yet; thousands of records' worth of buffers
+	constexpr int maxAudioChannels = 64;
+
+	int64_t steadyNanoseconds()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	// NDI's timestamp units
+	int64_t utcNow()
+	{
+		return std::chrono::duration_cast<std::chrono::duration<int64_t, std::ratio<1, 10000000>>>(std::chrono::system_clock::now().time_since_epoch()).count();
+	}
+
+	void raiseToAtLeast(std::atomic<uint64_t>& value, uint64_t const candidate)
+	{
+		uint64_t current{ value.load(std::memory_order_relaxed) };
+		while (candidate > current && !value.compare_exchange_weak(current, candidate, std::memory_order_relaxed))
+		{
+		}
+	}
+
+	uint8_t const zeros[recordAlignment]{};
+}
+
+Recorder::Recorder(PipelineStats& stats, size_t const buffers)
+	: m_stats{ stats }
+	, m_bufferCount{ std::max<size_t>(buffers, 2) }
+	, m_free{ m_bufferCount }
+	, m_filled{ m_bufferCount }
+	, m_pendingIndex{ pendingIndexEntries }
+{
+}
+
+Recorder::~Recorder()
+{
+	stop();
+}
+
+bool Recorder::start(std::filesystem::path const& path, std::string const& sourceName)
+{
+	std::lock_guard const control{ m_controlMutex };
+	finish();
+
+	{
+		std::lock_guard const lock{ m_errorMutex };
+		m_error.clear();
+	}
+	m_failed.store(false, std::memory_order_relaxed);
+	if (!openFile(path))
+	{
+		return false;
+	}
+
+	// The header goes first, unfinished, so a recording cut short is still recognisably one
+	m_buffers = static_cast<uint8_t*>(::operator new(m_bufferCount * bufferBytes, std::align_val_t{ fileAlignment }));
+	m_header = {};
+	std::memcpy(m_header.magic, magic, sizeof(magic));
+	m_header.version = version;
+	m_header.headerBytes = fileAlignment;
+	m_header.startedAt = utcNow();
+	std::memcpy(m_header.sourceName, sourceName.data(), std::min(sourceName.size(), sizeof(m_header.sourceName) - 1));
+	std::memset(m_buffers, 0, fileAlignment);
+	std::memcpy(m_buffers, &m_header, sizeof(m_header));
+	if (!writeAt(0, m_buffers, fileAlignment))
+	{
+		closeFile();
+		::operator delete(m_buffers, std::align_val_t{ fileAlignment });
+		m_buffers = nullptr;
+		return false;
+	}
+
+	for (size_t i = 0; i < m_bufferCount; ++i)
+	{
+		uint8_t* const buffer{ m_buffers + i * bufferBytes };
+		m_free.write(&buffer, 1);
+	}
+	m_current = nullptr;
+	m_currentFill = 0;
+	m_recordOffset = fileAlignment;
+	m_writeOffset = fileAlignment;
+	m_index.clear();
+
+	RecordingStats& stats{ m_stats.recording };
+	stats.directIo.store(m_directIo, std::memory_order_relaxed);
+	stats.videoFramesRecorded.store(0, std::memory_order_relaxed);
+	stats.videoFramesDropped.store(0, std::memory_order_relaxed);
+	stats.audioBlocksRecorded.store(0, std::memory_order_relaxed);
+	stats.audioBlocksDropped.store(0, std::memory_order_relaxed);
+	stats.bytesWritten.store(0, std::memory_order_relaxed);
+	stats.writeNanoseconds.store(0, std::memory_order_relaxed);
+	stats.buffersQueuedPeak.store(0, std::memory_order_relaxed);
+	stats.startedAt.store(steadyNanoseconds(), std::memory_order_relaxed);
+	stats.stoppedAt.store(0, std::memory_order_relaxed);
+	stats.active.store(true, std::memory_order_relaxed);
+
+	m_finishing.store(false, std::memory_order_relaxed);
+	m_writer = std::thread{ [this]() { writeLoop(); } };
+	m_recording.store(true, std::memory_order_release);
+	return true;
+}
+
+bool Recorder::stop()
+{
+	std::lock_guard const control{ m_controlMutex };
+	finish();
+	return !m_failed.load(std::memory_order_relaxed);
+}
+
+void Recorder::finish()
+{
+	if (!m_writer.joinable())
+	{
+		return;
+	}
+
+	{
+		// The last buffer goes out part full, padded to where the file's next aligned write can start
+		std::lock_guard const lock{ m_producerMutex };
+		m_recording.store(false, std::memory_order_release);
+		if (m_current)
+		{
+			size_t const padded{ roundUp(m_currentFill, fileAlignment) };
+			std::memset(m_current + m_currentFill, 0, padded - m_currentFill);
+			pushCurrent(padded);
+		}
+		m_header.dataBytes = m_recordOffset - fileAlignment;
+	}
+
+	m_finishing.store(true, std::memory_order_release);
+	{
+		std::lock_guard const lock{ m_wakeMutex };
+	}
+	m_wake.notify_one();
+	m_writer.join();
+
+	closeFile();
+	m_free.discard(m_free.available());
+	::operator delete(m_buffers, std::align_val_t{ fileAlignment });
+	m_buffers = nullptr;
+	m_stats.recording.stoppedAt.store(steadyNanoseconds(), std::memory_order_relaxed);
+	m_stats.recording.active.store(false, std::memory_order_relaxed);
+}
+
+std::string Recorder::error() const
+{
+	std::lock_guard const lock{ m_errorMutex };
+	return m_error;
+}
+
+void Recorder::fail(std::string const& reason)
+{
+	{
+		std::lock_guard const lock{ m_errorMutex };
+		if (m_error.empty())
+		{
+			m_error = reason;
+		}
+	}
+	m_failed.store(true, std::memory_order_relaxed);
+}
+
+bool Recorder::recordVideo(VideoFormat const& format, int64_t const timestamp, int64_t const timecode, uint8_t const* const data, size_t const bytes)
+{
+	if (!recording() || !data || bytes == 0)
+	{
+		return false;
+	}
+
+	ScopedStageTimer const timer{ m_stats.recordCopy };
+	RecordHeader header{};
+	header.type = RecordType::Video;
+	header.timestamp = timestamp > 0 ? timestamp : utcNow();
+	header.timecode = timecode;
+	header.video = format;
+
+	std::lock_guard const lock{ m_producerMutex };
+	if (!append(header, bytes))
+	{
+		m_stats.recording.videoFramesDropped.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+	put(data, bytes);
+	finishRecord(bytes);
+	m_stats.recording.videoFramesRecorded.fetch_add(1, std::memory_order_relaxed);
+	return true;
+}
+
+bool Recorder::recordAudio(int const sampleRate, int const channels, int64_t const timestamp, int64_t const timecode,
+                           float const* const planar, size_t const channelStride, size_t const frames)
+{
+	if (!recording() || !planar || frames == 0 || channels <= 0 || channels > maxAudioChannels)
+	{
+		return false;
+	}
+
+	ScopedStageTimer const timer{ m_stats.recordCopy };
+	RecordHeader header{};
+	header.type = RecordType::Audio;
+	header.timestamp = timestamp > 0 ? timestamp : utcNow();
+	header.timecode = timecode;
+	header.audio = { sampleRate, channels, static_cast<int32_t>(frames), {} };
+	size_t const frameBytes{ channels * sizeof(float) };
+	size_t const bytes{ frames * frameBytes };
+
+	std::lock_guard const lock{ m_producerMutex };
+	if (!append(header, bytes))
+	{
+		m_stats.recording.audioBlocksDropped.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+	if (m_interleaver.inputChannels() != channels)
+	{
+		m_interleaver.configure(channels, channels, SampleFormat::Float);
+	}
+
+	// Interleaved straight into the buffers, a buffer's worth at a time. A buffer boundary can fall within a
+	//  frame; that one frame goes through the stack.
+	size_t done{ 0 };
+	while (done < frames)
+	{
+		takeBuffer();
+		size_t const fit{ std::min(frames - done, (bufferBytes - m_currentFill) / frameBytes) };
+		if (fit > 0)
+		{
+			m_interleaver.convert(planar + done, channelStride, fit, m_current + m_currentFill);
+			m_currentFill += fit * frameBytes;
+			done += fit;
+			if (m_currentFill == bufferBytes)
+			{
+				pushCurrent(bufferBytes);
+			}
+		}
+		else
+		{
+			uint8_t frame[maxAudioChannels * sizeof(float)];
+			m_interleaver.convert(planar + done, channelStride, 1, frame);
+			put(frame, frameBytes);
+			++done;
+		}
+	}
+	finishRecord(bytes);
+	m_stats.recording.audioBlocksRecorded.fetch_add(1, std::memory_order_relaxed);
+	return true;
+}
+
+bool Recorder::append(RecordHeader& header, size_t const payloadBytes)
+{
+	// Checked against the recording having stopped under the lock, as well as before taking it
+	if (!m_recording.load(std::memory_order_relaxed) || m_failed.load(std::memory_order_relaxed))
+	{
+		return false;
+	}
+	// The buffers only ever come back while this waits, so a record that fits now still will
+	size_t const room{ (m_current ? bufferBytes - m_currentFill : 0) + m_free.available() * bufferBytes };
+	if (recordBytes(payloadBytes) > room || m_pendingIndex.freeSpace() == 0)
+	{
+		return false;
+	}
+
+	header.marker = recordMarker;
+	header.payloadBytes = payloadBytes;
+	IndexEntry const entry{ m_recordOffset, header.timestamp, header.type, 0 };
+	m_pendingIndex.write(&entry, 1);
+	put(&header, sizeof(header));
+	return true;
+}
+
+void Recorder::put(void const* const bytes, size_t count)
+{
+	auto const* from = static_cast<uint8_t const*>(bytes);
+	while (count > 0)
+	{
+		takeBuffer();
+		size_t const piece{ std::min(count, bufferBytes - m_currentFill) };
+		std::memcpy(m_current + m_currentFill, from, piece);
+		m_currentFill += piece;
+		from += piece;
+		count -= piece;
+		if (m_currentFill == bufferBytes)
+		{
+			pushCurrent(bufferBytes);
+		}
+	}
+}
+
+void Recorder::finishRecord(size_t const payloadBytes)
+{
+	put(zeros, roundUp(payloadBytes, recordAlignment) - payloadBytes);
+	m_recordOffset += recordBytes(payloadBytes);
+}
+
+void Recorder::takeBuffer()
+{
+	if (!m_current)
+	{
+		m_free.read(&m_current, 1); // append() made sure there is one
+		m_currentFill = 0;
+	}
+}
+
+void Recorder::pushCurrent(size_t const bytes)
+{
+	Filled const filled{ m_current, bytes };
+	m_filled.write(&filled, 1);
+	m_current = nullptr;
+	raiseToAtLeast(m_stats.recording.buffersQueuedPeak, m_filled.available());
+
+	// Taking the lock, however briefly, means the writer is either yet to look or already waiting
+	{
+		std::lock_guard const lock{ m_wakeMutex };
+	}
+	m_wake.notify_one();
+}
+
+void Recorder::writeLoop()
+{
+	for (;;)
+	{
+		Filled filled;
+		if (m_filled.read(&filled, 1) == 1)
+		{
+			if (!m_failed.load(std::memory_order_relaxed))
+			{
+				auto const started = std::chrono::steady_clock::now();
+				if (writeAt(m_writeOffset, filled.data, filled.bytes))
+				{
+					auto const took = std::chrono::steady_clock::now() - started;
+					m_stats.recordWrite.record(took);
+					m_stats.recording.writeNanoseconds.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(took).count(), std::memory_order_relaxed);
+					m_stats.recording.bytesWritten.fetch_add(filled.bytes, std::memory_order_relaxed);
+				}
+			}
+			m_writeOffset += filled.bytes;
+			m_free.write(&filled.data, 1);
+			drainIndex();
+			continue;
+		}
+
+		drainIndex();
+		if (m_finishing.load(std::memory_order_acquire))
+		{
+			if (m_filled.available() == 0)
+			{
+				break;
+			}
+			continue;
+		}
+		std::unique_lock lock{ m_wakeMutex };
+		m_wake.wait(lock, [this]() { return m_filled.available() > 0 || m_finishing.load(std::memory_order_acquire); });
+	}
+
+	if (!m_failed.load(std::memory_order_relaxed))
+	{
+		writeIndexAndHeader();
+	}
+}
+
+void Recorder::drainIndex()
+{
+	IndexEntry entries[256];
+	while (size_t const count = m_pendingIndex.read(entries, std::size(entries)))
+	{
+		m_index.insert(m_index.end(), entries, entries + count);
+	}
+}
+
+void Recorder::writeIndexAndHeader()
+{
+	// Every buffer is back by now, so they serve as aligned scratch for the index, a buffer's worth at a time
+	m_header.indexOffset = m_writeOffset;
+	m_header.indexEntries = m_index.size();
+	size_t const indexBytes{ m_index.size() * sizeof(IndexEntry) };
+	auto const* index = reinterpret_cast<uint8_t const*>(m_index.data());
+	for (size_t written = 0; written < indexBytes;)
+	{
+		size_t const piece{ std::min(indexBytes - written, bufferBytes) };
+		size_t const padded{ roundUp(piece, fileAlignment) };
+		std::memcpy(m_buffers, index + written, piece);
+		std::memset(m_buffers + piece, 0, padded - piece);
+		if (!writeAt(m_writeOffset, m_buffers, padded))
+		{
+			return;
+		}
+		m_writeOffset += padded;
+		written += piece;
+	}
+
+	std::memset(m_buffers, 0, fileAlignment);
+	std::memcpy(m_buffers, &m_header, sizeof(m_header));
+	if (writeAt(0, m_buffers, fileAlignment))
+	{
+		// Writes around the cache are on the device already, but the file's size and layout may not be
+#ifdef _WIN32
+		FlushFileBuffers(m_file);
+#else
+		::fsync(m_file);
+#endif
+	}
+}
+
+#ifdef _WIN32
+
+bool Recorder::openFile(std::filesystem::path const& path)
+{
+	// Unbuffered writes have to be sector aligned; every write here is aligned to 4096, which covers every
+	//  sector size in use
+	for (DWORD const flags : { DWORD{ FILE_FLAG_NO_BUFFERING }, DWORD{ 0 } })
+	{
+		HANDLE const file = CreateFileW(path.c_str(), GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL | flags, nullptr);
+		if (file != INVALID_HANDLE_VALUE)
+		{
+			m_file = file;
+			m_directIo = flags != 0;
+			return true;
+		}
+	}
+	fail("Cannot create " + path.string() + ": error " + std::to_string(GetLastError()));
+	return false;
+}
+
+void Recorder::closeFile()
+{
+	if (m_file)
+	{
+		CloseHandle(m_file);
+		m_file = nullptr;
+	}
+}
+
+bool Recorder::writeAt(uint64_t const offset, void const* const data, size_t const bytes)
+{
+	OVERLAPPED overlapped{};
+	overlapped.Offset = static_cast<DWORD>(offset);
+	overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+	DWORD written{ 0 };
+	if (!WriteFile(m_file, data, static_cast<DWORD>(bytes), &written, &overlapped) || written != bytes)
+	{
+		fail("Writing the recording failed: error " + std::to_string(GetLastError()));
+		return false;
+	}
+	return true;
+}
+
+#else
+
+bool Recorder::openFile(std::filesystem::path const& path)
+{
+	int const flags{ O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC };
+	m_directIo = false;
+#ifdef O_DIRECT
+	// Some file systems (tmpfs, some network ones) refuse O_DIRECT outright; those go through the page cache
+	m_file = ::open(path.c_str(), flags | O_DIRECT, 0644);
+	m_directIo = m_file >= 0;
+#endif
+	if (m_file < 0)
+	{
+		m_file = ::open(path.c_str(), flags, 0644);
+	}
+	if (m_file < 0)
+	{
+		fail("Cannot create " + path.string() + ": " + std::strerror(errno));
+		return false;
+	}
+#ifdef __APPLE__
+	m_directIo = ::fcntl(m_file, F_NOCACHE, 1) != -1;
+#endif
+	return true;
+}
+
+void Recorder::closeFile()
+{
+	if (m_file >= 0)
+	{
+		::close(m_file);
+		m_file = -1;
+	}
+}
+
+bool Recorder::writeAt(uint64_t offset, void const* const data, size_t bytes)
+{
+	auto const* from = static_cast<uint8_t const*>(data);
+	while (bytes > 0)
+	{
+		ssize_t const written{ ::pwrite(m_file, from, bytes, static_cast<off_t>(offset)) };
+		if (written < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+#ifdef O_DIRECT
+			if (errno == EINVAL && m_directIo)
+			{
+				// Took O_DIRECT at open, but wants a larger alignment than ours. Through the page cache, then.
+				::fcntl(m_file, F_SETFL, ::fcntl(m_file, F_GETFL) & ~O_DIRECT);
+				m_directIo = false;
+				m_stats.recording.directIo.store(false, std::memory_order_relaxed);
+				continue;
+			}
+#endif
+			fail(std::string("Writing the recording failed: ") + std::strerror(errno));
+			return false;
+		}
+		from += written;
+		offset += static_cast<uint64_t>(written);
+		bytes -= static_cast<size_t>(written);
+	}
+	return true;
+}
+
+#endif
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "AudioConvert.h"
+#include "RecordingFormat.h"
+#include "SpscRingBuffer.h"
+#include "Stats.h"
+
+// Writes received video and audio to a recording file (see RecordingFormat.h) without the capture path
+//  ever waiting on the disk.
+//
+// The capture path copies each frame straight into one of a fixed set of large buffers, the only copy
+//  made on the way to disk, and hands full buffers over a bounded queue to a thread of the recorder's own.
+//  That thread writes each buffer whole, at an aligned offset, with the OS's page cache bypassed where the
+//  file system allows it (O_DIRECT, F_NOCACHE, FILE_FLAG_NO_BUFFERING), then hands it back. When the disk
+//  falls behind far enough that no buffer is free, frames are dropped and counted rather than waited for.
+//  The buffers exist only while recording.
+//
+// The counts are in PipelineStats::recording; copying frames in is timed into recordCopy, each write to
+//  disk into recordWrite. start() and stop() are for any one thread at a time; recordVideo() and
+//  recordAudio() for any thread, as the direct receive mode's video and audio threads both record.
+class Recorder
+{
+public:
+    static constexpr size_t bufferBytes = 4 * 1024 * 1024;
+
+    explicit Recorder(PipelineStats& stats, size_t buffers = 16);
+    ~Recorder();
+
+    Recorder(Recorder const&) = delete;
+    Recorder& operator=(Recorder const&) = delete;
+
+    // Starts a new file, stopping any recording first. Returns false, with the reason in error(), if the
+    //  file can't be created.
+    bool start(std::filesystem::path const& path, std::string const& sourceName);
+    // Writes out what is buffered, then the index. Returns false, with the reason in error(), if any of
+    //  the recording failed to write.
+    bool stop();
+
+    // Any thread
+    bool recording() const { return m_recording.load(std::memory_order_acquire); }
+    std::string error() const;
+
+    // Returns false if the frame was dropped (or nothing is recording). timestamp is the source's, in NDI's
+    //  100 ns units; if it didn't set one, pass 0 and the time now is used instead.
+    bool recordVideo(RecordingFormat::VideoFormat const& format, int64_t timestamp, int64_t timecode, uint8_t const* data, size_t bytes);
+    // Planar, as NDI delivers it; recorded interleaved
+    bool recordAudio(int sampleRate, int channels, int64_t timestamp, int64_t timecode, float const* planar, size_t channelStride, size_t frames);
+
+private:
+    struct Filled
+    {
+        uint8_t* data;
+        size_t bytes; // Padded to RecordingFormat::fileAlignment when the last one is only part full
+    };
+
+    void finish();
+    bool openFile(std::filesystem::path const& path);
+    void closeFile();
+    bool append(RecordingFormat::RecordHeader& header, size_t payloadBytes);
+    void put(void const* bytes, size_t count);
+    void finishRecord(size_t payloadBytes);
+    void takeBuffer();
+    void pushCurrent(size_t bytes);
+    void fail(std::string const& reason);
+    void writeLoop();
+    void drainIndex();
+    bool writeAt(uint64_t offset, void const* data, size_t bytes);
+    void writeIndexAndHeader();
+
+    PipelineStats& m_stats;
+    size_t const m_bufferCount;
+
+    std::mutex m_controlMutex;       // start() and stop()
+    std::atomic<bool> m_recording{ false };
+
+    // The capture side. Records from the video and audio threads are kept whole and in order by the lock;
+    //  it is only ever held for a copy into memory.
+    std::mutex m_producerMutex;
+    uint8_t* m_buffers{ nullptr };   // m_bufferCount of bufferBytes, aligned to fileAlignment
+    uint8_t* m_current{ nullptr };   // Being filled
+    size_t m_currentFill{ 0 };
+    uint64_t m_recordOffset{ 0 };    // Where the next record goes in the file
+    AudioFrameConverter m_interleaver; // Audio goes straight from NDI's planar frame into the buffers
+
+    // Between the two sides. Neither blocks: the capture side takes free buffers and gives full ones, the
+    //  writer the other way round.
+    SpscRingBuffer<uint8_t*> m_free;
+    SpscRingBuffer<Filled> m_filled;
+    SpscRingBuffer<RecordingFormat::IndexEntry> m_pendingIndex;
+    std::mutex m_wakeMutex;
+    std::condition_variable m_wake;
+    std::atomic<bool> m_finishing{ false };
+    std::thread m_writer;
+
+    // The writer's
+#ifdef _WIN32
+    void* m_file{ nullptr };
+#else
+    int m_file{ -1 };
+#endif
+    bool m_directIo{ false };
+    uint64_t m_writeOffset{ 0 };
+    std::vector<RecordingFormat::IndexEntry> m_index;
+    RecordingFormat::FileHeader m_header{};
+    std::atomic<bool> m_failed{ false };
+    mutable std::mutex m_errorMutex;
+    std::string m_error;
+};
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+// The layout of a recording file, as Recorder writes it and RecordingReader reads it. Everything is
+//  little endian, as it is in memory on every machine this runs on.
+//
+//  offset 0:            FileHeader, padded to fileAlignment
+//  headerBytes:         records, one after another, each a RecordHeader and its payload padded to
+//                       recordAlignment, up to headerBytes + dataBytes
+//  indexOffset:         indexEntries IndexEntry, one per record in file order
+//
+// The index and the final figures in the header are written when recording stops. A file that was never
+//  finished (a crash, the disk filling) has an indexOffset of 0; its records are all still there, and a
+//  reader finds them by walking from one to the next.
+namespace RecordingFormat
+{
+    constexpr char magic[8]{ 'N', 'D', 'I', 'R', 'E', 'C', '0', '1' };
+    constexpr uint32_t version = 1;
+    constexpr uint32_t recordMarker = 0x4345524e; // "NREC"
+
+    // Writes around the page cache have to start, end and sit in memory on the device's block boundaries
+    constexpr size_t fileAlignment = 4096;
+    // Payloads start on this, so a memory mapped frame can be read with aligned vector loads
+    constexpr size_t recordAlignment = 64;
+
+    enum class RecordType : uint32_t
+    {
+        Video = 1, // Raw, as received: NDI's FourCC and line stride, UYVA's alpha plane (xres to a row) after the colour
+        Audio = 2  // 32-bit float, interleaved
+    };
+
+    struct FileHeader
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t headerBytes;    // Where the first record starts
+        uint64_t dataBytes;      // Of records, padding after the last one excluded. 0 if not finished
+        uint64_t indexOffset;    // 0 if not finished
+        uint64_t indexEntries;
+        int64_t startedAt;       // UTC, 100 ns units since 1970, like NDI timestamps
+        char sourceName[256];    // UTF-8, nul terminated
+    };
+
+    struct VideoFormat
+    {
+        uint32_t fourCC;         // NDIlib_FourCC_video_type_e
+        int32_t width;
+        int32_t height;
+        int32_t strideBytes;
+        int32_t frameRateN;
+        int32_t frameRateD;
+        uint32_t frameFormat;    // NDIlib_frame_format_type_e
+        float aspectRatio;       // 0 for square pixels
+    };
+
+    struct AudioFormat
+    {
+        int32_t sampleRate;
+        int32_t channels;
+        int32_t frames;          // Samples per channel
+        uint32_t reserved[5];
+    };
+
+    struct RecordHeader
+    {
+        uint32_t marker;         // recordMarker
+        RecordType type;
+        uint64_t payloadBytes;   // Unpadded
+        int64_t timestamp;       // The source's, or failing that when it was received; UTC, 100 ns units since 1970
+        int64_t timecode;        // The source's
+        union
+        {
+            VideoFormat video;
+            AudioFormat audio;
+        };
+    };
+
+    struct IndexEntry
+    {
+        uint64_t offset;         // Of the record's header, from the start of the file
+        int64_t timestamp;
+        RecordType type;
+        uint32_t reserved;
+    };
+
+    static_assert(sizeof(FileHeader) <= fileAlignment);
+    static_assert(sizeof(RecordHeader) == recordAlignment);
+    static_assert(sizeof(IndexEntry) == 24);
+    static_assert(std::is_trivially_copyable_v<RecordHeader> && std::is_trivially_copyable_v<IndexEntry>);
+
+    constexpr size_t roundUp(size_t const bytes, size_t const alignment) { return (bytes + alignment - 1) / alignment * alignment; }
+
+    // A record's header and payload, padded
+    constexpr size_t recordBytes(size_t const payloadBytes) { return sizeof(RecordHeader) + roundUp(payloadBytes, recordAlignment); }
+}
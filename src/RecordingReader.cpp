@@ -0,0 +1,212 @@
+#include "RecordingReader.h"
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace RecordingFormat;
+
+RecordingReader::~RecordingReader()
+{
+	close();
+}
+
+bool RecordingReader::open(std::filesystem::path const& path)
+{
+	close();
+
+#ifdef _WIN32
+	m_file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (m_file == INVALID_HANDLE_VALUE)
+	{
+		m_file = nullptr;
+		return fail("Cannot open " + path.string() + ": error " + std::to_string(GetLastError()));
+	}
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(m_file, &size) || size.QuadPart < static_cast<LONGLONG>(sizeof(FileHeader)))
+	{
+		return fail(path.string() + " is too short to be a recording");
+	}
+	m_mapping = CreateFileMappingW(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	void const* const view = m_mapping ? MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+	if (!view)
+	{
+		return fail("Cannot map " + path.string() + ": error " + std::to_string(GetLastError()));
+	}
+	m_data = static_cast<uint8_t const*>(view);
+	m_size = static_cast<size_t>(size.QuadPart);
+#else
+	int const file{ ::open(path.c_str(), O_RDONLY | O_CLOEXEC) };
+	if (file < 0)
+	{
+		return fail("Cannot open " + path.string() + ": " + std::strerror(errno));
+	}
+	struct stat status;
+	if (::fstat(file, &status) != 0 || status.st_size < static_cast<off_t>(sizeof(FileHeader)))
+	{
+		::close(file);
+		return fail(path.string() + " is too short to be a recording");
+	}
+	void* const view{ ::mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_SHARED, file, 0) };
+	::close(file); // The mapping keeps the file
+	if (view == MAP_FAILED)
+	{
+		return fail("Cannot map " + path.string() + ": " + std::strerror(errno));
+	}
+	m_data = static_cast<uint8_t const*>(view);
+	m_size = static_cast<size_t>(status.st_size);
+#endif
+
+	m_header = reinterpret_cast<FileHeader const*>(m_data);
+	if (std::memcmp(m_header->magic, magic, sizeof(magic)) != 0 || m_header->version != version
+		|| m_header->headerBytes < sizeof(FileHeader) || m_header->headerBytes > m_size)
+	{
+		return fail(path.string() + " isn't a recording this can read");
+	}
+
+	uint64_t const dataEnd{ m_header->headerBytes + m_header->dataBytes };
+	bool const haveIndex{ m_header->indexOffset != 0 && dataEnd <= m_size && m_header->indexOffset <= m_size
+		&& m_header->indexEntries <= (m_size - m_header->indexOffset) / sizeof(IndexEntry) };
+	if (haveIndex)
+	{
+		auto const* const index = reinterpret_cast<IndexEntry const*>(m_data + m_header->indexOffset);
+		for (uint64_t i = 0; i < m_header->indexEntries; ++i)
+		{
+			if (!validRecord(index[i].offset, dataEnd))
+			{
+				return fail(path.string() + " has an index entry outside its records");
+			}
+			addEntry(index[i]);
+		}
+		m_finished = true;
+	}
+	else
+	{
+		// Never finished: walk the records, as far as they are whole
+		for (uint64_t offset = m_header->headerBytes; validRecord(offset, m_size);)
+		{
+			auto const& header = *reinterpret_cast<RecordHeader const*>(m_data + offset);
+			addEntry({ offset, header.timestamp, header.type, 0 });
+			offset += recordBytes(header.payloadBytes);
+		}
+	}
+	return true;
+}
+
+void RecordingReader::close()
+{
+#ifdef _WIN32
+	if (m_data)
+	{
+		UnmapViewOfFile(m_data);
+	}
+	if (m_mapping)
+	{
+		CloseHandle(m_mapping);
+		m_mapping = nullptr;
+	}
+	if (m_file)
+	{
+		CloseHandle(m_file);
+		m_file = nullptr;
+	}
+#else
+	if (m_data)
+	{
+		::munmap(const_cast<uint8_t*>(m_data), m_size);
+	}
+#endif
+	m_data = nullptr;
+	m_size = 0;
+	m_header = nullptr;
+	m_finished = false;
+	m_video.clear();
+	m_audio.clear();
+	m_error.clear();
+}
+
+bool RecordingReader::fail(std::string const& reason)
+{
+	close();
+	m_error = reason;
+	return false;
+}
+
+bool RecordingReader::validRecord(uint64_t const offset, uint64_t const end) const
+{
+	if (offset < m_header->headerBytes || offset % recordAlignment != 0 || end > m_size || offset > end || end - offset < sizeof(RecordHeader))
+	{
+		return false;
+	}
+	auto const& header = *reinterpret_cast<RecordHeader const*>(m_data + offset);
+	if (header.marker != recordMarker || header.payloadBytes > end - offset - sizeof(RecordHeader))
+	{
+		return false;
+	}
+	// Whatever reads the payload can trust the format to describe no more than is there
+	switch (header.type)
+	{
+	case RecordType::Video:
+		return header.video.width > 0 && header.video.height > 0 && header.video.strideBytes > 0
+			&& static_cast<uint64_t>(header.video.strideBytes) * static_cast<uint64_t>(header.video.height) <= header.payloadBytes;
+	case RecordType::Audio:
+		return header.audio.channels > 0 && header.audio.frames >= 0
+			&& static_cast<uint64_t>(header.audio.channels) * static_cast<uint64_t>(header.audio.frames) * sizeof(float) == header.payloadBytes;
+	default:
+		return false;
+	}
+}
+
+void RecordingReader::addEntry(IndexEntry const& entry)
+{
+	auto const& header = *reinterpret_cast<RecordHeader const*>(m_data + entry.offset);
+	(header.type == RecordType::Video ? m_video : m_audio).push_back({ entry.offset, header.timestamp, header.type, 0 });
+}
+
+std::string RecordingReader::sourceName() const
+{
+	if (!m_header)
+	{
+		return {};
+	}
+	char const* const name{ m_header->sourceName };
+	return std::string(name, std::find(name, name + sizeof(m_header->sourceName), '\0'));
+}
+
+int64_t RecordingReader::startedAt() const
+{
+	return m_header ? m_header->startedAt : 0;
+}
+
+std::vector<IndexEntry> const& RecordingReader::entries(RecordType const type) const
+{
+	return type == RecordType::Video ? m_video : m_audio;
+}
+
+RecordingReader::Record RecordingReader::read(IndexEntry const& entry) const
+{
+	auto const* const header = reinterpret_cast<RecordHeader const*>(m_data + entry.offset);
+	return { header, m_data + entry.offset + sizeof(RecordHeader) };
+}
+
+std::optional<size_t> RecordingReader::find(RecordType const type, int64_t const timestamp) const
+{
+	auto const& list = entries(type);
+	auto const after = std::upper_bound(list.begin(), list.end(), timestamp,
+		[](int64_t const wanted, IndexEntry const& entry) { return wanted < entry.timestamp; });
+	if (after == list.begin())
+	{
+		return std::nullopt;
+	}
+	return static_cast<size_t>(after - list.begin() - 1);
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "RecordingFormat.h"
+
+// Reads a recording file (see RecordingFormat.h) by memory mapping it: records are read in place, with
+//  nothing copied. A recording that was never finished has no index on disk; one is built by walking the
+//  records instead, up to the first that isn't whole.
+class RecordingReader
+{
+public:
+    struct Record
+    {
+        RecordingFormat::RecordHeader const* header{ nullptr };
+        uint8_t const* payload{ nullptr };  // header->payloadBytes of it, aligned to RecordingFormat::recordAlignment
+    };
+
+    RecordingReader() = default;
+    ~RecordingReader();
+
+    RecordingReader(RecordingReader const&) = delete;
+    RecordingReader& operator=(RecordingReader const&) = delete;
+
+    // Returns false, with the reason in error(), if the file can't be mapped or isn't a recording
+    bool open(std::filesystem::path const& path);
+    void close();
+
+    std::string const& error() const { return m_error; }
+    bool finished() const { return m_finished; }       // Closed properly, with its index
+    std::string sourceName() const;
+    int64_t startedAt() const;
+
+    // Every record of one type, in the order recorded. Every entry has been checked to lie within the file.
+    std::vector<RecordingFormat::IndexEntry> const& entries(RecordingFormat::RecordType type) const;
+    Record read(RecordingFormat::IndexEntry const& entry) const;
+
+    // The position in entries(type) of the last record stamped at or before timestamp; nothing if they
+    //  are all later. Assumes the timestamps rise, as they do unless the source restarted mid-recording.
+    std::optional<size_t> find(RecordingFormat::RecordType type, int64_t timestamp) const;
+
+private:
+    bool fail(std::string const& reason);
+    bool validRecord(uint64_t offset, uint64_t end) const;
+    void addEntry(RecordingFormat::IndexEntry const& entry);
+
+    uint8_t const* m_data{ nullptr };
+    size_t m_size{ 0 };
+#ifdef _WIN32
+    void* m_file{ nullptr };
+    void* m_mapping{ nullptr };
+#endif
+    RecordingFormat::FileHeader const* m_header{ nullptr };
+    bool m_finished{ false };
+    std::vector<RecordingFormat::IndexEntry> m_video;
+    std::vector<RecordingFormat::IndexEntry> m_audio;
+    std::string m_error;
+};
@@ -0,0 +1,105 @@
+#include "SourceDiscovery.h"
+
+#include <QSettings>
+
+#include "Processing.NDI.Lib.h"
+#include "NDIDeleters.h"
+#include "Log.h"
+
+namespace
+{
+	constexpr char const* settingsKey = "discovery/sources";
+	constexpr std::chrono::seconds settleTime{ 10 };   // How long a new finder has to hear from everything before anything is removed
+	constexpr uint32_t waitSliceMs = 500;              // How often the finder thread checks for a stop
+	constexpr std::chrono::seconds retryDelay{ 2 };    // Between attempts to create a finder
+}
+
+SourceDiscovery::SourceDiscovery(QObject* parent)
+	: QObject(parent)
+	, m_remembered{ QSettings().value(settingsKey).toStringList() }
+{
+}
+
+SourceDiscovery::~SourceDiscovery()
+{
+	stop();
+}
+
+void SourceDiscovery::start()
+{
+	if (m_thread.joinable())
+	{
+		return;
+	}
+	m_stopRequested.store(false);
+	m_thread = std::thread(&SourceDiscovery::run, this);
+}
+
+void SourceDiscovery::stop()
+{
+	if (!m_thread.joinable())
+	{
+		return;
+	}
+	m_stopRequested.store(true);
+	m_thread.join();
+}
+
+void SourceDiscovery::run()
+{
+	LOG_INFO(QString("Source discovery started, with %1 sources remembered from last time").arg(m_remembered.size()));
+	SourceTable table{ m_remembered };
+
+	while (!m_stopRequested.load())
+	{
+		FindHandle const finder{ FindHandle::create(NDIlib_find_create_t{}) };
+		if (!finder)
+		{
+			LOG_WARNING("NDIlib_find_create_v2 failed; trying again shortly");
+			auto const retryAt = std::chrono::steady_clock::now() + retryDelay;
+			while (!m_stopRequested.load() && std::chrono::steady_clock::now() < retryAt)
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds(waitSliceMs));
+			}
+			continue;
+		}
+
+		auto const created = std::chrono::steady_clock::now();
+		bool wasSettled = false;
+		while (!m_stopRequested.load() && !m_rescanRequested.exchange(false))
+		{
+			bool const changed = NDIlib_find_wait_for_sources(finder.get(), waitSliceMs);
+			bool const settled = std::chrono::steady_clock::now() - created > settleTime;
+			if (!changed && settled == wasSettled)
+			{
+				continue;
+			}
+			wasSettled = settled;
+
+			uint32_t count = 0;
+			NDIlib_source_t const* const sources = NDIlib_find_get_current_sources(finder.get(), &count);
+			QStringList live;
+			for (uint32_t i = 0; i < count; ++i)
+			{
+				live << QString(sources[i].p_ndi_name);
+			}
+
+			SourceDiff const diff = table.update(live, settled);
+			if (!diff.isEmpty())
+			{
+				LOG_INFO(QString("Sources: %1 on the network; %2 new, %3 gone").arg(count).arg(diff.added.size()).arg(diff.removed.size()));
+				QMetaObject::invokeMethod(this, [this, diff, listed = table.names()]() { applyOnOwnThread(diff, listed); }, Qt::QueuedConnection);
+			}
+		}
+		if (!m_stopRequested.load())
+		{
+			LOG_INFO("Rescanning for sources with a new finder");
+		}
+	}
+}
+
+void SourceDiscovery::applyOnOwnThread(SourceDiff const& diff, QStringList const& listed)
+{
+	QSettings().setValue(settingsKey, listed);
+	emit sourcesChanged(diff);
+}
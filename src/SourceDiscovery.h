@@ -0,0 +1,46 @@
+#pragma once
+
+#include <QObject>
+#include <QStringList>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "SourceTable.h"
+
+// One long-lived NDI finder on a background thread, for the life of the application, instead of a new
+//  one and a blocking wait per scan. Whenever the finder's view of the network changes, the difference
+//  is posted to the GUI thread as sourcesChanged().
+//
+// The sources listed are remembered between runs (QSettings), so that at startup the ones from last time
+//  are listed, and selectable, immediately. Any that haven't reappeared once the finder has settled are removed.
+class SourceDiscovery : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit SourceDiscovery(QObject* parent = nullptr);
+    ~SourceDiscovery() override;
+
+    // Sources remembered from the previous run; sourcesChanged() reports on them as if they had been added.
+    QStringList remembered() const { return m_remembered; }
+
+    void start();
+    void stop();
+
+    // Replaces the finder with a new one, without disturbing the list. For when the network has changed
+    //  under it.
+    void rescan() { m_rescanRequested.store(true); }
+
+signals:
+    void sourcesChanged(SourceDiff const& diff);
+
+private:
+    void run();
+    void applyOnOwnThread(SourceDiff const& diff, QStringList const& listed);
+
+    QStringList m_remembered;
+    std::thread m_thread;
+    std::atomic<bool> m_stopRequested{ false };
+    std::atomic<bool> m_rescanRequested{ false };
+};
@@ -0,0 +1,65 @@
+#include "SourceTable.h"
+
+#include <set>
+
+SourceTable::SourceTable(QStringList const& remembered)
+{
+	for (QString const& name : remembered)
+	{
+		m_sources.emplace(name, false);
+	}
+}
+
+SourceDiff SourceTable::update(QStringList const& live, bool const settled)
+{
+	SourceDiff diff;
+	std::set<QString> const seen(live.begin(), live.end());
+
+	for (QString const& name : seen)
+	{
+		auto const [entry, inserted] = m_sources.emplace(name, true);
+		if (inserted)
+		{
+			diff.added << name;
+		}
+		else if (!entry->second)
+		{
+			entry->second = true;
+			diff.confirmed << name;
+		}
+	}
+
+	if (!settled)
+	{
+		return diff;
+	}
+	for (auto entry = m_sources.begin(); entry != m_sources.end();)
+	{
+		if (!seen.contains(entry->first))
+		{
+			diff.removed << entry->first;
+			entry = m_sources.erase(entry);
+		}
+		else
+		{
+			++entry;
+		}
+	}
+	return diff;
+}
+
+QStringList SourceTable::names() const
+{
+	QStringList names;
+	for (auto const& [name, confirmed] : m_sources)
+	{
+		names << name;
+	}
+	return names;
+}
+
+bool SourceTable::isConfirmed(QString const& name) const
+{
+	auto const entry = m_sources.find(name);
+	return entry != m_sources.end() && entry->second;
+}
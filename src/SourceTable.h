@@ -0,0 +1,36 @@
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <map>
+
+// What changed in the list of sources since the last update, for applying to a list widget piecemeal
+//  rather than clearing and refilling it.
+struct SourceDiff
+{
+    QStringList added;      // New to the list
+    QStringList removed;    // Gone from the list
+    QStringList confirmed;  // Already listed from the cache, now seen on the network
+
+    bool isEmpty() const { return added.isEmpty() && removed.isEmpty() && confirmed.isEmpty(); }
+};
+
+// The sources to list: those the finder currently sees, plus those remembered from an earlier session
+//  that it hasn't seen yet. Remembered ones are listed straight away so they can be picked without
+//  waiting for discovery. A new finder takes a while to hear from everything on the network, so until
+//  it has settled nothing is removed; after that, anything it doesn't see goes.
+class SourceTable
+{
+public:
+    SourceTable() = default;
+    explicit SourceTable(QStringList const& remembered);
+
+    // With the complete set the finder currently sees.
+    SourceDiff update(QStringList const& live, bool settled);
+
+    QStringList names() const;
+    bool isConfirmed(QString const& name) const;
+
+private:
+    std::map<QString, bool> m_sources; // Name, and whether it has been seen on the network
+};
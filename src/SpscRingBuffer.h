@@ -0,0 +1,107 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+
+// Lock-free ring buffer for exactly one producer thread and one consumer thread. Capacity is fixed at
+//  construction (rounded up to a power of two) so nothing is allocated while data flows. The read and
+//  write positions only ever increase; the slot index is the position masked to the capacity.
+template <typename T>
+class SpscRingBuffer
+{
+    static_assert(std::is_trivially_copyable_v<T>, "Ring contents are moved with memcpy");
+
+public:
+    // Up to two contiguous pieces of the ring, the second one present only when the region wraps.
+    template <typename U>
+    struct Region
+    {
+        U* first{ nullptr };
+        size_t firstCount{ 0 };
+        U* second{ nullptr };
+        size_t secondCount{ 0 };
+        size_t size() const { return firstCount + secondCount; }
+    };
+
+    explicit SpscRingBuffer(size_t minimumCapacity)
+    {
+        size_t capacity = 1;
+        while (capacity < minimumCapacity) { capacity <<= 1; }
+        m_capacity = capacity;
+        m_mask = capacity - 1;
+        m_data = std::make_unique<T[]>(capacity);
+    }
+
+    SpscRingBuffer(SpscRingBuffer const&) = delete;
+    SpscRingBuffer& operator=(SpscRingBuffer const&) = delete;
+
+    size_t capacity() const { return m_capacity; }
+
+    // Either side may ask; the answer is a snapshot and may be stale by the time it is used.
+    size_t available() const { return m_writePosition.load(std::memory_order_acquire) - m_readPosition.load(std::memory_order_acquire); }
+    size_t freeSpace() const { return m_capacity - available(); }
+
+    // Producer side. Space to write up to count items directly into the ring; follow with commitWrite().
+    Region<T> prepareWrite(size_t count)
+    {
+        size_t const writePosition = m_writePosition.load(std::memory_order_relaxed);
+        size_t const freeItems = m_capacity - (writePosition - m_readPosition.load(std::memory_order_acquire));
+        return regionAt(writePosition, std::min(count, freeItems));
+    }
+
+    void commitWrite(size_t count)
+    {
+        m_writePosition.store(m_writePosition.load(std::memory_order_relaxed) + count, std::memory_order_release);
+    }
+
+    // Producer side. Copies as much as fits and returns how many items were written.
+    size_t write(T const* items, size_t count)
+    {
+        auto const region = prepareWrite(count);
+        std::memcpy(region.first, items, region.firstCount * sizeof(T));
+        std::memcpy(region.second, items + region.firstCount, region.secondCount * sizeof(T));
+        commitWrite(region.size());
+        return region.size();
+    }
+
+    // Consumer side. Copies up to count items out and returns how many were read.
+    size_t read(T* items, size_t count)
+    {
+        size_t const readPosition = m_readPosition.load(std::memory_order_relaxed);
+        size_t const availableItems = m_writePosition.load(std::memory_order_acquire) - readPosition;
+        auto const region = regionAt(readPosition, std::min(count, availableItems));
+        std::memcpy(items, region.first, region.firstCount * sizeof(T));
+        std::memcpy(items + region.firstCount, region.second, region.secondCount * sizeof(T));
+        m_readPosition.store(readPosition + region.size(), std::memory_order_release);
+        return region.size();
+    }
+
+    // Consumer side. Throws away up to count items.
+    size_t discard(size_t count)
+    {
+        size_t const readPosition = m_readPosition.load(std::memory_order_relaxed);
+        size_t const toDiscard = std::min(count, m_writePosition.load(std::memory_order_acquire) - readPosition);
+        m_readPosition.store(readPosition + toDiscard, std::memory_order_release);
+        return toDiscard;
+    }
+
+private:
+    Region<T> regionAt(size_t position, size_t count)
+    {
+        size_t const start = position & m_mask;
+        size_t const firstCount = std::min(count, m_capacity - start);
+        return { m_data.get() + start, firstCount, m_data.get(), count - firstCount };
+    }
+
+    std::unique_ptr<T[]> m_data;
+    size_t m_capacity{ 0 };
+    size_t m_mask{ 0 };
+
+    // On separate cache lines so the two threads don't fight over them.
+    alignas(64) std::atomic<size_t> m_writePosition{ 0 };
+    alignas(64) std::atomic<size_t> m_readPosition{ 0 };
+};
@@ -0,0 +1,50 @@
+#include "Stats.h"
+
+#include <algorithm>
+#include <bit>
+
+uint64_t LatencyHistogram::Snapshot::percentileMicroseconds(double fraction) const
+{
+	if (count == 0)
+	{
+		return 0;
+	}
+	auto const wanted = static_cast<uint64_t>(std::clamp(fraction, 0.0, 1.0) * count);
+	uint64_t seen = 0;
+	for (int bucket = 0; bucket < numBuckets; ++bucket)
+	{
+		seen += buckets[bucket];
+		if (seen > wanted || seen == count)
+		{
+			return std::min(bucketUpperBoundMicroseconds(bucket), maxMicroseconds);
+		}
+	}
+	return maxMicroseconds;
+}
+
+void LatencyHistogram::record(std::chrono::nanoseconds duration)
+{
+	auto const microseconds = static_cast<uint64_t>(std::max<int64_t>(std::chrono::duration_cast<std::chrono::microseconds>(duration).count(), 0));
+	int const bucket = std::min(static_cast<int>(std::bit_width(microseconds)), numBuckets - 1);
+
+	m_buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+	m_sumMicroseconds.fetch_add(microseconds, std::memory_order_relaxed);
+
+	uint64_t previousMax = m_maxMicroseconds.load(std::memory_order_relaxed);
+	while (microseconds > previousMax && !m_maxMicroseconds.compare_exchange_weak(previousMax, microseconds, std::memory_order_relaxed))
+	{
+	}
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::snapshot() const
+{
+	Snapshot snapshot;
+	for (int bucket = 0; bucket < numBuckets; ++bucket)
+	{
+		snapshot.buckets[bucket] = m_buckets[bucket].load(std::memory_order_relaxed);
+		snapshot.count += snapshot.buckets[bucket];
+	}
+	snapshot.sumMicroseconds = m_sumMicroseconds.load(std::memory_order_relaxed);
+	snapshot.maxMicroseconds = m_maxMicroseconds.load(std::memory_order_relaxed);
+	return snapshot;
+}
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// Latency histogram cheap enough to feed from the capture loop: a record() is a handful of relaxed
+//  atomic adds, no locks. Buckets are fixed and power-of-two spaced in microseconds, so percentiles
+//  are approximate (to within a factor of two) but recording never allocates or rescales.
+class LatencyHistogram
+{
+public:
+    // Bucket i counts samples below 2^i microseconds (and at or above 2^(i-1)); the last one catches the rest.
+    static constexpr int numBuckets = 25; // Up to ~8s
+
+    struct Snapshot
+    {
+        uint64_t count{ 0 };
+        uint64_t sumMicroseconds{ 0 };
+        uint64_t maxMicroseconds{ 0 };
+        std::array<uint64_t, numBuckets> buckets{};
+
+        double meanMicroseconds() const { return count ? static_cast<double>(sumMicroseconds) / count : 0.0; }
+
+        // Upper bound of the bucket holding the given fraction (0..1) of samples.
+        uint64_t percentileMicroseconds(double fraction) const;
+    };
+
+    static uint64_t bucketUpperBoundMicroseconds(int bucket) { return uint64_t{ 1 } << bucket; }
+
+    void record(std::chrono::nanoseconds duration);
+    Snapshot snapshot() const;
+
+private:
+    std::array<std::atomic<uint64_t>, numBuckets> m_buckets{};
+    std::atomic<uint64_t> m_sumMicroseconds{ 0 };
+    std::atomic<uint64_t> m_maxMicroseconds{ 0 };
+};
+
+// Times the enclosing scope into a histogram.
+class ScopedStageTimer
+{
+public:
+    explicit ScopedStageTimer(LatencyHistogram& histogram) : m_histogram{ histogram } {}
+    ~ScopedStageTimer() { m_histogram.record(std::chrono::steady_clock::now() - m_start); }
+
+    ScopedStageTimer(ScopedStageTimer const&) = delete;
+    ScopedStageTimer& operator=(ScopedStageTimer const&) = delete;
+
+private:
+    LatencyHistogram& m_histogram;
+    std::chrono::steady_clock::time_point const m_start{ std::chrono::steady_clock::now() };
+};
+
+// The latest audio levels of one source, for meters. Written by the audio path after every block, read by
+//  meters and exports on any thread. Each value is atomic on its own, so a reader can catch one channel a
+//  block ahead of the next; nothing on a meter shows that. Levels are in dB (dBFS, dBTP, LUFS), floored at
+//  floorDb for silence, and meter style: peaks fall back slowly, RMS is smoothed over about 300 ms.
+struct AudioLevels
+{
+    static constexpr int maxChannels = 16;
+    static constexpr float floorDb = -120.0f;
+
+    struct Channel
+    {
+        std::atomic<float> peak{ floorDb };
+        std::atomic<float> truePeak{ floorDb };   // Between the samples, 4x oversampled as BS.1770 describes
+        std::atomic<float> rms{ floorDb };
+    };
+
+    std::array<Channel, maxChannels> channels;
+    std::atomic<int> channelCount{ 0 };           // Metered; a source with more has the rest left out
+    std::atomic<float> momentaryLufs{ floorDb };  // EBU R128: the last 400 ms...
+    std::atomic<float> shortTermLufs{ floorDb };  // ...the last 3 s...
+    std::atomic<float> integratedLufs{ floorDb }; // ...and gated, since the source was opened
+    std::atomic<float> maxTruePeak{ floorDb };    // Highest since opened, any channel
+};
+
+// A recording's progress (see Recorder), from when it was started. Written by the capture path and the
+//  recorder's writer thread.
+struct RecordingStats
+{
+    std::atomic<bool> active{ false };
+    std::atomic<bool> directIo{ false };             // Written around the OS's page cache
+    std::atomic<uint64_t> videoFramesRecorded{ 0 };
+    std::atomic<uint64_t> videoFramesDropped{ 0 };   // No buffer free for them: the disk had fallen behind
+    std::atomic<uint64_t> audioBlocksRecorded{ 0 };
+    std::atomic<uint64_t> audioBlocksDropped{ 0 };
+    std::atomic<uint64_t> bytesWritten{ 0 };
+    std::atomic<uint64_t> writeNanoseconds{ 0 };     // Spent in the writes; bytesWritten over this is what the disk managed
+    std::atomic<uint64_t> buffersQueuedPeak{ 0 };    // Most buffers waiting for the disk at once
+    std::atomic<int64_t> startedAt{ 0 };             // steady_clock, nanoseconds since its epoch
+    std::atomic<int64_t> stoppedAt{ 0 };             // Likewise; 0 while recording
+};
+
+// Everything measured about one receive pipeline. Written from the capture, GUI and audio threads;
+//  read by whatever reports it.
+struct PipelineStats
+{
+    LatencyHistogram tickJitter;        // Lateness of each capture tick against its deadline
+    LatencyHistogram videoCapture;      // NDIlib_framesync_capture_video
+    LatencyHistogram videoHash;         // Hashing new frames to spot ones whose content hasn't changed
+    LatencyHistogram videoDeinterlace;  // Making an interlaced frame (or one of its fields) progressive, before conversion
+    LatencyHistogram videoConvert;      // Colour conversion and scaling to the display
+    LatencyHistogram videoDelivery;     // Publish by the capture thread until painted on the GUI thread
+    LatencyHistogram audioCapture;      // NDIlib_framesync_capture_audio
+    LatencyHistogram audioWrite;        // Resample, convert and queue for the sound card
+    LatencyHistogram audioMeter;        // Measuring levels and loudness
+    LatencyHistogram timeToFirstFrame;  // From asking for a source to having its first video frame
+    // From the sender's timestamp on a video frame. Only meaningful with the two machines' clocks in step (NTP, PTP).
+    LatencyHistogram videoSourceToCapture;  // ...to the frame reaching the engine
+    LatencyHistogram glassToGlass;          // ...to the frame being painted
+    LatencyHistogram avOffset;          // How far each frame shown was from the audio playing, either way
+    LatencyHistogram recordCopy;        // Copying a frame into the recorder's buffers
+    LatencyHistogram recordWrite;       // Each buffer the recorder writes to disk
+    LatencyHistogram cadenceError;      // With capture locked to the source: how far each capture's step through its frames was from the one expected
+
+    std::atomic<uint64_t> ticks{ 0 };
+    std::atomic<uint64_t> videoFramesCaptured{ 0 };
+    std::atomic<uint64_t> videoFramesDisplayed{ 0 };
+    std::atomic<uint64_t> videoFramesDropped{ 0 };     // Replaced by a newer frame before it was painted
+    std::atomic<uint64_t> videoFramesDuplicated{ 0 };  // Same source frame handed back again by framesync
+    std::atomic<uint64_t> videoFramesUnchanged{ 0 };   // New source frame, but the same pixels as the last one shown
+    std::atomic<uint64_t> videoPicturesDeinterlaced{ 0 }; // Made from interlaced frames; two a frame when each field is shown
+    std::atomic<uint64_t> videoFramesLate{ 0 };        // Held for the audio, but its moment passed before it was shown
+    std::atomic<uint64_t> videoFramesProxy{ 0 };       // Received at proxy bandwidth by the adaptive mode
+    std::atomic<uint64_t> videoPixelsAvoided{ 0 };     // Full resolution pixels not received and decoded, thanks to the proxy
+    std::atomic<uint64_t> bandwidthSwitches{ 0 };
+    std::atomic<uint64_t> audioBytesDropped{ 0 };
+    std::atomic<uint64_t> audioUnderruns{ 0 };
+    std::atomic<int64_t> avOffsetMicroseconds{ 0 };    // Of the last frame shown: its sent time less the audio clock's. Positive is video early
+    std::atomic<bool> avOffsetKnown{ false };          // There was an audio clock to measure against
+    // Capture locked to the source's frame rate (see CadenceLock)
+    std::atomic<uint64_t> cadenceMisses{ 0 };          // Captures that found the same frame again, or had skipped one
+    std::atomic<uint64_t> cadencePhaseShifts{ 0 };     // Times the captures were moved off the edge where frames arrive
+    std::atomic<uint64_t> cadenceLocks{ 0 };           // The first lock to a source included; more mean its format changed
+    std::atomic<int64_t> captureIntervalNanoseconds{ 0 };
+    std::atomic<int> cadenceFrameRateN{ 0 };           // The rate locked to; 0 while not locked
+    std::atomic<int> cadenceFrameRateD{ 1 };
+    std::atomic<int> cadenceFramesPerCapture{ 1 };
+
+    AudioLevels audioLevels;
+    RecordingStats recording;
+
+    std::chrono::steady_clock::time_point const created{ std::chrono::steady_clock::now() };
+};
@@ -0,0 +1,381 @@
+#include "StatsReport.h"
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <cstdlib>
+
+#include "FramePool.h"
+#include "Log.h"
+#include "NDIDeleters.h"
+
+namespace
+{
+	struct NamedHistogram
+	{
+		char const* name;
+		LatencyHistogram const& histogram;
+	};
+
+	std::array<NamedHistogram, 16> histogramsOf(PipelineStats const& stats)
+	{
+		return { {
+			{ "tick_jitter", stats.tickJitter },
+			{ "video_capture", stats.videoCapture },
+			{ "video_hash", stats.videoHash },
+			{ "video_deinterlace", stats.videoDeinterlace },
+			{ "video_convert", stats.videoConvert },
+			{ "video_delivery", stats.videoDelivery },
+			{ "audio_capture", stats.audioCapture },
+			{ "audio_write", stats.audioWrite },
+			{ "audio_meter", stats.audioMeter },
+			{ "time_to_first_frame", stats.timeToFirstFrame },
+			{ "video_source_to_capture", stats.videoSourceToCapture },
+			{ "glass_to_glass", stats.glassToGlass },
+			{ "av_offset", stats.avOffset },
+			{ "record_copy", stats.recordCopy },
+			{ "record_write", stats.recordWrite },
+			{ "cadence_error", stats.cadenceError },
+		} };
+	}
+
+	struct NamedCounter
+	{
+		char const* name;
+		std::atomic<uint64_t> const& counter;
+	};
+
+	std::array<NamedCounter, 16> countersOf(PipelineStats const& stats)
+	{
+		return { {
+			{ "ticks", stats.ticks },
+			{ "video_frames_captured", stats.videoFramesCaptured },
+			{ "video_frames_displayed", stats.videoFramesDisplayed },
+			{ "video_frames_dropped", stats.videoFramesDropped },
+			{ "video_frames_duplicated", stats.videoFramesDuplicated },
+			{ "video_frames_unchanged", stats.videoFramesUnchanged },
+			{ "video_pictures_deinterlaced", stats.videoPicturesDeinterlaced },
+			{ "video_frames_late", stats.videoFramesLate },
+			{ "video_frames_proxy", stats.videoFramesProxy },
+			{ "video_pixels_avoided", stats.videoPixelsAvoided },
+			{ "bandwidth_switches", stats.bandwidthSwitches },
+			{ "audio_bytes_dropped", stats.audioBytesDropped },
+			{ "audio_underruns", stats.audioUnderruns },
+			{ "cadence_misses", stats.cadenceMisses },
+			{ "cadence_phase_shifts", stats.cadencePhaseShifts },
+			{ "cadence_locks", stats.cadenceLocks },
+		} };
+	}
+
+	// Levels are meaningless until the meter has seen the source's audio
+	int meteredChannels(PipelineStats const& stats)
+	{
+		return stats.audioLevels.channelCount.load(std::memory_order_relaxed);
+	}
+
+	double uptimeSeconds(PipelineStats const& stats)
+	{
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - stats.created).count();
+	}
+
+	// Of the current recording, or the last; 0 if there hasn't been one
+	double recordingSeconds(RecordingStats const& recording)
+	{
+		int64_t const started{ recording.startedAt.load(std::memory_order_relaxed) };
+		if (started == 0)
+		{
+			return 0.0;
+		}
+		int64_t const stopped{ recording.stoppedAt.load(std::memory_order_relaxed) };
+		int64_t const end{ stopped != 0 ? stopped : std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count() };
+		return (end - started) / 1e9;
+	}
+
+	// The source's rate the capture is locked to; 0 if it isn't
+	double lockedFrameRate(PipelineStats const& stats)
+	{
+		int const n{ stats.cadenceFrameRateN.load(std::memory_order_relaxed) };
+		int const d{ stats.cadenceFrameRateD.load(std::memory_order_relaxed) };
+		return n > 0 && d > 0 ? double(n) / d : 0.0;
+	}
+
+	// Overall, and while the disk was actually being written to, which is what it can sustain
+	double megabytesPerSecond(uint64_t const bytes, double const seconds)
+	{
+		return seconds > 0.0 ? bytes / (1024.0 * 1024.0) / seconds : 0.0;
+	}
+}
+
+QString StatsReport::toJson(PipelineStats const& stats)
+{
+	QJsonObject counters;
+	for (auto const& [name, counter] : countersOf(stats))
+	{
+		counters.insert(name, static_cast<qint64>(counter.load(std::memory_order_relaxed)));
+	}
+
+	QJsonObject histograms;
+	for (auto const& [name, histogram] : histogramsOf(stats))
+	{
+		auto const snapshot = histogram.snapshot();
+		QJsonArray buckets;
+		for (int bucket = 0; bucket < LatencyHistogram::numBuckets; ++bucket)
+		{
+			buckets.append(QJsonObject{ { "le_us", static_cast<qint64>(LatencyHistogram::bucketUpperBoundMicroseconds(bucket)) },
+				                        { "count", static_cast<qint64>(snapshot.buckets[bucket]) } });
+		}
+		histograms.insert(QString(name) + "_us", QJsonObject{
+			{ "count", static_cast<qint64>(snapshot.count) },
+			{ "mean", snapshot.meanMicroseconds() },
+			{ "p50", static_cast<qint64>(snapshot.percentileMicroseconds(0.5)) },
+			{ "p99", static_cast<qint64>(snapshot.percentileMicroseconds(0.99)) },
+			{ "max", static_cast<qint64>(snapshot.maxMicroseconds) },
+			{ "buckets", buckets } });
+	}
+
+	// Shared by every pipeline in the process
+	FramePool::Counters const pool{ FramePool::shared().counters() };
+	QJsonObject const framePool{ { "hits", static_cast<qint64>(pool.hits) },
+		                         { "misses", static_cast<qint64>(pool.misses) },
+		                         { "resident_bytes", static_cast<qint64>(pool.residentBytes) },
+		                         { "peak_resident_bytes", static_cast<qint64>(pool.peakResidentBytes) } };
+
+	QJsonObject capture{ { "interval_us", stats.captureIntervalNanoseconds.load(std::memory_order_relaxed) / 1000.0 } };
+	if (double const rate = lockedFrameRate(stats); rate > 0.0)
+	{
+		capture.insert("locked_frame_rate", rate);
+		capture.insert("frames_per_capture", stats.cadenceFramesPerCapture.load(std::memory_order_relaxed));
+	}
+
+	QJsonObject root{ { "uptime_s", uptimeSeconds(stats) }, { "counters", counters }, { "histograms", histograms }, { "frame_pool", framePool }, { "capture", capture } };
+	if constexpr (ndiHandlesCounted)
+	{
+		// Debug builds: across the process, like the frame pool
+		root.insert("ndi_handles_live", QJsonObject{ { "finders", static_cast<qint64>(FindHandle::live()) },
+			                                         { "receivers", static_cast<qint64>(ReceiverHandle::live()) },
+			                                         { "frame_syncs", static_cast<qint64>(FrameSyncHandle::live()) } });
+	}
+	if (stats.avOffsetKnown.load(std::memory_order_relaxed))
+	{
+		root.insert("av_offset_us", static_cast<qint64>(stats.avOffsetMicroseconds.load(std::memory_order_relaxed)));
+	}
+	if (int const channels = meteredChannels(stats))
+	{
+		AudioLevels const& levels{ stats.audioLevels };
+		QJsonArray perChannel;
+		for (int channel = 0; channel < channels; ++channel)
+		{
+			perChannel.append(QJsonObject{ { "peak_dbfs", levels.channels[channel].peak.load(std::memory_order_relaxed) },
+				                           { "true_peak_dbtp", levels.channels[channel].truePeak.load(std::memory_order_relaxed) },
+				                           { "rms_dbfs", levels.channels[channel].rms.load(std::memory_order_relaxed) } });
+		}
+		root.insert("audio_levels", QJsonObject{
+			{ "channels", perChannel },
+			{ "momentary_lufs", levels.momentaryLufs.load(std::memory_order_relaxed) },
+			{ "short_term_lufs", levels.shortTermLufs.load(std::memory_order_relaxed) },
+			{ "integrated_lufs", levels.integratedLufs.load(std::memory_order_relaxed) },
+			{ "max_true_peak_dbtp", levels.maxTruePeak.load(std::memory_order_relaxed) } });
+	}
+	RecordingStats const& recording{ stats.recording };
+	if (double const seconds = recordingSeconds(recording); seconds > 0.0)
+	{
+		uint64_t const bytes{ recording.bytesWritten.load(std::memory_order_relaxed) };
+		root.insert("recording", QJsonObject{
+			{ "active", recording.active.load(std::memory_order_relaxed) },
+			{ "direct_io", recording.directIo.load(std::memory_order_relaxed) },
+			{ "seconds", seconds },
+			{ "video_frames_recorded", static_cast<qint64>(recording.videoFramesRecorded.load(std::memory_order_relaxed)) },
+			{ "video_frames_dropped", static_cast<qint64>(recording.videoFramesDropped.load(std::memory_order_relaxed)) },
+			{ "audio_blocks_recorded", static_cast<qint64>(recording.audioBlocksRecorded.load(std::memory_order_relaxed)) },
+			{ "audio_blocks_dropped", static_cast<qint64>(recording.audioBlocksDropped.load(std::memory_order_relaxed)) },
+			{ "bytes_written", static_cast<qint64>(bytes) },
+			{ "write_mb_per_s", megabytesPerSecond(bytes, seconds) },
+			{ "disk_mb_per_s", megabytesPerSecond(bytes, recording.writeNanoseconds.load(std::memory_order_relaxed) / 1e9) },
+			{ "buffers_queued_peak", static_cast<qint64>(recording.buffersQueuedPeak.load(std::memory_order_relaxed)) } });
+	}
+	return QString::fromUtf8(QJsonDocument(root).toJson(QJsonDocument::Indented));
+}
+
+QString StatsReport::toPrometheus(PipelineStats const& stats)
+{
+	QString text;
+	text += QString("# TYPE ndirecv_uptime_seconds gauge\nndirecv_uptime_seconds %1\n").arg(uptimeSeconds(stats));
+	for (auto const& [name, counter] : countersOf(stats))
+	{
+		text += QString("# TYPE ndirecv_%1_total counter\nndirecv_%1_total %2\n").arg(name).arg(counter.load(std::memory_order_relaxed));
+	}
+
+	FramePool::Counters const pool{ FramePool::shared().counters() };
+	text += QString("# TYPE ndirecv_frame_pool_hits_total counter\nndirecv_frame_pool_hits_total %1\n").arg(pool.hits);
+	text += QString("# TYPE ndirecv_frame_pool_misses_total counter\nndirecv_frame_pool_misses_total %1\n").arg(pool.misses);
+	text += QString("# TYPE ndirecv_frame_pool_resident_bytes gauge\nndirecv_frame_pool_resident_bytes %1\n").arg(pool.residentBytes);
+	text += QString("# TYPE ndirecv_frame_pool_peak_resident_bytes gauge\nndirecv_frame_pool_peak_resident_bytes %1\n").arg(pool.peakResidentBytes);
+	if constexpr (ndiHandlesCounted)
+	{
+		text += "# TYPE ndirecv_ndi_handles_live gauge\n";
+		text += QString("ndirecv_ndi_handles_live{kind=\"finder\"} %1\n").arg(FindHandle::live());
+		text += QString("ndirecv_ndi_handles_live{kind=\"receiver\"} %1\n").arg(ReceiverHandle::live());
+		text += QString("ndirecv_ndi_handles_live{kind=\"frame_sync\"} %1\n").arg(FrameSyncHandle::live());
+	}
+	text += QString("# TYPE ndirecv_capture_interval_seconds gauge\nndirecv_capture_interval_seconds %1\n").arg(stats.captureIntervalNanoseconds.load(std::memory_order_relaxed) / 1e9);
+	if (double const rate = lockedFrameRate(stats); rate > 0.0)
+	{
+		text += QString("# TYPE ndirecv_capture_locked_frame_rate gauge\nndirecv_capture_locked_frame_rate %1\n").arg(rate);
+	}
+	if (stats.avOffsetKnown.load(std::memory_order_relaxed))
+	{
+		text += QString("# TYPE ndirecv_av_offset_seconds gauge\nndirecv_av_offset_seconds %1\n").arg(stats.avOffsetMicroseconds.load(std::memory_order_relaxed) / 1e6);
+	}
+	if (int const channels = meteredChannels(stats))
+	{
+		AudioLevels const& levels{ stats.audioLevels };
+		text += "# TYPE ndirecv_audio_level_db gauge\n";
+		for (int channel = 0; channel < channels; ++channel)
+		{
+			text += QString("ndirecv_audio_level_db{channel=\"%1\",measure=\"peak\"} %2\n").arg(channel).arg(levels.channels[channel].peak.load(std::memory_order_relaxed));
+			text += QString("ndirecv_audio_level_db{channel=\"%1\",measure=\"true_peak\"} %2\n").arg(channel).arg(levels.channels[channel].truePeak.load(std::memory_order_relaxed));
+			text += QString("ndirecv_audio_level_db{channel=\"%1\",measure=\"rms\"} %2\n").arg(channel).arg(levels.channels[channel].rms.load(std::memory_order_relaxed));
+		}
+		text += "# TYPE ndirecv_audio_loudness_lufs gauge\n";
+		text += QString("ndirecv_audio_loudness_lufs{window=\"momentary\"} %1\n").arg(levels.momentaryLufs.load(std::memory_order_relaxed));
+		text += QString("ndirecv_audio_loudness_lufs{window=\"short_term\"} %1\n").arg(levels.shortTermLufs.load(std::memory_order_relaxed));
+		text += QString("ndirecv_audio_loudness_lufs{window=\"integrated\"} %1\n").arg(levels.integratedLufs.load(std::memory_order_relaxed));
+		text += QString("# TYPE ndirecv_audio_max_true_peak_dbtp gauge\nndirecv_audio_max_true_peak_dbtp %1\n").arg(levels.maxTruePeak.load(std::memory_order_relaxed));
+	}
+
+	RecordingStats const& recording{ stats.recording };
+	if (recordingSeconds(recording) > 0.0)
+	{
+		text += QString("# TYPE ndirecv_recording_active gauge\nndirecv_recording_active %1\n").arg(recording.active.load(std::memory_order_relaxed) ? 1 : 0);
+		text += "# TYPE ndirecv_recording_video_frames_total counter\n";
+		text += QString("ndirecv_recording_video_frames_total{outcome=\"recorded\"} %1\n").arg(recording.videoFramesRecorded.load(std::memory_order_relaxed));
+		text += QString("ndirecv_recording_video_frames_total{outcome=\"dropped\"} %1\n").arg(recording.videoFramesDropped.load(std::memory_order_relaxed));
+		text += "# TYPE ndirecv_recording_audio_blocks_total counter\n";
+		text += QString("ndirecv_recording_audio_blocks_total{outcome=\"recorded\"} %1\n").arg(recording.audioBlocksRecorded.load(std::memory_order_relaxed));
+		text += QString("ndirecv_recording_audio_blocks_total{outcome=\"dropped\"} %1\n").arg(recording.audioBlocksDropped.load(std::memory_order_relaxed));
+		text += QString("# TYPE ndirecv_recording_bytes_written_total counter\nndirecv_recording_bytes_written_total %1\n").arg(recording.bytesWritten.load(std::memory_order_relaxed));
+		text += QString("# TYPE ndirecv_recording_write_seconds_total counter\nndirecv_recording_write_seconds_total %1\n").arg(recording.writeNanoseconds.load(std::memory_order_relaxed) / 1e9);
+	}
+
+	text += "# TYPE ndirecv_stage_latency_seconds histogram\n";
+	for (auto const& [name, histogram] : histogramsOf(stats))
+	{
+		auto const snapshot = histogram.snapshot();
+		uint64_t cumulative = 0;
+		for (int bucket = 0; bucket < LatencyHistogram::numBuckets - 1; ++bucket)
+		{
+			cumulative += snapshot.buckets[bucket];
+			text += QString("ndirecv_stage_latency_seconds_bucket{stage=\"%1\",le=\"%2\"} %3\n")
+				.arg(name).arg(LatencyHistogram::bucketUpperBoundMicroseconds(bucket) / 1e6).arg(cumulative);
+		}
+		text += QString("ndirecv_stage_latency_seconds_bucket{stage=\"%1\",le=\"+Inf\"} %2\n").arg(name).arg(snapshot.count);
+		text += QString("ndirecv_stage_latency_seconds_sum{stage=\"%1\"} %2\n").arg(name).arg(snapshot.sumMicroseconds / 1e6);
+		text += QString("ndirecv_stage_latency_seconds_count{stage=\"%1\"} %2\n").arg(name).arg(snapshot.count);
+	}
+	return text;
+}
+
+QString StatsReport::overlayText(PipelineStats const& stats)
+{
+	QString text;
+	for (auto const& [name, histogram] : histogramsOf(stats))
+	{
+		auto const snapshot = histogram.snapshot();
+		text += QString("%1: mean %2 us, p99 < %3 us, max %4 us\n")
+			.arg(name, -15).arg(snapshot.meanMicroseconds(), 0, 'f', 0).arg(snapshot.percentileMicroseconds(0.99)).arg(snapshot.maxMicroseconds);
+	}
+	text += QString("video frames: %1 captured, %2 shown, %3 dropped, %4 duplicate\n")
+		.arg(stats.videoFramesCaptured.load()).arg(stats.videoFramesDisplayed.load()).arg(stats.videoFramesDropped.load()).arg(stats.videoFramesDuplicated.load());
+	// Repeats from framesync and new frames with nothing new in them are both skipped, rather than converted and painted again
+	uint64_t const duplicated{ stats.videoFramesDuplicated.load() };
+	uint64_t const unchanged{ stats.videoFramesUnchanged.load() };
+	if (uint64_t const looked{ stats.videoFramesCaptured.load() + duplicated }; looked > 0)
+	{
+		text += QString("unchanged: %1 frames, %2% of captures skipped\n").arg(unchanged).arg(100.0 * (duplicated + unchanged) / looked, 0, 'f', 1);
+	}
+	if (uint64_t const deinterlaced = stats.videoPicturesDeinterlaced.load())
+	{
+		text += QString("deinterlaced: %1 pictures\n").arg(deinterlaced);
+	}
+	if (double const rate = lockedFrameRate(stats); rate > 0.0)
+	{
+		auto const error = stats.cadenceError.snapshot();
+		text += QString("cadence: locked to %1 fps, every %2 frame(s); error mean %3 us, %4 misses, %5 phase shifts, %6 locks\n")
+			.arg(rate, 0, 'f', 3).arg(stats.cadenceFramesPerCapture.load()).arg(error.meanMicroseconds(), 0, 'f', 0)
+			.arg(stats.cadenceMisses.load()).arg(stats.cadencePhaseShifts.load()).arg(stats.cadenceLocks.load());
+	}
+	if (uint64_t const proxyFrames = stats.videoFramesProxy.load())
+	{
+		text += QString("proxy: %1 frames, %2 Mpixels not decoded, %3 switches\n")
+			.arg(proxyFrames).arg(stats.videoPixelsAvoided.load() / 1000000).arg(stats.bandwidthSwitches.load());
+	}
+	if (stats.avOffsetKnown.load())
+	{
+		// Signed, unlike the histogram; which way round it is out matters as much as by how much
+		int64_t const offset{ stats.avOffsetMicroseconds.load() };
+		text += QString("a/v: video %1 ms %2 audio, %3 frames too late to show\n")
+			.arg(std::abs(offset) / 1000.0, 0, 'f', 1).arg(offset >= 0 ? "ahead of" : "behind").arg(stats.videoFramesLate.load());
+	}
+	if (meteredChannels(stats) > 0)
+	{
+		AudioLevels const& levels{ stats.audioLevels };
+		text += QString("loudness: M %1, S %2, I %3 LUFS; true peak max %4 dBTP\n")
+			.arg(levels.momentaryLufs.load(), 0, 'f', 1).arg(levels.shortTermLufs.load(), 0, 'f', 1)
+			.arg(levels.integratedLufs.load(), 0, 'f', 1).arg(levels.maxTruePeak.load(), 0, 'f', 1);
+	}
+	RecordingStats const& recording{ stats.recording };
+	if (double const seconds = recordingSeconds(recording); seconds > 0.0)
+	{
+		uint64_t const bytes{ recording.bytesWritten.load() };
+		text += QString("recording%1: %2 frames, %3 MB, %4 MB/s (disk %5 MB/s%6); %7 frames, %8 audio blocks dropped\n")
+			.arg(recording.active.load() ? "" : " (stopped)").arg(recording.videoFramesRecorded.load()).arg(bytes / (1024 * 1024))
+			.arg(megabytesPerSecond(bytes, seconds), 0, 'f', 1).arg(megabytesPerSecond(bytes, recording.writeNanoseconds.load() / 1e9), 0, 'f', 1)
+			.arg(recording.directIo.load() ? ", direct" : "").arg(recording.videoFramesDropped.load()).arg(recording.audioBlocksDropped.load());
+	}
+	FramePool::Counters const pool{ FramePool::shared().counters() };
+	text += QString("frame pool: %1 hits, %2 misses, %3 MB peak\n").arg(pool.hits).arg(pool.misses).arg(pool.peakResidentBytes / (1024 * 1024));
+	if constexpr (ndiHandlesCounted)
+	{
+		text += QString("ndi handles: %1 finders, %2 receivers, %3 frame syncs\n").arg(FindHandle::live()).arg(ReceiverHandle::live()).arg(FrameSyncHandle::live());
+	}
+	text += QString("audio: %1 underruns, %2 bytes dropped").arg(stats.audioUnderruns.load()).arg(stats.audioBytesDropped.load());
+	return text;
+}
+
+StatsExporter::StatsExporter(PipelineStats const& stats, QObject* parent)
+	: QObject(parent)
+	, m_stats{ stats }
+{
+	connect(&m_timer, &QTimer::timeout, this, &StatsExporter::exportNow);
+}
+
+void StatsExporter::setPath(QString const& path, int intervalMs)
+{
+	m_path = path.trimmed();
+	if (m_path.isEmpty())
+	{
+		m_timer.stop();
+		return;
+	}
+	m_timer.start(intervalMs);
+}
+
+void StatsExporter::exportNow()
+{
+	if (m_path.isEmpty())
+	{
+		return;
+	}
+
+	QSaveFile file(m_path);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+	{
+		LOG_WARNING(QString("Cannot write stats to %1: %2").arg(m_path, file.errorString()));
+		m_timer.stop();
+		return;
+	}
+	QString const text = m_path.endsWith(".prom") ? StatsReport::toPrometheus(m_stats) : StatsReport::toJson(m_stats);
+	file.write(text.toUtf8());
+	file.commit();
+}
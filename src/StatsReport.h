@@ -0,0 +1,36 @@
+#pragma once
+
+#include <QObject>
+#include <QString>
+#include <QTimer>
+
+#include "Stats.h"
+
+// Renderings of PipelineStats for people and for monitoring systems.
+namespace StatsReport
+{
+    QString toJson(PipelineStats const& stats);
+    QString toPrometheus(PipelineStats const& stats); // Prometheus text exposition format
+    QString overlayText(PipelineStats const& stats);  // A few lines for drawing over the video
+}
+
+// Periodically writes the stats to a local file, replacing it atomically so a scraper never sees a
+//  half-written file. Files ending .prom get Prometheus text, anything else JSON.
+class StatsExporter : public QObject
+{
+    Q_OBJECT
+
+public:
+    StatsExporter(PipelineStats const& stats, QObject* parent = nullptr);
+
+    // An empty path stops exporting.
+    void setPath(QString const& path, int intervalMs = 1000);
+
+public slots:
+    void exportNow();
+
+private:
+    PipelineStats const& m_stats;
+    QString m_path;
+    QTimer m_timer;
+};
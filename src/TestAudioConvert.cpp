@@ -0,0 +1,85 @@
+#include "AudioConvert.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace
+{
+    std::vector<uint8_t> convertWith(KernelPath path, int inputs, int outputs, SampleFormat format, std::vector<float> const& planar, size_t frames)
+    {
+        AudioFrameConverter converter(path);
+        converter.configure(inputs, outputs, format);
+        std::vector<uint8_t> out(frames * converter.bytesPerFrame());
+        converter.convert(planar.data(), frames, frames, out.data());
+        return out;
+    }
+
+    // Integer formats may differ by one step where a compiler fuses the scalar path's multiply-adds;
+    //  float output must match to within rounding of the mix.
+    bool closeEnough(SampleFormat format, std::vector<uint8_t> const& a, std::vector<uint8_t> const& b)
+    {
+        if (a.size() != b.size()) { return false; }
+        for (size_t i = 0; i < a.size(); )
+        {
+            switch (format)
+            {
+            case SampleFormat::UInt8: if (std::abs(int(a[i]) - int(b[i])) > 1) { return false; } i += 1; break;
+            case SampleFormat::Int16: { int16_t x, y; std::memcpy(&x, &a[i], 2); std::memcpy(&y, &b[i], 2); if (std::abs(x - y) > 1) { return false; } i += 2; break; }
+            case SampleFormat::Int32: { int32_t x, y; std::memcpy(&x, &a[i], 4); std::memcpy(&y, &b[i], 4); if (std::llabs(int64_t(x) - y) > 256) { return false; } i += 4; break; }
+            case SampleFormat::Float: { float x, y; std::memcpy(&x, &a[i], 4); std::memcpy(&y, &b[i], 4); if (std::abs(x - y) > 1e-6f) { return false; } i += 4; break; }
+            }
+        }
+        return true;
+    }
+}
+
+int main()
+{
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> distribution(-1.2f, 1.2f); // Some out of range, to exercise clamping
+
+    int const layouts[][2]{ { 2, 2 }, { 1, 2 }, { 6, 2 }, { 2, 1 }, { 2, 6 }, { 3, 3 }, { 8, 2 } };
+    for (auto const& layout : layouts)
+    {
+        constexpr size_t frames = 1001; // Not a multiple of any vector width, so the tails get used
+        std::vector<float> planar(frames * layout[0]);
+        for (auto& sample : planar) { sample = distribution(rng); }
+
+        for (SampleFormat format : { SampleFormat::UInt8, SampleFormat::Int16, SampleFormat::Int32, SampleFormat::Float })
+        {
+            auto const reference = convertWith(KernelPath::Scalar, layout[0], layout[1], format, planar, frames);
+            for (KernelPath path : { KernelPath::SSE41, KernelPath::AVX2 })
+            {
+                if (AudioFrameConverter(path).path() != path) { continue; } // Not supported on this CPU
+                if (!closeEnough(format, reference, convertWith(path, layout[0], layout[1], format, planar, frames))) { return 1; }
+            }
+        }
+    }
+
+    {
+        // Stereo planar in, interleaved Int16 out, with full scale and clipped values
+        std::vector<float> const planar{ 1.0f, -1.0f, 0.5f, 2.0f,     // Left
+                                         0.0f, -2.0f, -0.5f, 0.25f }; // Right
+        auto const out = convertWith(KernelPath::Best, 2, 2, SampleFormat::Int16, planar, 4);
+        int16_t samples[8];
+        std::memcpy(samples, out.data(), sizeof(samples));
+        int16_t const expected[8]{ 32767, 0, -32767, -32768, 16384, -16384, 32767, 8192 };
+        for (int i = 0; i < 8; ++i)
+        {
+            if (std::abs(samples[i] - expected[i]) > 1) { return 1; }
+        }
+    }
+
+    {
+        // Mono is copied to both sides
+        std::vector<float> const planar{ 0.5f, -0.25f };
+        auto const out = convertWith(KernelPath::Best, 1, 2, SampleFormat::Float, planar, 2);
+        float samples[4];
+        std::memcpy(samples, out.data(), sizeof(samples));
+        if (samples[0] != 0.5f || samples[1] != 0.5f || samples[2] != -0.25f || samples[3] != -0.25f) { return 1; }
+    }
+    return 0;
+}
@@ -0,0 +1,134 @@
+#include "AudioMeter.h"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace
+{
+    constexpr double pi = 3.14159265358979323846;
+    constexpr int rate = 48000;
+
+    // Planar channels of a sine, fed to the meter in blocks of odd sizes so runs start and end anywhere
+    void feedSine(AudioMeter& meter, int channels, double hz, double amplitude, double phase, double seconds, int64_t& position)
+    {
+        size_t const blockSizes[]{ 1601, 7, 960, 33 };
+        int64_t const end = position + static_cast<int64_t>(seconds * rate);
+        for (size_t block = 0; position < end; ++block)
+        {
+            size_t const frames = std::min<size_t>(blockSizes[block % std::size(blockSizes)], end - position);
+            std::vector<float> planar(frames * channels);
+            for (int c = 0; c < channels; ++c)
+            {
+                for (size_t f = 0; f < frames; ++f)
+                {
+                    planar[c * frames + f] = static_cast<float>(amplitude * std::sin(2.0 * pi * hz * (position + f) / rate + phase));
+                }
+            }
+            meter.process(planar.data(), frames, frames);
+            position += frames;
+        }
+    }
+
+    bool near(float value, float expected, float tolerance) { return std::abs(value - expected) <= tolerance; }
+}
+
+int main()
+{
+    KernelPath const paths[]{ KernelPath::Scalar, KernelPath::SSE41, KernelPath::AVX2 };
+
+    {
+        // Every path measures the same noise the same, to within float rounding
+        std::mt19937 random{ 3 };
+        std::uniform_real_distribution<float> distribution(-0.8f, 0.8f);
+        std::vector<float> planar(3 * 4801);
+        for (auto& sample : planar) { sample = distribution(random); }
+
+        AudioLevels reference;
+        AudioMeter scalar{ reference, KernelPath::Scalar };
+        scalar.configure(3, rate);
+        for (int i = 0; i < 20; ++i) { scalar.process(planar.data(), 4801, 4801); }
+
+        for (KernelPath const path : paths)
+        {
+            AudioLevels levels;
+            AudioMeter meter{ levels, path };
+            meter.configure(3, rate);
+            for (int i = 0; i < 20; ++i) { meter.process(planar.data(), 4801, 4801); }
+            for (int c = 0; c < 3; ++c)
+            {
+                if (!near(levels.channels[c].peak, reference.channels[c].peak, 0.001f)) { return 1; }
+                if (!near(levels.channels[c].truePeak, reference.channels[c].truePeak, 0.001f)) { return 1; }
+                if (!near(levels.channels[c].rms, reference.channels[c].rms, 0.001f)) { return 1; }
+            }
+            if (!near(levels.integratedLufs, reference.integratedLufs, 0.001f)) { return 1; }
+        }
+    }
+
+    for (KernelPath const path : paths)
+    {
+        // A 997 Hz stereo sine at -20 dBFS reads -20 LUFS (BS.1770's reference: K-weighting is +0.69 dB there)
+        AudioLevels levels;
+        AudioMeter meter{ levels, path };
+        meter.configure(2, rate);
+        int64_t position = 0;
+        feedSine(meter, 2, 997.0, 0.1, 0.0, 4.0, position);
+        if (levels.channelCount != 2) { return 1; }
+        if (!near(levels.momentaryLufs, -20.0f, 0.1f) || !near(levels.shortTermLufs, -20.0f, 0.1f) || !near(levels.integratedLufs, -20.0f, 0.1f)) { return 1; }
+        if (!near(levels.channels[0].peak, -20.0f, 0.05f) || !near(levels.channels[1].rms, -23.01f, 0.05f)) { return 1; }
+
+        // The peak meter falls back at its set rate rather than dropping at once
+        feedSine(meter, 2, 997.0, 0.001, 0.0, 0.5, position);
+        if (!near(levels.channels[0].peak, -20.0f - 0.5f * 20.0f / 1.7f, 0.2f)) { return 1; }
+
+        // Quiet passages below the relative gate don't pull the integrated loudness down; only the few blocks
+        //  straddling the change do, a little
+        feedSine(meter, 2, 997.0, 0.001, 0.0, 3.5, position);
+        if (!near(levels.integratedLufs, -20.0f, 0.25f) || !near(levels.momentaryLufs, -60.0f, 0.1f)) { return 1; }
+    }
+
+    for (KernelPath const path : paths)
+    {
+        // A quarter of the sample rate, sampled 45 degrees off its crests, peaks 3 dB above any sample
+        AudioLevels levels;
+        AudioMeter meter{ levels, path };
+        meter.configure(1, rate);
+        int64_t position = 0;
+        feedSine(meter, 1, rate / 4.0, 0.5, pi / 4.0, 1.0, position);
+        if (!near(levels.channels[0].peak, -9.03f, 0.05f)) { return 1; }
+        if (!near(levels.channels[0].truePeak, -6.02f, 0.3f) || !near(levels.maxTruePeak, -6.02f, 0.3f)) { return 1; }
+    }
+
+    {
+        // 5.1: the LFE doesn't count, the surrounds count for +1.5 dB
+        AudioLevels levels;
+        AudioMeter meter{ levels };
+        meter.configure(6, rate);
+        std::vector<float> planar(6 * 4800, 0.0f);
+        for (size_t f = 0; f < 4800; ++f) { planar[3 * 4800 + f] = static_cast<float>(0.5 * std::sin(2.0 * pi * 997.0 * f / rate)); }
+        for (int i = 0; i < 10; ++i) { meter.process(planar.data(), 4800, 4800); }
+        if (levels.momentaryLufs != AudioLevels::floorDb || levels.channels[3].peak < -7.0f) { return 1; }
+
+        std::fill(planar.begin(), planar.end(), 0.0f);
+        for (size_t f = 0; f < 4800; ++f) { planar[4 * 4800 + f] = static_cast<float>(0.1 * std::sin(2.0 * pi * 997.0 * f / rate)); }
+        for (int i = 0; i < 10; ++i) { meter.process(planar.data(), 4800, 4800); }
+        if (!near(levels.momentaryLufs, -23.01f + 1.49f, 0.1f)) { return 1; }
+    }
+
+    {
+        // Silence sits on the floor, and reconfiguring forgets what went before
+        AudioLevels levels;
+        AudioMeter meter{ levels };
+        meter.configure(2, rate);
+        std::vector<float> const silence(2 * 4800, 0.0f);
+        meter.process(silence.data(), 4800, 4800);
+        if (levels.channels[0].peak != AudioLevels::floorDb || levels.channels[1].rms != AudioLevels::floorDb) { return 1; }
+
+        int64_t position = 0;
+        feedSine(meter, 2, 997.0, 0.5, 0.0, 1.0, position);
+        meter.configure(20, 44100);
+        if (meter.channels() != 20 || levels.channelCount != AudioLevels::maxChannels) { return 1; }
+        if (levels.channels[0].peak != AudioLevels::floorDb || levels.integratedLufs != AudioLevels::floorDb) { return 1; }
+    }
+    return 0;
+}
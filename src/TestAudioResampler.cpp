@@ -0,0 +1,74 @@
+#include "AudioResampler.h"
+#include "SpscRingBuffer.h"
+
+#include <cmath>
+#include <vector>
+
+int main()
+{
+    {
+        // Ring buffer wraps around and hands data back in order
+        SpscRingBuffer<int> ring(6); // Rounded up to 8
+        if (ring.capacity() != 8) { return 1; }
+
+        int const first[5]{ 1, 2, 3, 4, 5 };
+        if (ring.write(first, 5) != 5) { return 1; }
+        int out[8]{};
+        if (ring.read(out, 3) != 3 || out[2] != 3) { return 1; }
+
+        int const second[7]{ 6, 7, 8, 9, 10, 11, 12 };
+        if (ring.write(second, 7) != 6) { return 1; } // Only 6 free
+        if (ring.read(out, 8) != 8) { return 1; }
+        for (int i = 0; i < 8; ++i)
+        {
+            if (out[i] != 4 + i) { return 1; }
+        }
+        if (ring.available() != 0) { return 1; }
+    }
+
+    {
+        // Ratio 1 passes a stream straight through (one frame of delay from the carried over frame aside)
+        AudioResampler resampler;
+        resampler.reset(2);
+        std::vector<float> planar{ 1, 2, 3, 4,        // Left
+                                   -1, -2, -3, -4 };  // Right
+        auto out = resampler.process(planar.data(), 4, 4, 1.0);
+        if (out.frames != 3 || out.data[0] != 1 || out.data[2] != 3 || out.data[out.channelStride + 2] != -3) { return 1; }
+        out = resampler.process(planar.data(), 4, 4, 1.0);
+        if (out.frames != 4 || out.data[0] != 4 || out.data[1] != 1 || out.data[out.channelStride] != -4) { return 1; }
+    }
+
+    {
+        // Producer and consumer clocks 300ppm apart; the controller must settle the queue on its target
+        //  and converge on the clock ratio, without ever running dry or overflowing.
+        constexpr size_t framesPerTick = 2400;
+        constexpr double targetFrames = 4800;
+        constexpr double consumerRate = 1.0 - 300e-6;
+
+        AudioResampler resampler;
+        resampler.reset(1);
+        FillLevelController controller;
+        controller.reset(targetFrames);
+        SpscRingBuffer<float> ring(1 << 16);
+        std::vector<float> input(framesPerTick, 0.25f);
+        std::vector<float> output(framesPerTick * 2);
+
+        double ratio = 1.0;
+        double consumerOwed = 0.0;
+        for (int tick = 0; tick < 20000; ++tick)
+        {
+            auto const resampled = resampler.process(input.data(), framesPerTick, framesPerTick, ratio);
+            if (ring.write(resampled.data, resampled.frames) != resampled.frames) { return 1; }
+
+            consumerOwed += framesPerTick * consumerRate;
+            auto const toConsume = static_cast<size_t>(consumerOwed);
+            consumerOwed -= toConsume;
+            if (tick > 0 && ring.read(output.data(), toConsume) != toConsume) { return 1; }
+
+            ratio = controller.update(static_cast<double>(ring.available()));
+        }
+        if (std::abs(ring.available() - targetFrames) > targetFrames * 0.05) { return 1; }
+        if (std::abs(ratio - consumerRate) > 20e-6) { return 1; }
+    }
+    return 0;
+}
@@ -0,0 +1,48 @@
+#include "BandwidthSelector.h"
+
+#include <chrono>
+
+int main()
+{
+    using namespace std::chrono_literals;
+    using clock = BandwidthSelector::clock;
+
+    BandwidthSelector selector{ { 1.25, 1.0, 1000ms } };
+    auto const t0 = clock::now();
+
+    // Nothing seen yet: straight to whichever suits
+    if (selector.reset(QSize(1280, 720)) != NDIlib_recv_bandwidth_highest) { return 1; }
+    if (selector.reset(QSize(480, 270)) != NDIlib_recv_bandwidth_lowest) { return 1; }
+
+    // On the proxy, growing into the band between the thresholds changes nothing
+    selector.observeFrame(NDIlib_recv_bandwidth_lowest, QSize(640, 360));
+    if (selector.update(QSize(760, 428), t0) != NDIlib_recv_bandwidth_lowest) { return 1; }
+    if (selector.update(QSize(760, 428), t0 + 5s) != NDIlib_recv_bandwidth_lowest) { return 1; }
+
+    // Past the upper threshold, it has to stay there for the dwell time
+    if (selector.update(QSize(1280, 720), t0 + 6s) != NDIlib_recv_bandwidth_lowest) { return 1; }
+    if (selector.update(QSize(1280, 720), t0 + 6500ms) != NDIlib_recv_bandwidth_lowest) { return 1; }
+    // A dip back into the band restarts the wait
+    if (selector.update(QSize(700, 394), t0 + 6800ms) != NDIlib_recv_bandwidth_lowest) { return 1; }
+    if (selector.update(QSize(1280, 720), t0 + 7s) != NDIlib_recv_bandwidth_lowest) { return 1; }
+    if (selector.update(QSize(1280, 720), t0 + 7500ms) != NDIlib_recv_bandwidth_lowest) { return 1; }
+    if (selector.update(QSize(1280, 720), t0 + 8s) != NDIlib_recv_bandwidth_highest) { return 1; }
+
+    // Keeps asking until told the switch has happened
+    if (selector.current() != NDIlib_recv_bandwidth_lowest) { return 1; }
+    selector.switched(NDIlib_recv_bandwidth_highest);
+    selector.observeFrame(NDIlib_recv_bandwidth_highest, QSize(1920, 1080));
+    if (selector.fullSize() != QSize(1920, 1080)) { return 1; }
+
+    // On full, the band holds too; only at or below the proxy's width does it go back
+    if (selector.update(QSize(700, 394), t0 + 10s) != NDIlib_recv_bandwidth_highest) { return 1; }
+    if (selector.update(QSize(700, 394), t0 + 20s) != NDIlib_recv_bandwidth_highest) { return 1; }
+    if (selector.update(QSize(640, 360), t0 + 21s) != NDIlib_recv_bandwidth_highest) { return 1; }
+    if (selector.update(QSize(640, 360), t0 + 22s) != NDIlib_recv_bandwidth_lowest) { return 1; }
+
+    // The picture's width is what counts, not the target's: a tall narrow target shows a narrow picture
+    selector.switched(NDIlib_recv_bandwidth_lowest);
+    if (selector.update(QSize(1280, 300), t0 + 30s) != NDIlib_recv_bandwidth_lowest) { return 1; }
+    if (selector.update(QSize(1280, 300), t0 + 40s) != NDIlib_recv_bandwidth_lowest) { return 1; }
+    return 0;
+}
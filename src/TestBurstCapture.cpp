@@ -0,0 +1,87 @@
+#include "BurstCapture.h"
+#include "MockNDI.h"
+
+#include <QDir>
+#include <QFile>
+#include <QImage>
+#include <QTemporaryDir>
+
+namespace
+{
+    QString const source{ "MOCK (Synthetic 1)" };
+}
+
+int main()
+{
+    using namespace std::chrono_literals;
+
+    MockNDI::Config config;
+    config.width = 320;
+    config.height = 180;
+    config.audioEnabled = false;
+    MockNDI::setConfig(config);
+
+    QTemporaryDir temporary;
+    if (!temporary.isValid()) { return 1; }
+    ReceiverCache receivers{ 2 };
+    BurstCapture burst{ receivers };
+    std::atomic<bool> stop{ false };
+
+    // The next 20 frames, every one on disk as a picture of the source, numbered in capture order
+    BurstSettings settings;
+    settings.sourceName = source;
+    settings.directory = QDir(temporary.path()).filePath("png");
+    settings.frames = 20;
+    BurstReport const png{ burst.run(settings, stop) };
+    if (!png.error.isEmpty() || png.framesCaptured + png.framesDropped != 20 || png.framesWritten != png.framesCaptured || png.framesFailed != 0) { return 1; }
+    if (png.encode.count != png.framesCaptured || png.captureToDisk.count != png.framesCaptured || png.write.count == 0 || png.encodedPerSecond() <= 0.0) { return 1; }
+    QImage const first{ QDir(settings.directory).filePath("frame-000001.png") };
+    if (first.size() != QSize(320, 180) || (first.pixel(10, 10) & 0xffffff) == 0) { return 1; }
+    if (QDir(settings.directory).entryList(QDir::Files).size() != static_cast<int>(png.framesWritten)) { return 1; }
+
+    // Raw: the frames exactly as received, one after another from the source, none seen twice
+    settings.directory = QDir(temporary.path()).filePath("raw");
+    settings.frames = 10;
+    settings.format = BurstFormat::Raw;
+    BurstReport const raw{ burst.run(settings, stop) };
+    if (!raw.error.isEmpty() || raw.framesWritten != 10 || raw.bytesWritten != 10 * 640 * 180) { return 1; }
+    int64_t previous{ -1 };
+    for (int i = 1; i <= 10; ++i)
+    {
+        QFile file{ QDir(settings.directory).filePath(QString("frame-%1-320x180-640bpl.uyvy").arg(i, 6, 10, QChar('0'))) };
+        if (!file.open(QIODevice::ReadOnly)) { return 1; }
+        QByteArray pixels{ file.readAll() };
+        NDIlib_video_frame_v2_t frame{ 320, 180, NDIlib_FourCC_video_type_UYVY };
+        frame.p_data = reinterpret_cast<uint8_t*>(pixels.data());
+        frame.line_stride_in_bytes = 640;
+        int64_t const number{ MockNDI::readFrameNumber(frame) };
+        if (number < 0 || (previous >= 0 && number != previous + 1)) { return 1; }
+        previous = number;
+    }
+
+    // Half a second's worth, however many frames that is: about 15 at 29.97 fps, though a busy host may
+    //  capture far fewer. Never more than the source sends, plus the few it had queued, and the duration,
+    //  not a frame count, ends it.
+    settings.directory = QDir(temporary.path()).filePath("timed");
+    settings.frames = 0;
+    settings.duration = 500ms;
+    settings.format = BurstFormat::Jpeg;
+    BurstReport const timed{ burst.run(settings, stop) };
+    if (!timed.error.isEmpty() || timed.framesCaptured < 2 || timed.framesCaptured > 15 + 4 + 1 || timed.captureTime > 500ms + 2s) { return 1; }
+
+    // Stopped before it starts: nothing captured, nothing wrong
+    stop.store(true);
+    if (BurstReport const stopped{ burst.run(settings, stop) }; stopped.framesCaptured != 0 || !stopped.error.isEmpty()) { return 1; }
+    stop.store(false);
+
+    // No limit at all, or no video to capture
+    settings.duration = 0ms;
+    if (burst.run(settings, stop).error.isEmpty()) { return 1; }
+    config.videoEnabled = false;
+    MockNDI::setConfig(config);
+    settings.frames = 5;
+    settings.sourceName = "MOCK (Synthetic 2)";
+    settings.firstFrameTimeout = 500ms;
+    if (BurstReport const silent{ burst.run(settings, stop) }; silent.error.isEmpty() || silent.framesCaptured != 0) { return 1; }
+    return 0;
+}
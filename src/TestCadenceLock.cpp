@@ -0,0 +1,106 @@
+#include "CadenceLock.h"
+
+#include <chrono>
+#include <cstdint>
+#include <random>
+
+namespace
+{
+    constexpr int progressive = 1;
+
+    // Ticks against a 59.94 fps source whose frames land with up to half a millisecond of jitter, starting
+    //  right on the edge where they arrive. Each tick sees the newest frame to have arrived by then. Returns
+    //  the misses over the last half of the ticks.
+    int simulate(bool followShifts)
+    {
+        CadenceLock lock;
+        auto const interval = lock.lockTo(60000, 1001, progressive, 0.0)->interval.count();
+        int64_t const period{ interval };  // In ns; one frame a tick
+        std::mt19937 random{ 7 };
+        std::uniform_int_distribution<int64_t> jitter{ -500000, 500000 };
+
+        int64_t tickAt{ 60 * period + 50000 };  // Just after a frame is due
+        int misses{ 0 };
+        int const ticks{ 600 };
+        for (int i = 0; i < ticks; ++i)
+        {
+            // The newest frame arrived by tickAt, with this tick's luck: near the edge, jitter decides
+            int64_t frame{ tickAt / period };
+            if (frame * period + jitter(random) > tickAt)
+            {
+                --frame;
+            }
+            int64_t const timestamp{ frame * period / 100 + 1 };  // 100 ns units, as NDI stamps them
+            if (auto const step = lock.observe(timestamp); step && step->missed && i >= ticks / 2)
+            {
+                ++misses;
+            }
+            tickAt += interval + (followShifts ? lock.takePhaseShift().count() : 0);
+        }
+        return misses;
+    }
+}
+
+int main()
+{
+    CadenceLock lock;
+    if (lock.locked() || lock.observe(10000000)) { return 1; }
+
+    // One tick per source frame, to the nanosecond
+    auto const ntsc = lock.lockTo(30000, 1001, progressive, 0.0);
+    if (!ntsc || ntsc->framesPerTick != 1 || ntsc->interval != std::chrono::nanoseconds{ 33366666 } || !lock.locked()) { return 1; }
+    if (lock.lockTo(30000, 1001, progressive, 0.0)) { return 1; } // Unchanged: no relock
+    if (lock.lockTo(0, 0, progressive, 0.0) || lock.lock().frameRateN != 30000) { return 1; } // Not a rate: keeps the lock
+
+    // Capped at the display's refresh rate: the fewest frames a tick that keep under it, with the cap read loosely
+    if (lock.lockTo(60000, 1001, progressive, 60.0)->framesPerTick != 1) { return 1; }
+    if (lock.lockTo(60, 1, progressive, 59.94)->framesPerTick != 1) { return 1; }
+    if (auto const capped = lock.lockTo(120, 1, progressive, 60.0); capped->framesPerTick != 2 || capped->interval != std::chrono::nanoseconds{ 16666666 }) { return 1; }
+    if (lock.lockTo(50, 1, progressive, 30.0)->framesPerTick != 2) { return 1; }
+    if (lock.lockTo(50, 1, progressive, 0.0)->framesPerTick != 1) { return 1; }
+
+    // A change of format relocks
+    if (!lock.lockTo(50, 1, 0, 0.0) || lock.lockTo(50, 1, 0, 0.0)) { return 1; }
+
+    // Steps of exactly a frame are on cadence; the first after a lock has nothing to step from
+    lock.lockTo(25, 1, progressive, 0.0);
+    int64_t const frame{ 400000 };
+    int64_t t{ 17000000000000000 };
+    if (lock.observe(t)) { return 1; }
+    for (int i = 0; i < 10; ++i)
+    {
+        t += frame;
+        auto const step = lock.observe(t + ((i + 1) % 2) * 1000); // 100 us of sender jitter
+        if (!step || step->missed || step->error > std::chrono::microseconds{ 200 }) { return 1; }
+    }
+    if (lock.takePhaseShift().count() != 0) { return 1; }
+
+    // A repeat and a skip: on the edge, so the ticks move half an interval later, once
+    auto const repeat = lock.observe(t);
+    if (!repeat || !repeat->missed || repeat->error != std::chrono::milliseconds{ 40 }) { return 1; }
+    if (lock.takePhaseShift().count() != 0) { return 1; }
+    t += 2 * frame;
+    if (!lock.observe(t)->missed) { return 1; }
+    if (lock.takePhaseShift() != std::chrono::milliseconds{ 20 } || lock.takePhaseShift().count() != 0) { return 1; }
+    if (lock.observe(t + 3 * frame / 2)) { return 1; } // The shifted tick's step isn't measured
+
+    // More misses straight after don't move the ticks again
+    t += 3 * frame / 2;
+    for (int i = 0; i < 4; ++i)
+    {
+        lock.observe(t);
+    }
+    if (lock.takePhaseShift().count() != 0) { return 1; }
+
+    // Unstamped frames can't be measured
+    if (lock.observe(0)) { return 1; }
+
+    // Ticking on the edge misses all the time; following the shifts it settles into the middle of the frame
+    int const stuck{ simulate(false) };
+    int const followed{ simulate(true) };
+    if (stuck < 50 || followed != 0) { return 1; }
+
+    lock.reset();
+    if (lock.locked()) { return 1; }
+    return 0;
+}
@@ -0,0 +1,89 @@
+#include "CaptureScheduler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+namespace
+{
+    using namespace std::chrono;
+
+    // Every figure in a tick comes from the same clock readings, so on a fixed grid they are tied together
+    //  however late the host makes us: the time between ticks is one interval on from the deadline the last
+    //  tick fired for (past any it skipped), plus this tick's lateness, less the last one's. A scheduler that
+    //  set each deadline from when the last tick fired would drift by the last lateness instead. Each figure
+    //  is truncated to a microsecond. After a retime, the skipped deadlines were still the old interval apart.
+    bool onGrid(CaptureScheduler::Tick const& previous, CaptureScheduler::Tick const& tick, nanoseconds interval,
+                nanoseconds shift = nanoseconds{ 0 }, nanoseconds previousInterval = nanoseconds{ 0 })
+    {
+        nanoseconds const skipped{ (previousInterval > nanoseconds{ 0 } ? previousInterval : interval) * previous.skippedTicks };
+        auto const expected = duration_cast<microseconds>(skipped + interval + shift) + tick.jitter - previous.jitter;
+        return std::chrono::abs(tick.sinceLastTick - expected) <= microseconds{ 3 };
+    }
+}
+
+int main()
+{
+    std::atomic<bool> const running{ false };
+    nanoseconds const interval{ milliseconds{ 20 } };
+    CaptureScheduler scheduler{ interval };
+    if (scheduler.ticksFired() != 0 || scheduler.meanJitter() != microseconds{ 0 }) { return 1; }
+
+    microseconds totalJitter{ 0 };
+    microseconds maxJitter{ 0 };
+    uint64_t skipped{ 0 };
+    auto const account = [&](CaptureScheduler::Tick const& tick) {
+        totalJitter += tick.jitter;
+        maxJitter = std::max(maxJitter, tick.jitter);
+        skipped += tick.skippedTicks;
+    };
+
+    // Never early, and no later than the skip count says
+    auto previous = scheduler.waitForNextTick(running);
+    if (!previous || previous->jitter < microseconds{ 0 } || previous->jitter >= interval * (1 + previous->skippedTicks)) { return 1; }
+    account(*previous);
+    for (int i = 0; i < 5; ++i)
+    {
+        auto const tick = scheduler.waitForNextTick(running);
+        if (!tick || tick->jitter < microseconds{ 0 } || !onGrid(*previous, *tick, interval)) { return 1; }
+        account(*tick);
+        previous = tick;
+    }
+
+    // Held up for over three intervals: the missed deadlines are skipped, not fired back to back, and the
+    //  grid carries on where it would have been
+    std::this_thread::sleep_for(interval * 7 / 2);
+    auto const late = scheduler.waitForNextTick(running);
+    if (!late || late->skippedTicks < 2 || late->jitter < interval * late->skippedTicks || !onGrid(*previous, *late, interval)) { return 1; }
+    account(*late);
+    auto const caughtUp = scheduler.waitForNextTick(running);
+    if (!caughtUp || !onGrid(*late, *caughtUp, interval)) { return 1; }
+    account(*caughtUp);
+
+    // The figures are the ticks' own, added up
+    if (scheduler.ticksFired() != 8 || scheduler.ticksSkipped() != skipped) { return 1; }
+    if (scheduler.maxJitter() != maxJitter || scheduler.meanJitter() != totalJitter / 8) { return 1; }
+
+    // Retiming puts the next deadline the new interval after the last one, moved on by any phase shift
+    nanoseconds const longer{ milliseconds{ 30 } };
+    scheduler.retime(longer, milliseconds{ 5 });
+    auto const retimed = scheduler.waitForNextTick(running);
+    if (!retimed || scheduler.interval() != longer || !onGrid(*caughtUp, *retimed, longer, milliseconds{ 5 }, interval)) { return 1; }
+    auto const after = scheduler.waitForNextTick(running);
+    if (!after || !onGrid(*retimed, *after, longer)) { return 1; }
+
+    // A stop is noticed within a sleep slice, however far off the deadline
+    CaptureScheduler slow{ seconds{ 30 } };
+    std::atomic<bool> stop{ false };
+    std::thread stopper{ [&stop] {
+        std::this_thread::sleep_for(milliseconds{ 20 });
+        stop.store(true);
+    } };
+    auto const waitStarted = steady_clock::now();
+    bool const stopped = !slow.waitForNextTick(stop);
+    stopper.join();
+    if (!stopped || steady_clock::now() - waitStarted > seconds{ 10 } || slow.ticksFired() != 0) { return 1; }
+    return 0;
+}
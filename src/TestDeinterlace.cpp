@@ -0,0 +1,139 @@
+#include "Deinterlace.h"
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace
+{
+    std::vector<uint8_t> randomFrame(int strideBytes, int height, unsigned seed)
+    {
+        std::mt19937 rng(seed);
+        std::vector<uint8_t> frame(static_cast<size_t>(strideBytes) * height);
+        for (auto& byte : frame) { byte = static_cast<uint8_t>(rng()); }
+        return frame;
+    }
+
+    std::vector<uint8_t> picture(SourceFrame const& frame)
+    {
+        int const rowBytes = frame.width * (frame.layout == PixelLayout::UYVY ? 2 : 4);
+        std::vector<uint8_t> out;
+        for (int y = 0; y < frame.height; ++y)
+        {
+            out.insert(out.end(), frame.data + y * frame.strideBytes, frame.data + y * frame.strideBytes + rowBytes);
+        }
+        return out;
+    }
+
+    // Two frames through a fresh deinterlacer, both fields of each, every picture kept
+    std::vector<std::vector<uint8_t>> run(KernelPath path, DeinterlaceMode mode, SourceFrame const& first, SourceFrame const& second)
+    {
+        Deinterlacer deinterlacer(path);
+        std::vector<std::vector<uint8_t>> pictures;
+        for (SourceFrame const& frame : { first, second })
+        {
+            pictures.push_back(picture(deinterlacer.deinterlace(frame, mode, 0, true)));
+            pictures.push_back(picture(deinterlacer.deinterlace(frame, mode, 1, false)));
+        }
+        return pictures;
+    }
+
+    // Every SIMD path this machine supports must give exactly the scalar path's bytes.
+    bool pathsAgree(PixelLayout layout, int width, int height)
+    {
+        int const stride = width * (layout == PixelLayout::UYVY ? 2 : 4) + 64; // Padded, as NDI frames can be
+        auto const firstPixels = randomFrame(stride, height, width * 31 + height);
+        auto secondPixels = firstPixels;
+        // Some of the second frame changes, some a little and some a lot, so motion adaptive does both
+        std::mt19937 rng(height);
+        for (size_t i = 0; i < secondPixels.size(); i += 1 + rng() % 7)
+        {
+            secondPixels[i] = static_cast<uint8_t>(secondPixels[i] + rng() % 24);
+        }
+        SourceFrame const first{ firstPixels.data(), width, height, stride, layout };
+        SourceFrame const second{ secondPixels.data(), width, height, stride, layout };
+
+        for (DeinterlaceMode mode : { DeinterlaceMode::Bob, DeinterlaceMode::LinearBlend, DeinterlaceMode::MotionAdaptive })
+        {
+            auto const reference = run(KernelPath::Scalar, mode, first, second);
+            for (KernelPath path : { KernelPath::SSE41, KernelPath::AVX2 })
+            {
+                if (Deinterlacer(path).path() != path) { continue; } // Not supported on this CPU
+                if (run(path, mode, first, second) != reference) { return false; }
+            }
+        }
+        return true;
+    }
+
+    // A woven 8x4 BGRA frame: every line one grey level, field 0's lines 10 and 30, field 1's 100 and 200
+    std::vector<uint8_t> wovenGreys(uint8_t const (&levels)[4])
+    {
+        std::vector<uint8_t> frame;
+        for (uint8_t level : levels) { frame.insert(frame.end(), 8 * 4, level); }
+        return frame;
+    }
+
+    bool linesAre(SourceFrame const& frame, std::vector<int> const& levels)
+    {
+        for (int y = 0; y < frame.height; ++y)
+        {
+            for (int x = 0; x < frame.width * 4; ++x)
+            {
+                if (frame.data[y * frame.strideBytes + x] != levels[y]) { return false; }
+            }
+        }
+        return true;
+    }
+}
+
+int main()
+{
+    for (PixelLayout layout : { PixelLayout::UYVY, PixelLayout::BGRA, PixelLayout::RGBA })
+    {
+        if (!pathsAgree(layout, 1920, 1080)) { return 1; }
+        if (!pathsAgree(layout, 720, 487)) { return 1; }  // An odd number of lines
+        if (!pathsAgree(layout, 18, 4)) { return 1; }     // Narrower than one SIMD block
+    }
+
+    {
+        auto const pixels = wovenGreys({ 10, 100, 30, 200 });
+        SourceFrame const frame{ pixels.data(), 8, 4, 32, PixelLayout::BGRA };
+        Deinterlacer deinterlacer;
+
+        // Off, or too few lines to have two fields, passes the frame straight through
+        if (deinterlacer.deinterlace(frame, DeinterlaceMode::Off, 0, true).data != pixels.data()) { return 1; }
+        if (deinterlacer.deinterlace({ pixels.data(), 8, 1, 32, PixelLayout::BGRA }, DeinterlaceMode::Bob, 0, true).data != pixels.data()) { return 1; }
+
+        // Bob keeps the field shown and fills in between; the last line has only the one above it
+        if (!linesAre(deinterlacer.deinterlace(frame, DeinterlaceMode::Bob, 0, true), { 10, 20, 30, 30 })) { return 1; }
+        if (!linesAre(deinterlacer.deinterlace(frame, DeinterlaceMode::Bob, 1, false), { 100, 100, 150, 200 })) { return 1; }
+
+        // Blend mixes each line half and half with the average of its neighbours, whichever field is asked for
+        if (!linesAre(deinterlacer.deinterlace(frame, DeinterlaceMode::LinearBlend, 1, true), { 33, 60, 90, 158 })) { return 1; }
+    }
+
+    {
+        // Motion adaptive bobs until it has a frame to compare with, then weaves where nothing has moved
+        //  and bobs where it has
+        auto const still = wovenGreys({ 10, 100, 30, 200 });
+        auto moved = still;
+        std::memset(moved.data() + 32 * 3, 60, 4); // The first pixel of field 1's second line
+        Deinterlacer deinterlacer;
+        SourceFrame const first{ still.data(), 8, 4, 32, PixelLayout::BGRA };
+        if (!linesAre(deinterlacer.deinterlace(first, DeinterlaceMode::MotionAdaptive, 0, true), { 10, 20, 30, 30 })) { return 1; }
+        if (!linesAre(deinterlacer.deinterlace(first, DeinterlaceMode::MotionAdaptive, 0, true), { 10, 100, 30, 200 })) { return 1; }
+        SourceFrame const second{ moved.data(), 8, 4, 32, PixelLayout::BGRA };
+        SourceFrame const out{ deinterlacer.deinterlace(second, DeinterlaceMode::MotionAdaptive, 0, true) };
+        if (out.data[32 * 3] != 30 || out.data[32 * 3 + 4] != 200 || out.data[32] != 100) { return 1; }
+
+        // The other field of the same frame compares with the same earlier frame
+        SourceFrame const other{ deinterlacer.deinterlace(second, DeinterlaceMode::MotionAdaptive, 1, false) };
+        if (other.data[0] != 10 || other.data[32 * 2] != 30 || other.data[32 * 3] != 60) { return 1; }
+
+        // Forgetting the history, or a change of size, starts again with bob
+        deinterlacer.reset();
+        if (!linesAre(deinterlacer.deinterlace(first, DeinterlaceMode::MotionAdaptive, 0, true), { 10, 20, 30, 30 })) { return 1; }
+        if (!linesAre(deinterlacer.deinterlace({ still.data(), 4, 4, 32, PixelLayout::BGRA }, DeinterlaceMode::MotionAdaptive, 0, true), { 10, 20, 30, 30 })) { return 1; }
+    }
+    return 0;
+}
@@ -0,0 +1,60 @@
+#include "FrameHash.h"
+
+#include <random>
+#include <vector>
+
+int main()
+{
+    std::mt19937 random{ 7 };
+    KernelPath const paths[]{ KernelPath::Scalar, KernelPath::SSE41, KernelPath::AVX2 };
+
+    // Every path agrees, for widths that do and don't fill whole vector blocks, and padding is ignored
+    for (int const rowBytes : { 3, 32, 100, 1920 * 2, 1921 * 2 + 1 })
+    {
+        int const height = 37;
+        int const stride = rowBytes + 13;
+        std::vector<uint8_t> frame(static_cast<size_t>(stride) * height);
+        for (auto& byte : frame) { byte = static_cast<uint8_t>(random()); }
+
+        for (FrameHashMode const mode : { FrameHashMode::Sampled, FrameHashMode::Full })
+        {
+            uint64_t const expected = FrameHasher(KernelPath::Scalar).hash(frame.data(), rowBytes, height, stride, mode, 42);
+            for (KernelPath const path : paths)
+            {
+                if (FrameHasher(path).hash(frame.data(), rowBytes, height, stride, mode, 42) != expected) { return 1; }
+            }
+
+            std::vector<uint8_t> padded{ frame };
+            for (int y = 0; y < height; ++y) { padded[static_cast<size_t>(y) * stride + rowBytes] ^= 0xff; }
+            if (FrameHasher().hash(padded.data(), rowBytes, height, stride, mode, 42) != expected) { return 1; }
+
+            // The seed (size, format) counts
+            if (FrameHasher().hash(frame.data(), rowBytes, height, stride, mode, 43) == expected) { return 1; }
+        }
+    }
+
+    // A full hash sees a change to any single byte; a sampled one sees changes on the rows it samples
+    int const rowBytes = 640 * 2;
+    int const height = 360;
+    std::vector<uint8_t> frame(static_cast<size_t>(rowBytes) * height);
+    for (auto& byte : frame) { byte = static_cast<uint8_t>(random()); }
+    FrameHasher const hasher;
+    uint64_t const full = hasher.hash(frame.data(), rowBytes, height, rowBytes, FrameHashMode::Full);
+    uint64_t const sampled = hasher.hash(frame.data(), rowBytes, height, rowBytes, FrameHashMode::Sampled);
+    for (int trial = 0; trial < 2000; ++trial)
+    {
+        size_t const at = random() % frame.size();
+        uint8_t const flip = static_cast<uint8_t>(1u << (random() % 8));
+        frame[at] ^= flip;
+        bool const sampledRow = (at / rowBytes) % 8 == 4;
+        if (hasher.hash(frame.data(), rowBytes, height, rowBytes, FrameHashMode::Full) == full) { return 1; }
+        if ((hasher.hash(frame.data(), rowBytes, height, rowBytes, FrameHashMode::Sampled) == sampled) == sampledRow) { return 1; }
+        frame[at] ^= flip;
+    }
+
+    // Swapping two words between lanes changes it
+    std::vector<uint8_t> swapped{ frame };
+    std::swap_ranges(swapped.begin(), swapped.begin() + 4, swapped.begin() + 4);
+    if (hasher.hash(swapped.data(), rowBytes, height, rowBytes, FrameHashMode::Full) == full) { return 1; }
+    return 0;
+}
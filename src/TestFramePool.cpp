@@ -0,0 +1,118 @@
+#include "FramePool.h"
+
+#include <cstdlib>
+#include <new>
+#include <thread>
+
+namespace
+{
+    uint64_t allocations = 0;
+}
+
+void* operator new(std::size_t size)
+{
+    ++allocations;
+    if (void* p = std::malloc(size ? size : 1))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+int main()
+{
+    // Size classes: at most a quarter wasted, powers of two exact
+    if (FramePool::roundUp(1) != 64 || FramePool::roundUp(4096) != 4096 || FramePool::roundUp(4097) != 5120) { return 1; }
+    size_t const frame1080 = 1920 * 1080 * 4;
+    if (FramePool::roundUp(frame1080) < frame1080 || FramePool::roundUp(frame1080) > frame1080 * 5 / 4) { return 1; }
+
+    {
+        FramePool pool;
+
+        // A returned buffer is handed out again, aligned
+        uint8_t* first = nullptr;
+        {
+            auto const buffer = pool.acquire(frame1080);
+            first = buffer.data();
+            if (reinterpret_cast<uintptr_t>(first) % FramePool::alignment != 0 || buffer.capacity() < frame1080) { return 1; }
+        }
+        {
+            auto const buffer = pool.acquire(frame1080 - 1000); // Same class
+            if (buffer.data() != first) { return 1; }
+        }
+        auto counters = pool.counters();
+        if (counters.hits != 1 || counters.misses != 1 || counters.peakResidentBytes != FramePool::roundUp(frame1080)) { return 1; }
+
+        // Still referenced, so not handed out
+        {
+            auto const buffer = pool.acquire(frame1080);
+            auto const copy = buffer;
+            {
+                auto const moved = FramePool::Buffer(buffer);
+            }
+            auto const other = pool.acquire(frame1080);
+            if (other.data() == buffer.data()) { return 1; }
+        }
+
+        // Steady state: the display alternating between two sizes (a window being resized back and forth,
+        //  a receiver switching stream) costs no allocations once both have been seen
+        for (int warmUp = 0; warmUp < 2; ++warmUp)
+        {
+            auto const a = pool.acquire(frame1080);
+            auto const b = pool.acquire(640 * 360 * 4);
+        }
+        uint64_t const before = allocations;
+        for (int i = 0; i < 1000; ++i)
+        {
+            auto a = pool.acquire(i % 2 ? frame1080 : 640 * 360 * 4);
+            auto b = std::move(a);
+            auto c = b;
+        }
+        if (allocations != before) { return 1; }
+
+        // Buffers may be returned on another thread than the one that took them
+        {
+            auto buffer = pool.acquire(frame1080);
+            std::thread([held = std::move(buffer)]() {}).join();
+        }
+        counters = pool.counters();
+        if (counters.residentBytes != counters.idleBytes) { return 1; }
+
+        // Images: rows padded to the alignment, pixels returned when the last copy goes
+        {
+            QImage image = pool.image(QSize(1001, 10));
+            if (image.bytesPerLine() % FramePool::alignment != 0 || reinterpret_cast<uintptr_t>(image.constBits()) % FramePool::alignment != 0) { return 1; }
+            uint64_t const hits = pool.counters().hits;
+            QImage copy = image;
+            image = QImage();
+            QImage again = pool.image(QSize(1001, 10));
+            if (pool.counters().hits != hits || again.constBits() == copy.constBits()) { return 1; }
+        }
+        if (pool.counters().residentBytes != pool.counters().idleBytes) { return 1; }
+
+        pool.trim();
+        if (pool.counters().residentBytes != 0) { return 1; }
+    }
+
+    // Over the idle limit, returned buffers are freed rather than kept
+    {
+        FramePool pool{ 1024 * 1024 };
+        {
+            auto const a = pool.acquire(600 * 1024);
+            auto const b = pool.acquire(600 * 1024);
+        }
+        auto const counters = pool.counters();
+        if (counters.idleBytes > 1024 * 1024 || counters.residentBytes != counters.idleBytes || counters.peakResidentBytes < 1200 * 1024) { return 1; }
+    }
+    return 0;
+}
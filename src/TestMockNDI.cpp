@@ -0,0 +1,220 @@
+#include "MockNDI.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    void setEnvironment(char const* name, char const* value)
+    {
+#ifdef _WIN32
+        _putenv_s(name, value);
+#else
+        setenv(name, value, 1);
+#endif
+    }
+
+    int64_t frameIndexOf(NDIlib_video_frame_v2_t const& frame)
+    {
+        return std::llround(frame.timecode / 1e7 * frame.frame_rate_N / frame.frame_rate_D);
+    }
+
+    // At the source's own rate, unless it is given: a drifting source's audio, resampled by the frame sync,
+    //  is at another
+    bool audioMatches(MockNDI::Config const& config, NDIlib_audio_frame_v2_t const& frame, int64_t firstSample, double sampleRate = 0.0)
+    {
+        for (int channel = 0; channel < frame.no_channels; ++channel)
+        {
+            auto const* plane = reinterpret_cast<float const*>(reinterpret_cast<uint8_t const*>(frame.p_data) + channel * frame.channel_stride_in_bytes);
+            for (int sample = 0; sample < frame.no_samples; ++sample)
+            {
+                if (plane[sample] != MockNDI::audioSample(config, channel, firstSample + sample, sampleRate > 0.0 ? sampleRate : frame.sample_rate)) { return false; }
+            }
+        }
+        return true;
+    }
+}
+
+int main()
+{
+    using namespace std::chrono_literals;
+
+    setEnvironment("NDIRECV_MOCK_SOURCES", "3");
+    setEnvironment("NDIRECV_MOCK_VIDEO", "1280x720@50/1:BGRX");
+    setEnvironment("NDIRECV_MOCK_AUDIO", "44100:6:noise");
+    auto const fromEnvironment = MockNDI::configFromEnvironment();
+    if (fromEnvironment.sourceCount != 3 || fromEnvironment.width != 1280 || fromEnvironment.height != 720) { return 1; }
+    if (fromEnvironment.frameRateN != 50 || fromEnvironment.frameRateD != 1 || fromEnvironment.fourCC != NDIlib_FourCC_video_type_BGRX) { return 1; }
+    if (fromEnvironment.sampleRate != 44100 || fromEnvironment.channels != 6 || fromEnvironment.signal != MockNDI::AudioSignal::Noise) { return 1; }
+    if (fromEnvironment.interlaced) { return 1; }
+    setEnvironment("NDIRECV_MOCK_VIDEO", "1920x1080@30000/1001i");
+    if (auto const interlaced = MockNDI::configFromEnvironment(); !interlaced.interlaced || interlaced.frameRateN != 30000 || interlaced.frameRateD != 1001) { return 1; }
+
+    MockNDI::Config config;
+    config.width = 320;
+    config.height = 180;
+    config.frameRateN = 100;
+    config.frameRateD = 1;
+    MockNDI::setConfig(config);
+
+    // Discovery
+    {
+        NDIlib_find_instance_t const finder = NDIlib_find_create_v2();
+        if (!NDIlib_find_wait_for_sources(finder, 1000)) { return 1; }
+        uint32_t count = 0;
+        NDIlib_source_t const* sources = NDIlib_find_get_current_sources(finder, &count);
+        if (count != 1 || !sources || !sources[0].p_ndi_name) { return 1; }
+        NDIlib_find_destroy(finder);
+    }
+
+    NDIlib_source_t const source{ "MOCK (Synthetic 1)" };
+    NDIlib_recv_create_v3_t const settings{ source, NDIlib_recv_color_format_UYVY_BGRA, NDIlib_recv_bandwidth_highest, false };
+
+    // Frame sync: video frames carry their own number, audio continues seamlessly from one capture to the next
+    {
+        NDIlib_recv_instance_t const receiver = NDIlib_recv_create_v3(&settings);
+        NDIlib_framesync_instance_t const frameSync = NDIlib_framesync_create(receiver);
+        std::this_thread::sleep_for(30ms);
+
+        NDIlib_video_frame_v2_t video;
+        NDIlib_framesync_capture_video(frameSync, &video);
+        if (video.xres != 320 || video.yres != 180 || video.FourCC != NDIlib_FourCC_video_type_UYVY || !video.p_data) { return 1; }
+        if (MockNDI::readFrameNumber(video) != frameIndexOf(video) || frameIndexOf(video) < 1) { return 1; }
+        NDIlib_framesync_free_video(frameSync, &video);
+
+        NDIlib_audio_frame_v2_t audio;
+        NDIlib_framesync_capture_audio(frameSync, &audio, 0, 0, 0);
+        if (audio.sample_rate != 48000 || audio.no_channels != 2 || audio.no_samples != 0) { return 1; }
+        NDIlib_framesync_capture_audio(frameSync, &audio, 48000, 2, 480);
+        if (audio.no_samples != 480 || !audioMatches(config, audio, 0)) { return 1; }
+        NDIlib_framesync_capture_audio(frameSync, &audio, 48000, 2, 480);
+        if (!audioMatches(config, audio, 480)) { return 1; }
+
+        // Interleaving helper
+        std::vector<float> interleaved(480 * 2);
+        NDIlib_audio_frame_interleaved_32f_t interleavedFrame;
+        interleavedFrame.p_data = interleaved.data();
+        NDIlib_util_audio_to_interleaved_32f_v2(&audio, &interleavedFrame);
+        if (interleaved[1] != audio.p_data[audio.channel_stride_in_bytes / sizeof(float)] || interleaved[2] != audio.p_data[1]) { return 1; }
+        NDIlib_framesync_free_audio(frameSync, &audio);
+
+        NDIlib_framesync_destroy(frameSync);
+        NDIlib_recv_destroy(receiver);
+    }
+
+    // Direct capture: only audio asked for, so only audio comes back, in source-paced chunks
+    {
+        NDIlib_recv_instance_t const receiver = NDIlib_recv_create_v3(&settings);
+        NDIlib_audio_frame_v2_t audio;
+        if (NDIlib_recv_capture_v2(receiver, nullptr, &audio, nullptr, 1000) != NDIlib_frame_type_audio) { return 1; }
+        if (audio.no_samples != 960 || !audioMatches(config, audio, 0)) { return 1; }
+        NDIlib_recv_free_audio_v2(receiver, &audio);
+
+        NDIlib_video_frame_v2_t video;
+        if (NDIlib_recv_capture_v2(receiver, &video, nullptr, nullptr, 1000) != NDIlib_frame_type_video) { return 1; }
+        if (MockNDI::readFrameNumber(video) != frameIndexOf(video)) { return 1; }
+        NDIlib_recv_free_video_v2(receiver, &video);
+        NDIlib_recv_destroy(receiver);
+    }
+
+    // Capture v3 from two threads at once, video on one and audio on the other, as the direct receive mode
+    //  does: each gets every frame of its own kind in order, stamped with the time it was sent
+    {
+        NDIlib_recv_instance_t const receiver = NDIlib_recv_create_v3(&settings);
+        bool audioOk = true;
+        std::thread audioThread([&]() {
+            for (int64_t chunk = 0; chunk < 10; ++chunk)
+            {
+                NDIlib_audio_frame_v3_t audio;
+                if (NDIlib_recv_capture_v3(receiver, nullptr, &audio, nullptr, 1000) != NDIlib_frame_type_audio) { audioOk = false; return; }
+                NDIlib_audio_frame_v2_t const planar(audio.sample_rate, audio.no_channels, audio.no_samples, audio.timecode,
+                                                     reinterpret_cast<float*>(audio.p_data), audio.channel_stride_in_bytes);
+                audioOk = audioOk && audio.FourCC == NDIlib_FourCC_audio_type_FLTP && audioMatches(config, planar, chunk * 960);
+                NDIlib_recv_free_audio_v3(receiver, &audio);
+            }
+        });
+        for (int64_t frame = 0; frame < 5; ++frame)
+        {
+            NDIlib_video_frame_v2_t video;
+            if (NDIlib_recv_capture_v3(receiver, &video, nullptr, nullptr, 1000) != NDIlib_frame_type_video) { return 1; }
+            auto const sent = std::chrono::system_clock::time_point(std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                std::chrono::duration<int64_t, std::ratio<1, 10000000>>(video.timestamp)));
+            auto const age = std::chrono::system_clock::now() - sent;
+            if (MockNDI::readFrameNumber(video) != frame || age < -5ms || age > 100ms) { return 1; }
+            NDIlib_recv_free_video_v2(receiver, &video);
+        }
+        audioThread.join();
+        if (!audioOk) { return 1; }
+        NDIlib_recv_destroy(receiver);
+    }
+
+    // RGB requested of a YUV source; lowest bandwidth gets the proxy size
+    {
+        config.width = 1280;
+        config.height = 720;
+        MockNDI::setConfig(config);
+        NDIlib_recv_create_v3_t const proxySettings{ source, NDIlib_recv_color_format_BGRX_BGRA, NDIlib_recv_bandwidth_lowest, false };
+        NDIlib_recv_instance_t const receiver = NDIlib_recv_create_v3(&proxySettings);
+        NDIlib_video_frame_v2_t video;
+        if (NDIlib_recv_capture_v2(receiver, &video, nullptr, nullptr, 1000) != NDIlib_frame_type_video) { return 1; }
+        if (video.xres != 640 || video.yres != 360 || video.FourCC != NDIlib_FourCC_video_type_BGRA) { return 1; }
+        if (MockNDI::readFrameNumber(video) != 0) { return 1; }
+        NDIlib_recv_free_video_v2(receiver, &video);
+        NDIlib_recv_destroy(receiver);
+    }
+
+    // A source clock running twice as fast gets through frames twice as fast, and the frame sync's audio
+    //  through the source's timeline twice as fast too
+    {
+        config.width = 320;
+        config.height = 180;
+        config.clockDriftPpm = 1000000.0;
+        MockNDI::setConfig(config);
+        NDIlib_recv_instance_t const receiver = NDIlib_recv_create_v3(&settings);
+        NDIlib_framesync_instance_t const frameSync = NDIlib_framesync_create(receiver);
+        std::this_thread::sleep_for(200ms);
+        NDIlib_video_frame_v2_t video;
+        NDIlib_framesync_capture_video(frameSync, &video);
+        if (frameIndexOf(video) < 30) { return 1; }
+        NDIlib_audio_frame_v2_t audio;
+        NDIlib_framesync_capture_audio(frameSync, &audio, 48000, 2, 480);
+        NDIlib_framesync_capture_audio(frameSync, &audio, 48000, 2, 480);
+        if (audio.sample_rate != 48000 || audio.timecode != 200000 || !audioMatches(config, audio, 480, 24000.0)) { return 1; }
+        NDIlib_framesync_destroy(frameSync);
+        NDIlib_recv_destroy(receiver);
+    }
+
+    // Interlaced: woven frames, the moving box on the odd lines ahead of the even, for a receiver that allows
+    //  fields and asks for them; progressive frames otherwise
+    {
+        config.clockDriftPpm = 0.0;
+        config.interlaced = true;
+        MockNDI::setConfig(config);
+        auto const combed = [](NDIlib_video_frame_v2_t const& frame) {
+            uint8_t const* even = frame.p_data + static_cast<size_t>(frame.yres / 2 & ~1) * frame.line_stride_in_bytes;
+            return !std::equal(even, even + frame.line_stride_in_bytes, even + frame.line_stride_in_bytes);
+        };
+        NDIlib_recv_create_v3_t const fieldSettings{ source, NDIlib_recv_color_format_UYVY_BGRA, NDIlib_recv_bandwidth_highest, true };
+        NDIlib_recv_instance_t const receiver = NDIlib_recv_create_v3(&fieldSettings);
+        NDIlib_framesync_instance_t const frameSync = NDIlib_framesync_create(receiver);
+        std::this_thread::sleep_for(30ms);
+        NDIlib_video_frame_v2_t video;
+        NDIlib_framesync_capture_video(frameSync, &video, NDIlib_frame_format_type_interleaved);
+        if (video.frame_format_type != NDIlib_frame_format_type_interleaved || !combed(video)) { return 1; }
+        NDIlib_framesync_capture_video(frameSync, &video, NDIlib_frame_format_type_progressive);
+        if (video.frame_format_type != NDIlib_frame_format_type_progressive || combed(video)) { return 1; }
+        NDIlib_framesync_destroy(frameSync);
+        NDIlib_recv_destroy(receiver);
+
+        NDIlib_recv_instance_t const progressive = NDIlib_recv_create_v3(&settings);
+        if (NDIlib_recv_capture_v2(progressive, &video, nullptr, nullptr, 1000) != NDIlib_frame_type_video) { return 1; }
+        if (video.frame_format_type != NDIlib_frame_format_type_progressive || combed(video)) { return 1; }
+        NDIlib_recv_free_video_v2(progressive, &video);
+        NDIlib_recv_destroy(progressive);
+    }
+    return 0;
+}
@@ -1,5 +1,8 @@
 #include "NDIDeleters.h"
 
+#include <type_traits>
+#include <utility>
+
 
 struct countingInstances
 {
@@ -14,26 +17,121 @@ void deductor(countingInstances* instance)
     delete instance;
 }
 
+void otherDeductor(countingInstances* instance)
+{
+    deductor(instance);
+}
+
+countingInstances* counter()
+{
+    return new countingInstances;
+}
+
 int countingInstances::count = 0;
 
-int main() 
+using CountingHandle = NDIHandle<countingInstances*, counter, deductor>;
+using OtherHandle = NDIHandle<countingInstances*, counter, otherDeductor>;
+
+template <typename Handle, typename... Args>
+concept creatable = requires(Args&&... args) { Handle::create(std::forward<Args>(args)...); };
+
+template <typename Handle, typename P>
+concept resettableTo = requires(Handle& handle, P raw) { handle.reset(raw); };
+
+// Move-only, no bigger than the pointer, and the deleter is part of the type: a handle of one kind can't
+//  become one of another
+static_assert(!std::is_copy_constructible_v<CountingHandle> && !std::is_copy_assignable_v<CountingHandle>);
+static_assert(std::is_nothrow_move_constructible_v<CountingHandle> && std::is_nothrow_move_assignable_v<CountingHandle>);
+static_assert(sizeof(CountingHandle) == sizeof(countingInstances*));
+static_assert(!std::is_constructible_v<OtherHandle, CountingHandle&&> && !std::is_assignable_v<OtherHandle&, CountingHandle&&>);
+static_assert(!std::is_convertible_v<countingInstances*, CountingHandle>);
+static_assert(!std::is_convertible_v<CountingHandle, countingInstances*>);
+static_assert(!std::is_constructible_v<FrameSyncHandle, ReceiverHandle&&> && !std::is_assignable_v<FrameSyncHandle&, ReceiverHandle&&>);
+static_assert(!std::is_constructible_v<ReceiverHandle, FindHandle&&> && !std::is_assignable_v<ReceiverHandle&, FrameSyncHandle&&>);
+static_assert(!std::is_convertible_v<NDIlib_recv_instance_t, ReceiverHandle> && sizeof(FrameSyncHandle) == sizeof(NDIlib_framesync_instance_t));
+
+// Nor be made from a raw pointer at all, which could be anything: NDI's are all void*, so a public
+//  constructor or reset taking one would let a receiver be wrapped as a frame sync
+static_assert(!std::is_constructible_v<CountingHandle, countingInstances*> && !resettableTo<CountingHandle, countingInstances*>);
+static_assert(!std::is_constructible_v<FrameSyncHandle, NDIlib_recv_instance_t> && !std::is_constructible_v<FrameSyncHandle, NDIlib_framesync_instance_t>);
+static_assert(!std::is_constructible_v<ReceiverHandle, NDIlib_recv_instance_t> && !std::is_constructible_v<FindHandle, NDIlib_find_instance_t>);
+static_assert(!resettableTo<FrameSyncHandle, NDIlib_recv_instance_t> && !resettableTo<ReceiverHandle, NDIlib_recv_instance_t>);
+
+// Only from the settings or the object each kind is made from
+static_assert(creatable<FindHandle, NDIlib_find_create_t const&> && !creatable<FindHandle, NDIlib_recv_create_v3_t const&>);
+static_assert(creatable<ReceiverHandle, NDIlib_recv_create_v3_t const&> && !creatable<ReceiverHandle, NDIlib_find_create_t const&>);
+static_assert(creatable<FrameSyncHandle, ReceiverHandle const&> && !creatable<FrameSyncHandle, NDIlib_recv_instance_t>);
+static_assert(!creatable<FrameSyncHandle, FindHandle const&> && !creatable<FrameSyncHandle, FrameSyncHandle const&>);
+
+namespace
 {
+    bool counted(int64_t const live)
     {
-        countingInstances* pInstance = new countingInstances;
-        deleteGuard guard(deductor, pInstance);
+        return !ndiHandlesCounted || CountingHandle::live() == live;
+    }
+}
 
-        if (countingInstances::count != 1) { return 1; }
+int main()
+{
+    {
+        CountingHandle guard{ CountingHandle::create() };
+
+        if (countingInstances::count != 1 || !counted(1)) { return 1; }
 
         {
-            countingInstances* pInstanceTwo = new countingInstances;
-            deleteGuard guardTwo(deductor, pInstanceTwo);
+            CountingHandle guardTwo{ CountingHandle::create() };
 
-            if (countingInstances::count != 2) { return 1; }
+            if (countingInstances::count != 2 || !counted(2)) { return 1; }
 
         }
 
-        if (countingInstances::count != 1) { return 1; }
+        if (countingInstances::count != 1 || !counted(1)) { return 1; }
+    }
+    if (countingInstances::count != 0 || !counted(0)) { return 1; }
+
+    // Moving hands the object over: destroyed once, by the last owner
+    {
+        CountingHandle first{ CountingHandle::create() };
+        countingInstances* const raw = first.get();
+        CountingHandle second{ std::move(first) };
+        if (first || second.get() != raw || countingInstances::count != 1 || !counted(1)) { return 1; }
+
+        CountingHandle third{ CountingHandle::create() };
+        third = std::move(second); // third's own object goes
+        if (second || third.get() != raw || countingInstances::count != 1 || !counted(1)) { return 1; }
+
+        CountingHandle& same = third;
+        third = std::move(same);
+        if (third.get() != raw || countingInstances::count != 1) { return 1; }
+    }
+    if (countingInstances::count != 0 || !counted(0)) { return 1; }
+
+    // Assigning a new one destroys what is held; reset destroys it and leaves the handle empty
+    {
+        CountingHandle handle;
+        if (handle || !counted(0)) { return 1; }
+        handle = CountingHandle::create();
+        handle = CountingHandle::create();
+        if (!handle || countingInstances::count != 1 || !counted(1)) { return 1; }
+        handle.reset();
+        if (handle || countingInstances::count != 0 || !counted(0)) { return 1; }
+        handle.reset();
+    }
+
+    // Release gives ownership up without destroying, and stops counting it
+    {
+        CountingHandle handle{ CountingHandle::create() };
+        countingInstances* const raw = handle.release();
+        if (handle || countingInstances::count != 1 || !counted(0)) { return 1; }
+        deductor(raw);
     }
-    if (countingInstances::count != 0) { return 1; }
+
+    // Each kind is counted separately
+    {
+        CountingHandle counting{ CountingHandle::create() };
+        OtherHandle other{ OtherHandle::create() };
+        if (ndiHandlesCounted && (CountingHandle::live() != 1 || OtherHandle::live() != 1)) { return 1; }
+    }
+    if (countingInstances::count != 0 || !counted(0) || (ndiHandlesCounted && OtherHandle::live() != 0)) { return 1; }
     return 0;
-}
\ No newline at end of file
+}
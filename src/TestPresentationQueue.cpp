@@ -0,0 +1,56 @@
+#include "PresentationQueue.h"
+
+#include <chrono>
+
+int main()
+{
+    using namespace std::chrono_literals;
+    using TimePoint = std::chrono::system_clock::time_point;
+    TimePoint const t0{ 1000s };
+
+    PresentationQueue queue{ 4 };
+    if (!queue.empty() || queue.nextDue() || queue.takeOldest()) { return 1; }
+
+    // Images come sized as asked, and are handed back in sent order
+    for (int i = 0; i < 4; ++i)
+    {
+        QImage& image = queue.prepare({ 64, 36 });
+        if (image.size() != QSize(64, 36)) { return 1; }
+        queue.push(t0 + i * 40ms);
+    }
+    if (!queue.full() || queue.size() != 4 || *queue.nextDue() != t0) { return 1; }
+
+    // Nothing is due before its time
+    uint64_t overtaken = 0;
+    if (queue.takeDue(t0 - 1ms, overtaken) || overtaken != 0 || queue.size() != 4) { return 1; }
+
+    // Exactly on time
+    PresentationQueue::Frame* frame = queue.takeDue(t0, overtaken);
+    if (!frame || frame->sentAt != t0 || frame->image.size() != QSize(64, 36) || overtaken != 0 || queue.size() != 3) { return 1; }
+
+    // The clock jumped past two frames: the newer is shown, the older was overtaken
+    frame = queue.takeDue(t0 + 90ms, overtaken);
+    if (!frame || frame->sentAt != t0 + 80ms || overtaken != 1 || queue.size() != 1) { return 1; }
+
+    // A swap with a back buffer leaves the queue recycling that buffer, resized only when it must be
+    QImage backBuffer{ 64, 36, QImage::Format_RGB32 };
+    auto const* const backBits = backBuffer.constBits();
+    std::swap(frame->image, backBuffer);
+    bool recycled = false;
+    for (int i = 0; i < 3; ++i)
+    {
+        recycled = recycled || queue.prepare({ 64, 36 }).constBits() == backBits;
+        queue.push(t0 + (4 + i) * 40ms);
+    }
+    if (!recycled || !queue.full()) { return 1; }
+
+    // Full is full; oldest first regardless of the clock
+    queue.push(t0 + 1s);
+    if (queue.size() != 4 || queue.takeOldest()->sentAt != t0 + 120ms) { return 1; }
+    if (queue.prepare({ 32, 18 }).size() != QSize(32, 18)) { return 1; }
+
+    queue.clear();
+    if (!queue.empty() || queue.takeDue(t0 + 1h, overtaken)) { return 1; }
+
+    return 0;
+}
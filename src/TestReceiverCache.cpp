@@ -0,0 +1,96 @@
+#include "ReceiverCache.h"
+
+#include <chrono>
+
+int main()
+{
+    using namespace std::chrono_literals;
+
+    ReceiverCache cache{ 2, 1min };
+    NDIlib_recv_instance_t first = nullptr;
+    {
+        auto const lease = cache.acquire("A", NDIlib_recv_bandwidth_highest);
+        if (!lease || lease.reused()) { return 1; }
+        first = lease.get();
+
+        // In use, so a second user of the same source gets its own connection
+        auto const second = cache.acquire("A", NDIlib_recv_bandwidth_highest);
+        if (!second || second.get() == first || cache.openConnections() != 2) { return 1; }
+    }
+    if (cache.openConnections() != 2) { return 1; }
+
+    // Returned receivers are handed out again, still connected
+    {
+        auto const lease = cache.acquire("A", NDIlib_recv_bandwidth_highest);
+        if (!lease.reused() || cache.hits() != 1 || cache.misses() != 2) { return 1; }
+
+        // A different bandwidth is a different connection
+        auto const proxy = cache.acquire("A", NDIlib_recv_bandwidth_lowest);
+        if (proxy.reused()) { return 1; }
+    }
+
+    // So is one that delivers fields
+    {
+        auto const fields = cache.acquire("A", NDIlib_recv_bandwidth_highest, true);
+        if (!fields || fields.reused()) { return 1; }
+    }
+
+    // Over the cap: least recently used idle receivers go first, in-use ones never
+    {
+        auto const held = cache.acquire("B", NDIlib_recv_bandwidth_highest);
+        if (cache.openConnections() != 2) { return 1; }
+        auto const another = cache.acquire("C", NDIlib_recv_bandwidth_highest);
+        if (cache.openConnections() != 2) { return 1; }
+        auto const more = cache.acquire("D", NDIlib_recv_bandwidth_highest);
+        if (cache.openConnections() != 3) { return 1; } // All in use; over the cap until they come back
+    }
+    if (cache.openConnections() != 2) { return 1; }
+
+    // Idle timeout
+    if (cache.evictIdle() != 0) { return 1; }
+    if (cache.evictIdle(ReceiverCache::clock::now() + 2min) != 2 || cache.openConnections() != 0) { return 1; }
+
+    // Moving a lease moves the responsibility for returning it, and what it knew about the receiver; an empty
+    //  lease knows nothing
+    {
+        auto lease = cache.acquire("E", NDIlib_recv_bandwidth_highest);
+        ReceiverCache::Lease moved{ std::move(lease) };
+        if (lease || !moved || lease.connected() != ReceiverCache::clock::time_point{}) { return 1; }
+        moved.reset();
+        auto again = cache.acquire("E", NDIlib_recv_bandwidth_highest);
+        if (!again.reused()) { return 1; }
+        moved = std::move(again);
+        if (again.reused() || again.connected() != ReceiverCache::clock::time_point{} || !moved.reused()) { return 1; }
+        moved.reset();
+        if (moved.reused() || moved.connected() != ReceiverCache::clock::time_point{}) { return 1; }
+    }
+    if (cache.openConnections() != 1) { return 1; }
+
+    // A lease closed rather than returned takes its receiver with it
+    {
+        auto lease = cache.acquire("E", NDIlib_recv_bandwidth_highest);
+        if (!lease.reused()) { return 1; }
+        lease.close();
+        if (lease || lease.reused() || cache.openConnections() != 0) { return 1; }
+    }
+    if (cache.openConnections() != 0) { return 1; }
+
+    // No caching at all
+    cache.setLimits(0, 1min);
+    if (cache.openConnections() != 0) { return 1; }
+    {
+        auto const lease = cache.acquire("F", NDIlib_recv_bandwidth_highest);
+    }
+    if (cache.openConnections() != 0) { return 1; }
+
+    // Every receiver closed is destroyed: none left alive behind the cache's back
+    if (ndiHandlesCounted && ReceiverHandle::live() != 0) { return 1; }
+    {
+        ReceiverCache scoped{ 4, 1min };
+        auto const lease = scoped.acquire("G", NDIlib_recv_bandwidth_highest);
+        scoped.acquire("H", NDIlib_recv_bandwidth_highest);
+        if (ndiHandlesCounted && ReceiverHandle::live() != 2) { return 1; }
+    }
+    if (ndiHandlesCounted && ReceiverHandle::live() != 0) { return 1; }
+    return 0;
+}
@@ -0,0 +1,125 @@
+#include "AudioRouter.h"
+#include "MockNDI.h"
+#include "ReceiverPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    class CountingVideo : public VideoTarget
+    {
+    public:
+        QSize targetSize() const override { return { 160, 90 }; }
+        QImage& backBuffer() override { return m_image; }
+        void publishFrame(std::chrono::system_clock::time_point) override { ++published; }
+
+        std::atomic<int> published{ 0 };
+
+    private:
+        QImage m_image;
+    };
+
+    class CountingAudio : public AudioTarget
+    {
+    public:
+        int start(int sourceSampleRate, int, std::chrono::microseconds) override { ++starts; return sourceSampleRate; }
+        void stop() override { ++stops; }
+        void write(float const*, int, size_t frames, std::chrono::system_clock::time_point) override { written += frames; }
+        std::optional<std::chrono::system_clock::time_point> presentationClock() const override { return std::chrono::system_clock::time_point{ std::chrono::seconds{ 1 } }; }
+
+        std::atomic<int> starts{ 0 };
+        std::atomic<int> stops{ 0 };
+        std::atomic<size_t> written{ 0 };
+    };
+}
+
+int main()
+{
+    using namespace std::chrono_literals;
+
+    // Only the selected input reaches the output, however the calls interleave
+    {
+        CountingAudio output;
+        AudioRouter router{ output, 2 };
+        float const samples[4]{};
+
+        if (router.input(0).active() || router.input(1).active()) { return 1; }
+        if (router.input(0).start(48000, 2, 20ms) != 48000 || output.starts != 0) { return 1; }
+
+        router.select(1);
+        if (!router.input(1).active() || router.input(1).start(48000, 2, 20ms) != 48000 || output.starts != 1) { return 1; }
+        router.input(0).write(samples, 8, 2, {});
+        router.input(1).write(samples, 8, 2, {});
+        if (output.written != 2) { return 1; }
+        if (router.input(0).presentationClock() || !router.input(1).presentationClock()) { return 1; }
+
+        // Handover: the new input starts before the old one has noticed and stopped
+        router.select(0);
+        router.input(0).start(48000, 2, 20ms);
+        router.input(1).write(samples, 8, 2, {});
+        router.input(1).stop();
+        router.input(0).write(samples, 8, 2, {});
+        if (output.starts != 2 || output.stops != 0 || output.written != 4) { return 1; }
+        router.input(0).stop();
+        if (output.stops != 1) { return 1; }
+    }
+
+    // Six sources on two threads: none starves, and none is ticked faster than its rate. How many ticks fit
+    //  in the run is up to the host, so each source is judged against the others and against the time the
+    //  pool actually ran, not against a fixed count.
+    {
+        MockNDI::Config config;
+        config.sourceCount = 6;
+        config.width = 320;
+        config.height = 180;
+        MockNDI::setConfig(config);
+
+        ReceiverCache receivers{ 0 };
+        CountingAudio output;
+        AudioRouter router{ output, static_cast<size_t>(config.sourceCount) };
+        router.select(2);
+
+        std::vector<std::unique_ptr<CountingVideo>> videos;
+        std::vector<std::unique_ptr<ReceiverEngine>> engines;
+        ReceiverPool pool{ 2 };
+        for (int i = 0; i < config.sourceCount; ++i)
+        {
+            videos.push_back(std::make_unique<CountingVideo>());
+            engines.push_back(std::make_unique<ReceiverEngine>(*videos.back(), router.input(i), receivers));
+            ReceiverSettings settings;
+            settings.sourceName = QString("MOCK (Synthetic %1)").arg(i + 1);
+            settings.capturesPerSecond = 25;
+            pool.add(*engines.back(), settings);
+        }
+        if (pool.threadCount() != 2) { return 1; }
+
+        auto const started = std::chrono::steady_clock::now();
+        pool.start();
+        std::this_thread::sleep_for(1s);
+        pool.stop();
+        double const ran = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+        uint64_t total = 0;
+        uint64_t fewest = UINT64_MAX;
+        for (int i = 0; i < config.sourceCount; ++i)
+        {
+            uint64_t const ticks = engines[i]->stats().ticks.load();
+            if (ticks == 0 || ticks > static_cast<uint64_t>(25 * ran) + 2) { return 1; }
+            if (videos[i]->published == 0) { return 1; }
+            total += ticks;
+            fewest = std::min(fewest, ticks);
+        }
+        if (pool.ticksFired() != total || fewest * 2 * config.sourceCount < total) { return 1; }
+
+        // Only the selected source's audio was captured and played, and it was stopped with the pool
+        if (output.starts != 1 || output.written == 0 || output.stops != 1) { return 1; }
+        if (receivers.openConnections() != 0) { return 1; }
+    }
+    return 0;
+}
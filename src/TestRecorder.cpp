@@ -0,0 +1,158 @@
+#include "Recorder.h"
+#include "RecordingReader.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+using namespace RecordingFormat;
+
+namespace
+{
+    constexpr int width = 320;
+    constexpr int height = 180;
+    constexpr int stride = width * 2;
+    constexpr int channels = 2;
+    constexpr size_t audioFrames = 1601; // Odd, so the interleaved audio ends off any alignment
+    constexpr int records = 60;
+    constexpr int64_t firstTimestamp = 17000000000000000;
+    constexpr int64_t frameTicks = 333667; // 29.97 fps in 100 ns units
+
+    uint8_t pixel(int frame, size_t i) { return static_cast<uint8_t>(frame * 7 + i * 13); }
+    float sample(int block, int channel, size_t f) { return static_cast<float>(block) + channel * 0.5f + f / 4096.0f; }
+
+    VideoFormat uyvy()
+    {
+        return { 0x59565955 /* UYVY */, width, height, stride, 30000, 1001, 1, 16.0f / 9.0f };
+    }
+}
+
+int main()
+{
+    auto const directory = std::filesystem::temp_directory_path();
+    auto const path = directory / "ndirecv-test-recording.ndirec";
+    auto const unfinishedPath = directory / "ndirecv-test-unfinished.ndirec";
+
+    {
+        // Video and audio interleaved, enough to spread over a few buffers with records straddling them
+        PipelineStats stats;
+        Recorder recorder{ stats };
+        if (recorder.recording() || !recorder.start(path, "MACHINE (Test source)") || !recorder.recording()) { return 1; }
+
+        std::vector<uint8_t> frame(static_cast<size_t>(stride) * height);
+        std::vector<float> planar(channels * audioFrames);
+        for (int i = 0; i < records; ++i)
+        {
+            for (size_t b = 0; b < frame.size(); ++b) { frame[b] = pixel(i, b); }
+            if (!recorder.recordVideo(uyvy(), firstTimestamp + i * frameTicks, i, frame.data(), frame.size())) { return 1; }
+
+            for (int c = 0; c < channels; ++c)
+            {
+                for (size_t f = 0; f < audioFrames; ++f) { planar[c * audioFrames + f] = sample(i, c, f); }
+            }
+            if (!recorder.recordAudio(48000, channels, firstTimestamp + i * frameTicks + 1, 0, planar.data(), audioFrames, audioFrames)) { return 1; }
+        }
+        if (!recorder.stop() || recorder.recording() || !recorder.error().empty()) { return 1; }
+        if (stats.recording.active || stats.recording.videoFramesRecorded != records || stats.recording.audioBlocksRecorded != records) { return 1; }
+        if (stats.recording.videoFramesDropped != 0 || stats.recording.audioBlocksDropped != 0) { return 1; }
+        if (stats.recording.bytesWritten < records * (frame.size() + planar.size() * sizeof(float)) || stats.recordWrite.snapshot().count == 0) { return 1; }
+        if (stats.recordCopy.snapshot().count != 2 * records) { return 1; }
+
+        // Nothing more is taken once stopped
+        if (recorder.recordVideo(uyvy(), firstTimestamp, 0, frame.data(), frame.size())) { return 1; }
+    }
+
+    {
+        // Read back in place, through the index
+        RecordingReader reader;
+        if (!reader.open(path) || !reader.finished() || reader.sourceName() != "MACHINE (Test source)" || reader.startedAt() <= 0) { return 1; }
+        auto const& video = reader.entries(RecordType::Video);
+        auto const& audio = reader.entries(RecordType::Audio);
+        if (video.size() != records || audio.size() != records) { return 1; }
+        for (int i = 0; i < records; ++i)
+        {
+            auto const frame = reader.read(video[i]);
+            if (frame.header->timestamp != firstTimestamp + i * frameTicks || frame.header->timecode != i) { return 1; }
+            if (frame.header->video.width != width || frame.header->video.frameRateD != 1001 || frame.header->payloadBytes != size_t{ stride } * height) { return 1; }
+            if (reinterpret_cast<uintptr_t>(frame.payload) % recordAlignment != 0) { return 1; }
+            for (size_t b = 0; b < frame.header->payloadBytes; ++b)
+            {
+                if (frame.payload[b] != pixel(i, b)) { return 1; }
+            }
+
+            auto const block = reader.read(audio[i]);
+            if (block.header->audio.sampleRate != 48000 || block.header->audio.channels != channels || block.header->audio.frames != audioFrames) { return 1; }
+            auto const* const interleaved = reinterpret_cast<float const*>(block.payload);
+            for (size_t f = 0; f < audioFrames; ++f)
+            {
+                for (int c = 0; c < channels; ++c)
+                {
+                    if (interleaved[f * channels + c] != sample(i, c, f)) { return 1; }
+                }
+            }
+        }
+
+        // Seeking finds the frame showing at a time
+        if (reader.find(RecordType::Video, firstTimestamp - 1) || reader.find(RecordType::Video, firstTimestamp) != 0u) { return 1; }
+        if (reader.find(RecordType::Video, firstTimestamp + 10 * frameTicks + 5) != 10u || reader.find(RecordType::Video, INT64_MAX) != records - 1u) { return 1; }
+        if (reader.find(RecordType::Audio, firstTimestamp + 10 * frameTicks) != 9u) { return 1; }
+    }
+
+    {
+        // A recording cut short, with no index and its last record half there, still reads up to that record
+        std::filesystem::copy_file(path, unfinishedPath, std::filesystem::copy_options::overwrite_existing);
+        RecordingReader finished;
+        if (!finished.open(path)) { return 1; }
+        uint64_t const cut{ finished.entries(RecordType::Video)[records - 1].offset + 100 };
+        finished.close();
+
+        std::filesystem::resize_file(unfinishedPath, cut);
+        {
+            std::fstream file{ unfinishedPath, std::ios::in | std::ios::out | std::ios::binary };
+            uint64_t const noIndex{ 0 };
+            file.seekp(offsetof(FileHeader, indexOffset));
+            file.write(reinterpret_cast<char const*>(&noIndex), sizeof(noIndex));
+        }
+        RecordingReader reader;
+        if (!reader.open(unfinishedPath) || reader.finished()) { return 1; }
+        if (reader.entries(RecordType::Video).size() != records - 1 || reader.entries(RecordType::Audio).size() != records - 1) { return 1; }
+        auto const last = reader.read(reader.entries(RecordType::Audio).back());
+        if (reinterpret_cast<float const*>(last.payload)[1] != sample(records - 2, 1, 0)) { return 1; }
+    }
+
+    {
+        // A frame bigger than all the buffers together is dropped and counted, and the rest still recorded
+        PipelineStats stats;
+        Recorder recorder{ stats, 2 };
+        if (!recorder.start(path, "Small")) { return 1; }
+        std::vector<uint8_t> huge(2 * Recorder::bufferBytes + 1, 1);
+        std::vector<uint8_t> small(static_cast<size_t>(stride) * height, 2);
+        if (recorder.recordVideo({ 0x59565955, width, static_cast<int32_t>(huge.size() / stride), stride, 30, 1, 1, 0.0f }, 0, 0, huge.data(), huge.size())) { return 1; }
+        if (!recorder.recordVideo(uyvy(), 0, 0, small.data(), small.size())) { return 1; }
+        if (!recorder.stop() || stats.recording.videoFramesDropped != 1 || stats.recording.videoFramesRecorded != 1) { return 1; }
+
+        RecordingReader reader;
+        if (!reader.open(path) || reader.entries(RecordType::Video).size() != 1) { return 1; }
+        auto const frame = reader.read(reader.entries(RecordType::Video)[0]);
+        if (frame.header->timestamp <= 0 || frame.payload[0] != 2) { return 1; } // No source timestamp: stamped as received
+    }
+
+    {
+        // Anything else is refused
+        {
+            std::ofstream file{ unfinishedPath, std::ios::binary | std::ios::trunc };
+            std::vector<char> const text(8192, 'x');
+            file.write(text.data(), text.size());
+        }
+        RecordingReader reader;
+        if (reader.open(unfinishedPath) || reader.error().empty()) { return 1; }
+        PipelineStats stats;
+        Recorder recorder{ stats };
+        if (recorder.start(directory / "no such directory" / "x.ndirec", "") || recorder.error().empty() || recorder.recording()) { return 1; }
+    }
+
+    std::filesystem::remove(path);
+    std::filesystem::remove(unfinishedPath);
+    return 0;
+}
@@ -0,0 +1,31 @@
+#include "SourceTable.h"
+
+int main()
+{
+    // Remembered sources are listed before the finder has seen anything
+    SourceTable table{ QStringList{ "A (1)", "B (1)" } };
+    if (table.names() != QStringList({ "A (1)", "B (1)" }) || table.isConfirmed("A (1)")) { return 1; }
+
+    // Seen: confirmed, not added again. New ones are added. Nothing goes while the finder is settling.
+    SourceDiff diff = table.update({ "A (1)", "C (1)" }, false);
+    if (diff.added != QStringList{ "C (1)" } || diff.confirmed != QStringList{ "A (1)" } || !diff.removed.isEmpty()) { return 1; }
+    if (!table.isConfirmed("A (1)") || table.isConfirmed("B (1)")) { return 1; }
+
+    // A lost source lingers until settled, too
+    diff = table.update({ "C (1)" }, false);
+    if (!diff.isEmpty() || table.names().size() != 3) { return 1; }
+
+    // No change, no diff
+    diff = table.update({ "C (1)" }, false);
+    if (!diff.isEmpty()) { return 1; }
+
+    // Settled: everything not seen goes, remembered or not
+    diff = table.update({ "C (1)" }, true);
+    if (diff.removed != QStringList({ "A (1)", "B (1)" }) || !diff.added.isEmpty()) { return 1; }
+    if (table.names() != QStringList{ "C (1)" }) { return 1; }
+
+    // And from then on, as soon as the finder loses it; duplicates from the finder are harmless
+    diff = table.update({ "D (1)", "D (1)" }, true);
+    if (diff.added != QStringList{ "D (1)" } || diff.removed != QStringList{ "C (1)" }) { return 1; }
+    return 0;
+}
@@ -0,0 +1,32 @@
+#include "Stats.h"
+
+int main()
+{
+    using namespace std::chrono_literals;
+
+    LatencyHistogram histogram;
+    if (histogram.snapshot().count != 0 || histogram.snapshot().percentileMicroseconds(0.5) != 0) { return 1; }
+
+    // 0us lands in the first bucket, 3us in [2,4), 1000us in [512,1024)
+    histogram.record(0us);
+    histogram.record(3us);
+    histogram.record(1000us);
+    histogram.record(1000us);
+
+    auto const snapshot = histogram.snapshot();
+    if (snapshot.count != 4 || snapshot.sumMicroseconds != 2003 || snapshot.maxMicroseconds != 1000) { return 1; }
+    if (snapshot.buckets[0] != 1 || snapshot.buckets[2] != 1 || snapshot.buckets[10] != 2) { return 1; }
+    if (snapshot.percentileMicroseconds(0.0) != 1) { return 1; }
+    if (snapshot.percentileMicroseconds(0.3) != 4) { return 1; }
+    if (snapshot.percentileMicroseconds(0.99) != 1000) { return 1; } // Bucket bound capped at the true maximum
+
+    // Absurdly long samples go in the last bucket rather than off the end
+    histogram.record(1h);
+    if (histogram.snapshot().buckets[LatencyHistogram::numBuckets - 1] != 1) { return 1; }
+
+    {
+        ScopedStageTimer timer(histogram);
+    }
+    if (histogram.snapshot().count != 6) { return 1; }
+    return 0;
+}
@@ -0,0 +1,63 @@
+#include "MockNDI.h"
+#include "ThumbnailEngine.h"
+
+#include <thread>
+
+namespace
+{
+    template <typename Condition>
+    bool waitFor(Condition const& condition, std::chrono::milliseconds timeout)
+    {
+        auto const deadline = std::chrono::steady_clock::now() + timeout;
+        while (!condition())
+        {
+            if (std::chrono::steady_clock::now() > deadline) { return false; }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return true;
+    }
+}
+
+int main()
+{
+    using namespace std::chrono_literals;
+
+    MockNDI::Config config;
+    config.sourceCount = 20;
+    config.width = 1280;
+    config.height = 720;
+    config.audioEnabled = false;
+    MockNDI::setConfig(config);
+
+    ThumbnailEngine thumbnails{ { 2, 1s, 2000ms } };
+    thumbnails.addSource("MOCK (Synthetic 1)");
+    thumbnails.addSource("MOCK (Synthetic 2)");
+    thumbnails.addSource("MOCK (Synthetic 3)");
+    if (!thumbnails.thumbnail("MOCK (Synthetic 1)").isNull()) { return 1; }
+
+    thumbnails.start();
+    if (!waitFor([&]() { return thumbnails.grabbed() >= 3; }, 5s)) { return 1; }
+
+    // One cell each, filled edge to edge for a 16:9 source, and not just black
+    QImage const first = thumbnails.thumbnail("MOCK (Synthetic 1)");
+    if (first.size() != QSize(ThumbnailEngine::cellWidth, ThumbnailEngine::cellHeight)) { return 1; }
+    if ((first.pixel(10, 10) & 0xffffff) == 0) { return 1; }
+    if (thumbnails.atlasSize() != QSize(ThumbnailEngine::atlasColumns * ThumbnailEngine::cellWidth, ThumbnailEngine::cellHeight)) { return 1; }
+
+    // Revisited every refresh interval
+    uint64_t const before = thumbnails.grabbed();
+    if (!waitFor([&]() { return thumbnails.grabbed() >= before + 3; }, 3s)) { return 1; }
+
+    // Removed sources lose their cell; more sources than a row grows the atlas by a row
+    thumbnails.removeSource("MOCK (Synthetic 2)");
+    if (!thumbnails.thumbnail("MOCK (Synthetic 2)").isNull()) { return 1; }
+    for (int i = 4; i <= 20; ++i)
+    {
+        thumbnails.addSource(QString("MOCK (Synthetic %1)").arg(i));
+    }
+    if (thumbnails.atlasSize().height() != 2 * ThumbnailEngine::cellHeight) { return 1; }
+    if (!waitFor([&]() { return !thumbnails.thumbnail("MOCK (Synthetic 20)").isNull(); }, 10s)) { return 1; }
+
+    thumbnails.stop();
+    return thumbnails.failed() == 0 ? 0 : 1;
+}
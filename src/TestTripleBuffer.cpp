@@ -0,0 +1,50 @@
+#include "TripleBuffer.h"
+
+#include <thread>
+
+int main()
+{
+    {
+        TripleBuffer<int> buffer;
+
+        // Nothing published yet
+        if (buffer.acquireLatest()) { return 1; }
+
+        buffer.back() = 1;
+        if (buffer.publish()) { return 1; }
+        if (!buffer.acquireLatest() || buffer.front() != 1) { return 1; }
+        if (buffer.acquireLatest()) { return 1; } // Already consumed
+
+        // Publishing twice without a read overwrites the first value, and says so
+        buffer.back() = 2;
+        if (buffer.publish()) { return 1; }
+        buffer.back() = 3;
+        if (!buffer.publish()) { return 1; }
+        if (!buffer.acquireLatest() || buffer.front() != 3) { return 1; }
+    }
+
+    {
+        // Producer and consumer on separate threads; the consumer must only ever see values increase
+        TripleBuffer<int> buffer;
+        constexpr int lastValue = 200000;
+        std::thread producer([&buffer]() {
+            for (int i = 1; i <= lastValue; ++i)
+            {
+                buffer.back() = i;
+                buffer.publish();
+            }
+        });
+
+        int lastSeen = 0;
+        while (lastSeen != lastValue)
+        {
+            if (buffer.acquireLatest())
+            {
+                if (buffer.front() <= lastSeen) { producer.join(); return 1; }
+                lastSeen = buffer.front();
+            }
+        }
+        producer.join();
+    }
+    return 0;
+}
@@ -0,0 +1,87 @@
+#include "VideoConvert.h"
+
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace
+{
+    constexpr int tolerance = 0; // Per channel; every path does the same integer arithmetic
+
+    std::vector<uint8_t> randomFrame(int strideBytes, int height, unsigned seed)
+    {
+        std::mt19937 rng(seed);
+        std::vector<uint8_t> frame(static_cast<size_t>(strideBytes) * height);
+        for (auto& byte : frame) { byte = static_cast<uint8_t>(rng()); }
+        return frame;
+    }
+
+    std::vector<uint8_t> convertWith(KernelPath path, SourceFrame const& source, int width, int height)
+    {
+        std::vector<uint8_t> out(static_cast<size_t>(width) * height * 4);
+        FrameConverter converter(path);
+        converter.convert(source, { out.data(), width, height, width * 4 });
+        return out;
+    }
+
+    bool withinTolerance(std::vector<uint8_t> const& a, std::vector<uint8_t> const& b)
+    {
+        if (a.size() != b.size()) { return false; }
+        for (size_t i = 0; i < a.size(); ++i)
+        {
+            if (std::abs(int(a[i]) - int(b[i])) > tolerance) { return false; }
+        }
+        return true;
+    }
+
+    // Every SIMD path this machine supports must agree with the scalar path.
+    bool pathsAgree(PixelLayout layout, int srcWidth, int srcHeight, int dstWidth, int dstHeight)
+    {
+        int const stride = srcWidth * (layout == PixelLayout::UYVY ? 2 : 4) + 64; // Padded, as NDI frames can be
+        auto const frame = randomFrame(stride, srcHeight, srcWidth * 31 + srcHeight);
+        SourceFrame const source{ frame.data(), srcWidth, srcHeight, stride, layout };
+
+        auto const reference = convertWith(KernelPath::Scalar, source, dstWidth, dstHeight);
+        for (KernelPath path : { KernelPath::SSE41, KernelPath::AVX2 })
+        {
+            if (FrameConverter(path).path() != path) { continue; } // Not supported on this CPU
+            if (!withinTolerance(reference, convertWith(path, source, dstWidth, dstHeight))) { return false; }
+        }
+        return true;
+    }
+}
+
+int main()
+{
+    for (PixelLayout layout : { PixelLayout::UYVY, PixelLayout::BGRA, PixelLayout::RGBA })
+    {
+        if (!pathsAgree(layout, 1920, 1080, 320, 180)) { return 1; }
+        if (!pathsAgree(layout, 1280, 720, 301, 173)) { return 1; }  // Uneven box sizes
+        if (!pathsAgree(layout, 1920, 1080, 1280, 720)) { return 1; } // Mild, with boxes of one and two columns
+        if (!pathsAgree(layout, 1920, 1080, 1920, 1080)) { return 1; } // 1:1
+        if (!pathsAgree(layout, 1920, 1080, 7, 3)) { return 1; }       // Boxes too big to average in floats
+        if (!pathsAgree(layout, 66, 38, 130, 80)) { return 1; }      // Enlarging
+        if (!pathsAgree(layout, 18, 4, 18, 4)) { return 1; }         // 1:1, narrower than one SIMD block
+    }
+
+    {
+        // Limited range white and black UYVY average to full range white and black
+        std::vector<uint8_t> uyvy{ 128, 235, 128, 235, 128, 16, 128, 16 };
+        std::vector<uint8_t> out(2 * 4);
+        FrameConverter().convert({ uyvy.data(), 4, 1, 8, PixelLayout::UYVY }, { out.data(), 2, 1, 8 });
+        std::vector<uint8_t> const expected{ 255, 255, 255, 255, 0, 0, 0, 255 };
+        if (!withinTolerance(out, expected)) { return 1; }
+    }
+
+    {
+        // A 2x2 RGBA box averages, and comes out in BGRA byte order
+        std::vector<uint8_t> rgba{ 200, 0, 0, 0,   0, 100, 0, 0,
+                                   0, 0, 40, 0,    0, 0, 0, 0 };
+        std::vector<uint8_t> out(4);
+        FrameConverter().convert({ rgba.data(), 2, 2, 8, PixelLayout::RGBA }, { out.data(), 1, 1, 4 });
+        std::vector<uint8_t> const expected{ 10, 25, 50, 255 };
+        if (!withinTolerance(out, expected)) { return 1; }
+    }
+
+    return 0;
+}
@@ -0,0 +1,233 @@
+#include "ThumbnailEngine.h"
+
+#include <QRect>
+#include <algorithm>
+
+#include "Processing.NDI.Lib.h"
+#include "FramePool.h"
+#include "NDIDeleters.h"
+#include "ReceiverEngine.h"
+#include "Log.h"
+
+ThumbnailEngine::ThumbnailEngine(Settings const& settings, QObject* parent)
+	: QObject(parent)
+	, m_settings{ settings }
+{
+}
+
+ThumbnailEngine::~ThumbnailEngine()
+{
+	stop();
+}
+
+void ThumbnailEngine::addSource(QString const& name)
+{
+	{
+		std::lock_guard lock(m_mutex);
+		if (m_entries.contains(name))
+		{
+			return;
+		}
+		// New sources go to the front of the queue
+		m_entries.emplace(name, Entry{ allocateCell(), clock::now(), false, false, m_nextGeneration++ });
+	}
+	m_wake.notify_one();
+}
+
+void ThumbnailEngine::removeSource(QString const& name)
+{
+	std::lock_guard lock(m_mutex);
+	auto const entry = m_entries.find(name);
+	if (entry == m_entries.end())
+	{
+		return;
+	}
+	m_freeCells.push_back(entry->second.cell);
+	m_entries.erase(entry);
+}
+
+void ThumbnailEngine::start()
+{
+	if (!m_threads.empty())
+	{
+		return;
+	}
+	m_stopping = false;
+	for (size_t i = 0; i < std::max<size_t>(m_settings.concurrency, 1); ++i)
+	{
+		m_threads.emplace_back(&ThumbnailEngine::work, this);
+	}
+}
+
+void ThumbnailEngine::stop()
+{
+	if (m_threads.empty())
+	{
+		return;
+	}
+	{
+		std::lock_guard lock(m_mutex);
+		m_stopping = true;
+	}
+	m_wake.notify_all();
+	for (auto& thread : m_threads)
+	{
+		thread.join();
+	}
+	m_threads.clear();
+}
+
+QImage ThumbnailEngine::thumbnail(QString const& name) const
+{
+	std::lock_guard lock(m_mutex);
+	auto const entry = m_entries.find(name);
+	if (entry == m_entries.end() || !entry->second.hasThumbnail)
+	{
+		return {};
+	}
+	return m_atlas.copy(cellRect(entry->second.cell));
+}
+
+QSize ThumbnailEngine::atlasSize() const
+{
+	std::lock_guard lock(m_mutex);
+	return m_atlas.size();
+}
+
+int ThumbnailEngine::allocateCell()
+{
+	if (!m_freeCells.empty())
+	{
+		int const cell = m_freeCells.back();
+		m_freeCells.pop_back();
+		return cell;
+	}
+	int const cell = m_cellsAllocated++;
+	int const rowsNeeded = cell / atlasColumns + 1;
+	if (m_atlas.height() < rowsNeeded * cellHeight)
+	{
+		// Another row of cells. Rare, and the atlas is small, so copying it over is fine.
+		QImage grown = FramePool::shared().image(QSize(atlasColumns * cellWidth, rowsNeeded * cellHeight));
+		grown.fill(Qt::black);
+		for (int y = 0; y < m_atlas.height(); ++y)
+		{
+			std::copy_n(m_atlas.constScanLine(y), m_atlas.bytesPerLine(), grown.scanLine(y));
+		}
+		m_atlas = std::move(grown);
+	}
+	return cell;
+}
+
+QRect ThumbnailEngine::cellRect(int const cell) const
+{
+	return QRect((cell % atlasColumns) * cellWidth, (cell / atlasColumns) * cellHeight, cellWidth, cellHeight);
+}
+
+void ThumbnailEngine::work()
+{
+	FrameConverter converter; // Per worker; stops allocating once it has seen the widest proxy frame
+	QImage scaled{ cellWidth, cellHeight, QImage::Format_RGB32 }; // Per worker, so scaling needs no lock
+	std::unique_lock lock(m_mutex);
+	while (!m_stopping)
+	{
+		// Whichever source has been waiting longest
+		auto next = m_entries.end();
+		for (auto entry = m_entries.begin(); entry != m_entries.end(); ++entry)
+		{
+			if (!entry->second.inFlight && (next == m_entries.end() || entry->second.due < next->second.due))
+			{
+				next = entry;
+			}
+		}
+		if (next == m_entries.end())
+		{
+			m_wake.wait(lock);
+			continue;
+		}
+		if (clock::now() < next->second.due)
+		{
+			m_wake.wait_until(lock, next->second.due);
+			continue;
+		}
+
+		QString const name = next->first;
+		uint64_t const generation = next->second.generation;
+		next->second.inFlight = true;
+
+		lock.unlock();
+		bool const grabbed = grab(name, generation, converter, scaled);
+		(grabbed ? m_grabbed : m_failed).fetch_add(1, std::memory_order_relaxed);
+		if (grabbed)
+		{
+			emit thumbnailUpdated(name);
+		}
+		lock.lock();
+
+		if (auto const entry = m_entries.find(name); entry != m_entries.end() && entry->second.generation == generation)
+		{
+			entry->second.inFlight = false;
+			entry->second.due = clock::now() + m_settings.refreshInterval;
+		}
+	}
+}
+
+bool ThumbnailEngine::grab(QString const& name, uint64_t const generation, FrameConverter& converter, QImage& scaled)
+{
+	// A fresh receiver per visit: at one frame per source every half minute, holding hundreds of
+	//  connections open in between would cost far more than reconnecting
+	std::string const sourceName{ name.toStdString() };
+	NDIlib_source_t const source{ sourceName.c_str() };
+	NDIlib_recv_create_v3_t const recvSettings{ source,
+		                                        NDIlib_recv_color_format_UYVY_BGRA,
+		                                        NDIlib_recv_bandwidth_lowest, // The proxy stream; plenty for a thumbnail
+		                                        false };
+	ReceiverHandle const receiver{ ReceiverHandle::create(recvSettings) };
+	if (!receiver)
+	{
+		return false;
+	}
+
+	auto const deadline = clock::now() + m_settings.grabTimeout;
+	for (auto now = clock::now(); now < deadline; now = clock::now())
+	{
+		auto const remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now);
+		NDIlib_video_frame_v2_t video_frame;
+		if (NDIlib_recv_capture_v2(receiver.get(), &video_frame, nullptr, nullptr, static_cast<uint32_t>(remaining.count())) != NDIlib_frame_type_video)
+		{
+			continue;
+		}
+
+		bool converted = false;
+		if (auto const layout = pixelLayoutFor(video_frame.FourCC); layout && video_frame.p_data && video_frame.yres > 0)
+		{
+			// Letterboxed into a cell of our own, with no lock held: the scaling is the slow part, and the
+			//  other workers and the GUI's thumbnail() calls shouldn't wait on it
+			QSize const fitted{ QSize(video_frame.xres, video_frame.yres).scaled(scaled.size(), Qt::KeepAspectRatio) };
+			QPoint const topLeft{ (scaled.width() - fitted.width()) / 2, (scaled.height() - fitted.height()) / 2 };
+			scaled.fill(Qt::black);
+			if (!fitted.isEmpty())
+			{
+				converter.convert({ video_frame.p_data, video_frame.xres, video_frame.yres, video_frame.line_stride_in_bytes, *layout },
+					              { scaled.scanLine(topLeft.y()) + topLeft.x() * 4, fitted.width(), fitted.height(), static_cast<int>(scaled.bytesPerLine()) });
+			}
+
+			// Then into the atlas. The source may have been removed while we were connecting, and its cell
+			//  handed to another; only write if it is still ours.
+			std::lock_guard lock(m_mutex);
+			if (auto const entry = m_entries.find(name); entry != m_entries.end() && entry->second.generation == generation)
+			{
+				QRect const cell{ cellRect(entry->second.cell) };
+				for (int y = 0; y < cell.height(); ++y)
+				{
+					std::copy_n(scaled.constScanLine(y), cell.width() * 4, m_atlas.scanLine(cell.y() + y) + cell.x() * 4);
+				}
+				entry->second.hasThumbnail = true;
+				converted = true;
+			}
+		}
+		NDIlib_recv_free_video_v2(receiver.get(), &video_frame);
+		return converted;
+	}
+	LOG_DEBUG(QString("No thumbnail frame from %1 within %2 ms").arg(name).arg(m_settings.grabTimeout.count()));
+	return false;
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <QImage>
+#include <QObject>
+#include <QSize>
+#include <QString>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "VideoConvert.h"
+
+// Small preview pictures of every source listed, so the right feed can be found among hundreds by
+//  looking rather than by grabbing full frames one at a time. A few worker threads take turns through the
+//  sources, stalest first: each opens a proxy bandwidth receiver, takes one frame, scales it to the size of
+//  a cell, copies it into that source's cell of a shared atlas image and disconnects again. Concurrency is capped and each source
+//  is only revisited every refresh interval, so the network and CPU cost stays small however many there are.
+//
+// Thumbnail receivers are deliberately not taken from the ReceiverCache; hundreds of one-frame visits
+//  would push out the connections that playback and capture are keeping warm.
+class ThumbnailEngine : public QObject
+{
+    Q_OBJECT
+
+public:
+    using clock = std::chrono::steady_clock;
+
+    static constexpr int cellWidth = 160;
+    static constexpr int cellHeight = 90;
+    static constexpr int atlasColumns = 16;
+
+    struct Settings
+    {
+        size_t concurrency{ 4 };                        // Receivers open at once
+        std::chrono::seconds refreshInterval{ 30 };     // How often each source is revisited
+        std::chrono::milliseconds grabTimeout{ 3000 };  // Give up on a source that sends nothing for this long
+    };
+
+    explicit ThumbnailEngine(Settings const& settings, QObject* parent = nullptr);
+    ~ThumbnailEngine() override;
+
+    // Any thread.
+    void addSource(QString const& name);
+    void removeSource(QString const& name);
+
+    void start();
+    void stop();
+
+    // Any thread. A copy of the source's cell, or a null image if there is no thumbnail yet.
+    QImage thumbnail(QString const& name) const;
+
+    QSize atlasSize() const;
+    uint64_t grabbed() const { return m_grabbed.load(std::memory_order_relaxed); }
+    uint64_t failed() const { return m_failed.load(std::memory_order_relaxed); }
+
+signals:
+    // Emitted on a worker thread; connect with the default (queued) connection.
+    void thumbnailUpdated(QString const& name);
+
+private:
+    struct Entry
+    {
+        int cell;
+        clock::time_point due;  // When it should next be visited
+        bool inFlight{ false };
+        bool hasThumbnail{ false };
+        uint64_t generation;    // Tells a worker whether the source it was grabbing was removed (and maybe re-added) meanwhile
+    };
+
+    void work();
+    // Grabs one frame, scales it into the worker's own cell-sized image, then copies that into the entry's
+    //  cell. Returns false if nothing arrived in time.
+    bool grab(QString const& name, uint64_t generation, FrameConverter& converter, QImage& scaled);
+    int allocateCell(); // Caller holds the lock
+    QRect cellRect(int cell) const;
+
+    Settings const m_settings;
+    std::vector<std::thread> m_threads;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;
+    bool m_stopping{ false };
+    std::map<QString, Entry> m_entries;
+    std::vector<int> m_freeCells;
+    int m_cellsAllocated{ 0 };
+    uint64_t m_nextGeneration{ 0 };
+    QImage m_atlas; // Format_RGB32, atlasColumns cells wide, grown a row at a time
+
+    std::atomic<uint64_t> m_grabbed{ 0 };
+    std::atomic<uint64_t> m_failed{ 0 };
+};
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// Lock-free triple buffer for handing the newest value from one producer thread to one consumer thread.
+//  The producer always has a back slot to write into and never waits; the consumer always has a front
+//  slot to read from and never waits. The third slot is the one "in flight" between them. Publishing
+//  while an earlier publish has not been picked up simply replaces it - stale values are overwritten,
+//  never queued. Slots are reused, so once each slot has been sized nothing is allocated per exchange.
+template <typename T>
+class TripleBuffer
+{
+public:
+    TripleBuffer() = default;
+    TripleBuffer(TripleBuffer const&) = delete;
+    TripleBuffer& operator=(TripleBuffer const&) = delete;
+
+    // Producer side. Write into back(), then publish() it.
+    T& back() { return m_slots[m_backIndex]; }
+
+    // Returns true if the previously published value had not been consumed yet and was discarded.
+    bool publish()
+    {
+        uint8_t const previous = m_middle.exchange(static_cast<uint8_t>(m_backIndex | freshBit), std::memory_order_acq_rel);
+        m_backIndex = previous & indexMask;
+        return (previous & freshBit) != 0;
+    }
+
+    // Consumer side. Returns true if a newer value was swapped into front().
+    bool acquireLatest()
+    {
+        if ((m_middle.load(std::memory_order_relaxed) & freshBit) == 0)
+        {
+            return false;
+        }
+        uint8_t const previous = m_middle.exchange(m_frontIndex, std::memory_order_acq_rel);
+        m_frontIndex = previous & indexMask;
+        return true;
+    }
+
+    T const& front() const { return m_slots[m_frontIndex]; }
+
+private:
+    static constexpr uint8_t indexMask = 0x3;
+    static constexpr uint8_t freshBit = 0x4;
+
+    std::array<T, 3> m_slots{};
+    uint8_t m_backIndex{ 0 };                // Only touched by the producer
+    uint8_t m_frontIndex{ 1 };               // Only touched by the consumer
+    std::atomic<uint8_t> m_middle{ 2 };      // Index of the in-flight slot, plus a flag saying it is unread
+};
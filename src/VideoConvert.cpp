@@ -0,0 +1,391 @@
+#include "VideoConvert.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if NDIRECV_X86
+#include <immintrin.h>
+#endif
+
+namespace
+{
+	void accumulateRowScalar(uint8_t const* row, uint32_t* columnSums, int numBytes)
+	{
+		for (int i = 0; i < numBytes; ++i)
+		{
+			columnSums[i] += row[i];
+		}
+	}
+
+#if NDIRECV_X86
+	NDIRECV_TARGET_SSE41 void accumulateRowSse41(uint8_t const* row, uint32_t* columnSums, int numBytes)
+	{
+		int i = 0;
+		for (; i + 16 <= numBytes; i += 16)
+		{
+			__m128i const bytes = _mm_loadu_si128(reinterpret_cast<__m128i const*>(row + i));
+			__m128i* sums = reinterpret_cast<__m128i*>(columnSums + i);
+			_mm_storeu_si128(sums + 0, _mm_add_epi32(_mm_loadu_si128(sums + 0), _mm_cvtepu8_epi32(bytes)));
+			_mm_storeu_si128(sums + 1, _mm_add_epi32(_mm_loadu_si128(sums + 1), _mm_cvtepu8_epi32(_mm_srli_si128(bytes, 4))));
+			_mm_storeu_si128(sums + 2, _mm_add_epi32(_mm_loadu_si128(sums + 2), _mm_cvtepu8_epi32(_mm_srli_si128(bytes, 8))));
+			_mm_storeu_si128(sums + 3, _mm_add_epi32(_mm_loadu_si128(sums + 3), _mm_cvtepu8_epi32(_mm_srli_si128(bytes, 12))));
+		}
+		accumulateRowScalar(row + i, columnSums + i, numBytes - i);
+	}
+
+	NDIRECV_TARGET_AVX2 void accumulateRowAvx2(uint8_t const* row, uint32_t* columnSums, int numBytes)
+	{
+		int i = 0;
+		for (; i + 32 <= numBytes; i += 32)
+		{
+			__m256i* sums = reinterpret_cast<__m256i*>(columnSums + i);
+			for (int part = 0; part < 4; ++part)
+			{
+				__m128i const bytes = _mm_loadl_epi64(reinterpret_cast<__m128i const*>(row + i + part * 8));
+				_mm256_storeu_si256(sums + part, _mm256_add_epi32(_mm256_loadu_si256(sums + part), _mm256_cvtepu8_epi32(bytes)));
+			}
+		}
+		accumulateRowScalar(row + i, columnSums + i, numBytes - i);
+	}
+#endif
+
+	NDIRECV_FORCE_INLINE uint8_t clampToByte(int value)
+	{
+		return static_cast<uint8_t>(std::clamp(value, 0, 255));
+	}
+
+	// BT.709 limited range to full range RGB, 16.16 fixed point.
+	NDIRECV_FORCE_INLINE void yuvToBgr(int y, int u, int v, uint8_t* bgrOut)
+	{
+		int const c = (y - 16) * 76309;
+		int const d = u - 128;
+		int const e = v - 128;
+		constexpr int half = 1 << 15;
+		bgrOut[0] = clampToByte((c + 138438 * d + half) >> 16);
+		bgrOut[1] = clampToByte((c - 13975 * d - 34925 * e + half) >> 16);
+		bgrOut[2] = clampToByte((c + 117489 * e + half) >> 16);
+	}
+
+	// Start of the run of source samples feeding output index i, for a source of length s and output length d.
+	int boxStart(int i, int s, int d)
+	{
+		return static_cast<int>(static_cast<int64_t>(i) * s / d);
+	}
+
+	// One past the end of that run. Always at least one sample, so enlarging also works (by replication).
+	int boxEnd(int i, int s, int d)
+	{
+		return std::max(boxStart(i + 1, s, d), std::min(boxStart(i, s, d) + 1, s));
+	}
+
+	// Sums each output pixel's box of column sums into pixelSums, 4 per pixel: U, Y, V for UYVY, or the
+	//  source's first three channels in their own order. The fourth is unused.
+	void reducePixelsScalar(uint32_t const* sums, int const* columnBoxes, int width, PixelLayout layout, uint32_t* pixelSums)
+	{
+		for (int dx = 0; dx < width; ++dx, pixelSums += 4)
+		{
+			uint32_t sum0 = 0, sum1 = 0, sum2 = 0;
+			if (layout == PixelLayout::UYVY)
+			{
+				// Every source pixel contributes its own Y and the U/V of the pair it belongs to.
+				for (int x = columnBoxes[dx * 2]; x < columnBoxes[dx * 2 + 1]; ++x)
+				{
+					int const pair = (x / 2) * 4;
+					sum0 += sums[pair];
+					sum1 += sums[x * 2 + 1];
+					sum2 += sums[pair + 2];
+				}
+			}
+			else
+			{
+				for (int x = columnBoxes[dx * 2]; x < columnBoxes[dx * 2 + 1]; ++x)
+				{
+					sum0 += sums[x * 4];
+					sum1 += sums[x * 4 + 1];
+					sum2 += sums[x * 4 + 2];
+				}
+			}
+			pixelSums[0] = sum0;
+			pixelSums[1] = sum1;
+			pixelSums[2] = sum2;
+			pixelSums[3] = 0;
+		}
+	}
+
+	// Averages each pixel's sums over its box (boxWidths[dx] columns by rows) and converts to 0xffRRGGBB.
+	void convertPixelsScalar(uint32_t const* pixelSums, uint32_t const* boxWidths, uint32_t rows, int width, PixelLayout layout, uint8_t* out)
+	{
+		for (int dx = 0; dx < width; ++dx, pixelSums += 4, out += 4)
+		{
+			uint32_t const count = boxWidths[dx] * rows;
+			uint32_t const rounding = count / 2;
+			int const average0 = static_cast<int>((pixelSums[0] + rounding) / count);
+			int const average1 = static_cast<int>((pixelSums[1] + rounding) / count);
+			int const average2 = static_cast<int>((pixelSums[2] + rounding) / count);
+			if (layout == PixelLayout::UYVY)
+			{
+				yuvToBgr(average1, average0, average2, out);
+			}
+			else
+			{
+				out[0] = static_cast<uint8_t>(layout == PixelLayout::BGRA ? average0 : average2);
+				out[1] = static_cast<uint8_t>(average1);
+				out[2] = static_cast<uint8_t>(layout == PixelLayout::BGRA ? average2 : average0);
+			}
+			out[3] = 0xFF;
+		}
+	}
+
+#if NDIRECV_X86
+	// A whole source pixel's column sums are one vector (two pixels' worth for UYVY), so a box is summed a
+	//  pixel or a pair at a time. AVX2 would only help boxes wider than it is worth splitting, so it uses this too.
+	NDIRECV_TARGET_SSE41 void reducePixelsSse41(uint32_t const* sums, int const* columnBoxes, int width, PixelLayout layout, uint32_t* pixelSums)
+	{
+		for (int dx = 0; dx < width; ++dx, pixelSums += 4)
+		{
+			int x = columnBoxes[dx * 2];
+			int const x1 = columnBoxes[dx * 2 + 1];
+			__m128i total = _mm_setzero_si128();
+			if (layout == PixelLayout::UYVY)
+			{
+				// Whole pairs as U, Y0, V, Y1, where U and V count once for each pixel; a half pair at either
+				//  edge is added on its own
+				uint32_t edgeU = 0, edgeY = 0, edgeV = 0;
+				if ((x & 1) && x < x1)
+				{
+					edgeU += sums[(x / 2) * 4];
+					edgeY += sums[x * 2 + 1];
+					edgeV += sums[(x / 2) * 4 + 2];
+					++x;
+				}
+				for (; x + 2 <= x1; x += 2)
+				{
+					total = _mm_add_epi32(total, _mm_loadu_si128(reinterpret_cast<__m128i const*>(sums + x * 2)));
+				}
+				if (x < x1)
+				{
+					edgeU += sums[x * 2];
+					edgeY += sums[x * 2 + 1];
+					edgeV += sums[x * 2 + 2];
+				}
+				__m128i const doubled = _mm_add_epi32(total, total);
+				total = _mm_setr_epi32(static_cast<int>(_mm_extract_epi32(doubled, 0) + edgeU),
+					static_cast<int>(_mm_extract_epi32(total, 1) + _mm_extract_epi32(total, 3) + edgeY),
+					static_cast<int>(_mm_extract_epi32(doubled, 2) + edgeV), 0);
+			}
+			else
+			{
+				for (; x < x1; ++x)
+				{
+					total = _mm_add_epi32(total, _mm_loadu_si128(reinterpret_cast<__m128i const*>(sums + x * 4)));
+				}
+			}
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(pixelSums), total);
+		}
+	}
+
+	// (sum + count / 2) / count for 32 bit integers below 2^24 and counts below 2^17: the float quotient is
+	//  at most 255.5, its rounding error under 2^-17 and any fraction at least 1/count away from the next
+	//  integer, so truncating it gives exactly the integer division.
+	NDIRECV_TARGET_SSE41 __m128i averageSse41(__m128i sum, __m128i count, __m128 countF)
+	{
+		__m128 const rounded = _mm_cvtepi32_ps(_mm_add_epi32(sum, _mm_srli_epi32(count, 1)));
+		return _mm_cvttps_epi32(_mm_div_ps(rounded, countF));
+	}
+
+	NDIRECV_TARGET_SSE41 __m128i clampToByteSse41(__m128i value)
+	{
+		return _mm_min_epi32(_mm_max_epi32(value, _mm_setzero_si128()), _mm_set1_epi32(255));
+	}
+
+	NDIRECV_TARGET_SSE41 __m128i packBgrSse41(__m128i b, __m128i g, __m128i r)
+	{
+		return _mm_or_si128(_mm_or_si128(b, _mm_slli_epi32(g, 8)), _mm_or_si128(_mm_slli_epi32(r, 16), _mm_set1_epi32(static_cast<int>(0xFF000000))));
+	}
+
+	// yuvToBgr, 4 pixels at a time
+	NDIRECV_TARGET_SSE41 __m128i yuvToBgrSse41(__m128i y, __m128i u, __m128i v)
+	{
+		__m128i const c = _mm_mullo_epi32(_mm_sub_epi32(y, _mm_set1_epi32(16)), _mm_set1_epi32(76309));
+		__m128i const d = _mm_sub_epi32(u, _mm_set1_epi32(128));
+		__m128i const e = _mm_sub_epi32(v, _mm_set1_epi32(128));
+		__m128i const cHalf = _mm_add_epi32(c, _mm_set1_epi32(1 << 15));
+		__m128i const b = _mm_srai_epi32(_mm_add_epi32(cHalf, _mm_mullo_epi32(d, _mm_set1_epi32(138438))), 16);
+		__m128i const g = _mm_srai_epi32(_mm_sub_epi32(_mm_sub_epi32(cHalf, _mm_mullo_epi32(d, _mm_set1_epi32(13975))), _mm_mullo_epi32(e, _mm_set1_epi32(34925))), 16);
+		__m128i const r = _mm_srai_epi32(_mm_add_epi32(cHalf, _mm_mullo_epi32(e, _mm_set1_epi32(117489))), 16);
+		return packBgrSse41(clampToByteSse41(b), clampToByteSse41(g), clampToByteSse41(r));
+	}
+
+	NDIRECV_TARGET_SSE41 void convertPixelsSse41(uint32_t const* pixelSums, uint32_t const* boxWidths, uint32_t rows, int width, PixelLayout layout, uint8_t* out)
+	{
+		__m128i const rowCount = _mm_set1_epi32(static_cast<int>(rows));
+		int dx = 0;
+		for (; dx + 4 <= width; dx += 4)
+		{
+			// Four pixels' sums, transposed to one vector per channel
+			__m128i const* const in = reinterpret_cast<__m128i const*>(pixelSums + dx * 4);
+			__m128i const p0 = _mm_loadu_si128(in + 0);
+			__m128i const p1 = _mm_loadu_si128(in + 1);
+			__m128i const p2 = _mm_loadu_si128(in + 2);
+			__m128i const p3 = _mm_loadu_si128(in + 3);
+			__m128i const low01 = _mm_unpacklo_epi32(p0, p1);
+			__m128i const low23 = _mm_unpacklo_epi32(p2, p3);
+			__m128i const high01 = _mm_unpackhi_epi32(p0, p1);
+			__m128i const high23 = _mm_unpackhi_epi32(p2, p3);
+
+			__m128i const count = _mm_mullo_epi32(_mm_loadu_si128(reinterpret_cast<__m128i const*>(boxWidths + dx)), rowCount);
+			__m128 const countF = _mm_cvtepi32_ps(count);
+			__m128i const average0 = averageSse41(_mm_unpacklo_epi64(low01, low23), count, countF);
+			__m128i const average1 = averageSse41(_mm_unpackhi_epi64(low01, low23), count, countF);
+			__m128i const average2 = averageSse41(_mm_unpacklo_epi64(high01, high23), count, countF);
+
+			__m128i const pixels = layout == PixelLayout::UYVY ? yuvToBgrSse41(average1, average0, average2)
+				: layout == PixelLayout::BGRA ? packBgrSse41(average0, average1, average2)
+				: packBgrSse41(average2, average1, average0);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out + dx * 4), pixels);
+		}
+		convertPixelsScalar(pixelSums + dx * 4, boxWidths + dx, rows, width - dx, layout, out + dx * 4);
+	}
+
+	NDIRECV_TARGET_AVX2 __m256i averageAvx2(__m256i sum, __m256i count, __m256 countF)
+	{
+		__m256 const rounded = _mm256_cvtepi32_ps(_mm256_add_epi32(sum, _mm256_srli_epi32(count, 1)));
+		return _mm256_cvttps_epi32(_mm256_div_ps(rounded, countF));
+	}
+
+	NDIRECV_TARGET_AVX2 __m256i clampToByteAvx2(__m256i value)
+	{
+		return _mm256_min_epi32(_mm256_max_epi32(value, _mm256_setzero_si256()), _mm256_set1_epi32(255));
+	}
+
+	NDIRECV_TARGET_AVX2 __m256i packBgrAvx2(__m256i b, __m256i g, __m256i r)
+	{
+		return _mm256_or_si256(_mm256_or_si256(b, _mm256_slli_epi32(g, 8)), _mm256_or_si256(_mm256_slli_epi32(r, 16), _mm256_set1_epi32(static_cast<int>(0xFF000000))));
+	}
+
+	NDIRECV_TARGET_AVX2 __m256i yuvToBgrAvx2(__m256i y, __m256i u, __m256i v)
+	{
+		__m256i const c = _mm256_mullo_epi32(_mm256_sub_epi32(y, _mm256_set1_epi32(16)), _mm256_set1_epi32(76309));
+		__m256i const d = _mm256_sub_epi32(u, _mm256_set1_epi32(128));
+		__m256i const e = _mm256_sub_epi32(v, _mm256_set1_epi32(128));
+		__m256i const cHalf = _mm256_add_epi32(c, _mm256_set1_epi32(1 << 15));
+		__m256i const b = _mm256_srai_epi32(_mm256_add_epi32(cHalf, _mm256_mullo_epi32(d, _mm256_set1_epi32(138438))), 16);
+		__m256i const g = _mm256_srai_epi32(_mm256_sub_epi32(_mm256_sub_epi32(cHalf, _mm256_mullo_epi32(d, _mm256_set1_epi32(13975))), _mm256_mullo_epi32(e, _mm256_set1_epi32(34925))), 16);
+		__m256i const r = _mm256_srai_epi32(_mm256_add_epi32(cHalf, _mm256_mullo_epi32(e, _mm256_set1_epi32(117489))), 16);
+		return packBgrAvx2(clampToByteAvx2(b), clampToByteAvx2(g), clampToByteAvx2(r));
+	}
+
+	NDIRECV_TARGET_AVX2 void convertPixelsAvx2(uint32_t const* pixelSums, uint32_t const* boxWidths, uint32_t rows, int width, PixelLayout layout, uint8_t* out)
+	{
+		__m256i const rowCount = _mm256_set1_epi32(static_cast<int>(rows));
+		int dx = 0;
+		for (; dx + 8 <= width; dx += 8)
+		{
+			// Pixels 0-3 in the low lane and 4-7 in the high one, so the in-lane transpose keeps them in order
+			__m128i const* const in = reinterpret_cast<__m128i const*>(pixelSums + dx * 4);
+			__m256i p[4];
+			for (int i = 0; i < 4; ++i)
+			{
+				p[i] = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128(in + i)), _mm_loadu_si128(in + 4 + i), 1);
+			}
+			__m256i const low01 = _mm256_unpacklo_epi32(p[0], p[1]);
+			__m256i const low23 = _mm256_unpacklo_epi32(p[2], p[3]);
+			__m256i const high01 = _mm256_unpackhi_epi32(p[0], p[1]);
+			__m256i const high23 = _mm256_unpackhi_epi32(p[2], p[3]);
+
+			__m256i const count = _mm256_mullo_epi32(_mm256_loadu_si256(reinterpret_cast<__m256i const*>(boxWidths + dx)), rowCount);
+			__m256 const countF = _mm256_cvtepi32_ps(count);
+			__m256i const average0 = averageAvx2(_mm256_unpacklo_epi64(low01, low23), count, countF);
+			__m256i const average1 = averageAvx2(_mm256_unpackhi_epi64(low01, low23), count, countF);
+			__m256i const average2 = averageAvx2(_mm256_unpacklo_epi64(high01, high23), count, countF);
+
+			__m256i const pixels = layout == PixelLayout::UYVY ? yuvToBgrAvx2(average1, average0, average2)
+				: layout == PixelLayout::BGRA ? packBgrAvx2(average0, average1, average2)
+				: packBgrAvx2(average2, average1, average0);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + dx * 4), pixels);
+		}
+		convertPixelsScalar(pixelSums + dx * 4, boxWidths + dx, rows, width - dx, layout, out + dx * 4);
+	}
+#endif
+
+	// Largest box the vector paths average exactly; see averageSse41(). Only a huge downscale has more.
+	constexpr uint32_t maxVectorBox{ 65535 };
+}
+
+FrameConverter::FrameConverter(KernelPath path)
+	: m_path{ CpuFeatures::resolve(path) }
+{
+	m_accumulateRow = accumulateRowScalar;
+	m_reducePixels = reducePixelsScalar;
+	m_convertPixels = convertPixelsScalar;
+#if NDIRECV_X86
+	if (m_path == KernelPath::AVX2)
+	{
+		m_accumulateRow = accumulateRowAvx2;
+		m_reducePixels = reducePixelsSse41;
+		m_convertPixels = convertPixelsAvx2;
+	}
+	if (m_path == KernelPath::SSE41)
+	{
+		m_accumulateRow = accumulateRowSse41;
+		m_reducePixels = reducePixelsSse41;
+		m_convertPixels = convertPixelsSse41;
+	}
+#endif
+}
+
+void FrameConverter::convert(SourceFrame const& source, DestinationImage const& destination)
+{
+	if (!source.data || !destination.data || source.width <= 0 || source.height <= 0 || destination.width <= 0 || destination.height <= 0)
+	{
+		return;
+	}
+
+	// UYVY carries 2 bytes per pixel, the RGB layouts 4. It also comes in whole pixel pairs; an odd
+	//  trailing column (which NDI shouldn't send) is dropped rather than read past.
+	int const sourceWidth = source.layout == PixelLayout::UYVY ? (source.width & ~1) : source.width;
+	if (sourceWidth == 0)
+	{
+		return;
+	}
+	int const rowBytes = sourceWidth * (source.layout == PixelLayout::UYVY ? 2 : 4);
+	if (m_columnSums.size() < static_cast<size_t>(rowBytes))
+	{
+		m_columnSums.resize(rowBytes);
+	}
+	uint32_t* const sums = m_columnSums.data();
+
+	// Horizontal box edges are the same for every output row; work them out once.
+	if (m_columnBoxes.size() < static_cast<size_t>(destination.width) * 2)
+	{
+		m_columnBoxes.resize(static_cast<size_t>(destination.width) * 2);
+		m_boxWidths.resize(destination.width);
+		m_pixelSums.resize(static_cast<size_t>(destination.width) * 4);
+	}
+	uint32_t widestBox = 0;
+	for (int dx = 0; dx < destination.width; ++dx)
+	{
+		m_columnBoxes[dx * 2] = boxStart(dx, sourceWidth, destination.width);
+		m_columnBoxes[dx * 2 + 1] = boxEnd(dx, sourceWidth, destination.width);
+		m_boxWidths[dx] = static_cast<uint32_t>(m_columnBoxes[dx * 2 + 1] - m_columnBoxes[dx * 2]);
+		widestBox = std::max(widestBox, m_boxWidths[dx]);
+	}
+
+	for (int dy = 0; dy < destination.height; ++dy)
+	{
+		int const y0 = boxStart(dy, source.height, destination.height);
+		int const y1 = boxEnd(dy, source.height, destination.height);
+
+		std::memset(sums, 0, rowBytes * sizeof(uint32_t));
+		for (int y = y0; y < y1; ++y)
+		{
+			m_accumulateRow(source.data + static_cast<ptrdiff_t>(y) * source.strideBytes, sums, rowBytes);
+		}
+
+		uint32_t const rows = static_cast<uint32_t>(y1 - y0);
+		uint8_t* const out = destination.data + static_cast<ptrdiff_t>(dy) * destination.strideBytes;
+		m_reducePixels(sums, m_columnBoxes.data(), destination.width, source.layout, m_pixelSums.data());
+		auto const convertPixels = static_cast<uint64_t>(widestBox) * rows <= maxVectorBox ? m_convertPixels : convertPixelsScalar;
+		convertPixels(m_pixelSums.data(), m_boxWidths.data(), rows, destination.width, source.layout, out);
+	}
+}
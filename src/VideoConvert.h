@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "CpuFeatures.h"
+
+// Byte layouts of the frames NDI hands us when asked for NDIlib_recv_color_format_UYVY_BGRA (or the RGB
+//  variants). Alpha, where present, is ignored - the display is opaque.
+enum class PixelLayout
+{
+    UYVY, // 4:2:2, U0 Y0 V0 Y1 per pair of pixels. Also covers UYVA, whose alpha plane follows the UYVY data.
+    BGRA, // Also BGRX
+    RGBA  // Also RGBX
+};
+
+struct SourceFrame
+{
+    uint8_t const* data;
+    int width;
+    int height;
+    int strideBytes;
+    PixelLayout layout;
+};
+
+// Destination pixels are 32 bit 0xffRRGGBB, i.e. QImage::Format_RGB32.
+struct DestinationImage
+{
+    uint8_t* data;
+    int width;
+    int height;
+    int strideBytes;
+};
+
+// Colour converts and area-average resizes a frame in one pass over the source. Each run of source rows
+//  that maps to an output row is summed column by column (where nearly all the memory traffic is), then
+//  each output pixel sums its box of those column sums, and finally the sums are averaged and converted to
+//  RGB several pixels at a time. All three steps are vectorised, and every path gives exactly the scalar
+//  path's bytes. Because YUV->RGB is affine, averaging before converting gives the same answer as
+//  converting every source pixel first, for a fraction of the work. The sums live in the converter and are
+//  reused, so converting a stream of frames does not allocate once it has seen the widest frame.
+class FrameConverter
+{
+public:
+    explicit FrameConverter(KernelPath path = KernelPath::Best);
+
+    void convert(SourceFrame const& source, DestinationImage const& destination);
+
+    // The path actually in use, after resolving Best and dropping anything the CPU can't run.
+    KernelPath path() const { return m_path; }
+
+private:
+    using AccumulateRowFunction = void (*)(uint8_t const* row, uint32_t* columnSums, int numBytes);
+    using ReducePixelsFunction = void (*)(uint32_t const* columnSums, int const* columnBoxes, int width, PixelLayout layout, uint32_t* pixelSums);
+    using ConvertPixelsFunction = void (*)(uint32_t const* pixelSums, uint32_t const* boxWidths, uint32_t rows, int width, PixelLayout layout, uint8_t* out);
+
+    KernelPath m_path;
+    AccumulateRowFunction m_accumulateRow;
+    ReducePixelsFunction m_reducePixels;
+    ConvertPixelsFunction m_convertPixels;
+    std::vector<uint32_t> m_columnSums;
+    std::vector<int> m_columnBoxes;     // Start and end source column for each output column
+    std::vector<uint32_t> m_boxWidths;  // Their widths
+    std::vector<uint32_t> m_pixelSums;  // Three channel sums and a spare for each output pixel of a row
+};
@@ -0,0 +1,135 @@
+#include "VideoPlaybackWidget.h"
+
+#include <QFontDatabase>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QResizeEvent>
+#include <algorithm>
+
+#include "StatsReport.h"
+
+VideoPlaybackWidget::VideoPlaybackWidget(QWidget* parent)
+	: QWidget(parent)
+{
+	setAttribute(Qt::WA_OpaquePaintEvent); // We fill every pixel ourselves; skip Qt clearing the background first
+	m_statsOverlayTimer.setInterval(250);
+	connect(&m_statsOverlayTimer, &QTimer::timeout, this, qOverload<>(&QWidget::update));
+}
+
+QSize VideoPlaybackWidget::targetSize() const
+{
+	uint64_t const packed = m_targetSize.load(std::memory_order_relaxed);
+	return QSize(static_cast<int>(packed >> 32), static_cast<int>(packed & 0xFFFFFFFF));
+}
+
+void VideoPlaybackWidget::publishFrame(std::chrono::system_clock::time_point const sentAt)
+{
+	m_frames.back().published = std::chrono::steady_clock::now();
+	m_frames.back().sentAt = sentAt;
+	if (m_frames.publish() && m_stats)
+	{
+		m_stats->videoFramesDropped.fetch_add(1, std::memory_order_relaxed);
+	}
+	if (!m_repaintPending.exchange(true))
+	{
+		QMetaObject::invokeMethod(this, [this]() { update(); }, Qt::QueuedConnection);
+	}
+}
+
+void VideoPlaybackWidget::setStatsOverlayVisible(bool const visible)
+{
+	m_statsOverlayVisible = visible;
+	m_statsOverlayUpdated = {};
+	if (visible)
+	{
+		m_statsOverlayTimer.start();
+	}
+	else
+	{
+		m_statsOverlayTimer.stop();
+	}
+	update();
+}
+
+void VideoPlaybackWidget::setPlaceholderText(QString const& text)
+{
+	m_placeholderText = text;
+	update();
+}
+
+void VideoPlaybackWidget::setHighlighted(bool const highlighted)
+{
+	m_highlighted = highlighted;
+	update();
+}
+
+void VideoPlaybackWidget::mousePressEvent(QMouseEvent* event)
+{
+	if (event->button() == Qt::LeftButton)
+	{
+		emit clicked();
+	}
+	QWidget::mousePressEvent(event);
+}
+
+void VideoPlaybackWidget::resizeEvent(QResizeEvent* event)
+{
+	QSize const newSize{ event->size() };
+	m_targetSize.store((static_cast<uint64_t>(newSize.width()) << 32) | static_cast<uint32_t>(newSize.height()), std::memory_order_relaxed);
+	QWidget::resizeEvent(event);
+}
+
+void VideoPlaybackWidget::paintEvent(QPaintEvent*)
+{
+	m_repaintPending.store(false);
+	if (m_frames.acquireLatest() && m_stats)
+	{
+		m_stats->videoDelivery.record(std::chrono::steady_clock::now() - m_frames.front().published);
+		m_stats->videoFramesDisplayed.fetch_add(1, std::memory_order_relaxed);
+		// As near to the glass as we can see; the compositor and the display's own refresh come after this
+		if (m_frames.front().sentAt != std::chrono::system_clock::time_point{})
+		{
+			m_stats->glassToGlass.record(std::max<std::chrono::nanoseconds>(std::chrono::system_clock::now() - m_frames.front().sentAt, std::chrono::nanoseconds{ 0 }));
+		}
+	}
+
+	QPainter painter(this);
+	painter.fillRect(rect(), Qt::black);
+
+	QImage const& frame{ m_frames.front().image };
+	if (frame.isNull())
+	{
+		painter.setPen(Qt::white);
+		QFont boldFont{ painter.font() };
+		boldFont.setBold(true);
+		painter.setFont(boldFont);
+		painter.drawText(rect(), Qt::AlignCenter, m_placeholderText);
+	}
+	else
+	{
+		// Frames are already scaled to fit by the capture thread; just centre it.
+		QPoint const topLeft{ (width() - frame.width()) / 2, (height() - frame.height()) / 2 };
+		painter.drawImage(topLeft, frame);
+	}
+
+	if (m_statsOverlayVisible && m_stats)
+	{
+		// Rebuilding the text every paint would cost more than what it is measuring; a few times a second is plenty.
+		auto const now = std::chrono::steady_clock::now();
+		if (now - m_statsOverlayUpdated > std::chrono::milliseconds(250))
+		{
+			m_statsOverlayText = StatsReport::overlayText(*m_stats);
+			m_statsOverlayUpdated = now;
+		}
+		painter.setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+		painter.setPen(Qt::yellow);
+		painter.drawText(rect().adjusted(6, 6, -6, -6), Qt::AlignTop | Qt::AlignLeft, m_statsOverlayText);
+	}
+
+	if (m_highlighted)
+	{
+		painter.setPen(QPen(QColor(255, 160, 0), 3));
+		painter.setBrush(Qt::NoBrush);
+		painter.drawRect(rect().adjusted(1, 1, -2, -2));
+	}
+}
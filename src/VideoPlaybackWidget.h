@@ -0,0 +1,67 @@
+#pragma once
+
+#include <QWidget>
+#include <QImage>
+#include <QTimer>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include "MediaTargets.h"
+#include "Stats.h"
+#include "TripleBuffer.h"
+
+// Widget that displays the most recent video frame handed over from the capture thread. The capture
+//  thread renders straight into a back buffer owned by this widget and publishes it; paintEvent picks
+//  up whatever is newest. If the GUI thread falls behind, older frames are overwritten rather than
+//  queued up as they would be with a queued signal per frame.
+class VideoPlaybackWidget : public QWidget, public VideoTarget
+{
+    Q_OBJECT
+
+public:
+    explicit VideoPlaybackWidget(QWidget* parent = nullptr);
+
+    // Safe to call from any thread. The size frames should be scaled to fit within.
+    QSize targetSize() const override;
+
+    // Capture thread only. Render into backBuffer(), then publishFrame().
+    QImage& backBuffer() override { return m_frames.back().image; }
+    void publishFrame(std::chrono::system_clock::time_point sentAt) override;
+
+    // GUI thread. Counts frames shown and dropped, how long each took from publish to paint, and from the source to paint.
+    void setStats(PipelineStats* stats) { m_stats = stats; }
+    void setStatsOverlayVisible(bool visible);
+
+    // GUI thread. Shown until the first frame arrives.
+    void setPlaceholderText(QString const& text);
+    // GUI thread. Draws a border, to mark e.g. the multiview tile whose audio is playing.
+    void setHighlighted(bool highlighted);
+
+signals:
+    void clicked();
+
+protected:
+    void paintEvent(QPaintEvent* event) override;
+    void mousePressEvent(QMouseEvent* event) override;
+    void resizeEvent(QResizeEvent* event) override;
+
+private:
+    struct Frame
+    {
+        QImage image;
+        std::chrono::steady_clock::time_point published;
+        std::chrono::system_clock::time_point sentAt;
+    };
+
+    TripleBuffer<Frame> m_frames;
+    PipelineStats* m_stats{ nullptr };
+    bool m_statsOverlayVisible{ false };
+    bool m_highlighted{ false };
+    QString m_placeholderText{ "Video playback" };
+    QString m_statsOverlayText;
+    QTimer m_statsOverlayTimer;                    // Unchanged frames aren't published, so nothing else would repaint a still picture
+    std::chrono::steady_clock::time_point m_statsOverlayUpdated;
+    std::atomic<uint64_t> m_targetSize{ 0 };       // Width in the high half, height in the low half
+    std::atomic<bool> m_repaintPending{ false };   // Keeps at most one repaint request in the event queue
+};
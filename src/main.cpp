@@ -5,6 +5,8 @@
 int main(int argc, char *argv[])
 {
     QApplication a(argc, argv);
+    a.setOrganizationName("HowlsMovingCast");
+    a.setApplicationName("NDIReceive"); // Where QSettings keeps the remembered sources
     MainWindow w;
     w.show();
     return a.exec();
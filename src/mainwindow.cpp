@@ -1,29 +1,37 @@
 
 #include <QPushButton>
 #include <QDateTime>
+#include <QDir>
+#include <QIcon>
 #include <QMessageBox>
+#include <QPixmap>
+#include <QRegularExpression>
+#include <QScreen>
+#include <QStandardPaths>
 #include <chrono>
+#include <optional>
 
+#include "FramePool.h"
 #include "NDIDeleters.h"
+#include "Log.h"
 
 #include "mainwindow.h"
 #include "./ui_mainwindow.h"
 
-// Convert an NDI video frame to QImage
+// Convert an NDI video frame to QImage, at full size
 QImage NDIFrameToQImage(const NDIlib_video_frame_v2_t& videoFrame)
 {
-	if (videoFrame.p_data == nullptr)
+	auto const layout = pixelLayoutFor(videoFrame.FourCC);
+	if (videoFrame.p_data == nullptr || !layout)
 	{
 		return {};
 	}
 
-	// Assuming BGRA format (most common for NDI)
-	QImage image(videoFrame.p_data,
-		videoFrame.xres,
-		videoFrame.yres,
-		QImage::Format_ARGB32);
-
-	return image.rgbSwapped();  // Convert BGRA -> RGBA for Qt
+	QImage image = FramePool::shared().image(QSize(videoFrame.xres, videoFrame.yres));
+	FrameConverter converter;
+	converter.convert({ videoFrame.p_data, videoFrame.xres, videoFrame.yres, videoFrame.line_stride_in_bytes, *layout },
+		              { image.bits(), image.width(), image.height(), static_cast<int>(image.bytesPerLine()) });
+	return image;
 }
 
 MainWindow::MainWindow(QWidget *parent)
@@ -31,95 +39,145 @@ MainWindow::MainWindow(QWidget *parent)
     , ui(new Ui::MainWindow)
 {
     ui->setupUi(this);
-	log("Starting...");
-
-	connect(this, &MainWindow::logOnWidgetThread,
-		    ui->debugOutput, &QTextEdit::append);
-
-	connect(this, &MainWindow::updateVideoPlaybackImage,
-		    ui->labelPlayback, &QLabel::setPixmap);
+	m_logView = new LogView(ui->debugOutput, 5000, this);
+	LOG_INFO("Starting...");
+
+	connect(ui->checkBoxVideoPlaybackDebugLogging, &QCheckBox::toggled, this, [](bool const checked) {
+		Log::setLevel(checked ? LogLevel::Debug : LogLevel::Info);
+	});
+
+	updateReceiverCacheLimits();
+	connect(ui->spinBoxCachedConnections, &QSpinBox::valueChanged, this, &MainWindow::updateReceiverCacheLimits);
+	connect(ui->spinBoxConnectionIdleSeconds, &QSpinBox::valueChanged, this, &MainWindow::updateReceiverCacheLimits);
+	connect(m_receiverCacheSweep, &QTimer::timeout, this, [this]() {
+		if (size_t const closed = m_receiverCache.evictIdle())
+		{
+			LOG_INFO(QString("Closed %1 idle NDI connection(s); %2 still open").arg(closed).arg(m_receiverCache.openConnections()));
+		}
+	});
+	m_receiverCacheSweep->start(5000);
+
+	m_engine = std::make_unique<ReceiverEngine>(*ui->videoPlayback, *m_audioOutput, m_receiverCache);
+	m_statsExporter = new StatsExporter(m_engine->stats(), this);
+	ui->videoPlayback->setStats(&m_engine->stats());
+	connect(ui->checkBoxAudio, &QCheckBox::toggled, this, [this](bool const checked) { m_engine->setAudioEnabled(checked); });
+	connect(ui->checkBoxStatsOverlay, &QCheckBox::toggled, ui->videoPlayback, &VideoPlaybackWidget::setStatsOverlayVisible);
+	ui->audioMeters->setLevels(&m_engine->stats().audioLevels);
+	connect(ui->checkBoxAudioMeters, &QCheckBox::toggled, this, [this](bool const checked) {
+		ui->audioMeters->setVisible(checked);
+		m_engine->setAudioMetering(checked);
+	});
+	connect(ui->lineEditStatsFile, &QLineEdit::editingFinished, this, [this]() {
+		m_statsExporter->setPath(ui->lineEditStatsFile->text());
+		LOG_INFO(QString("Stats export file: %1").arg(ui->lineEditStatsFile->text().isEmpty() ? "none" : ui->lineEditStatsFile->text()));
+	});
+	connect(ui->buttonRecord, &QPushButton::toggled, this, &MainWindow::setRecording);
+
+	m_multiview = new MultiviewWidget(m_receiverCache, ui->multiviewContainer);
+	ui->multiviewContainer->layout()->addWidget(m_multiview);
+	connect(ui->buttonStartMultiview, &QPushButton::clicked, this, &MainWindow::launchMultiview);
+	connect(ui->buttonStopMultiview, &QPushButton::clicked, m_multiview, &MultiviewWidget::stop);
+	connect(ui->checkBoxAudioFollowsTile, &QCheckBox::toggled, m_multiview, &MultiviewWidget::setAudioFollowsSelection);
+	connect(ui->checkBoxStatsOverlay, &QCheckBox::toggled, m_multiview, &MultiviewWidget::setStatsOverlayVisible);
+	connect(ui->checkBoxAudioMeters, &QCheckBox::toggled, m_multiview, &MultiviewWidget::setAudioMetersVisible);
+
+	// Sources from last time are selectable straight away, greyed until discovery sees them again
+	ui->listWidgetStreamsFound->setIconSize(QSize(ThumbnailEngine::cellWidth / 2, ThumbnailEngine::cellHeight / 2));
+	connect(m_thumbnails, &ThumbnailEngine::thumbnailUpdated, this, &MainWindow::showThumbnail);
+	for (QString const& name : m_sourceDiscovery->remembered())
+	{
+		addSource(name, false);
+	}
+	connect(m_sourceDiscovery, &SourceDiscovery::sourcesChanged, this, &MainWindow::applySourceDiff);
+	m_sourceDiscovery->start();
+	m_thumbnails->start();
 
-	connect(ui->buttonScanForStreams, &QPushButton::clicked, this, &MainWindow::launchFindNDISources);
+	connect(ui->buttonScanForStreams, &QPushButton::clicked, m_sourceDiscovery, &SourceDiscovery::rescan);
 	connect(ui->buttonCaptureVideoFrame, &QPushButton::clicked, this, &MainWindow::launchCaptureVideoFrame);
+	connect(ui->buttonCaptureBurst, &QPushButton::toggled, this, &MainWindow::launchBurst);
 	connect(ui->buttonPlayVideo, &QPushButton::clicked, this, &MainWindow::launchPlayVideo);
 	connect(ui->buttonStopVideo, &QPushButton::clicked, this, [&m_stopPlayingOut = m_stopPlayingOut]() {m_stopPlayingOut.store(true);});
 	connect(ui->buttonRedetectSoundDevices, &QPushButton::clicked, this, &MainWindow::redetectSoundDevices);
 	connect(ui->cbSoundDevices, &QComboBox::currentIndexChanged, this, &MainWindow::selectedSoundDeviceChanged);
-	connect(findSourcesWatcher, &QFutureWatcher<QStringList>::finished, this, &MainWindow::findSourcesFinished);
 	connect(captureVideoFrameWatcher, &QFutureWatcher<QImage>::finished, this, & MainWindow::captureVideoFrameFinished);
+	connect(burstWatcher, &QFutureWatcher<BurstReport>::finished, this, &MainWindow::burstFinished);
 	connect(playVideoWatcher, &QFutureWatcher<bool>::finished, this, &MainWindow::playVideoFinished);
 
-	log(QString("Default audio output device detected as: ID: %1. Description: %2.").arg(m_defaultAudioDevice.id()).arg(m_defaultAudioDevice.description()));
+	LOG_INFO(QString("Default audio output device detected as: ID: %1. Description: %2.").arg(m_defaultAudioDevice.id()).arg(m_defaultAudioDevice.description()));
 }
 
 MainWindow::~MainWindow()
 {
+	// The playback thread writes into the audio output and the playback widget; it must be gone before they are.
+	m_stopPlayingOut.store(true);
+	playVideoWatcher->waitForFinished();
+	captureVideoFrameWatcher->waitForFinished(); // Its receiver lease goes back to the cache
+	m_stopBurst.store(true);
+	burstWatcher->waitForFinished(); // What it captured is still written; a moment, not the whole burst
+	m_multiview->stop();
+	m_sourceDiscovery->stop();
+	m_thumbnails->stop();
+	m_engine.reset();
     delete ui;
 }
 
-void MainWindow::selectedSoundDeviceChanged(int const index)
+void MainWindow::updateReceiverCacheLimits()
 {
-	m_selectedAudioDevice = m_detectedAudioDevices.at(index);
-	log(QString("Selected sound device updated: %1").arg(m_selectedAudioDevice.description()));
+	m_receiverCache.setLimits(ui->spinBoxCachedConnections->value(), std::chrono::seconds(ui->spinBoxConnectionIdleSeconds->value()));
 }
 
-void MainWindow::launchFindNDISources()
+void MainWindow::selectedSoundDeviceChanged(int const index)
 {
-	ui->listWidgetStreamsFound->clear();
-	// Launch function to find NDI sources on another thread, so as not to block the
-	//  GUI thread.
-
-	QFuture<QStringList> future = QtConcurrent::run(&MainWindow::findNDISources, this);
-	findSourcesWatcher->setFuture(future);
+	m_selectedAudioDevice = m_detectedAudioDevices.at(index);
+	LOG_INFO(QString("Selected sound device updated: %1").arg(m_selectedAudioDevice.description()));
 }
 
-void MainWindow::findSourcesFinished()
+void MainWindow::addSource(QString const& name, bool const confirmed)
 {
-	auto result = findSourcesWatcher->future().result();
-	for (auto& val : result)
+	auto* const item = new QListWidgetItem(name, ui->listWidgetStreamsFound);
+	if (!confirmed)
 	{
-		ui->listWidgetStreamsFound->addItem(val);
+		item->setForeground(palette().color(QPalette::Disabled, QPalette::Text));
+		item->setToolTip("Found in an earlier session; not seen on the network yet");
 	}
+	m_thumbnails->addSource(name);
 }
 
-QStringList MainWindow::findNDISources()
+void MainWindow::showThumbnail(QString const& name)
 {
-	log("Scan for NDI sources started");
-	
-	NDIlib_find_instance_t pFind = NDIlib_find_create_v2();
-	deleteGuard findInstanceGuard(NDIlib_find_destroy, pFind);
-
-	if (!pFind)
-	{
-		log("NDIlib_find_create_v2 failed");
-		return {};
-	}
-
-	if (!NDIlib_find_wait_for_sources(pFind, 5000 /* milliseconds */)) 
+	QImage const thumbnail = m_thumbnails->thumbnail(name);
+	if (thumbnail.isNull())
 	{
-		log(QString("No change to the sources found."));
+		return; // Removed since
 	}
-
-	// Get the updated list of sources
-	uint32_t no_sources = 0;
-	const NDIlib_source_t* p_sources = NDIlib_find_get_current_sources(pFind, &no_sources);
-	// Display all the sources.
-	log(QString("Network sources (%1 found).").arg(no_sources));
-	
-	QStringList foundSources;
-	for (uint32_t i = 0; i < no_sources; i++)
+	for (QListWidgetItem* const item : ui->listWidgetStreamsFound->findItems(name, Qt::MatchExactly))
 	{
-		foundSources.append(QString(p_sources[i].p_ndi_name));
+		item->setIcon(QIcon(QPixmap::fromImage(thumbnail)));
 	}
-
-	return foundSources;
 }
 
-void MainWindow::log(QString const& logline, bool doLog)
+void MainWindow::applySourceDiff(SourceDiff const& diff)
 {
-	if (doLog)
+	// Item by item, so the selection and scroll position survive and nothing flickers
+	for (QString const& name : diff.removed)
+	{
+		m_thumbnails->removeSource(name);
+		for (QListWidgetItem* const item : ui->listWidgetStreamsFound->findItems(name, Qt::MatchExactly))
+		{
+			delete item;
+		}
+	}
+	for (QString const& name : diff.confirmed)
 	{
-		emit logOnWidgetThread(QDateTime::currentDateTime().toString(Qt::ISODateWithMs) + " - " + logline);
+		for (QListWidgetItem* const item : ui->listWidgetStreamsFound->findItems(name, Qt::MatchExactly))
+		{
+			item->setForeground(palette().color(QPalette::Text));
+			item->setToolTip({});
+		}
+	}
+	for (QString const& name : diff.added)
+	{
+		addSource(name, true);
 	}
 }
 
@@ -127,13 +185,13 @@ void MainWindow::launchCaptureVideoFrame()
 {
 	if (!ui->listWidgetStreamsFound->currentItem())
 	{
-		log("Select source before capturing video frame");
+		LOG_WARNING("Select source before capturing video frame");
 		QMessageBox::warning(this, "No source selected", "Select a source before capturing video frame");
 		return;
 	}
 	ui->buttonCaptureVideoFrame->setEnabled(false);
 	QString const selectedSource{ ui->listWidgetStreamsFound->currentItem()->text() };
-	log(QString("Video frame capture from source: %1").arg(selectedSource));
+	LOG_INFO(QString("Video frame capture from source: %1").arg(selectedSource));
 	captureVideoFrameWatcher->setFuture(QtConcurrent::run(&MainWindow::captureVideoFrame, this, selectedSource));
 }
 
@@ -145,30 +203,42 @@ void MainWindow::closeEvent(QCloseEvent* event) // Called when user closes appli
 
 QImage MainWindow::captureVideoFrame(QString sourceName)
 {
-	// This function sets up and tears down the NDI receiving objects every time it is called.
-	// This seems to be fairly expensive (as in, takes a noticable amount of time) but for the 
-	// simple purposes of just grabbing one frame to display, that's fine.
-
-	const auto streamStdString = sourceName.toStdString();
-	NDIlib_source_t source{ streamStdString.c_str() };
-	NDIlib_recv_create_v3_t const recvSettings{ source, NDIlib_recv_color_format_RGBX_RGBA, NDIlib_recv_bandwidth_highest, false };
-
-	NDIlib_recv_instance_t const pNDIlibRecv = NDIlib_recv_create_v3(&recvSettings);
-	deleteGuard NdiRecvGuard(NDIlib_recv_destroy, pNDIlibRecv);
-	if (!pNDIlibRecv)
+	// Setting up an NDI receiver takes a noticeable amount of time, so receivers are kept connected for a
+	//  while after use. Grabbing from the same source again, or playing it, picks up where this left off.
+	auto const started = std::chrono::steady_clock::now();
+	ReceiverCache::Lease const receiver = m_receiverCache.acquire(sourceName.toStdString(), NDIlib_recv_bandwidth_highest);
+	if (!receiver)
 	{
 		return {};
 	}
 
 	NDIlib_video_frame_v2_t video_frame;
-	QImage imToReturn;
+	if (receiver.reused())
+	{
+		// A warm receiver has been queueing frames since it was last used. They're old; throw them away
+		//  and wait for the next one.
+		for (int discarded = 0; discarded < 100; ++discarded)
+		{
+			NDIlib_frame_type_e const frame_type = NDIlib_recv_capture_v2(receiver.get(), &video_frame, nullptr, nullptr, 0);
+			if (frame_type == NDIlib_frame_type_video)
+			{
+				NDIlib_recv_free_video_v2(receiver.get(), &video_frame);
+			}
+			else if (frame_type == NDIlib_frame_type_none || frame_type == NDIlib_frame_type_error)
+			{
+				break;
+			}
+		}
+	}
 
-	int tries = 0;
-	while (tries++ < 10)
+	QImage imToReturn;
+	auto const deadline = started + std::chrono::seconds(5);
+	for (auto now = started; now < deadline; now = std::chrono::steady_clock::now())
 	{
 		// Depending on the source, it seems that even though we're only asking for a video frame, we can get other kinds
 		//  of responses to the capture request. Hence multiple attempts.
-		NDIlib_frame_type_e frame_type = NDIlib_recv_capture_v2(pNDIlibRecv, &video_frame, nullptr, nullptr, 5000);
+		auto const remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now);
+		NDIlib_frame_type_e frame_type = NDIlib_recv_capture_v2(receiver.get(), &video_frame, nullptr, nullptr, static_cast<uint32_t>(remaining.count()));
 
 		if (frame_type == NDIlib_frame_type_video) 
 		{
@@ -176,7 +246,13 @@ QImage MainWindow::captureVideoFrame(QString sourceName)
 			imToReturn = NDIFrameToQImage(video_frame);
 
 			// Free the video frame
-			NDIlib_recv_free_video_v2(pNDIlibRecv, &video_frame);
+			NDIlib_recv_free_video_v2(receiver.get(), &video_frame);
+
+			auto const waited = std::chrono::steady_clock::now() - started;
+			m_engine->stats().timeToFirstFrame.record(waited);
+			LOG_INFO(QString("Frame from %1 after %2 ms (%3 connection)").arg(sourceName)
+				.arg(std::chrono::duration_cast<std::chrono::milliseconds>(waited).count())
+				.arg(receiver.reused() ? "warm" : "new"));
 			break;
 		}
 	}
@@ -187,128 +263,73 @@ QImage MainWindow::captureVideoFrame(QString sourceName)
 void MainWindow::captureVideoFrameFinished()
 {
 	auto result = captureVideoFrameWatcher->future().result();
-	log("Video frame capture complete");
+	LOG_INFO("Video frame capture complete");
 	QSize const labelSize{ ui->labelVideoFrame->size() };
 	ui->labelVideoFrame->setPixmap(QPixmap::fromImage(result.scaled(labelSize, Qt::KeepAspectRatio)));
-	log(QString("Captured frame size: %1x%2. Scaled to fit: %3x%4").arg(result.width()).arg(result.height()).arg(labelSize.width()).arg(labelSize.height()));
+	LOG_INFO(QString("Captured frame size: %1x%2. Scaled to fit: %3x%4").arg(result.width()).arg(result.height()).arg(labelSize.width()).arg(labelSize.height()));
 	ui->buttonCaptureVideoFrame->setEnabled(true);
 }
 
-
-
-void MainWindow::captureAudioFrame(NDIlib_framesync_instance_t const& pNdiFrameSync, uint const microsecondsSinceLastCapture)
+void MainWindow::launchBurst(bool const start)
 {
+	if (!start)
 	{
-		NDIlib_audio_frame_v2_t audio_frame;
-
-		if (!m_audioIdentified) 
-		{
-			NDIlib_framesync_capture_audio(pNdiFrameSync, &audio_frame, 0, 0, 0);
-			if (m_pAudioSink) // Could have leftover audio sink from earlier captures
-			{
-				delete m_pAudioSink;
-				m_pAudioSink = nullptr;
-			}
-			identifyAudioParameters(audio_frame);
-		}
-		else if (m_pAudioSink)
-		{
-			if (m_pAudioSink->state() == QAudio::StoppedState)
-			{
-				log("Starting audiosink");
-				m_pAudioSinkIoDevice = m_pAudioSink->start(); // The QAudioSink, when started, provides a pointer to a QIODevice to which to write the audio data
-				log("Audiosink started");
-			}
-			else
-			{
-				// Audio sink was previously started. Let's just start putting audio into it
-				int const numSamplesToFetchPerChannel = m_currentAudioFormat.sampleRate() * (microsecondsSinceLastCapture / 1000000.0);
-				NDIlib_framesync_capture_audio(
-					pNdiFrameSync, // The frame sync instance. NDILib object
-					&audio_frame, // The destination audio buffer. NDILib object 
-					m_currentAudioFormat.sampleRate(),
-					m_currentAudioFormat.channelCount(), // 2 channels to draw
-					numSamplesToFetchPerChannel);
-
-				processOutputAudioFrame(audio_frame, numSamplesToFetchPerChannel);
-			}
-		}
-		NDIlib_framesync_free_audio(pNdiFrameSync, &audio_frame);
+		m_stopBurst.store(true); // Ends the capture; burstFinished() follows once the files are written
+		return;
 	}
-
-}
-
-void MainWindow::processOutputAudioFrame(NDIlib_audio_frame_v2_t const& audio_frame, int const numSamplesToFetchPerChannel)
-{
-	// The NDILib structure stores audio data in a planar format, meaning each channel's samples are grouped together. 
-	//  However, QAudioSink expects interleaved data. Fortunately, an NDILib utility function can handle the conversion, 
-	//  but we still need to ensure the recipient structure is properly populated with data.
-	NDIlib_audio_frame_interleaved_32f_t ndiInterleavedAudioStore;
-	ndiInterleavedAudioStore.sample_rate = m_currentAudioFormat.sampleRate();
-	ndiInterleavedAudioStore.no_samples = numSamplesToFetchPerChannel;
-	ndiInterleavedAudioStore.no_channels = m_currentAudioFormat.channelCount();
-
-	int const totalNumberOfSamplesAcrossAllChannels = numSamplesToFetchPerChannel * m_currentAudioFormat.channelCount();
-
-	// We must also provide the memory for the rearranged audio data to occupy.
-	if (m_vecInterleavedData.size() < totalNumberOfSamplesAcrossAllChannels)
+	if (!ui->listWidgetStreamsFound->currentItem())
 	{
-		m_vecInterleavedData.resize(totalNumberOfSamplesAcrossAllChannels);
+		LOG_WARNING("Select source before capturing a burst");
+		QMessageBox::warning(this, "No source selected", "Select a source before capturing a burst");
+		QSignalBlocker const blocker{ ui->buttonCaptureBurst };
+		ui->buttonCaptureBurst->setChecked(false);
+		return;
 	}
-	ndiInterleavedAudioStore.p_data = &(m_vecInterleavedData[0]);
-
-	// This is the utility function that turns planar audio data into interleaved
-	NDIlib_util_audio_to_interleaved_32f_v2(&audio_frame, &ndiInterleavedAudioStore);
-
-	m_audioOutputsBuffer.clear();
-
-	// The audio data will go to a QByteArray to be ingested by the QAudioSink's
-	//  QIODevice. Accordingly the array of floats must be copied into that QByteArray.
-	m_audioOutputsBuffer.append(reinterpret_cast<const char*>(ndiInterleavedAudioStore.p_data), sizeof(float) * totalNumberOfSamplesAcrossAllChannels);
-	log(QString("Stored %1 bytes in buffer.").arg(m_audioOutputsBuffer.size()), ui->checkBoxVideoPlaybackDebugLogging->isChecked());
 
-	if (m_pAudioSinkIoDevice)
+	BurstSettings settings;
+	settings.sourceName = ui->listWidgetStreamsFound->currentItem()->text();
+	settings.frames = ui->spinBoxBurstFrames->value();
+	settings.duration = std::chrono::seconds(ui->spinBoxBurstSeconds->value());
+	settings.format = static_cast<BurstFormat>(ui->comboBoxBurstFormat->currentIndex());
+	settings.directory = ui->lineEditBurstDirectory->text().trimmed();
+	if (settings.directory.isEmpty())
 	{
-		qsizetype const bytesFree = m_pAudioSink->bytesFree();
-		log(QString("Audio sink has %1 bytes free").arg(bytesFree), ui->checkBoxVideoPlaybackDebugLogging->isChecked());
-		if (bytesFree < m_audioOutputsBuffer.size())
-		{
-			log("Audiosink buffer has too little space for current audio data. Some audio data will be dropped.");
-		}
-		qint64 const bytesWritten = m_pAudioSinkIoDevice->write(m_audioOutputsBuffer.data(), qMin(m_audioOutputsBuffer.size(), bytesFree));
-		log(QString("Wrote %1 bytes to audiosink").arg(bytesWritten), ui->checkBoxVideoPlaybackDebugLogging->isChecked());
+		// Source names are "MACHINE (Name)"; keep them readable, but out of the way of the file system
+		QString source{ settings.sourceName };
+		source.replace(QRegularExpression("[^A-Za-z0-9_.-]+"), "_");
+		settings.directory = QDir(QStandardPaths::writableLocation(QStandardPaths::PicturesLocation))
+			.filePath(QString("ndirecv-%1-%2").arg(source).arg(QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss")));
 	}
-	else
+	if (settings.frames <= 0 && settings.duration.count() <= 0)
 	{
-		log("Could not obtain IO device for audiosink; cannot send audio data to output audio device.");
+		LOG_WARNING("A burst needs a number of frames or a number of seconds");
+		QSignalBlocker const blocker{ ui->buttonCaptureBurst };
+		ui->buttonCaptureBurst->setChecked(false);
+		return;
 	}
-}
 
+	LOG_INFO(QString("Burst capture from %1 to %2").arg(settings.sourceName, settings.directory));
+	m_stopBurst.store(false);
+	burstWatcher->setFuture(QtConcurrent::run([this, settings]() { return m_burstCapture.run(settings, m_stopBurst); }));
+}
 
-void MainWindow::captureAndProcessForDisplayVideoFrame(NDIlib_framesync_instance_t const& pNdiFrameSync)
+void MainWindow::burstFinished()
 {
-	NDIlib_video_frame_v2_t video_frame;
-
-	NDIlib_framesync_capture_video(
-		pNdiFrameSync,
-		&video_frame, // Write data into here
-		NDIlib_frame_format_type_progressive);
-
-	if (video_frame.yres > 0) // Used as proxy for knowing an actual frame of video data was captured
+	BurstReport const report{ burstWatcher->future().result() };
+	if (report.error.isEmpty())
 	{
-		log(QString("Captured video frame, size %1x%2").arg(video_frame.yres).arg(video_frame.xres), 
-			ui->checkBoxVideoPlaybackDebugLogging->isChecked());
+		LOG_INFO(QString("Burst capture complete: %1").arg(report.summary()));
 	}
-
-	if (QImage imageToStore(video_frame.p_data, video_frame.xres, video_frame.yres, QImage::Format_RGBX8888);
-		!imageToStore.isNull())
+	else
 	{
-		emit updateVideoPlaybackImage(QPixmap::fromImage(imageToStore.scaled(ui->labelPlayback->size(), Qt::KeepAspectRatio)));
+		LOG_WARNING(QString("Burst capture: %1. %2").arg(report.error, report.summary()));
 	}
-
-	NDIlib_framesync_free_video(pNdiFrameSync, &video_frame);
+	QSignalBlocker const blocker{ ui->buttonCaptureBurst };
+	ui->buttonCaptureBurst->setChecked(false);
 }
 
+
+
 void MainWindow::redetectSoundDevices()
 {
 	if (m_stopPlayingOut.load() != true) // Used as proxy for "are we playing out?"
@@ -321,14 +342,14 @@ void MainWindow::redetectSoundDevices()
 	// This is being done on the MainWindow's thread. This should make it safe to directly call on the UI elements, 
 	// BUT if this function takes a while, the GUI will freeze. If that's an issue, move the detection of the audio
 	// output devices to a separate thread and when that thread is done, then update the UI.
-	log(QString("Detecting output audio devices"));
+	LOG_INFO(QString("Detecting output audio devices"));
 	ui->cbSoundDevices->clear();
 
 	m_detectedAudioDevices = QMediaDevices::audioOutputs();
 
 	for (auto const& device : m_detectedAudioDevices)
 	{
-		log(QString("Detected audio output device: ID: %1. Description: %2.").arg(device.id()).arg(device.description()));
+		LOG_INFO(QString("Detected audio output device: ID: %1. Description: %2.").arg(device.id()).arg(device.description()));
 		ui->cbSoundDevices->addItem(device.description());
 	}
 }
@@ -337,125 +358,113 @@ void MainWindow::launchPlayVideo()
 {
 	if (!ui->listWidgetStreamsFound->currentItem())
 	{
-		log("Select source before capturing video frame");
+		LOG_WARNING("Select source before capturing video frame");
 		return;
 	}
-	QString const selectedSource{ ui->listWidgetStreamsFound->currentItem()->text() };
+	// Everything the playback thread needs from the widgets is read here, on the GUI thread
+	ReceiverSettings settings;
+	settings.sourceName = ui->listWidgetStreamsFound->currentItem()->text();
+	settings.capturesPerSecond = ui->spinBoxCapturesperSecond->value();
+	// No point capturing frames faster than the screen the video is on can show them
+	settings.lockToSource = ui->checkBoxLockToSource->isChecked();
+	settings.maxCapturesPerSecond = screen()->refreshRate();
+	settings.deinterlace = static_cast<DeinterlaceMode>(ui->comboBoxDeinterlace->currentIndex()); // Listed in the enum's order
+	settings.bandwidth = ui->comboBoxVideoQuality->currentText() == "Full" ? NDIlib_recv_bandwidth_highest : NDIlib_recv_bandwidth_lowest;
+	settings.adaptiveBandwidth = ui->comboBoxVideoQuality->currentText().startsWith("Auto");
+	settings.audio = ui->checkBoxAudio->isChecked();
+	settings.receiveMode = ui->comboBoxReceiveMode->currentText().startsWith("Direct") ? ReceiveMode::Direct : ReceiveMode::FrameSync;
+	settings.meterAudio = ui->checkBoxAudioMeters->isChecked();
+	m_audioOutput->setDevice(m_selectedAudioDevice);
+	m_playingSource = settings.sourceName;
+
 	ui->buttonPlayVideo->setEnabled(false);
-	log(QString("Launching play video from source %1").arg(selectedSource));
-	QFuture<bool> future = QtConcurrent::run(&MainWindow::playVideo, this, selectedSource);
+	LOG_INFO(QString("Launching play video from source %1").arg(settings.sourceName));
+	QFuture<bool> future = QtConcurrent::run(&MainWindow::playVideo, this, settings);
 	playVideoWatcher->setFuture(future);
 }
 
-bool MainWindow::playVideo(QString sourceName)
+void MainWindow::launchMultiview()
 {
-	const auto streamStdString = sourceName.toStdString();
-	NDIlib_source_t source{ streamStdString.c_str() };
-	NDIlib_recv_create_v3_t const recvSettings{ source, 
-		                                        NDIlib_recv_color_format_RGBX_RGBA, 
-		                                        ui->comboBoxVideoQuality->currentText() == "Full" ? NDIlib_recv_bandwidth_highest : NDIlib_recv_bandwidth_lowest,
-		                                        false };
-
-	NDIlib_recv_instance_t const pNDIlibRecv = NDIlib_recv_create_v3(&recvSettings);
-	deleteGuard NdiRecvGuard(NDIlib_recv_destroy, pNDIlibRecv);
-	if (!pNDIlibRecv)
+	QStringList sources;
+	for (int i = 0; i < ui->listWidgetStreamsFound->count(); ++i)
 	{
-		log("NDIlib_recv_create_v3 failed");
-		return false;
+		sources << ui->listWidgetStreamsFound->item(i)->text();
 	}
-
-	NDIlib_framesync_instance_t const pNdiFrameSync = NDIlib_framesync_create(pNDIlibRecv);
-	deleteGuard frameSyncguard(NDIlib_recv_destroy, pNDIlibRecv);
-	if (!pNdiFrameSync)
+	if (sources.isEmpty())
 	{
-		log("NDIlib_framesync_create failed");
-		return false;
+		LOG_WARNING("Scan for sources before starting multiview");
+		return;
 	}
+	// Many tiles at once are small; the proxy stream is plenty unless full quality was asked for. In the
+	//  automatic mode, each tile gets whichever suits the size it is drawn at.
+	ReceiverSettings settings;
+	settings.capturesPerSecond = ui->spinBoxCapturesperSecond->value();
+	settings.lockToSource = ui->checkBoxLockToSource->isChecked();
+	settings.maxCapturesPerSecond = m_multiview->screen()->refreshRate();
+	settings.deinterlace = static_cast<DeinterlaceMode>(ui->comboBoxDeinterlace->currentIndex());
+	settings.bandwidth = ui->comboBoxVideoQuality->currentText() == "Full" ? NDIlib_recv_bandwidth_highest : NDIlib_recv_bandwidth_lowest;
+	settings.adaptiveBandwidth = ui->comboBoxVideoQuality->currentText().startsWith("Auto");
+	m_multiview->setAudioFollowsSelection(ui->checkBoxAudioFollowsTile->isChecked());
+	m_multiview->setStatsOverlayVisible(ui->checkBoxStatsOverlay->isChecked());
+	m_multiview->setAudioMetersVisible(ui->checkBoxAudioMeters->isChecked());
+	m_multiview->start(sources, settings, m_selectedAudioDevice);
+}
 
-	int m_NdiDataCapturesPerSecond = ui->spinBoxCapturesperSecond->value();
-	uint const microsecondsBetweenCaptures = 1000000 / m_NdiDataCapturesPerSecond; // Nearest microsecond is good enough
-	std::chrono::time_point<std::chrono::steady_clock> m_timeOflastSample{ std::chrono::steady_clock::now() }; //When to take a new sample
-
-	m_audioIdentified = false;
+bool MainWindow::playVideo(ReceiverSettings settings)
+{
 	m_stopPlayingOut.store(false);
-	while (m_stopPlayingOut.load() != true)       //  loop until someone external orders a stop
-	{
-		using namespace std::chrono;
-		if (auto const microSecondsSinceLastCapture = static_cast<uint>(duration_cast<microseconds>(steady_clock::now() - m_timeOflastSample).count());
-			microSecondsSinceLastCapture >= microsecondsBetweenCaptures)
-		{
-			m_timeOflastSample = steady_clock::now();
-			captureAndProcessForDisplayVideoFrame(pNdiFrameSync);
-
-			if (ui->checkBoxAudio->isChecked())
-			{
-				captureAudioFrame(pNdiFrameSync, microSecondsSinceLastCapture);
-			}
-
-			log(QString("Captured video, and audio if appropriate. Microseconds since previous capture = %1").arg(microSecondsSinceLastCapture),
-				ui->checkBoxVideoPlaybackDebugLogging->isChecked());
-		}
-	}
-	if (m_pAudioSink) 
-	{
-		delete m_pAudioSink;
-		m_pAudioSink = nullptr;
-	} // The QAudioSink is a QObject with QTimers, and should be destroyed on same thread it is created i.e. here
-	return true;
+	bool const played = m_engine->run(settings, m_stopPlayingOut); //  loops until someone external orders a stop
+	m_stopPlayingOut.store(true);
+	return played;
 }
 
 void MainWindow::playVideoFinished()
 {
-	log("Play video complete");
+	LOG_INFO("Play video complete");
+	ui->buttonRecord->setChecked(false); // Finishes the file
+	m_statsExporter->exportNow(); // Make sure the file has the final numbers, not ones from up to a second before the stop
 	ui->buttonPlayVideo->setEnabled(true);
 }
 
-void MainWindow::identifyAudioParameters(NDIlib_audio_frame_v2_t const& audio_frame)
+void MainWindow::setRecording(bool const record)
 {
-	if (audio_frame.no_channels != 0) // Used as a proxy for having real data - assume any real audio data must have at least one channel
+	Recorder& recorder{ m_engine->recorder() };
+	RecordingStats const& stats{ m_engine->stats().recording };
+	if (!record)
 	{
-		log(QString("Audio data detected. Num channels = %1, sample rate = %2 Hz, metadata: %3")
-			.arg(audio_frame.no_channels)
-			.arg(audio_frame.sample_rate)
-			.arg(audio_frame.p_metadata));
-
-		m_currentAudioFormat = QAudioFormat();
-
-		m_currentAudioFormat.setSampleRate(audio_frame.sample_rate);
-		m_currentAudioFormat.setChannelCount(audio_frame.no_channels);
-		m_currentAudioFormat.setSampleFormat(QAudioFormat::Float);
-
-		if (!m_selectedAudioDevice.isFormatSupported(m_currentAudioFormat))
+		if (!recorder.recording())
 		{
-			log(QString("Audio format not supported by device, cannot play audio. Sample rate: %1 , channel count: %2 , sample format: FLOAT")
-				       .arg(audio_frame.sample_rate).arg(audio_frame.no_channels));
-
-			m_currentAudioFormat = m_selectedAudioDevice.preferredFormat();
-			log(QString("Will attempt preferred format: Sample rate: %1 , channel count: %2 , sample format: %3")
-				.arg(m_currentAudioFormat.sampleRate()).arg(m_currentAudioFormat.channelCount()).arg(m_currentAudioFormat.sampleFormat()));
-
-			if (m_pAudioSink)
-			{
-				delete m_pAudioSink;
-				m_pAudioSink = nullptr;
-			}
-			m_pAudioSink = new QAudioSink(m_selectedAudioDevice, m_currentAudioFormat);
+			return;
+		}
+		// Waits for what is buffered to reach the disk: a fraction of a second, unless the disk is struggling
+		if (recorder.stop())
+		{
+			LOG_INFO(QString("Recording finished: %1 video frames and %2 audio blocks, %3 MB; %4 frames and %5 audio blocks dropped")
+				.arg(stats.videoFramesRecorded.load()).arg(stats.audioBlocksRecorded.load()).arg(stats.bytesWritten.load() / (1024 * 1024))
+				.arg(stats.videoFramesDropped.load()).arg(stats.audioBlocksDropped.load()));
 		}
 		else
 		{
-			log("Audio format supported by device.", ui->checkBoxVideoPlaybackDebugLogging->isChecked());
-
-			if (m_pAudioSink)
-			{
-				delete m_pAudioSink;
-				m_pAudioSink = nullptr;
-			}
-			m_pAudioSink = new QAudioSink(m_selectedAudioDevice, m_currentAudioFormat);
+			LOG_WARNING(QString("Recording failed: %1").arg(QString::fromStdString(recorder.error())));
 		}
-		m_audioIdentified = true;
+		return;
+	}
+
+	QString path{ ui->lineEditRecordFile->text().trimmed() };
+	if (path.isEmpty())
+	{
+		path = QDir(QStandardPaths::writableLocation(QStandardPaths::MoviesLocation))
+			.filePath(QString("ndirecv-%1.ndirec").arg(QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss")));
+	}
+	QString const source{ m_playingSource.isEmpty() && ui->listWidgetStreamsFound->currentItem() ? ui->listWidgetStreamsFound->currentItem()->text() : m_playingSource };
+	if (recorder.start(std::filesystem::path(path.toStdU16String()), source.toStdString()))
+	{
+		LOG_INFO(QString("Recording to %1%2").arg(path).arg(stats.directIo.load() ? "" : ", through the page cache"));
 	}
 	else
 	{
-		log("No audio captured");
+		LOG_WARNING(QString("Cannot record: %1").arg(QString::fromStdString(recorder.error())));
+		QSignalBlocker const blocker{ ui->buttonRecord };
+		ui->buttonRecord->setChecked(false);
 	}
 }
\ No newline at end of file
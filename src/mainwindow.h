@@ -9,8 +9,20 @@
 #include <QMediaDevices>
 #include <QAudioFormat>
 #include <QAudioSink>
+#include <QTimer>
 #include <atomic> 
+#include <chrono>
+#include <memory>
 #include "Processing.NDI.Lib.h"
+#include "AudioOutput.h"
+#include "BurstCapture.h"
+#include "LogView.h"
+#include "MultiviewWidget.h"
+#include "ReceiverCache.h"
+#include "ReceiverEngine.h"
+#include "SourceDiscovery.h"
+#include "ThumbnailEngine.h"
+#include "StatsReport.h"
 
 
 QT_BEGIN_NAMESPACE
@@ -34,47 +46,48 @@ public:
 private:
     Ui::MainWindow *ui;
 
-    NDIlib_find_create_t m_find_create;
-    NDIlib_find_instance_t m_findInstance;
-    NDIlib_recv_instance_t m_pNDIlibRecv;
-    NDIlib_framesync_instance_t m_pNdiFrameSync;
-
     QList<QAudioDevice> m_detectedAudioDevices;
     QAudioDevice m_defaultAudioDevice{ QMediaDevices::defaultAudioOutput() }; // This can take significant time to call; do it here rather than in an audio loop
     QAudioDevice m_selectedAudioDevice{ m_defaultAudioDevice }; // Make it easy for users who don't want to pick through audio devices
-    bool m_audioIdentified{ false };
-    QAudioSink* m_pAudioSink{ nullptr }; // REPLACE this with memory safe option. Note QObjects are sometimes awkward about being created/deleted across threads.
-    QIODevice* m_pAudioSinkIoDevice{ nullptr }; // Pointer to the QT audio sink's IO device - this is where audio data is written to for output
-    QAudioFormat m_currentAudioFormat;
+    AudioOutput* m_audioOutput{ new AudioOutput(this) }; // Lives on the GUI thread; the capture thread only writes into it
+
+    LogView* m_logView{ nullptr }; // Batches log lines from all threads into the log widget
 
-    void captureAudioFrame(NDIlib_framesync_instance_t const& pNdiFrameSync, uint const microsecondsSinceLastCapture);
-    void processOutputAudioFrame(NDIlib_audio_frame_v2_t const& audio_frame, int const numSamplesToFetchPerChannel);
-    void identifyAudioParameters(NDIlib_audio_frame_v2_t const& audio_frame);
-    std::vector<float>      m_vecInterleavedData;   // For NDI utility function to write interleaved audio data into
-    QByteArray              m_audioOutputsBuffer;   // Holding buffer for audio data before passing to the Qt audio sink's IO device
+    ReceiverCache m_receiverCache;                       // Connected receivers, shared by frame capture and playback
+    QTimer* m_receiverCacheSweep{ new QTimer(this) };
+    void updateReceiverCacheLimits();
 
-    void log(QString const& logline, bool doLog = true);
+    std::unique_ptr<ReceiverEngine> m_engine;            // The receive pipeline; runs on the playback thread
+    StatsExporter* m_statsExporter{ nullptr };
 
-    QFutureWatcher<QStringList>* findSourcesWatcher{ new QFutureWatcher<QStringList>(this) };
-    void findSourcesFinished();
-    void launchFindNDISources();
-    QStringList findNDISources();
+    MultiviewWidget* m_multiview{ nullptr };             // Every source found at once, on a shared pool of capture threads
+    void launchMultiview();
+
+    SourceDiscovery* m_sourceDiscovery{ new SourceDiscovery(this) }; // Keeps the list of sources up to date in the background
+    ThumbnailEngine* m_thumbnails{ new ThumbnailEngine({}, this) };   // Preview pictures for the source list
+    void addSource(QString const& name, bool confirmed);
+    void showThumbnail(QString const& name);
+    void applySourceDiff(SourceDiff const& diff);
 
     QFutureWatcher<QImage>* captureVideoFrameWatcher{ new QFutureWatcher<QImage>(this) };
     QImage captureVideoFrame(QString sourceName);
     void launchCaptureVideoFrame();
     void captureVideoFrameFinished();
 
+    BurstCapture m_burstCapture{ m_receiverCache };      // The next N frames or T seconds of a source, to a directory of files
+    QFutureWatcher<BurstReport>* burstWatcher{ new QFutureWatcher<BurstReport>(this) };
+    std::atomic<bool> m_stopBurst{ false };
+    void launchBurst(bool start);
+    void burstFinished();
+
     QFutureWatcher<bool>* playVideoWatcher{ new QFutureWatcher<bool>(this) };
     std::atomic<bool> m_stopPlayingOut{ true };
-    bool playVideo(QString sourceName);
+    bool playVideo(ReceiverSettings settings);
     void redetectSoundDevices();
     void selectedSoundDeviceChanged(int const index);
     void launchPlayVideo();
     void playVideoFinished();
-    void captureAndProcessForDisplayVideoFrame(NDIlib_framesync_instance_t const& pNdiFrameSync);
-signals:
-    void logOnWidgetThread(QString);
-    void updateVideoPlaybackImage(QPixmap);
+    QString m_playingSource;
+    void setRecording(bool record);                      // Of what playback receives, to the file named or a new one
 };
 #endif // MAINWINDOW_H